@@ -48,6 +48,9 @@ async def lifespan(app: FastAPI):
     # TODO: Initialize C++ indicators
     if settings.USE_CPP_INDICATORS:
         logger.info("⚡ C++ indicators will be initialized in Phase 3")
+        if settings.KERNEL_CACHE_MB > 0:
+            from services.technical_indicators.cpp_wrapper import enable_kernel_cache
+            enable_kernel_cache(settings.KERNEL_CACHE_MB)
 
     logger.info("✅ AlphaSignal API is ready!")
 
@@ -147,6 +150,11 @@ app.include_router(predictions.router, prefix="/api/v1", tags=["ML Predictions"]
 # Factor Analysis API
 app.include_router(factors.router, prefix="/api/v1", tags=["Factor Analysis"])
 
+# ===== PE Dashboard Analytics =====
+from api.v1 import portfolio
+
+app.include_router(portfolio.router, prefix="/api/v1", tags=["PE Portfolio"])
+
 # TODO Phase 6 - Sentiment & Social API (requires API keys):
 #   from api.v1 import sentiment
 #   app.include_router(sentiment.router, prefix="/api/v1/sentiment", tags=["Sentiment"])
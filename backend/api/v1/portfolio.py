@@ -0,0 +1,85 @@
+"""
+PE Portfolio API Routes
+Deal and fund performance and public-market equivalents for the PE dashboard
+"""
+
+from fastapi import APIRouter, HTTPException, Query, Depends
+from fastapi.concurrency import run_in_threadpool
+from sqlalchemy.orm import Session
+from typing import List, Optional
+from datetime import date
+import pandas as pd
+import logging
+
+from database import get_db
+from services.pe_analytics.fund_performance import get_performance_engine
+from services.pe_analytics.pme import PMEEngine
+
+logger = logging.getLogger(__name__)
+router = APIRouter()
+
+
+def _records(df: pd.DataFrame) -> List[dict]:
+    """Rows as dicts, NaN (no IRR / no paid-in capital) as null"""
+    return df.astype(object).where(df.notna(), None).to_dict('records')
+
+
+@router.get("/pe/performance")
+async def get_portfolio_performance(
+    as_of: Optional[date] = Query(default=None),
+    fund_id: Optional[List[int]] = Query(default=None),
+    include_deals: bool = Query(default=True),
+    db: Session = Depends(get_db)
+):
+    """
+    TVPI / DPI / RVPI and XIRR for every fund and deal
+    Only flows and NAV marks on or before as_of (today) count; the residual NAV
+    (nav_latest when as_of is today, else the last NAV mark on or before as_of)
+    is valued on as_of
+    """
+    try:
+        # Loading and solving block; keep them off the event loop
+        result = await run_in_threadpool(get_performance_engine().compute, db,
+                                         as_of=as_of, fund_ids=fund_id)
+    except Exception as e:
+        logger.error(f"Error computing portfolio performance: {e}")
+        raise HTTPException(status_code=500, detail=str(e))
+
+    response = {
+        "as_of": str(as_of or date.today()),
+        "funds": _records(result['funds'])
+    }
+    if include_deals:
+        response["deals"] = _records(result['deals'])
+    return response
+
+
+@router.get("/pe/pme")
+async def get_public_market_equivalents(
+    benchmark: List[str] = Query(default=["SPY"]),
+    as_of: Optional[date] = Query(default=None),
+    fund_id: Optional[List[int]] = Query(default=None),
+    include_deals: bool = Query(default=True),
+    db: Session = Depends(get_db)
+):
+    """
+    Kaplan-Schoar PME, Long-Nickels IRR and Direct Alpha per fund and deal
+    for each benchmark ticker (MarketData.adj_close)
+    """
+    try:
+        result = await run_in_threadpool(PMEEngine().compute, db, benchmark,
+                                         as_of=as_of, fund_ids=fund_id)
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    except Exception as e:
+        logger.error(f"Error computing PME: {e}")
+        raise HTTPException(status_code=500, detail=str(e))
+
+    response = {
+        "as_of": str(as_of or date.today()),
+        "benchmarks": [b.upper() for b in benchmark],
+        "funds": _records(result['funds'])
+    }
+    if include_deals:
+        response["deals"] = _records(result['deals'])
+    return response
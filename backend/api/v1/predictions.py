@@ -4,17 +4,21 @@ ML-powered stock direction predictions
 """
 
 from fastapi import APIRouter, HTTPException, Query, Depends
+from fastapi.concurrency import run_in_threadpool
 from sqlalchemy.orm import Session
 from typing import List
 from datetime import datetime, timedelta
 import pandas as pd
 import logging
 
+from config import settings
 from database import get_db
 from models import Predictions, SentimentData
 from schemas import prediction_schema
 from services.ml_engine.feature_engineering import FeatureEngineer
-from services.ml_engine.model_training import XGBoostPredictor
+from services.ml_engine.prediction_batcher import get_prediction_coalescer
+from services.ml_engine.prediction_log import get_prediction_log
+from services.ml_engine.outcome_resolver import OutcomeResolver
 from services.data_ingestion.market_data import MarketDataService
 
 logger = logging.getLogger(__name__)
@@ -44,6 +48,45 @@ async def get_predictions(
     return predictions
 
 
+def _latest_features(ticker: str, db: Session) -> pd.DataFrame:
+    """Fetch prices and sentiment for ticker and return its latest feature row"""
+    market_service = MarketDataService()
+    price_df = market_service.fetch_prices(ticker, start_date=None, end_date=None)
+
+    if price_df.empty:
+        raise HTTPException(status_code=404, detail=f"No price data found for {ticker}")
+
+    # Calculate returns (including log_returns needed for model)
+    price_df = market_service.calculate_returns(price_df)
+
+    # Get sentiment data (optional)
+    sentiment_data = db.query(SentimentData)\
+        .filter(SentimentData.ticker == ticker.upper())\
+        .all()
+
+    sentiment_df = pd.DataFrame([{
+        'date': s.date,
+        'sentiment_score': s.sentiment_score,
+        'article_count': s.article_count
+    } for s in sentiment_data]) if sentiment_data else None
+
+    # Engineer features
+    engineer = FeatureEngineer(use_cpp=settings.USE_CPP_INDICATORS)
+    features_df = engineer.create_features(price_df, sentiment_df)
+
+    if features_df.empty:
+        raise HTTPException(status_code=500, detail="Failed to engineer features")
+
+    feature_names = engineer.get_feature_names(features_df)
+    return features_df.iloc[-1:][feature_names]
+
+
+def _save(db: Session, entry: Predictions) -> None:
+    db.add(entry)
+    db.commit()
+    db.refresh(entry)
+
+
 @router.post("/predictions/{ticker}/predict")
 async def make_prediction(
     ticker: str,
@@ -55,43 +98,16 @@ async def make_prediction(
     """
 
     try:
-        # Load trained model
-        model = XGBoostPredictor(model_path='models/xgboost_model.pkl')
-
-        # Fetch latest data
-        market_service = MarketDataService()
-        price_df = market_service.fetch_prices(ticker, start_date=None, end_date=None)
-
-        if price_df.empty:
-            raise HTTPException(status_code=404, detail=f"No price data found for {ticker}")
+        # Shared scorer; concurrent requests are batched into one model call.
+        # The first call (or one after retraining) loads and exports the model.
+        model = await run_in_threadpool(get_prediction_coalescer, 'models/xgboost_model.pkl')
 
-        # Calculate returns (including log_returns needed for model)
-        price_df = market_service.calculate_returns(price_df)
-
-        # Get sentiment data (optional)
-        sentiment_data = db.query(SentimentData)\
-            .filter(SentimentData.ticker == ticker.upper())\
-            .all()
-
-        sentiment_df = pd.DataFrame([{
-            'date': s.date,
-            'sentiment_score': s.sentiment_score,
-            'article_count': s.article_count
-        } for s in sentiment_data]) if sentiment_data else None
-
-        # Engineer features
-        engineer = FeatureEngineer()
-        features_df = engineer.create_features(price_df, sentiment_df)
-
-        if features_df.empty:
-            raise HTTPException(status_code=500, detail="Failed to engineer features")
-
-        # Get latest features
-        feature_names = engineer.get_feature_names(features_df)
-        latest_features = features_df.iloc[-1:][feature_names]
+        # Data fetch and feature engineering are blocking; run them off the
+        # event loop so concurrent requests reach the coalescer together
+        latest_features = await run_in_threadpool(_latest_features, ticker, db)
 
         # Make prediction
-        prediction_result = model.predict(latest_features)
+        prediction_result = await model.predict(latest_features)
 
         # Save to database
         prediction_entry = Predictions(
@@ -105,9 +121,7 @@ async def make_prediction(
             model_version="xgboost_v2_5day"
         )
 
-        db.add(prediction_entry)
-        db.commit()
-        db.refresh(prediction_entry)
+        await run_in_threadpool(_save, db, prediction_entry)
 
         logger.info(f"Generated prediction for {ticker}: {prediction_result['prediction']} ({prediction_result['confidence']:.2%} confidence)")
 
@@ -128,6 +142,26 @@ async def make_prediction(
         raise HTTPException(status_code=500, detail=str(e))
 
 
+@router.post("/predictions/resolve-outcomes")
+async def resolve_prediction_outcomes(db: Session = Depends(get_db)):
+    """
+    Fill actual_direction / correct for every prediction whose target date has passed
+    Intended for the nightly job after prices are ingested
+    """
+    try:
+        return await run_in_threadpool(OutcomeResolver().resolve, db)
+    except Exception as e:
+        logger.error(f"Error resolving prediction outcomes: {e}")
+        raise HTTPException(status_code=500, detail=str(e))
+
+
+def _synced_log(db: Session):
+    """Process-wide accuracy log, caught up with the Predictions table"""
+    log = get_prediction_log()
+    log.sync(db)
+    return log
+
+
 @router.get("/predictions/{ticker}/accuracy")
 async def get_prediction_accuracy(
     ticker: str,
@@ -138,43 +172,72 @@ async def get_prediction_accuracy(
     Calculate prediction accuracy for ticker
     Compares predictions to actual outcomes
     """
-    cutoff_date = datetime.now() - timedelta(days=days)
+    log = await run_in_threadpool(_synced_log, db)
+    summary = log.accuracy(ticker=ticker.upper(), start=(datetime.now() - timedelta(days=days)).date())
 
-    predictions = db.query(Predictions)\
-        .filter(
-            Predictions.ticker == ticker.upper(),
-            Predictions.prediction_date >= cutoff_date,
-            Predictions.actual_direction.isnot(None)
-        )\
-        .all()
-
-    if not predictions:
+    total = summary['total']
+    if total == 0:
         raise HTTPException(status_code=404, detail="No predictions with actual outcomes found")
 
-    total = len(predictions)
-    correct = sum(1 for p in predictions if p.correct)
-    accuracy = (correct / total) * 100
-
-    # Calculate by confidence bucket
-    high_conf = [p for p in predictions if p.confidence > 0.7]
-    medium_conf = [p for p in predictions if 0.6 <= p.confidence <= 0.7]
-    low_conf = [p for p in predictions if p.confidence < 0.6]
+    def bucket(name):
+        count = summary[name]['count']
+        return {
+            "count": count,
+            "accuracy": round(summary[name]['correct'] / count * 100, 2) if count else 0
+        }
 
     return {
         "ticker": ticker,
         "total_predictions": total,
-        "correct_predictions": correct,
-        "accuracy_pct": round(accuracy, 2),
-        "high_confidence": {
-            "count": len(high_conf),
-            "accuracy": round((sum(1 for p in high_conf if p.correct) / len(high_conf) * 100), 2) if high_conf else 0
-        },
-        "medium_confidence": {
-            "count": len(medium_conf),
-            "accuracy": round((sum(1 for p in medium_conf if p.correct) / len(medium_conf) * 100), 2) if medium_conf else 0
-        },
-        "low_confidence": {
-            "count": len(low_conf),
-            "accuracy": round((sum(1 for p in low_conf if p.correct) / len(low_conf) * 100), 2) if low_conf else 0
-        }
+        "correct_predictions": summary['correct'],
+        "accuracy_pct": round(summary['correct'] / total * 100, 2),
+        "high_confidence": bucket('high'),
+        "medium_confidence": bucket('medium'),
+        "low_confidence": bucket('low')
     }
+
+
+@router.get("/predictions/{ticker}/accuracy/rolling")
+async def get_rolling_accuracy(
+    ticker: str,
+    days: int = Query(default=365, ge=30, le=3650),
+    window: int = Query(default=30, ge=5, le=365),
+    model_version: str = Query(default=''),
+    db: Session = Depends(get_db)
+):
+    """Trailing-window accuracy at each prediction day"""
+    log = await run_in_threadpool(_synced_log, db)
+    series = log.rolling_accuracy(window, ticker=ticker.upper(), model_version=model_version,
+                                  start=(datetime.now() - timedelta(days=days)).date())
+    return {
+        "ticker": ticker,
+        "window_days": window,
+        "series": [
+            {"date": row.date, "total": int(row.total), "correct": int(row.correct),
+             "accuracy_pct": float(row.accuracy_pct)}
+            for row in series.itertuples(index=False)
+        ]
+    }
+
+
+@router.get("/predictions/accuracy/breakdown")
+async def get_accuracy_breakdown(
+    group_by: str = Query(default='ticker', pattern='^(ticker|model_version|bucket)$'),
+    days: int = Query(default=90, ge=1, le=3650),
+    model_version: str = Query(default=''),
+    db: Session = Depends(get_db)
+):
+    """Accuracy per ticker, model version or confidence bucket across all predictions"""
+    log = await run_in_threadpool(_synced_log, db)
+    groups = log.accuracy_by(group_by, model_version=model_version,
+                             start=(datetime.now() - timedelta(days=days)).date())
+    return [
+        {
+            group_by: g['key'],
+            "predictions": g['predictions'],
+            "resolved": g['total'],
+            "correct": g['correct'],
+            "accuracy_pct": round(g['correct'] / g['total'] * 100, 2) if g['total'] else None
+        }
+        for g in groups
+    ]
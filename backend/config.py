@@ -56,10 +56,12 @@ class Settings(BaseSettings):
     # ML Model Settings
     MODEL_VERSION: str = "v1.0"
     MODEL_PATH: str = os.getenv("MODEL_PATH", "./models")
+    PREDICTION_LOG_PATH: str = os.getenv("PREDICTION_LOG_PATH", "./models/prediction_log.aslog")  # "" = memory only
     FEATURE_COUNT: int = 47
 
     # Technical Indicators Settings
     USE_CPP_INDICATORS: bool = os.getenv("USE_CPP_INDICATORS", "True").lower() == "true"
+    KERNEL_CACHE_MB: int = int(os.getenv("KERNEL_CACHE_MB", "0"))  # 0 = memo cache off
 
     # Cache Settings
     CACHE_ENABLED: bool = True
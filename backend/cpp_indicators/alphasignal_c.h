@@ -0,0 +1,102 @@
+#ifndef ALPHASIGNAL_C_H
+#define ALPHASIGNAL_C_H
+
+/*
+ * Stable C ABI over the alphasignal core library (libalphasignal_c).
+ *
+ * - Every function returns an asg_status; on failure asg_last_error()
+ *   describes the error for the calling thread until its next call.
+ * - Callers own every buffer. Outputs are written in full and never
+ *   resized; sizes are given in elements, not bytes.
+ * - Multi-column outputs are column-major: column k of an n-row result
+ *   starts at out + k * n.
+ * - Handles (asg_universe, asg_model) are opaque and must be released with
+ *   their destroy function. A handle may be read from several threads at
+ *   once but must not be updated concurrently.
+ *
+ * New functions may be added; existing signatures and the meaning of
+ * existing enum values only change together with ASG_ABI_VERSION.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#ifdef alphasignal_c_EXPORTS /* defined by CMake while building the DLL */
+#define ASG_API __declspec(dllexport)
+#else
+#define ASG_API __declspec(dllimport)
+#endif
+#else
+#define ASG_API __attribute__((visibility("default")))
+#endif
+
+#define ASG_ABI_VERSION 1
+
+typedef enum asg_status {
+    ASG_OK = 0,
+    ASG_INVALID_ARGUMENT = 1,
+    ASG_RUNTIME_ERROR = 2,
+    ASG_OUT_OF_MEMORY = 3,
+    ASG_UNKNOWN_ERROR = 4
+} asg_status;
+
+ASG_API uint32_t asg_abi_version(void);
+ASG_API const char *asg_last_error(void);
+
+/* Classic indicators; warm-up rows are 0 (see technical.h) */
+ASG_API asg_status asg_rsi(const double *prices, size_t n, int period, double *out);
+ASG_API asg_status asg_macd(const double *prices, size_t n, int fast_period, int slow_period,
+                            int signal_period, double *macd, double *signal, double *hist);
+ASG_API asg_status asg_bollinger_bands(const double *prices, size_t n, int period, double num_std,
+                                       double *upper, double *middle, double *lower);
+ASG_API asg_status asg_rolling_correlation(const double *x, const double *y, size_t n, int window,
+                                           double *out);
+
+/* Returns over n_horizons look-backs: simple and (optional, may be NULL)
+ * log returns, n_horizons x n each; NaN where undefined */
+ASG_API asg_status asg_returns(const double *close, size_t n, const int32_t *horizons,
+                               size_t n_horizons, double *simple, double *log_returns);
+
+/* Candlestick pattern bits (one uint64 per bar, CandlePattern order) and
+ * the 6 shape features (6 x n); either output may be NULL */
+ASG_API asg_status asg_candle_patterns(const double *open, const double *high, const double *low,
+                                       const double *close, size_t n, uint64_t *patterns,
+                                       double *features);
+
+/* Calendar features from epoch days: asg_calendar_feature_count() x n */
+ASG_API size_t asg_calendar_feature_count(void);
+ASG_API asg_status asg_calendar_features(const int64_t *days, size_t n, const int64_t *holidays,
+                                         size_t n_holidays, double *out);
+
+/* Streaming RSI / MACD / Bollinger state for a fixed universe (default
+ * periods 14, 12/26/9, 20 x 2). Features are asg_universe_feature_count()
+ * x n_tickers. */
+typedef struct asg_universe asg_universe;
+
+ASG_API size_t asg_universe_feature_count(void);
+ASG_API asg_status asg_universe_create(size_t n_tickers, asg_universe **out);
+ASG_API void asg_universe_destroy(asg_universe *universe);
+/* prices: n_tickers values (NaN = no print); features may be NULL */
+ASG_API asg_status asg_universe_update(asg_universe *universe, const double *prices,
+                                       double *features);
+
+/* Gradient-boosted tree ensemble exported by XGBoostPredictor.export_native */
+typedef struct asg_model asg_model;
+
+ASG_API asg_status asg_model_load(const char *path, asg_model **out);
+ASG_API void asg_model_destroy(asg_model *model);
+ASG_API int32_t asg_model_feature_count(const asg_model *model);
+/* rows: n_rows x feature_count, row-major; out: n_rows probabilities */
+ASG_API asg_status asg_model_predict(const asg_model *model, const double *rows, size_t n_rows,
+                                     double *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ALPHASIGNAL_C_H */
@@ -0,0 +1,96 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <new>
+
+namespace alphasignal {
+
+Arena::Arena(size_t first_block) : first_block_(std::max<size_t>(first_block, 4096)) {}
+
+Arena::~Arena() { release_blocks(); }
+
+void Arena::add_block(size_t size) {
+    char *data = static_cast<char *>(::operator new(size, std::align_val_t{64}));
+    blocks_.push_back(Block{data, size});
+    ++upstream_;
+}
+
+void Arena::release_blocks() {
+    for (const Block &b : blocks_) {
+        ::operator delete(b.data, std::align_val_t{64});
+    }
+    blocks_.clear();
+}
+
+void *Arena::do_allocate(size_t bytes, size_t alignment) {
+    ++allocations_;
+    if (bytes == 0) {
+        bytes = 1;
+    }
+    for (;;) {
+        if (current_ < blocks_.size()) {
+            const Block &b = blocks_[current_];
+            const uintptr_t base = reinterpret_cast<uintptr_t>(b.data);
+            const uintptr_t aligned = (base + offset_ + alignment - 1) & ~(uintptr_t(alignment) - 1);
+            const size_t begin = static_cast<size_t>(aligned - base);
+            if (begin + bytes <= b.size) {
+                offset_ = begin + bytes;
+                high_water_ = std::max(high_water_, used_before_ + offset_);
+                return b.data + begin;
+            }
+            // Move on to the next retained block, or grow
+            used_before_ += b.size;
+            ++current_;
+            offset_ = 0;
+            continue;
+        }
+        const size_t last = blocks_.empty() ? first_block_ : blocks_.back().size * 2;
+        add_block(std::max(last, bytes + alignment));
+    }
+}
+
+void Arena::rewind(const Mark &m) {
+    if (m.block != 0 || m.offset != 0) {
+        used_before_ = 0;
+        for (size_t b = 0; b < m.block && b < blocks_.size(); ++b) {
+            used_before_ += blocks_[b].size;
+        }
+        current_ = m.block;
+        offset_ = m.offset;
+        return;
+    }
+    // Empty again: fold the blocks this pass needed into one, within the cap
+    if (blocks_.size() > 1) {
+        size_t total = 0;
+        for (const Block &b : blocks_) {
+            total += b.size;
+        }
+        release_blocks();
+        add_block(std::min(total, kMaxRetained));
+    } else if (!blocks_.empty() && blocks_[0].size > kMaxRetained) {
+        release_blocks();
+    }
+    current_ = 0;
+    offset_ = 0;
+    used_before_ = 0;
+}
+
+ArenaStats Arena::stats() const {
+    ArenaStats s;
+    s.allocations = allocations_;
+    s.upstream_allocations = upstream_;
+    s.blocks = blocks_.size();
+    for (const Block &b : blocks_) {
+        s.capacity += b.size;
+    }
+    s.in_use = used_before_ + offset_;
+    s.high_water = high_water_;
+    return s;
+}
+
+Arena &thread_arena() {
+    thread_local Arena arena;
+    return arena;
+}
+
+}  // namespace alphasignal
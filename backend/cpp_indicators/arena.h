@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace alphasignal {
+
+struct ArenaStats {
+    uint64_t allocations = 0;           // requests served
+    uint64_t upstream_allocations = 0;  // blocks taken from the heap
+    size_t blocks = 0;
+    size_t capacity = 0;    // bytes held across all blocks
+    size_t in_use = 0;      // bytes handed out since the last full rewind (approx.)
+    size_t high_water = 0;  // largest in_use seen
+};
+
+// Bump allocator for kernel temporaries. Allocation is a pointer bump,
+// deallocation is a no-op, and memory comes back in bulk by rewinding to
+// a mark. Blocks are kept across rewinds, so once a thread has seen its
+// largest request it stops touching the heap. Rewinding to empty folds
+// several blocks into one of their combined size. Not thread-safe: use
+// thread_arena(). pmr containers take it as their memory_resource.
+class Arena : public std::pmr::memory_resource {
+public:
+    struct Mark {
+        size_t block;
+        size_t offset;
+    };
+
+    explicit Arena(size_t first_block = size_t(64) << 10);
+    ~Arena() override;
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    Mark mark() const { return Mark{current_, offset_}; }
+    // Everything allocated after m becomes reusable
+    void rewind(const Mark &m);
+    void reset() { rewind(Mark{0, 0}); }
+
+    ArenaStats stats() const;
+
+    // Retained capacity above this is returned to the heap on a full rewind
+    static constexpr size_t kMaxRetained = size_t(64) << 20;
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    struct Block {
+        char *data;
+        size_t size;
+    };
+
+    void add_block(size_t size);
+    void release_blocks();
+
+    std::vector<Block> blocks_;
+    size_t first_block_;
+    size_t current_ = 0;
+    size_t offset_ = 0;
+    size_t used_before_ = 0;  // bytes in blocks before current_
+    uint64_t allocations_ = 0;
+    uint64_t upstream_ = 0;
+    size_t high_water_ = 0;
+};
+
+// The calling thread's arena
+Arena &thread_arena();
+
+// Rewinds the calling thread's arena when it goes out of scope. Wrap a
+// kernel call, a request or a batch; scopes nest.
+class ArenaScope {
+public:
+    ArenaScope() : arena_(thread_arena()), mark_(arena_.mark()) {}
+    ~ArenaScope() { arena_.rewind(mark_); }
+
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+    Arena &arena() { return arena_; }
+
+private:
+    Arena &arena_;
+    Arena::Mark mark_;
+};
+
+// Scratch buffer on the calling thread's arena; valid until the enclosing
+// ArenaScope ends. Growth allocates at the arena's current mark, so a
+// buffer from an outer scope must not grow (push_back past capacity,
+// resize, assign) while an inner ArenaScope is open: its new storage
+// would be handed out again when the inner scope rewinds. Reserve or size
+// it before opening the inner scope. Buffers made on one thread and only
+// written by parallel_for workers are fine; workers allocate from their
+// own arenas.
+template <class T>
+using ScratchVector = std::pmr::vector<T>;
+
+template <class T>
+ScratchVector<T> scratch(size_t n, const T &value = T()) {
+    return ScratchVector<T>(n, value, &thread_arena());
+}
+
+}  // namespace alphasignal
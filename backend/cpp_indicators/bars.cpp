@@ -0,0 +1,201 @@
+#include "bars.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "batch.h"
+
+namespace alphasignal {
+
+namespace {
+
+// Floor division, so bars before the epoch align like the ones after it
+inline int64_t floor_div(int64_t a, int64_t b) {
+    const int64_t q = a / b;
+    return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+}
+
+}  // namespace
+
+BarType parse_bar_type(const std::string &name) {
+    if (name == "time") {
+        return BarType::Time;
+    }
+    if (name == "tick") {
+        return BarType::Tick;
+    }
+    if (name == "volume") {
+        return BarType::Volume;
+    }
+    if (name == "dollar") {
+        return BarType::Dollar;
+    }
+    if (name == "tick_imbalance") {
+        return BarType::TickImbalance;
+    }
+    throw std::invalid_argument("unknown bar type: " + name);
+}
+
+BarBuilder::BarBuilder(const BarOptions &opts) : opts_(opts) {
+    switch (opts_.type) {
+        case BarType::Time:
+            if (opts_.interval_ns <= 0) {
+                throw std::invalid_argument("interval_ns must be positive");
+            }
+            break;
+        case BarType::TickImbalance:
+            if (opts_.expected_ticks < 1.0 || opts_.expected_imbalance <= 0.0 ||
+                opts_.ewma_span < 1.0) {
+                throw std::invalid_argument(
+                    "expected_ticks and ewma_span must be >= 1, expected_imbalance > 0");
+            }
+            break;
+        default:
+            if (!(opts_.threshold > 0.0)) {
+                throw std::invalid_argument("threshold must be positive");
+            }
+    }
+    reset();
+}
+
+void BarBuilder::reset() {
+    bar_ = Bar{};
+    bar_end_ns_ = 0;
+    last_price_ = 0.0;
+    last_sign_ = 1.0;
+    seen_tick_ = false;
+    theta_ = 0.0;
+    ewma_ticks_ = opts_.expected_ticks;
+    ewma_imbalance_ = std::min(opts_.expected_imbalance, 1.0);
+    threshold_ = imbalance_threshold();
+}
+
+double BarBuilder::imbalance_threshold() const {
+    // At least one tick, or every tick would close a bar
+    return std::max(ewma_ticks_ * ewma_imbalance_, 1.0);
+}
+
+void BarBuilder::open_bar(int64_t ts, double price) {
+    bar_ = Bar{};
+    bar_.start_ns = ts;
+    bar_.open = bar_.high = bar_.low = price;
+    if (opts_.type == BarType::Time) {
+        bar_end_ns_ = (floor_div(ts, opts_.interval_ns) + 1) * opts_.interval_ns;
+    }
+}
+
+Bar BarBuilder::close_bar() {
+    bar_.vwap = bar_.volume > 0.0 ? bar_.dollar_volume / bar_.volume : bar_.close;
+    const Bar closed = bar_;
+    if (opts_.type == BarType::TickImbalance) {
+        const double ticks = static_cast<double>(bar_.ticks);
+        const double alpha = 2.0 / (opts_.ewma_span + 1.0);
+        // E[T] feeds back into the bar length and can run away in either
+        // direction, so it is held within a decade of the prior
+        ewma_ticks_ += alpha * (ticks - ewma_ticks_);
+        ewma_ticks_ = std::min(std::max(ewma_ticks_, 0.1 * opts_.expected_ticks),
+                               10.0 * opts_.expected_ticks);
+        ewma_imbalance_ += alpha * (std::fabs(theta_) / ticks - ewma_imbalance_);
+        threshold_ = imbalance_threshold();
+        theta_ = 0.0;
+    }
+    bar_.ticks = 0;
+    return closed;
+}
+
+template <BarType Type>
+size_t BarBuilder::run(const int64_t *ts, const double *price, const double *size, size_t n,
+                       std::vector<Bar> &out) {
+    const size_t before = out.size();
+    for (size_t i = 0; i < n; ++i) {
+        const double p = price[i];
+        if (is_missing(p)) {
+            continue;
+        }
+        const double q = is_missing(size[i]) ? 0.0 : size[i];
+        const int64_t t = ts[i];
+
+        // Tick rule: an unchanged price repeats the previous direction
+        double sign = 0.0;
+        if (seen_tick_) {
+            sign = p > last_price_ ? 1.0 : (p < last_price_ ? -1.0 : last_sign_);
+            last_sign_ = sign;
+        }
+        last_price_ = p;
+        seen_tick_ = true;
+
+        if (Type == BarType::Time && bar_.ticks > 0 && t >= bar_end_ns_) {
+            out.push_back(close_bar());
+        }
+        if (bar_.ticks == 0) {
+            open_bar(t, p);
+        }
+        bar_.end_ns = t;
+        bar_.high = std::max(bar_.high, p);
+        bar_.low = std::min(bar_.low, p);
+        bar_.close = p;
+        bar_.volume += q;
+        bar_.dollar_volume += p * q;
+        bar_.buy_volume += sign > 0.0 ? q : 0.0;
+        ++bar_.ticks;
+
+        bool done = false;
+        switch (Type) {
+            case BarType::Tick:
+                done = static_cast<double>(bar_.ticks) >= opts_.threshold;
+                break;
+            case BarType::Volume:
+                done = bar_.volume >= opts_.threshold;
+                break;
+            case BarType::Dollar:
+                done = bar_.dollar_volume >= opts_.threshold;
+                break;
+            case BarType::TickImbalance:
+                theta_ += sign;
+                done = std::fabs(theta_) >= threshold_;
+                break;
+            default:
+                break;
+        }
+        if (done) {
+            out.push_back(close_bar());
+        }
+    }
+    return out.size() - before;
+}
+
+size_t BarBuilder::update(const int64_t *ts, const double *price, const double *size, size_t n,
+                          std::vector<Bar> &out) {
+    switch (opts_.type) {
+        case BarType::Time: return run<BarType::Time>(ts, price, size, n, out);
+        case BarType::Tick: return run<BarType::Tick>(ts, price, size, n, out);
+        case BarType::Volume: return run<BarType::Volume>(ts, price, size, n, out);
+        case BarType::Dollar: return run<BarType::Dollar>(ts, price, size, n, out);
+        default: return run<BarType::TickImbalance>(ts, price, size, n, out);
+    }
+}
+
+bool BarBuilder::flush(Bar &out) {
+    if (bar_.ticks == 0) {
+        return false;
+    }
+    // The imbalance estimates learn from the partial bar too: a session
+    // boundary is a genuine close
+    out = close_bar();
+    return true;
+}
+
+std::vector<Bar> make_bars(const int64_t *ts, const double *price, const double *size, size_t n,
+                           const BarOptions &opts) {
+    BarBuilder builder(opts);
+    std::vector<Bar> bars;
+    builder.update(ts, price, size, n, bars);
+    Bar last;
+    if (builder.flush(last)) {
+        bars.push_back(last);
+    }
+    return bars;
+}
+
+}  // namespace alphasignal
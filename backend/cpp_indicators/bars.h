@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace alphasignal {
+
+// Tick-to-bar aggregation. Ticks are (timestamp ns, price, size) in time
+// order; a bar is emitted as soon as its closing condition is met, so the
+// builder streams with constant state and can be fed chunk by chunk.
+enum class BarType {
+    Time,           // fixed clock intervals aligned to multiples of interval_ns
+    Tick,           // every `threshold` ticks
+    Volume,         // once cumulative size reaches `threshold`
+    Dollar,         // once cumulative price * size reaches `threshold`
+    TickImbalance,  // once |signed tick count| exceeds its expected value
+};
+
+struct BarOptions {
+    BarType type = BarType::Time;
+    int64_t interval_ns = 60'000'000'000;  // Time bars; empty intervals emit no bar
+    double threshold = 0.0;                // Tick / Volume / Dollar bars
+    // Tick-imbalance bars (Lopez de Prado, AFML 2.3.2.1): close when
+    // |sum b_t| >= E[T] * |E[b]|, both estimated by an EWMA over past bars.
+    // E[T] stays within [0.1, 10] x expected_ticks.
+    double expected_ticks = 1000.0;    // E[T] before the first bar closes
+    double expected_imbalance = 0.1;   // |E[b]| before the first bar closes
+    double ewma_span = 20.0;           // in bars
+};
+
+BarType parse_bar_type(const std::string &name);
+
+struct Bar {
+    int64_t start_ns;  // first tick
+    int64_t end_ns;    // last tick
+    double open;
+    double high;
+    double low;
+    double close;
+    double volume;
+    double dollar_volume;
+    double vwap;        // dollar_volume / volume; close when the bar has no volume
+    double buy_volume;  // size of upticks by the tick rule
+    int64_t ticks;
+};
+
+class BarBuilder {
+public:
+    explicit BarBuilder(const BarOptions &opts = BarOptions());
+
+    // Appends every bar closed by these ticks to `out` and returns how many.
+    // Ticks with a NaN price are skipped; a NaN size counts as 0.
+    size_t update(const int64_t *ts, const double *price, const double *size, size_t n,
+                  std::vector<Bar> &out);
+
+    // Emits the partial bar, if any, and starts afresh (end of a session or file)
+    bool flush(Bar &out);
+    void reset();
+
+    bool has_partial() const { return bar_.ticks > 0; }
+    const Bar &partial() const { return bar_; }
+    // Current tick-imbalance threshold E[T] * |E[b]|
+    double imbalance_threshold() const;
+
+private:
+    template <BarType Type>
+    size_t run(const int64_t *ts, const double *price, const double *size, size_t n,
+               std::vector<Bar> &out);
+    void open_bar(int64_t ts, double price);
+    Bar close_bar();
+
+    BarOptions opts_;
+    Bar bar_;
+    int64_t bar_end_ns_ = 0;  // Time bars: exclusive end of the open interval
+    // Tick rule state survives bar boundaries
+    double last_price_ = 0.0;
+    double last_sign_ = 1.0;
+    bool seen_tick_ = false;
+    // Tick-imbalance state
+    double theta_ = 0.0;
+    double ewma_ticks_;
+    double ewma_imbalance_;
+    double threshold_;
+};
+
+// One-shot conversion of a tick array, partial last bar included
+std::vector<Bar> make_bars(const int64_t *ts, const double *price, const double *size, size_t n,
+                           const BarOptions &opts);
+
+}  // namespace alphasignal
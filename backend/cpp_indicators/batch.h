@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace alphasignal {
+
+// Multi-ticker input layout shared by the batched kernels: every ticker's
+// rows are stored back to back and row range [offsets[i], offsets[i + 1])
+// belongs to ticker i. offsets has n_series + 1 entries.
+struct RaggedBatch {
+    const int64_t *offsets = nullptr;
+    size_t n_series = 0;
+
+    size_t begin(size_t i) const { return static_cast<size_t>(offsets[i]); }
+    size_t length(size_t i) const { return static_cast<size_t>(offsets[i + 1] - offsets[i]); }
+    size_t total_rows() const { return n_series ? static_cast<size_t>(offsets[n_series]) : 0; }
+};
+
+// Column pointers of an OHLCV table, one entry per row
+struct OHLCVColumns {
+    const double *open;
+    const double *high;
+    const double *low;
+    const double *close;
+    const double *volume;
+};
+
+// NaN test that survives -ffast-math (std::isnan may be folded to false
+// under -ffinite-math-only). Branch-free, so loops using it still vectorize.
+inline bool is_missing(double x) {
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return (bits & 0x7fffffffffffffffULL) > 0x7ff0000000000000ULL;
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,180 @@
+#include "alphasignal_c.h"
+
+#include <exception>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "calendar.h"
+#include "candles.h"
+#include "returns.h"
+#include "technical.h"
+#include "tree_model.h"
+#include "universe_state.h"
+
+namespace as = alphasignal;
+
+struct asg_universe {
+    as::UniverseState state;
+};
+
+struct asg_model {
+    as::TreeEnsemble ensemble;
+};
+
+namespace {
+
+thread_local std::string g_last_error;
+
+asg_status fail(asg_status status, const char *message) {
+    g_last_error = message;
+    return status;
+}
+
+// Runs fn, translating C++ exceptions into status codes; nothing may unwind
+// across the C boundary
+template <typename Fn>
+asg_status guarded(Fn &&fn) {
+    try {
+        fn();
+        g_last_error.clear();
+        return ASG_OK;
+    } catch (const std::invalid_argument &e) {
+        return fail(ASG_INVALID_ARGUMENT, e.what());
+    } catch (const std::bad_alloc &) {
+        return fail(ASG_OUT_OF_MEMORY, "out of memory");
+    } catch (const std::exception &e) {
+        return fail(ASG_RUNTIME_ERROR, e.what());
+    } catch (...) {
+        return fail(ASG_UNKNOWN_ERROR, "unknown error");
+    }
+}
+
+void require(bool ok, const char *message) {
+    if (!ok) {
+        throw std::invalid_argument(message);
+    }
+}
+
+}  // namespace
+
+extern "C" {
+
+uint32_t asg_abi_version(void) { return ASG_ABI_VERSION; }
+
+const char *asg_last_error(void) { return g_last_error.c_str(); }
+
+asg_status asg_rsi(const double *prices, size_t n, int period, double *out) {
+    return guarded([&] {
+        require((prices && out) || n == 0, "null buffer");
+        as::rsi(prices, n, period, out);
+    });
+}
+
+asg_status asg_macd(const double *prices, size_t n, int fast_period, int slow_period,
+                    int signal_period, double *macd, double *signal, double *hist) {
+    return guarded([&] {
+        require((prices && macd && signal && hist) || n == 0, "null buffer");
+        as::macd(prices, n, fast_period, slow_period, signal_period, macd, signal, hist);
+    });
+}
+
+asg_status asg_bollinger_bands(const double *prices, size_t n, int period, double num_std,
+                               double *upper, double *middle, double *lower) {
+    return guarded([&] {
+        require((prices && upper && middle && lower) || n == 0, "null buffer");
+        as::bollinger_bands(prices, n, period, num_std, upper, middle, lower);
+    });
+}
+
+asg_status asg_rolling_correlation(const double *x, const double *y, size_t n, int window,
+                                   double *out) {
+    return guarded([&] {
+        require((x && y && out) || n == 0, "null buffer");
+        as::rolling_correlation(x, y, n, window, out);
+    });
+}
+
+asg_status asg_returns(const double *close, size_t n, const int32_t *horizons, size_t n_horizons,
+                       double *simple, double *log_returns) {
+    return guarded([&] {
+        require((close && simple) || n == 0, "null buffer");
+        require(horizons || n_horizons == 0, "null horizons");
+        as::ReturnsOptions opts;
+        opts.horizons.assign(horizons, horizons + n_horizons);
+        opts.log = log_returns != nullptr;
+        as::compute_returns(close, n, opts,
+                            as::ReturnsOutput{simple, log_returns, nullptr, nullptr, n});
+    });
+}
+
+asg_status asg_candle_patterns(const double *open, const double *high, const double *low,
+                               const double *close, size_t n, uint64_t *patterns,
+                               double *features) {
+    return guarded([&] {
+        require((open && high && low && close) || n == 0, "null buffer");
+        // The kernel always writes both outputs
+        std::vector<uint64_t> bits(patterns ? 0 : n);
+        std::vector<double> feats(features ? 0 : as::kNumCandleFeatures * n);
+        as::candle_patterns(as::OHLCVColumns{open, high, low, close, nullptr}, n,
+                            as::CandleOptions(), patterns ? patterns : bits.data(),
+                            features ? features : feats.data(), n);
+    });
+}
+
+size_t asg_calendar_feature_count(void) { return as::kNumCalendarFeatures; }
+
+asg_status asg_calendar_features(const int64_t *days, size_t n, const int64_t *holidays,
+                                 size_t n_holidays, double *out) {
+    return guarded([&] {
+        require((days && out) || n == 0, "null buffer");
+        require(holidays || n_holidays == 0, "null holidays");
+        as::calendar_features(days, n, holidays, n_holidays, out);
+    });
+}
+
+size_t asg_universe_feature_count(void) { return as::kNumUniverseFeatures; }
+
+asg_status asg_universe_create(size_t n_tickers, asg_universe **out) {
+    return guarded([&] {
+        require(out != nullptr, "null output handle");
+        *out = new asg_universe{as::UniverseState(n_tickers)};
+    });
+}
+
+void asg_universe_destroy(asg_universe *universe) { delete universe; }
+
+asg_status asg_universe_update(asg_universe *universe, const double *prices, double *features) {
+    return guarded([&] {
+        require(universe && prices, "null argument");
+        universe->state.update_all(prices);
+        if (features) {
+            universe->state.features(features);
+        }
+    });
+}
+
+asg_status asg_model_load(const char *path, asg_model **out) {
+    return guarded([&] {
+        require(path && out, "null argument");
+        *out = new asg_model{as::load_tree_ensemble(path)};
+    });
+}
+
+void asg_model_destroy(asg_model *model) { delete model; }
+
+int32_t asg_model_feature_count(const asg_model *model) {
+    return model ? model->ensemble.n_features : 0;
+}
+
+asg_status asg_model_predict(const asg_model *model, const double *rows, size_t n_rows,
+                             double *out) {
+    return guarded([&] {
+        require(model != nullptr, "null model");
+        require((rows && out) || n_rows == 0, "null buffer");
+        model->ensemble.predict_batch(rows, n_rows, out);
+    });
+}
+
+}  // extern "C"
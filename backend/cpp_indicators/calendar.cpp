@@ -0,0 +1,168 @@
+#include "calendar.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "arena.h"
+#include "thread_pool.h"
+
+namespace alphasignal {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+constexpr int64_t kNsPerDay = 86'400'000'000'000LL;
+// Holiday lookups look this far past the first / last row
+constexpr int64_t kMargin = 400;
+// 300 years of days; anything wider is almost certainly a unit mistake
+constexpr int64_t kMaxSpan = 110'000;
+constexpr size_t kRowChunk = 4096;
+
+// Day-indexed lookup tables over [first, first + size), on the calling
+// thread's arena
+struct CalendarTable {
+    int64_t first = 0;
+    ScratchVector<uint8_t> holiday{&thread_arena()};
+    // trading days strictly before each day
+    ScratchVector<int32_t> trading_before{&thread_arena()};
+    // first holiday index >= day / last holiday index <= day, or -1
+    ScratchVector<int32_t> next_holiday{&thread_arena()};
+    ScratchVector<int32_t> prev_holiday{&thread_arena()};
+
+    bool trading(int64_t idx) const { return day_of_week(first + idx) < 5 && !holiday[idx]; }
+};
+
+CalendarTable build_table(int64_t lo, int64_t hi, const int64_t *holidays, size_t n_holidays) {
+    CalendarTable tab;
+    tab.first = lo - kMargin;
+    const int64_t size = hi - lo + 2 * kMargin + 1;
+    tab.holiday.assign(size, 0);
+    for (size_t k = 0; k < n_holidays; ++k) {
+        const int64_t idx = holidays[k] - tab.first;
+        if (idx >= 0 && idx < size && day_of_week(holidays[k]) < 5) {
+            tab.holiday[idx] = 1;
+        }
+    }
+    tab.trading_before.resize(size + 1);
+    tab.trading_before[0] = 0;
+    for (int64_t i = 0; i < size; ++i) {
+        tab.trading_before[i + 1] = tab.trading_before[i] + (tab.trading(i) ? 1 : 0);
+    }
+    tab.next_holiday.resize(size);
+    tab.prev_holiday.resize(size);
+    int32_t last = -1;
+    for (int64_t i = 0; i < size; ++i) {
+        last = tab.holiday[i] ? static_cast<int32_t>(i) : last;
+        tab.prev_holiday[i] = last;
+    }
+    last = -1;
+    for (int64_t i = size; i-- > 0;) {
+        last = tab.holiday[i] ? static_cast<int32_t>(i) : last;
+        tab.next_holiday[i] = last;
+    }
+    return tab;
+}
+
+// Weekday strictly after / before idx (skipping weekends only)
+inline int64_t next_weekday(int64_t day) {
+    const int32_t dow = day_of_week(day);
+    return day + (dow == 4 ? 3 : (dow == 5 ? 2 : 1));
+}
+
+inline int64_t prev_weekday(int64_t day) {
+    const int32_t dow = day_of_week(day);
+    return day - (dow == 0 ? 3 : (dow == 6 ? 2 : 1));
+}
+
+}  // namespace
+
+const std::vector<std::string> &calendar_feature_names() {
+    static const std::vector<std::string> names = {
+        "year",
+        "month",
+        "day",
+        "day_of_week",
+        "day_of_year",
+        "quarter",
+        "iso_week",
+        "is_month_start",
+        "is_month_end",
+        "is_quarter_end",
+        "is_trading_day",
+        "first_trading_day_of_month",
+        "last_trading_day_of_month",
+        "trading_days_to_month_end",
+        "days_to_month_end",
+        "days_to_holiday",
+        "days_since_holiday",
+        "is_pre_holiday",
+        "is_post_holiday",
+    };
+    return names;
+}
+
+void days_from_ns(const int64_t *ns, size_t n, int64_t *days) {
+    for (size_t i = 0; i < n; ++i) {
+        const int64_t q = ns[i] / kNsPerDay;
+        days[i] = (ns[i] % kNsPerDay < 0) ? q - 1 : q;
+    }
+}
+
+void calendar_features(const int64_t *days, size_t n, const int64_t *holidays, size_t n_holidays,
+                       double *out) {
+    if (n == 0) {
+        return;
+    }
+    const auto range = std::minmax_element(days, days + n);
+    const int64_t lo = *range.first, hi = *range.second;
+    if (hi - lo > kMaxSpan) {
+        throw std::invalid_argument("dates span more than 300 years; pass epoch days, not ns");
+    }
+    ArenaScope scope;
+    const CalendarTable tab = build_table(lo, hi, holidays, n_holidays);
+
+    parallel_for((n + kRowChunk - 1) / kRowChunk, [&](size_t chunk) {
+        const size_t end = std::min(n, (chunk + 1) * kRowChunk);
+        for (size_t i = chunk * kRowChunk; i < end; ++i) {
+            const int64_t day = days[i];
+            const CivilDate date = civil_from_days(day);
+            const int32_t dow = day_of_week(day);
+            const int32_t dim = days_in_month(date.year, date.month);
+            const int64_t idx = day - tab.first;
+            const int64_t month_start = idx - (date.day - 1);
+            const int64_t month_end = month_start + dim - 1;
+
+            // ISO week: the week belongs to the year holding its Thursday
+            const CivilDate thursday = civil_from_days(day - dow + 3);
+            const bool trading = tab.trading(idx);
+            const int32_t before_in_month = tab.trading_before[idx] - tab.trading_before[month_start];
+            const int32_t after_in_month =
+                tab.trading_before[month_end + 1] - tab.trading_before[idx + 1];
+            const int32_t next_h = tab.next_holiday[idx];
+            const int32_t prev_h = tab.prev_holiday[idx];
+
+            out[kYear * n + i] = date.year;
+            out[kMonth * n + i] = date.month;
+            out[kDay * n + i] = date.day;
+            out[kDayOfWeek * n + i] = dow;
+            out[kDayOfYear * n + i] = date.day_of_year;
+            out[kQuarter * n + i] = (date.month + 2) / 3;
+            out[kIsoWeek * n + i] = (thursday.day_of_year - 1) / 7 + 1;
+            out[kIsMonthStart * n + i] = date.day == 1;
+            out[kIsMonthEnd * n + i] = date.day == dim;
+            out[kIsQuarterEnd * n + i] = date.day == dim && date.month % 3 == 0;
+            out[kIsTradingDay * n + i] = trading;
+            out[kFirstTradingDayOfMonth * n + i] = trading && before_in_month == 0;
+            out[kLastTradingDayOfMonth * n + i] = trading && after_in_month == 0;
+            out[kTradingDaysToMonthEnd * n + i] = after_in_month;
+            out[kDaysToMonthEnd * n + i] = static_cast<double>(dim - date.day);
+            out[kDaysToHoliday * n + i] = next_h >= 0 ? static_cast<double>(next_h - idx) : kNaN;
+            out[kDaysSinceHoliday * n + i] = prev_h >= 0 ? static_cast<double>(idx - prev_h) : kNaN;
+            out[kIsPreHoliday * n + i] = tab.holiday[next_weekday(day) - tab.first];
+            out[kIsPostHoliday * n + i] = tab.holiday[prev_weekday(day) - tab.first];
+        }
+    });
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace alphasignal {
+
+// Epoch days (1970-01-01 = 0) -> proleptic Gregorian date, Neri & Schneider
+// (2022): multiplications, shifts and one select, no data-dependent
+// branches. Valid for days -12'699'422 .. 1'061'042'401, i.e. -32800-03-01
+// (kShift eras before 0000-03-01) to 2907005-06-05, where 4 * n + 3 still
+// fits in 32 bits; outside that range the shifted day count wraps and the
+// result is meaningless.
+struct CivilDate {
+    int32_t year;
+    int32_t month;        // 1..12
+    int32_t day;          // 1..31
+    int32_t day_of_year;  // 1..366
+};
+
+inline CivilDate civil_from_days(int64_t days) {
+    constexpr uint32_t kShift = 82;  // eras added so the argument is non-negative
+    constexpr uint32_t kOffset = 719468 + 146097 * kShift;
+    const uint32_t n = static_cast<uint32_t>(days + kOffset);
+    const uint32_t n1 = 4 * n + 3;
+    const uint32_t century = n1 / 146097;
+    const uint32_t n_c = n1 % 146097 / 4;
+    const uint32_t n2 = 4 * n_c + 3;
+    const uint64_t p2 = uint64_t{2939745} * n2;
+    const uint32_t z = static_cast<uint32_t>(p2 >> 32);
+    const uint32_t n_y = static_cast<uint32_t>(p2) / 2939745 / 4;  // day of the March-based year
+    const uint32_t n3 = 2141 * n_y + 197913;
+    const uint32_t m = n3 >> 16;
+    const uint32_t d = (n3 & 0xffff) / 2141;
+    const uint32_t jan_feb = n_y >= 306;
+
+    CivilDate date;
+    date.year = static_cast<int32_t>(100 * century + z) - static_cast<int32_t>(400 * kShift) +
+                static_cast<int32_t>(jan_feb);
+    date.month = static_cast<int32_t>(jan_feb ? m - 12 : m);
+    date.day = static_cast<int32_t>(d + 1);
+    const int32_t y = date.year;
+    const int32_t leap = (y % 4 == 0) & ((y % 100 != 0) | (y % 400 == 0));
+    date.day_of_year = static_cast<int32_t>(jan_feb ? n_y - 305 : n_y + 60 + leap);
+    return date;
+}
+
+// Monday = 0 .. Sunday = 6
+inline int32_t day_of_week(int64_t days) {
+    // 1970-01-01 was a Thursday; the offset is a multiple of 7 keeping it positive
+    return static_cast<int32_t>(static_cast<uint64_t>(days + 3 + 7 * 146097 * 1000LL) % 7);
+}
+
+inline int32_t days_in_month(int32_t year, int32_t month) {
+    const int32_t leap = (year % 4 == 0) & ((year % 100 != 0) | (year % 400 == 0));
+    return month == 2 ? 28 + leap : 30 + ((month + (month >> 3)) & 1);
+}
+
+enum CalendarFeature : int {
+    kYear = 0,
+    kMonth,
+    kDay,
+    kDayOfWeek,
+    kDayOfYear,
+    kQuarter,
+    kIsoWeek,
+    kIsMonthStart,               // calendar day 1
+    kIsMonthEnd,                 // last calendar day
+    kIsQuarterEnd,               // last calendar day of a quarter
+    kIsTradingDay,               // weekday and not a holiday
+    kFirstTradingDayOfMonth,
+    kLastTradingDayOfMonth,
+    kTradingDaysToMonthEnd,      // trading days after this one in the month
+    kDaysToMonthEnd,             // calendar days
+    kDaysToHoliday,              // calendar days to the next holiday (NaN if none listed)
+    kDaysSinceHoliday,           // calendar days since the previous one (NaN likewise)
+    kIsPreHoliday,               // the next weekday is a holiday
+    kIsPostHoliday,              // the previous weekday was a holiday
+    kNumCalendarFeatures
+};
+
+const std::vector<std::string> &calendar_feature_names();
+
+// days: epoch days per row, any order. holidays: epoch days of exchange
+// holidays (weekend entries are ignored), any order, may be empty.
+// Output is feature-major: out[f * n + i].
+void calendar_features(const int64_t *days, size_t n, const int64_t *holidays, size_t n_holidays,
+                       double *out);
+
+// Epoch nanoseconds -> epoch days (floor), for intraday timestamps
+void days_from_ns(const int64_t *ns, size_t n, int64_t *days);
+
+}  // namespace alphasignal
@@ -0,0 +1,185 @@
+#include "candles.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "thread_pool.h"
+
+namespace alphasignal {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+struct Shape {
+    bool valid = false;
+    double open = 0.0, high = 0.0, low = 0.0, close = 0.0;
+    double range = 0.0, body = 0.0, upper = 0.0, lower = 0.0;
+    bool bull = false, bear = false;
+    double body_top() const { return std::max(open, close); }
+    double body_bottom() const { return std::min(open, close); }
+    double mid() const { return 0.5 * (open + close); }
+};
+
+Shape make_shape(const OHLCVColumns &c, size_t t) {
+    Shape s;
+    s.open = c.open[t];
+    s.high = c.high[t];
+    s.low = c.low[t];
+    s.close = c.close[t];
+    s.valid = !is_missing(s.open) && !is_missing(s.high) && !is_missing(s.low) &&
+              !is_missing(s.close) && s.close > 0.0 && s.high >= s.low;
+    if (!s.valid) {
+        return s;
+    }
+    s.range = s.high - s.low;
+    s.body = std::abs(s.close - s.open);
+    s.upper = s.high - s.body_top();
+    s.lower = s.body_bottom() - s.low;
+    s.bull = s.close > s.open;
+    s.bear = s.close < s.open;
+    return s;
+}
+
+inline uint64_t bit(CandlePattern p, bool on) { return static_cast<uint64_t>(on) << p; }
+
+}  // namespace
+
+const std::vector<std::string> &candle_pattern_names() {
+    static const std::vector<std::string> names = {
+        "bullish",         "doji",              "dragonfly_doji",     "gravestone_doji",
+        "marubozu",        "hammer",            "hanging_man",        "inverted_hammer",
+        "shooting_star",   "bullish_engulfing", "bearish_engulfing",  "bullish_harami",
+        "bearish_harami",  "piercing_line",     "dark_cloud_cover",   "morning_star",
+        "evening_star",    "three_white_soldiers", "three_black_crows", "inside_bar",
+        "outside_bar",     "higher_high",       "lower_low",          "gap_up",
+        "gap_down"};
+    return names;
+}
+
+const std::vector<std::string> &candle_feature_names() {
+    static const std::vector<std::string> names = {"candle_size", "upper_shadow", "lower_shadow",
+                                                   "body_size",   "body_ratio",   "close_location"};
+    return names;
+}
+
+void candle_patterns(const OHLCVColumns &ohlc, size_t n, const CandleOptions &opts,
+                     uint64_t *patterns, double *features, size_t stride) {
+    if (opts.trend_lookback < 1) {
+        throw std::invalid_argument("trend_lookback must be at least 1");
+    }
+    const size_t lookback = static_cast<size_t>(opts.trend_lookback);
+    Shape p2, p1;  // bars t - 2 and t - 1
+    for (size_t t = 0; t < n; ++t) {
+        const Shape s = make_shape(ohlc, t);
+        uint64_t mask = 0;
+
+        if (s.valid) {
+            const double c = s.close, r = s.range;
+            features[0 * stride + t] = r / c;
+            features[1 * stride + t] = s.upper / c;
+            features[2 * stride + t] = s.lower / c;
+            features[3 * stride + t] = s.body / c;
+            features[4 * stride + t] = r > 0.0 ? s.body / r : kNaN;
+            features[5 * stride + t] = r > 0.0 ? (s.close - s.low) / r : kNaN;
+
+            // Single bar
+            const bool doji = r > 0.0 && s.body <= opts.doji_body * r;
+            const bool real_body = r > 0.0 && !doji;
+            const bool hammer_shape = real_body && s.lower >= opts.shadow_ratio * s.body &&
+                                      s.upper <= 0.1 * r;
+            const bool inverted_shape = real_body && s.upper >= opts.shadow_ratio * s.body &&
+                                        s.lower <= 0.1 * r;
+            mask |= bit(kBullish, s.bull);
+            mask |= bit(kDoji, doji);
+            mask |= bit(kDragonflyDoji, doji && s.upper <= 0.1 * r && s.lower >= 0.6 * r);
+            mask |= bit(kGravestoneDoji, doji && s.lower <= 0.1 * r && s.upper >= 0.6 * r);
+            mask |= bit(kMarubozu, r > 0.0 && s.upper <= 0.05 * r && s.lower <= 0.05 * r);
+
+            // Trend into the bar decides hammer vs hanging man and friends
+            bool down = false, up = false;
+            if (t > lookback) {
+                const double a = ohlc.close[t - 1], b = ohlc.close[t - 1 - lookback];
+                if (!is_missing(a) && !is_missing(b)) {
+                    down = a < b;
+                    up = a > b;
+                }
+            }
+            mask |= bit(kHammer, hammer_shape && down);
+            mask |= bit(kHangingMan, hammer_shape && up);
+            mask |= bit(kInvertedHammer, inverted_shape && down);
+            mask |= bit(kShootingStar, inverted_shape && up);
+
+            // Two bars
+            if (p1.valid) {
+                const bool p1_long = p1.range > 0.0 && p1.body >= opts.long_body * p1.range;
+                mask |= bit(kBullishEngulfing, p1.bear && s.bull && s.open <= p1.close &&
+                                                   s.close >= p1.open && s.body > p1.body);
+                mask |= bit(kBearishEngulfing, p1.bull && s.bear && s.open >= p1.close &&
+                                                   s.close <= p1.open && s.body > p1.body);
+                mask |= bit(kBullishHarami, p1.bear && p1_long && s.bull &&
+                                                s.body_top() <= p1.open &&
+                                                s.body_bottom() >= p1.close && s.body < p1.body);
+                mask |= bit(kBearishHarami, p1.bull && p1_long && s.bear &&
+                                                s.body_top() <= p1.close &&
+                                                s.body_bottom() >= p1.open && s.body < p1.body);
+                mask |= bit(kPiercingLine, p1.bear && p1_long && s.bull && s.open < p1.close &&
+                                               s.close > p1.mid() && s.close < p1.open);
+                mask |= bit(kDarkCloudCover, p1.bull && p1_long && s.bear && s.open > p1.close &&
+                                                 s.close < p1.mid() && s.close > p1.open);
+                mask |= bit(kInsideBar, s.high < p1.high && s.low > p1.low);
+                mask |= bit(kOutsideBar, s.high > p1.high && s.low < p1.low);
+                mask |= bit(kHigherHigh, s.high > p1.high);
+                mask |= bit(kLowerLow, s.low < p1.low);
+                const double gap = s.open / p1.close - 1.0;
+                mask |= bit(kGapUp, gap > opts.gap_threshold);
+                mask |= bit(kGapDown, gap < -opts.gap_threshold);
+            }
+
+            // Three bars
+            if (p1.valid && p2.valid) {
+                const bool p2_long = p2.range > 0.0 && p2.body >= opts.long_body * p2.range;
+                const bool p1_small = p1.range > 0.0 && p1.body <= opts.small_body * p1.range;
+                mask |= bit(kMorningStar, p2.bear && p2_long && p1_small &&
+                                              p1.body_top() <= p2.close && s.bull &&
+                                              s.close >= p2.mid());
+                mask |= bit(kEveningStar, p2.bull && p2_long && p1_small &&
+                                              p1.body_bottom() >= p2.close && s.bear &&
+                                              s.close <= p2.mid());
+                // Rising closes, each opening inside the previous body
+                mask |= bit(kThreeWhiteSoldiers,
+                            p2.bull && p1.bull && s.bull && p1.close > p2.close &&
+                                s.close > p1.close && p1.open >= p2.open && p1.open <= p2.close &&
+                                s.open >= p1.open && s.open <= p1.close &&
+                                s.upper <= s.body && p1.upper <= p1.body);
+                mask |= bit(kThreeBlackCrows,
+                            p2.bear && p1.bear && s.bear && p1.close < p2.close &&
+                                s.close < p1.close && p1.open <= p2.open && p1.open >= p2.close &&
+                                s.open <= p1.open && s.open >= p1.close &&
+                                s.lower <= s.body && p1.lower <= p1.body);
+            }
+        } else {
+            for (size_t f = 0; f < kNumCandleFeatures; ++f) {
+                features[f * stride + t] = kNaN;
+            }
+        }
+        patterns[t] = mask;
+        p2 = p1;
+        p1 = s;
+    }
+}
+
+void candle_patterns_batch(const OHLCVColumns &ohlc, const RaggedBatch &batch,
+                           const CandleOptions &opts, uint64_t *patterns, double *features) {
+    const size_t stride = batch.total_rows();
+    parallel_for(batch.n_series, [&](size_t i) {
+        const size_t b = batch.begin(i);
+        const OHLCVColumns cols{ohlc.open + b, ohlc.high + b, ohlc.low + b, ohlc.close + b,
+                                ohlc.volume ? ohlc.volume + b : nullptr};
+        candle_patterns(cols, batch.length(i), opts, patterns + b, features + b, stride);
+    });
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "batch.h"
+
+namespace alphasignal {
+
+// Candlestick shape features and classic patterns in one pass over OHLC.
+// With range R = high - low, body B = |close - open| and shadows U (upper),
+// L (lower), patterns are flagged as bits of one uint64 per bar. A pattern
+// needs every bar it looks at to have a full, positive OHLC.
+enum CandlePattern : int {
+    kBullish = 0,           // close > open
+    kDoji,                  // B <= doji_body * R
+    kDragonflyDoji,         // doji, long lower shadow, no upper shadow
+    kGravestoneDoji,        // doji, long upper shadow, no lower shadow
+    kMarubozu,              // shadows <= 5% of R
+    kHammer,                // L >= shadow_ratio * B, tiny U, after a decline
+    kHangingMan,            // hammer shape after an advance
+    kInvertedHammer,        // U >= shadow_ratio * B, tiny L, after a decline
+    kShootingStar,          // inverted-hammer shape after an advance
+    kBullishEngulfing,
+    kBearishEngulfing,
+    kBullishHarami,
+    kBearishHarami,
+    kPiercingLine,
+    kDarkCloudCover,
+    kMorningStar,
+    kEveningStar,
+    kThreeWhiteSoldiers,
+    kThreeBlackCrows,
+    kInsideBar,
+    kOutsideBar,
+    kHigherHigh,            // high > previous high
+    kLowerLow,              // low < previous low
+    kGapUp,                 // open / previous close - 1 > gap_threshold
+    kGapDown,               // open / previous close - 1 < -gap_threshold
+    kNumCandlePatterns
+};
+
+// Bit names in CandlePattern order
+const std::vector<std::string> &candle_pattern_names();
+
+struct CandleOptions {
+    double doji_body = 0.1;      // body / range at or below this is a doji
+    double small_body = 0.3;     // star bodies
+    double long_body = 0.6;      // engulfed / star-framing bodies
+    double shadow_ratio = 2.0;   // hammer-family shadow / body
+    double gap_threshold = 0.02;
+    int trend_lookback = 5;      // trend before bar t: close[t-1] vs close[t-1-lookback]
+};
+
+// Continuous features, feature-major with stride n (or total_rows):
+// candle_size (R / C), upper_shadow (U / C), lower_shadow (L / C),
+// body_size (B / C), body_ratio (B / R), close_location ((C - low) / R)
+constexpr size_t kNumCandleFeatures = 6;
+const std::vector<std::string> &candle_feature_names();
+
+void candle_patterns(const OHLCVColumns &ohlc, size_t n, const CandleOptions &opts,
+                     uint64_t *patterns, double *features, size_t stride);
+
+void candle_patterns_batch(const OHLCVColumns &ohlc, const RaggedBatch &batch,
+                           const CandleOptions &opts, uint64_t *patterns, double *features);
+
+}  // namespace alphasignal
@@ -0,0 +1,377 @@
+#include "changepoint.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "arena.h"
+#include "thread_pool.h"
+
+namespace alphasignal {
+
+namespace {
+
+const double kLogPi = 1.1447298858494002;  // log(pi)
+
+// Beyond this run length lgamma(a + 0.5) - lgamma(a) uses its asymptotic
+// series, which keeps the cache (and the detector state) bounded
+const size_t kLgammaCacheSize = 4096;
+
+}  // namespace
+
+// ===== CUSUM filter =====
+
+int CusumFilter::update(double x, double threshold) {
+    if (is_missing(x) || is_missing(threshold)) {
+        return 0;
+    }
+    pos_ = std::max(0.0, pos_ + x - drift_);
+    neg_ = std::min(0.0, neg_ + x + drift_);
+    if (pos_ > threshold) {
+        pos_ = 0.0;
+        return 1;
+    }
+    if (neg_ < -threshold) {
+        neg_ = 0.0;
+        return -1;
+    }
+    return 0;
+}
+
+void cusum_filter(const double *x, size_t n, const double *threshold, bool per_bar_threshold,
+                  double drift, int8_t *events) {
+    CusumFilter filter(drift);
+    for (size_t t = 0; t < n; ++t) {
+        double h = per_bar_threshold ? threshold[t] : threshold[0];
+        events[t] = static_cast<int8_t>(filter.update(x[t], h));
+    }
+}
+
+void cusum_filter_batch(const double *x, const RaggedBatch &batch, const double *threshold,
+                        bool per_bar_threshold, double drift, int8_t *events) {
+    parallel_for(batch.n_series, [&](size_t i) {
+        const size_t begin = batch.begin(i);
+        cusum_filter(x + begin, batch.length(i),
+                     per_bar_threshold ? threshold + begin : threshold,
+                     per_bar_threshold, drift, events + begin);
+    });
+}
+
+// ===== Bayesian online change-point detection =====
+
+BOCPD::BOCPD(const BOCPDOptions &opts) : opts_(opts) {
+    if (opts.expected_run_length <= 1.0) {
+        throw std::invalid_argument("expected_run_length must be greater than 1");
+    }
+    if (opts.kappa0 <= 0.0 || opts.alpha0 <= 0.0 || opts.beta0 <= 0.0) {
+        throw std::invalid_argument("kappa0, alpha0 and beta0 must be positive");
+    }
+    if (opts.max_hypotheses < 1) {
+        throw std::invalid_argument("max_hypotheses must be at least 1");
+    }
+    hazard_ = 1.0 / opts.expected_run_length;
+
+    const size_t cap = opts.max_hypotheses + 1;
+    for (auto *v : {&prob_, &mu_, &kappa_, &beta_, &next_prob_, &next_mu_, &next_kappa_,
+                    &next_beta_, &log_pred_}) {
+        v->reserve(cap);
+    }
+    run_.reserve(cap);
+    next_run_.reserve(cap);
+    reset();
+}
+
+void BOCPD::reset() {
+    run_.assign(1, 0);
+    prob_.assign(1, 1.0);
+    mu_.assign(1, opts_.mu0);
+    kappa_.assign(1, opts_.kappa0);
+    beta_.assign(1, opts_.beta0);
+    last_ = {0.0, 0.0, 0.0};
+}
+
+double BOCPD::lgamma_ratio(size_t run) {
+    if (run >= kLgammaCacheSize) {
+        const double a = opts_.alpha0 + 0.5 * run;
+        return 0.5 * std::log(a) - 1.0 / (8.0 * a) + 1.0 / (192.0 * a * a * a);
+    }
+    while (lgamma_cache_.size() <= run) {
+        const double a = opts_.alpha0 + 0.5 * lgamma_cache_.size();
+        lgamma_cache_.push_back(std::lgamma(a + 0.5) - std::lgamma(a));
+    }
+    return lgamma_cache_[run];
+}
+
+BOCPDOutput BOCPD::update(double x) {
+    if (is_missing(x)) {
+        return last_;
+    }
+    const size_t m = run_.size();
+
+    // Student-t posterior predictive of x under each run-length hypothesis
+    // (the lgamma lookups are hoisted so the arithmetic loop vectorizes)
+    log_pred_.resize(m);
+    for (size_t i = 0; i < m; ++i) {
+        log_pred_[i] = lgamma_ratio(run_[i]);
+    }
+    double max_lp = std::numeric_limits<double>::lowest();
+    for (size_t i = 0; i < m; ++i) {
+        const double alpha = opts_.alpha0 + 0.5 * static_cast<double>(run_[i]);
+        const double nu = 2.0 * alpha;
+        const double scale2 = beta_[i] * (kappa_[i] + 1.0) / (alpha * kappa_[i]);
+        const double d = x - mu_[i];
+        log_pred_[i] += -0.5 * (std::log(nu * scale2) + kLogPi) -
+                        (alpha + 0.5) * std::log1p(d * d / (nu * scale2));
+        max_lp = std::max(max_lp, log_pred_[i]);
+    }
+
+    // Growth: every run extends by one and absorbs x. Change: all mass that
+    // hits the hazard restarts at run length 0 with the prior.
+    next_run_.resize(m + 1);
+    next_prob_.resize(m + 1);
+    next_mu_.resize(m + 1);
+    next_kappa_.resize(m + 1);
+    next_beta_.resize(m + 1);
+
+    double change_mass = 0.0;
+    double total = 0.0;
+    for (size_t i = 0; i < m; ++i) {
+        const double w = prob_[i] * std::exp(log_pred_[i] - max_lp);
+        change_mass += w * hazard_;
+        next_prob_[i + 1] = w * (1.0 - hazard_);
+        total += w;
+
+        const double k = kappa_[i];
+        const double d = x - mu_[i];
+        next_run_[i + 1] = run_[i] + 1;
+        next_mu_[i + 1] = (k * mu_[i] + x) / (k + 1.0);
+        next_kappa_[i + 1] = k + 1.0;
+        next_beta_[i + 1] = beta_[i] + k * d * d / (2.0 * (k + 1.0));
+    }
+    next_run_[0] = 0;
+    next_prob_[0] = change_mass;
+    next_mu_[0] = opts_.mu0;
+    next_kappa_[0] = opts_.kappa0;
+    next_beta_[0] = opts_.beta0;
+
+    if (!(total > 0.0)) {
+        // Every hypothesis underflowed: treat x as the start of a new run
+        reset();
+        last_ = {1.0, 0.0, 0.0};
+        return last_;
+    }
+    for (size_t i = 0; i <= m; ++i) {
+        next_prob_[i] /= total;
+    }
+
+    run_.swap(next_run_);
+    prob_.swap(next_prob_);
+    mu_.swap(next_mu_);
+    kappa_.swap(next_kappa_);
+    beta_.swap(next_beta_);
+    prune();
+
+    BOCPDOutput out{0.0, 0.0, 0.0};
+    double best = -1.0;
+    for (size_t i = 0; i < run_.size(); ++i) {
+        if (run_[i] < static_cast<size_t>(opts_.alert_window)) {
+            out.change_prob += prob_[i];
+        }
+        out.expected_run_length += prob_[i] * run_[i];
+        if (prob_[i] > best) {
+            best = prob_[i];
+            out.map_run_length = static_cast<double>(run_[i]);
+        }
+    }
+    last_ = out;
+    return out;
+}
+
+void BOCPD::prune() {
+    // Drop negligible hypotheses, then enforce the hard cap by keeping the
+    // most probable ones. Entries stay ordered by run length.
+    double cutoff = opts_.prune_threshold;
+    if (run_.size() > opts_.max_hypotheses) {
+        log_pred_.assign(prob_.begin(), prob_.end());
+        auto kth = log_pred_.begin() + (opts_.max_hypotheses - 1);
+        std::nth_element(log_pred_.begin(), kth, log_pred_.end(), std::greater<double>());
+        cutoff = std::max(cutoff, *kth);
+    }
+
+    // The most probable hypothesis always survives
+    const size_t best = std::max_element(prob_.begin(), prob_.end()) - prob_.begin();
+    size_t kept = 0;
+    double total = 0.0;
+    for (size_t i = 0; i < run_.size(); ++i) {
+        if ((prob_[i] >= cutoff || i == best) && kept < opts_.max_hypotheses) {
+            run_[kept] = run_[i];
+            prob_[kept] = prob_[i];
+            mu_[kept] = mu_[i];
+            kappa_[kept] = kappa_[i];
+            beta_[kept] = beta_[i];
+            total += prob_[i];
+            ++kept;
+        }
+    }
+    run_.resize(kept);
+    prob_.resize(kept);
+    mu_.resize(kept);
+    kappa_.resize(kept);
+    beta_.resize(kept);
+    for (size_t i = 0; i < kept; ++i) {
+        prob_[i] /= total;
+    }
+}
+
+void bocpd(const double *x, size_t n, const BOCPDOptions &opts,
+           double *change_prob, double *map_run_length, double *expected_run_length) {
+    BOCPD detector(opts);
+    for (size_t t = 0; t < n; ++t) {
+        BOCPDOutput out = detector.update(x[t]);
+        change_prob[t] = out.change_prob;
+        map_run_length[t] = out.map_run_length;
+        expected_run_length[t] = out.expected_run_length;
+    }
+}
+
+void bocpd_batch(const double *x, const RaggedBatch &batch, const BOCPDOptions &opts,
+                 double *change_prob, double *map_run_length, double *expected_run_length) {
+    parallel_for(batch.n_series, [&](size_t i) {
+        const size_t begin = batch.begin(i);
+        bocpd(x + begin, batch.length(i), opts, change_prob + begin, map_run_length + begin,
+              expected_run_length + begin);
+    });
+}
+
+// ===== PELT =====
+
+namespace {
+
+// Noise scale from the median absolute deviation of first differences,
+// which is insensitive to the level shifts being searched for
+double robust_sigma2(const double *x, size_t n) {
+    if (n < 3) {
+        return 1.0;
+    }
+    ArenaScope scope;
+    ScratchVector<double> d = scratch<double>(n - 1);
+    for (size_t i = 1; i < n; ++i) {
+        d[i - 1] = x[i] - x[i - 1];
+    }
+    auto mid = d.begin() + d.size() / 2;
+    std::nth_element(d.begin(), mid, d.end());
+    const double med = *mid;
+    for (double &v : d) {
+        v = std::abs(v - med);
+    }
+    std::nth_element(d.begin(), mid, d.end());
+    const double sigma = 1.4826 * (*mid) / std::sqrt(2.0);
+    return sigma > 0.0 ? sigma * sigma : 1.0;
+}
+
+}  // namespace
+
+std::vector<int64_t> pelt(const double *x, size_t n, const PeltOptions &opts) {
+    if (opts.min_size < 1) {
+        throw std::invalid_argument("min_size must be at least 1");
+    }
+    const size_t min_size = static_cast<size_t>(opts.min_size);
+    if (n < 2 * min_size) {
+        return {};
+    }
+
+    ArenaScope scope;
+    // Prefix sums give O(1) segment costs
+    ScratchVector<double> s1 = scratch<double>(n + 1), s2 = scratch<double>(n + 1);
+    for (size_t i = 0; i < n; ++i) {
+        s1[i + 1] = s1[i] + x[i];
+        s2[i + 1] = s2[i] + x[i] * x[i];
+    }
+
+    const bool mean_only = opts.cost == PeltCost::Mean;
+    const double inv_sigma2 = mean_only ? 1.0 / robust_sigma2(x, n) : 1.0;
+    const double global_var = std::max(s2[n] / n - (s1[n] / n) * (s1[n] / n), 0.0);
+    const double var_floor = global_var > 0.0 ? global_var * 1e-6 : 1e-300;
+    const double penalty = opts.penalty > 0.0
+                               ? opts.penalty
+                               : (mean_only ? 2.0 : 3.0) * std::log(static_cast<double>(n));
+
+    // -2 log-likelihood of x[a, b) up to constants
+    auto cost = [&](size_t a, size_t b) {
+        const double len = static_cast<double>(b - a);
+        const double sum = s1[b] - s1[a];
+        const double sse = std::max(s2[b] - s2[a] - sum * sum / len, 0.0);
+        if (mean_only) {
+            return sse * inv_sigma2;
+        }
+        return len * std::log(std::max(sse / len, var_floor));
+    };
+
+    ScratchVector<double> f = scratch<double>(n + 1);
+    ScratchVector<size_t> last = scratch<size_t>(n + 1);
+    ScratchVector<size_t> cands = scratch<size_t>(0);
+    ScratchVector<double> cand_cost = scratch<double>(0);
+    cands.push_back(0);
+    f[0] = -penalty;
+
+    for (size_t t = min_size; t <= n; ++t) {
+        if (t >= 2 * min_size) {
+            cands.push_back(t - min_size);
+        }
+        cand_cost.resize(cands.size());
+        double best = std::numeric_limits<double>::max();
+        size_t best_tau = 0;
+        for (size_t c = 0; c < cands.size(); ++c) {
+            const size_t tau = cands[c];
+            cand_cost[c] = f[tau] + cost(tau, t);
+            const double v = cand_cost[c] + penalty;
+            if (v < best) {
+                best = v;
+                best_tau = tau;
+            }
+        }
+        f[t] = best;
+        last[t] = best_tau;
+
+        // Pruning: a candidate that cannot beat f[t] now never will
+        size_t kept = 0;
+        for (size_t c = 0; c < cands.size(); ++c) {
+            if (cand_cost[c] <= best) {
+                cands[kept++] = cands[c];
+            }
+        }
+        cands.resize(kept);
+    }
+
+    std::vector<int64_t> cps;
+    for (size_t t = n; t > 0;) {
+        const size_t tau = last[t];
+        if (tau > 0) {
+            cps.push_back(static_cast<int64_t>(tau));
+        }
+        t = tau;
+    }
+    std::reverse(cps.begin(), cps.end());
+    return cps;
+}
+
+void pelt_batch(const double *x, const RaggedBatch &batch, const PeltOptions &opts,
+                std::vector<int64_t> &out, std::vector<int64_t> &out_offsets) {
+    std::vector<std::vector<int64_t>> per_series(batch.n_series);
+    parallel_for(batch.n_series, [&](size_t i) {
+        per_series[i] = pelt(x + batch.begin(i), batch.length(i), opts);
+    });
+
+    out_offsets.assign(batch.n_series + 1, 0);
+    for (size_t i = 0; i < batch.n_series; ++i) {
+        out_offsets[i + 1] = out_offsets[i] + static_cast<int64_t>(per_series[i].size());
+    }
+    out.clear();
+    out.reserve(static_cast<size_t>(out_offsets[batch.n_series]));
+    for (const auto &cps : per_series) {
+        out.insert(out.end(), cps.begin(), cps.end());
+    }
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "batch.h"
+
+namespace alphasignal {
+
+// ===== CUSUM filter =====
+
+// Symmetric CUSUM on increments (e.g. returns). Fires +1/-1 when the
+// positive/negative cumulative sum crosses the threshold, then resets.
+// Doubles as an event sampler for labelling: the bars with a non-zero
+// event are the sample points.
+class CusumFilter {
+public:
+    explicit CusumFilter(double drift = 0.0) : drift_(drift) {}
+
+    // NaN increments leave the state unchanged and return 0
+    int update(double x, double threshold);
+    void reset() { pos_ = neg_ = 0.0; }
+
+    double pos() const { return pos_; }
+    double neg() const { return neg_; }
+
+private:
+    double drift_;
+    double pos_ = 0.0;
+    double neg_ = 0.0;
+};
+
+// threshold holds either one value or one value per bar
+void cusum_filter(const double *x, size_t n, const double *threshold, bool per_bar_threshold,
+                  double drift, int8_t *events);
+
+void cusum_filter_batch(const double *x, const RaggedBatch &batch, const double *threshold,
+                        bool per_bar_threshold, double drift, int8_t *events);
+
+// ===== Bayesian online change-point detection (Adams & MacKay) =====
+
+// Gaussian observations with unknown mean and variance (Normal-Gamma prior),
+// constant hazard 1 / expected_run_length.
+struct BOCPDOptions {
+    double expected_run_length = 250.0;
+    double mu0 = 0.0;
+    double kappa0 = 1.0;
+    double alpha0 = 1.0;
+    double beta0 = 1e-4;             // prior scale; match the variance of the input
+    double prune_threshold = 1e-5;   // drop run lengths below this posterior mass
+    size_t max_hypotheses = 256;     // hard cap on tracked run lengths
+    int alert_window = 5;            // change_prob = P(run length < alert_window)
+};
+
+struct BOCPDOutput {
+    double change_prob;
+    double map_run_length;
+    double expected_run_length;
+};
+
+// Streaming detector; memory is bounded by max_hypotheses
+class BOCPD {
+public:
+    explicit BOCPD(const BOCPDOptions &opts = BOCPDOptions());
+
+    // NaN observations repeat the previous output
+    BOCPDOutput update(double x);
+    void reset();
+
+    size_t n_hypotheses() const { return run_.size(); }
+
+private:
+    void prune();
+    double lgamma_ratio(size_t run);
+
+    BOCPDOptions opts_;
+    double hazard_;
+    BOCPDOutput last_{0.0, 0.0, 0.0};
+
+    // One entry per surviving run-length hypothesis
+    std::vector<size_t> run_;
+    std::vector<double> prob_, mu_, kappa_, beta_;
+    // Double buffers reused every update
+    std::vector<size_t> next_run_;
+    std::vector<double> next_prob_, next_mu_, next_kappa_, next_beta_, log_pred_;
+    // lgamma(alpha + 0.5) - lgamma(alpha) depends only on the run length
+    std::vector<double> lgamma_cache_;
+};
+
+// Outputs are per bar: change_prob, map_run_length, expected_run_length
+void bocpd(const double *x, size_t n, const BOCPDOptions &opts,
+           double *change_prob, double *map_run_length, double *expected_run_length);
+
+void bocpd_batch(const double *x, const RaggedBatch &batch, const BOCPDOptions &opts,
+                 double *change_prob, double *map_run_length, double *expected_run_length);
+
+// ===== PELT (offline segmentation) =====
+
+enum class PeltCost {
+    Mean,     // change in mean, Gaussian noise with a robust variance estimate
+    MeanVar,  // change in mean and variance
+};
+
+struct PeltOptions {
+    PeltCost cost = PeltCost::MeanVar;
+    double penalty = 0.0;  // <= 0 selects BIC: (params per segment + 1) * log(n)
+    int min_size = 5;
+};
+
+// Returns the start index of every new segment (excluding 0). NaNs must be
+// removed by the caller.
+std::vector<int64_t> pelt(const double *x, size_t n, const PeltOptions &opts);
+
+// Change points of ticker i are out[out_offsets[i], out_offsets[i + 1]),
+// indices relative to the ticker's first row
+void pelt_batch(const double *x, const RaggedBatch &batch, const PeltOptions &opts,
+                std::vector<int64_t> &out, std::vector<int64_t> &out_offsets);
+
+}  // namespace alphasignal
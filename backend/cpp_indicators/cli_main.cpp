@@ -0,0 +1,230 @@
+// alphasignal_cli: batch indicator, feature and scoring pipelines over CSV
+// files, without Python.
+//
+//   alphasignal_cli indicators|features|score [options]
+//     --input FILE       CSV with a header row ("-" = stdin, the default)
+//     --output FILE      CSV to write ("-" = stdout, the default)
+//     --ticker-col NAME  series key (default "ticker"; optional column)
+//     --date-col NAME    YYYY-MM-DD dates (default "date"; optional column)
+//     --model FILE       .astree ensemble (score only)
+//     --holidays FILE    one YYYY-MM-DD per line (features only)
+//
+//   alphasignal_cli pipeline --input-dir DIR --output-dir DIR [options]
+//     --model FILE       adds the inference stage
+//     --read-workers N, --feature-workers N, --score-workers N,
+//     --write-workers N  per-stage concurrency (feature default: all cores)
+//     --channel-capacity N  files queued between stages (default 4)
+//     plus --ticker-col, --date-col, --holidays as above
+//
+// Rows of one ticker must be contiguous and in time order, as the panels
+// built by the data pipeline are. indicators adds RSI/MACD/Bollinger from
+// the close column; features adds returns, candlestick shapes (with
+// open/high/low) and calendar fields (with a date column); score feeds the
+// model's named columns (from its .features sidecar) or else every column
+// except ticker and date, in file order. pipeline runs indicators, features
+// and (with --model) score over every *.csv in a directory, streaming files
+// through bounded stages, and prints per-stage metrics to stderr.
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "frame.h"
+#include "pipeline.h"
+#include "tree_model.h"
+
+namespace as = alphasignal;
+
+namespace {
+
+struct CliOptions {
+    std::string command;
+    std::string input = "-";
+    std::string output = "-";
+    std::string ticker_col = "ticker";
+    std::string date_col = "date";
+    std::string model;
+    std::string holidays;
+    std::string input_dir;
+    std::string output_dir;
+    unsigned read_workers = 2;
+    unsigned feature_workers = 0;
+    unsigned score_workers = 1;
+    unsigned write_workers = 2;
+    size_t channel_capacity = 4;
+};
+
+unsigned parse_count(const std::string &arg, const char *val) {
+    char *end = nullptr;
+    const unsigned long v = std::strtoul(val, &end, 10);
+    if (!end || *end != '\0' || v > 4096) {
+        throw std::runtime_error("bad value for " + arg + ": " + val);
+    }
+    return static_cast<unsigned>(v);
+}
+
+int run_pipeline(const CliOptions &opts) {
+    if (opts.input_dir.empty() || opts.output_dir.empty()) {
+        throw std::runtime_error("pipeline needs --input-dir and --output-dir");
+    }
+    as::BatchPipelineOptions popts;
+    popts.input_dir = opts.input_dir;
+    popts.output_dir = opts.output_dir;
+    popts.model_path = opts.model;
+    popts.frame.ticker_col = opts.ticker_col;
+    popts.frame.date_col = opts.date_col;
+    if (!opts.holidays.empty()) {
+        popts.frame.holidays = as::load_holidays(opts.holidays);
+    }
+    popts.read_workers = opts.read_workers;
+    popts.feature_workers = opts.feature_workers;
+    popts.score_workers = opts.score_workers;
+    popts.write_workers = opts.write_workers;
+    popts.channel_capacity = opts.channel_capacity;
+
+    const as::BatchPipelineReport report = as::run_batch_pipeline(popts);
+    std::fprintf(stderr, "%zu/%zu files written in %.3f s\n", report.written, report.files,
+                 report.wall_s);
+    std::fprintf(stderr, "%-10s %7s %7s %7s %6s %9s %9s %9s %6s\n", "stage", "workers", "in",
+                 "out", "errors", "busy_s", "starved_s", "blocked_s", "queue");
+    for (const as::StageMetrics &m : report.stages) {
+        std::fprintf(stderr, "%-10s %7u %7llu %7llu %6llu %9.3f %9.3f %9.3f %6zu\n",
+                     m.name.c_str(), m.workers, static_cast<unsigned long long>(m.items_in),
+                     static_cast<unsigned long long>(m.items_out),
+                     static_cast<unsigned long long>(m.errors), m.busy_s, m.starved_s,
+                     m.blocked_s, m.queue_high_water);
+    }
+    for (const as::StageMetrics &m : report.stages) {
+        if (m.errors > 0) {
+            std::fprintf(stderr, "%s: %llu failed, first: %s\n", m.name.c_str(),
+                         static_cast<unsigned long long>(m.errors), m.first_error.c_str());
+        }
+    }
+    return report.written == report.files ? 0 : 1;
+}
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: alphasignal_cli indicators|features|score [--input FILE] "
+                 "[--output FILE]\n"
+                 "       [--ticker-col NAME] [--date-col NAME] [--model FILE] "
+                 "[--holidays FILE]\n"
+                 "       alphasignal_cli pipeline --input-dir DIR --output-dir DIR "
+                 "[--model FILE]\n"
+                 "       [--read-workers N] [--feature-workers N] [--score-workers N] "
+                 "[--write-workers N]\n"
+                 "       [--channel-capacity N] [--ticker-col NAME] [--date-col NAME] "
+                 "[--holidays FILE]\n");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+    CliOptions opts;
+    opts.command = argv[1];
+    try {
+        for (int i = 2; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                usage();
+                return 2;
+            }
+            const char *val = argv[++i];
+            if (arg == "--input") {
+                opts.input = val;
+            } else if (arg == "--output") {
+                opts.output = val;
+            } else if (arg == "--ticker-col") {
+                opts.ticker_col = val;
+            } else if (arg == "--date-col") {
+                opts.date_col = val;
+            } else if (arg == "--model") {
+                opts.model = val;
+            } else if (arg == "--holidays") {
+                opts.holidays = val;
+            } else if (arg == "--input-dir") {
+                opts.input_dir = val;
+            } else if (arg == "--output-dir") {
+                opts.output_dir = val;
+            } else if (arg == "--read-workers") {
+                opts.read_workers = parse_count(arg, val);
+            } else if (arg == "--feature-workers") {
+                opts.feature_workers = parse_count(arg, val);
+            } else if (arg == "--score-workers") {
+                opts.score_workers = parse_count(arg, val);
+            } else if (arg == "--write-workers") {
+                opts.write_workers = parse_count(arg, val);
+            } else if (arg == "--channel-capacity") {
+                opts.channel_capacity = parse_count(arg, val);
+            } else {
+                usage();
+                return 2;
+            }
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "alphasignal_cli: %s\n", e.what());
+        return 2;
+    }
+    if (opts.command != "indicators" && opts.command != "features" && opts.command != "score" &&
+        opts.command != "pipeline") {
+        usage();
+        return 2;
+    }
+
+    try {
+        std::ios::sync_with_stdio(false);
+        if (opts.command == "pipeline") {
+            return run_pipeline(opts);
+        }
+
+        auto table = std::make_shared<as::CsvTable>();
+        if (opts.input == "-") {
+            table->read(std::cin);
+        } else {
+            *table = as::CsvTable::load(opts.input);
+        }
+
+        as::FrameOptions frame_opts;
+        frame_opts.ticker_col = opts.ticker_col;
+        frame_opts.date_col = opts.date_col;
+        if (opts.command == "features" && !opts.holidays.empty()) {
+            frame_opts.holidays = as::load_holidays(opts.holidays);
+        }
+        as::FeatureFrame frame(table, frame_opts);
+
+        if (opts.command == "score") {
+            if (opts.model.empty()) {
+                throw std::runtime_error("score needs --model");
+            }
+            frame.add_scores(as::load_tree_ensemble(opts.model));
+        } else {
+            frame.add_indicators();
+            if (opts.command == "features") {
+                frame.add_features();
+            }
+        }
+
+        if (opts.output == "-") {
+            frame.write(std::cout);
+        } else {
+            std::ofstream os(opts.output, std::ios::binary);
+            if (!os) {
+                throw std::runtime_error("cannot write " + opts.output);
+            }
+            frame.write(os);
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "alphasignal_cli: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
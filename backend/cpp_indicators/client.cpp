@@ -0,0 +1,114 @@
+#include "client.h"
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace alphasignal {
+
+namespace {
+
+std::runtime_error sys_error(const std::string &what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+}  // namespace
+
+IndicatorClient::IndicatorClient(const std::string &socket_path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("socket path is too long: " + socket_path);
+    }
+    std::memcpy(addr.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        throw sys_error("socket");
+    }
+    if (::connect(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        const std::runtime_error err = sys_error("connect " + socket_path);
+        ::close(fd_);
+        throw err;
+    }
+}
+
+IndicatorClient::~IndicatorClient() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+void IndicatorClient::write_all(const uint8_t *data, size_t n) {
+    while (n > 0) {
+        const ssize_t w = ::send(fd_, data, n, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw sys_error("send");
+        }
+        data += w;
+        n -= static_cast<size_t>(w);
+    }
+}
+
+void IndicatorClient::read_all(uint8_t *data, size_t n) {
+    while (n > 0) {
+        const ssize_t r = ::read(fd_, data, n);
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw sys_error("read");
+        }
+        if (r == 0) {
+            throw std::runtime_error("server closed the connection");
+        }
+        data += r;
+        n -= static_cast<size_t>(r);
+    }
+}
+
+std::vector<uint8_t> IndicatorClient::call(Op op, const std::vector<uint8_t> &payload) {
+    const uint32_t id = next_id_++;
+    const std::vector<uint8_t> frame = make_frame(op, id, payload);
+    write_all(frame.data(), frame.size());
+
+    uint8_t raw[kFrameHeaderSize];
+    read_all(raw, sizeof(raw));
+    const FrameHeader header = decode_header(raw);
+    std::vector<uint8_t> body(header.length);
+    read_all(body.data(), body.size());
+    if (header.request_id != id) {
+        throw ProtocolError("response for request " + std::to_string(header.request_id) +
+                            ", expected " + std::to_string(id));
+    }
+    return body;
+}
+
+void IndicatorClient::ping() {
+    const std::vector<uint8_t> body = call(Op::Ping, {});
+    WireReader in(body.data(), body.size());
+    check_status(in);
+}
+
+IndicatorResponse IndicatorClient::indicators(const IndicatorRequest &req) {
+    std::vector<uint8_t> payload;
+    encode_indicator_request(req, payload);
+    const std::vector<uint8_t> body = call(Op::Indicators, payload);
+    return decode_indicator_response(body.data(), body.size());
+}
+
+ScoreResponse IndicatorClient::score(const ScoreRequest &req) {
+    std::vector<uint8_t> payload;
+    encode_score_request(req, payload);
+    const std::vector<uint8_t> body = call(Op::Score, payload);
+    return decode_score_response(body.data(), body.size());
+}
+
+}  // namespace alphasignal
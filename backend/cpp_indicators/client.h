@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "protocol.h"
+
+namespace alphasignal {
+
+// Blocking client for IndicatorServer: one request in flight at a time.
+// Errors reported by the server are raised as ServiceError, transport
+// failures as std::runtime_error.
+class IndicatorClient {
+public:
+    explicit IndicatorClient(const std::string &socket_path);
+    ~IndicatorClient();
+
+    IndicatorClient(const IndicatorClient &) = delete;
+    IndicatorClient &operator=(const IndicatorClient &) = delete;
+
+    void ping();
+    IndicatorResponse indicators(const IndicatorRequest &req);
+    ScoreResponse score(const ScoreRequest &req);
+
+    // Sends one frame and returns the payload of the matching response
+    std::vector<uint8_t> call(Op op, const std::vector<uint8_t> &payload);
+
+private:
+    void write_all(const uint8_t *data, size_t n);
+    void read_all(uint8_t *data, size_t n);
+
+    int fd_ = -1;
+    uint32_t next_id_ = 1;
+};
+
+}  // namespace alphasignal
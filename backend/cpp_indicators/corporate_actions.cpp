@@ -0,0 +1,104 @@
+#include "corporate_actions.h"
+
+#include <limits>
+
+#include "thread_pool.h"
+
+namespace alphasignal {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+inline double event_value(const double *col, size_t t) {
+    if (col == nullptr) {
+        return 0.0;
+    }
+    const double v = col[t];
+    return is_missing(v) || v <= 0.0 ? 0.0 : v;
+}
+
+OHLCVColumns shift(const OHLCVColumns &c, size_t b) {
+    return {c.open + b, c.high + b, c.low + b, c.close + b, c.volume + b};
+}
+
+}  // namespace
+
+void adjust_corporate_actions(const OHLCVColumns &raw, const CorporateActions &actions, size_t n,
+                              const AdjustedOHLCV &out) {
+    double price_factor = 1.0;
+    double volume_factor = 1.0;
+    double shares = 1.0;            // total-return share count relative to the last row
+    double pending_dividend = 0.0;  // awaiting the previous valid close, current share basis
+    double pending_reinvest = 0.0;  // dividends whose ex-date close was missing
+    size_t first_valid = n;
+
+    for (size_t i = n; i-- > 0;) {
+        const double c = raw.close[i];
+        const bool valid = !is_missing(c);
+        if (valid) {
+            first_valid = i;
+            if (pending_dividend > 0.0) {
+                const double f = 1.0 - pending_dividend / c;
+                price_factor *= f > 0.0 ? f : 1.0;
+                pending_dividend = 0.0;
+            }
+            if (pending_reinvest > 0.0) {
+                shares /= 1.0 + pending_reinvest / c;
+                pending_reinvest = 0.0;
+            }
+        }
+
+        out.open[i] = raw.open[i] * price_factor;
+        out.high[i] = raw.high[i] * price_factor;
+        out.low[i] = raw.low[i] * price_factor;
+        out.close[i] = c * price_factor;
+        out.volume[i] = raw.volume[i] * volume_factor;
+        out.total_return[i] = valid ? c * shares : kNaN;
+        out.factor[i] = price_factor;
+
+        // Events on row i apply to every earlier row
+        const double d = event_value(actions.dividend, i);
+        double r = event_value(actions.split, i);
+        r = r > 0.0 ? r : 1.0;
+        if (d > 0.0) {
+            if (valid) {
+                shares /= 1.0 + d / c;
+            } else {
+                pending_reinvest += d;
+            }
+            pending_dividend += d;
+        }
+        if (r != 1.0) {
+            // Carry pending amounts into the pre-split share basis
+            shares /= r;
+            pending_dividend *= r;
+            pending_reinvest *= r;
+            price_factor /= r;
+            volume_factor *= r;
+        }
+    }
+
+    if (first_valid < n) {
+        const double base = out.total_return[first_valid];
+        const double scale = base > 0.0 ? 1.0 / base : kNaN;
+        for (size_t i = first_valid; i < n; ++i) {
+            out.total_return[i] *= scale;
+        }
+    }
+}
+
+void adjust_corporate_actions_batch(const OHLCVColumns &raw, const CorporateActions &actions,
+                                    const RaggedBatch &batch, const AdjustedOHLCV &out) {
+    parallel_for(batch.n_series, [&](size_t i) {
+        const size_t b = batch.begin(i);
+        const CorporateActions events{actions.split ? actions.split + b : nullptr,
+                                      actions.dividend ? actions.dividend + b : nullptr};
+        const AdjustedOHLCV dst{out.open + b,   out.high + b,         out.low + b,
+                                out.close + b,  out.volume + b,       out.total_return + b,
+                                out.factor + b};
+        adjust_corporate_actions(shift(raw, b), events, batch.length(i), dst);
+    });
+}
+
+}  // namespace alphasignal
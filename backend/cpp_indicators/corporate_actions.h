@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+
+#include "batch.h"
+
+namespace alphasignal {
+
+// Corporate actions per row, on the ex-date. NaN or non-positive entries
+// mean no event.
+struct CorporateActions {
+    const double *split;     // new shares per old share (2.0 for a 2:1 split)
+    const double *dividend;  // cash per share, in the post-split share basis
+};
+
+// Every pointer is written for all n rows
+struct AdjustedOHLCV {
+    double *open;
+    double *high;
+    double *low;
+    double *close;
+    double *volume;
+    double *total_return;  // 1.0 at the first valid close
+    double *factor;        // adjusted price = raw price * factor
+};
+
+// Backward adjustment in one reverse pass, last row unadjusted:
+// - prices before an ex-date t are multiplied by (1 - D_t / C_prev) / split_t,
+//   with C_prev the last valid close before t (the CRSP / Yahoo adj_close
+//   convention); volume before t is multiplied by split_t
+// - total_return reinvests dividends at the ex-date close:
+//   TR_t / TR_prev = split_t * (C_t + D_t) / C_prev
+// A dividend at or above C_prev is treated as bad data and ignored in the
+// price factor.
+void adjust_corporate_actions(const OHLCVColumns &raw, const CorporateActions &actions, size_t n,
+                              const AdjustedOHLCV &out);
+
+// Tickers laid out by offsets, in parallel
+void adjust_corporate_actions_batch(const OHLCVColumns &raw, const CorporateActions &actions,
+                                    const RaggedBatch &batch, const AdjustedOHLCV &out);
+
+}  // namespace alphasignal
@@ -0,0 +1,454 @@
+#include "dtw.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+
+#include "arena.h"
+#include "thread_pool.h"
+
+namespace alphasignal {
+
+namespace {
+
+// Finite stand-in for infinity: the module is built with -ffast-math,
+// which assumes no infinities reach arithmetic or comparisons
+constexpr double kBig = 1e300;
+
+inline double sq(double x) { return x * x; }
+
+// Lemire's streaming min/max over [i - r, i + r] clipped to [0, n); the
+// deques need room for n entries each
+void envelope(const double *t, size_t n, size_t r, double *lower, double *upper, size_t *dq_lo,
+              size_t *dq_hi) {
+    size_t lo_head = 0, lo_tail = 0, hi_head = 0, hi_tail = 0;
+    for (size_t j = 0; j < n + r; ++j) {
+        if (j < n) {
+            while (hi_tail > hi_head && t[dq_hi[hi_tail - 1]] <= t[j]) {
+                --hi_tail;
+            }
+            dq_hi[hi_tail++] = j;
+            while (lo_tail > lo_head && t[dq_lo[lo_tail - 1]] >= t[j]) {
+                --lo_tail;
+            }
+            dq_lo[lo_tail++] = j;
+        }
+        if (j >= r) {
+            const size_t i = j - r;
+            while (dq_hi[hi_head] + r < i) {
+                ++hi_head;
+            }
+            while (dq_lo[lo_head] + r < i) {
+                ++lo_head;
+            }
+            upper[i] = t[dq_hi[hi_head]];
+            lower[i] = t[dq_lo[lo_head]];
+        }
+    }
+}
+
+// z-normalized query with its envelope and the LB_Keogh visiting order
+// (largest |q| first, where a mismatch is most likely to show up early)
+struct Query {
+    size_t m = 0;
+    size_t r = 0;
+    std::vector<double> q, lower, upper;
+    std::vector<size_t> order;
+};
+
+Query prepare_query(const double *query, size_t m, size_t r) {
+    Query qr;
+    qr.m = m;
+    qr.r = r;
+    double mean = 0.0;
+    for (size_t i = 0; i < m; ++i) {
+        if (is_missing(query[i])) {
+            throw std::invalid_argument("query contains NaN");
+        }
+        mean += query[i];
+    }
+    mean /= m;
+    double ss = 0.0;
+    for (size_t i = 0; i < m; ++i) {
+        ss += sq(query[i] - mean);
+    }
+    const double sd = std::sqrt(ss / m);
+    const double inv = sd > 1e-12 * (std::fabs(mean) + 1.0) ? 1.0 / sd : 0.0;
+    qr.q.resize(m);
+    for (size_t i = 0; i < m; ++i) {
+        qr.q[i] = (query[i] - mean) * inv;
+    }
+
+    qr.lower.resize(m);
+    qr.upper.resize(m);
+    {
+        ArenaScope scope;
+        ScratchVector<size_t> dq_lo = scratch<size_t>(m), dq_hi = scratch<size_t>(m);
+        envelope(qr.q.data(), m, r, qr.lower.data(), qr.upper.data(), dq_lo.data(), dq_hi.data());
+    }
+
+    qr.order.resize(m);
+    std::iota(qr.order.begin(), qr.order.end(), 0);
+    std::sort(qr.order.begin(), qr.order.end(),
+              [&](size_t a, size_t b) { return std::fabs(qr.q[a]) > std::fabs(qr.q[b]); });
+    return qr;
+}
+
+// First and last three points; each term is a cell every warping path
+// must pass through (or the cheapest of the cells it might use)
+double lb_kim(const double *t, const double *q, size_t m, double mean, double inv, double bsf) {
+    const double x0 = (t[0] - mean) * inv, y0 = (t[m - 1] - mean) * inv;
+    double lb = sq(x0 - q[0]) + sq(y0 - q[m - 1]);
+    if (m < 6 || lb >= bsf) {
+        return lb;
+    }
+    const double x1 = (t[1] - mean) * inv;
+    lb += std::min({sq(x1 - q[0]), sq(x0 - q[1]), sq(x1 - q[1])});
+    if (lb >= bsf) {
+        return lb;
+    }
+    const double y1 = (t[m - 2] - mean) * inv;
+    lb += std::min({sq(y1 - q[m - 1]), sq(y0 - q[m - 2]), sq(y1 - q[m - 2])});
+    if (lb >= bsf) {
+        return lb;
+    }
+    const double x2 = (t[2] - mean) * inv;
+    lb += std::min({sq(x0 - q[2]), sq(x1 - q[2]), sq(x2 - q[2]), sq(x2 - q[1]), sq(x2 - q[0])});
+    if (lb >= bsf) {
+        return lb;
+    }
+    const double y2 = (t[m - 3] - mean) * inv;
+    lb += std::min({sq(y0 - q[m - 3]), sq(y1 - q[m - 3]), sq(y2 - q[m - 3]),
+                    sq(y2 - q[m - 2]), sq(y2 - q[m - 1])});
+    return lb;
+}
+
+// Candidate against the query envelope; per-point contributions go to cb
+double lb_keogh_query(const double *t, const Query &qr, double mean, double inv, double *cb,
+                      double bsf) {
+    double lb = 0.0;
+    for (size_t i = 0; i < qr.m && lb < bsf; ++i) {
+        const size_t j = qr.order[i];
+        const double x = (t[j] - mean) * inv;
+        double d = 0.0;
+        if (x > qr.upper[j]) {
+            d = sq(x - qr.upper[j]);
+        } else if (x < qr.lower[j]) {
+            d = sq(x - qr.lower[j]);
+        }
+        lb += d;
+        cb[j] = d;
+    }
+    return lb;
+}
+
+// Query against the candidate's envelope (taken from the whole series,
+// which is wider than the window's own envelope and so still a bound)
+double lb_keogh_data(const Query &qr, const double *lower, const double *upper, double mean,
+                     double inv, double *cb, double bsf) {
+    double lb = 0.0;
+    for (size_t i = 0; i < qr.m && lb < bsf; ++i) {
+        const size_t j = qr.order[i];
+        const double u = (upper[j] - mean) * inv;
+        const double l = (lower[j] - mean) * inv;
+        double d = 0.0;
+        if (qr.q[j] > u) {
+            d = sq(qr.q[j] - u);
+        } else if (qr.q[j] < l) {
+            d = sq(qr.q[j] - l);
+        }
+        lb += d;
+        cb[j] = d;
+    }
+    return lb;
+}
+
+// Banded DTW on squared costs. cb[i] bounds the cost still to come from row
+// i onwards; the row minimum plus that bound abandons hopeless candidates.
+// cost and prev hold 2 * r + 1 entries each.
+double dtw_banded(const double *a, const double *b, const double *cb, size_t m, size_t r,
+                  double bsf, double *cost, double *prev) {
+    const size_t width = 2 * r + 1;
+    std::fill(prev, prev + width, kBig);
+    size_t k = 0;
+    for (size_t i = 0; i < m; ++i) {
+        std::fill(cost, cost + width, kBig);
+        k = i < r ? r - i : 0;
+        double row_min = kBig;
+        const size_t j_lo = i > r ? i - r : 0;
+        const size_t j_hi = std::min(m - 1, i + r);
+        for (size_t j = j_lo; j <= j_hi; ++j, ++k) {
+            if (i == 0 && j == 0) {
+                cost[k] = sq(a[0] - b[0]);
+                row_min = cost[k];
+                continue;
+            }
+            const double left = (j == 0 || k == 0) ? kBig : cost[k - 1];
+            const double up = (i == 0 || k + 1 >= width) ? kBig : prev[k + 1];
+            const double diag = (i == 0 || j == 0) ? kBig : prev[k];
+            cost[k] = std::min({left, up, diag}) + sq(a[i] - b[j]);
+            row_min = std::min(row_min, cost[k]);
+        }
+        if (i + r + 1 < m && row_min + cb[i + r + 1] >= bsf) {
+            return row_min + cb[i + r + 1];
+        }
+        std::swap(cost, prev);
+    }
+    return prev[k - 1];
+}
+
+bool by_distance(const DTWMatch &a, const DTWMatch &b) {
+    return std::tie(a.distance, a.series, a.start) < std::tie(b.distance, b.series, b.start);
+}
+
+bool overlaps(const DTWMatch &it, int64_t series, int64_t start, int64_t span) {
+    return it.series == series && std::llabs(it.start - start) < span;
+}
+
+// One worker's windows that beat the pruning bound, plus the bound itself.
+// The result is the greedy pick over all windows by distance, skipping any
+// that overlaps (same series, starts < m apart) one already picked. A window
+// can only be pruned once k windows that must all make that pick are known
+// to beat it: k matches at least 2m - 1 apart qualify, since no window
+// overlaps two of them, so each is either picked or displaced by a better
+// pick. Those matches are kept online with the same reject / replace rule.
+class TopMatches {
+public:
+    TopMatches(size_t k, size_t m) : k_(k), span_(static_cast<int64_t>(m)) {}
+
+    double threshold() const { return bound_.size() < k_ ? kBig : bound_.back().distance; }
+
+    void offer(int64_t series, int64_t start, double d2, double bsf) {
+        const DTWMatch match{series, start, d2};
+        candidates_.push_back(match);
+        if (candidates_.size() >= next_compact_) {
+            const double th = std::min(threshold(), bsf);
+            candidates_.erase(std::remove_if(candidates_.begin(), candidates_.end(),
+                                             [&](const DTWMatch &c) { return c.distance >= th; }),
+                              candidates_.end());
+            next_compact_ = std::max<size_t>(1024, 2 * candidates_.size());
+        }
+
+        const int64_t apart = 2 * span_ - 1;
+        for (const DTWMatch &it : bound_) {
+            if (overlaps(it, series, start, apart) && it.distance <= d2) {
+                return;
+            }
+        }
+        bound_.erase(std::remove_if(bound_.begin(), bound_.end(),
+                                    [&](const DTWMatch &it) {
+                                        return overlaps(it, series, start, apart);
+                                    }),
+                     bound_.end());
+        bound_.insert(std::upper_bound(bound_.begin(), bound_.end(), match, by_distance), match);
+        if (bound_.size() > k_) {
+            bound_.pop_back();
+        }
+    }
+
+    const std::vector<DTWMatch> &candidates() const { return candidates_; }
+
+private:
+    size_t k_;
+    int64_t span_;
+    size_t next_compact_ = 1024;
+    std::vector<DTWMatch> bound_;
+    std::vector<DTWMatch> candidates_;
+};
+
+// Per-worker buffers on the worker's arena, sized once for the longest
+// series and reused across series
+struct Scratch {
+    ScratchVector<long double> sum, sum2;
+    ScratchVector<int64_t> n_missing;
+    ScratchVector<double> lower, upper, z, cb, cb1, cb2, cost, prev;
+    ScratchVector<size_t> dq_lo, dq_hi;
+
+    Scratch(size_t max_n, size_t m, size_t r)
+        : sum(scratch<long double>(max_n + 1)), sum2(scratch<long double>(max_n + 1)),
+          n_missing(scratch<int64_t>(max_n + 1)), lower(scratch<double>(max_n)),
+          upper(scratch<double>(max_n)), z(scratch<double>(m)), cb(scratch<double>(m + 1)),
+          cb1(scratch<double>(m)), cb2(scratch<double>(m)), cost(scratch<double>(2 * r + 1)),
+          prev(scratch<double>(2 * r + 1)), dq_lo(scratch<size_t>(max_n)),
+          dq_hi(scratch<size_t>(max_n)) {}
+};
+
+void search_series(const double *t, size_t n, int64_t series, const Query &qr,
+                   const DTWSearchOptions &opts, Scratch &s, TopMatches &top,
+                   std::atomic<double> &shared_bound) {
+    const size_t m = qr.m;
+    if (n < m) {
+        return;
+    }
+
+    // Prefix sums for per-window mean and deviation; NaNs are counted and
+    // windows containing one are skipped
+    s.sum[0] = 0.0L;
+    s.sum2[0] = 0.0L;
+    s.n_missing[0] = 0;
+    double shift = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!is_missing(t[i])) {
+            shift = t[i];
+            break;
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        const bool missing = is_missing(t[i]);
+        const long double x = missing ? 0.0L : static_cast<long double>(t[i]) - shift;
+        s.sum[i + 1] = s.sum[i] + x;
+        s.sum2[i + 1] = s.sum2[i] + x * x;
+        s.n_missing[i + 1] = s.n_missing[i] + (missing ? 1 : 0);
+    }
+
+    // The data envelope is only meaningful without gaps; otherwise the
+    // cascade simply skips that bound
+    const bool use_data_envelope = s.n_missing[n] == 0;
+    if (use_data_envelope) {
+        envelope(t, n, qr.r, s.lower.data(), s.upper.data(), s.dq_lo.data(), s.dq_hi.data());
+    }
+
+    const bool excluded = series == opts.exclude_series && opts.exclude_start >= 0;
+    for (size_t start = 0; start + m <= n; ++start) {
+        if (s.n_missing[start + m] != s.n_missing[start]) {
+            continue;
+        }
+        if (excluded && static_cast<int64_t>(start + m) > opts.exclude_start &&
+            static_cast<int64_t>(start) < opts.exclude_start + static_cast<int64_t>(m)) {
+            continue;
+        }
+        const double bsf = std::min(top.threshold(), shared_bound.load(std::memory_order_relaxed));
+
+        const long double ws = s.sum[start + m] - s.sum[start];
+        const long double ws2 = s.sum2[start + m] - s.sum2[start];
+        const long double wmean = ws / m;
+        const long double var = ws2 / m - wmean * wmean;
+        const double mean = static_cast<double>(wmean) + shift;
+        const double sd = var > 0 ? static_cast<double>(std::sqrt(var)) : 0.0;
+        const double inv = sd > 1e-12 * (std::fabs(mean) + 1.0) ? 1.0 / sd : 0.0;
+        const double *w = t + start;
+
+        if (lb_kim(w, qr.q.data(), m, mean, inv, bsf) >= bsf) {
+            continue;
+        }
+        const double lb1 = lb_keogh_query(w, qr, mean, inv, s.cb1.data(), bsf);
+        if (lb1 >= bsf) {
+            continue;
+        }
+        double lb2 = 0.0;
+        if (use_data_envelope) {
+            lb2 = lb_keogh_data(qr, s.lower.data() + start, s.upper.data() + start, mean, inv,
+                                s.cb2.data(), bsf);
+            if (lb2 >= bsf) {
+                continue;
+            }
+        }
+
+        // Suffix sums of the tighter bound drive DTW early abandoning
+        const double *cbx = (use_data_envelope && lb2 > lb1) ? s.cb2.data() : s.cb1.data();
+        s.cb[m] = 0.0;
+        for (size_t i = m; i-- > 0;) {
+            s.cb[i] = s.cb[i + 1] + cbx[i];
+        }
+
+        for (size_t i = 0; i < m; ++i) {
+            s.z[i] = (w[i] - mean) * inv;
+        }
+        const double d2 = dtw_banded(s.z.data(), qr.q.data(), s.cb.data(), m, qr.r, bsf,
+                                     s.cost.data(), s.prev.data());
+        if (d2 < bsf) {
+            top.offer(series, static_cast<int64_t>(start), d2, bsf);
+            const double th = top.threshold();
+            double cur = shared_bound.load(std::memory_order_relaxed);
+            while (th < cur && !shared_bound.compare_exchange_weak(cur, th)) {
+            }
+        }
+    }
+}
+
+size_t band_radius(double band, size_t m) {
+    if (!(band >= 0.0 && band <= 1.0)) {
+        throw std::invalid_argument("band must be in [0, 1]");
+    }
+    return std::min(m - 1, static_cast<size_t>(std::floor(band * m)));
+}
+
+}  // namespace
+
+std::vector<DTWMatch> dtw_search(const double *values, const RaggedBatch &batch,
+                                 const double *query, size_t m, const DTWSearchOptions &opts) {
+    if (m < 2) {
+        throw std::invalid_argument("query must have at least 2 points");
+    }
+    if (opts.k == 0) {
+        throw std::invalid_argument("k must be positive");
+    }
+    const Query qr = prepare_query(query, m, band_radius(opts.band, m));
+
+    const size_t n_series = batch.n_series;
+    if (n_series == 0) {
+        return {};
+    }
+    const size_t n_slots = std::min<size_t>(ThreadPool::shared().size(), n_series);
+    std::vector<TopMatches> tops(n_slots, TopMatches(opts.k, m));
+    std::atomic<size_t> next{0};
+    std::atomic<double> shared_bound{kBig};
+    size_t max_n = 0;
+    for (size_t i = 0; i < n_series; ++i) {
+        max_n = std::max(max_n, batch.length(i));
+    }
+
+    // One task per worker slot pulling series off a shared counter: dynamic
+    // balance across uneven series with buffers that live for the whole run
+    parallel_for(n_slots, [&](size_t slot) {
+        ArenaScope scope;
+        Scratch buffers(max_n, m, qr.r);
+        for (;;) {
+            const size_t i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= n_series) {
+                break;
+            }
+            search_series(values + batch.begin(i), batch.length(i), static_cast<int64_t>(i), qr,
+                          opts, buffers, tops[slot], shared_bound);
+        }
+    });
+
+    // Greedy pick over every worker's candidates
+    std::vector<DTWMatch> pool;
+    for (const TopMatches &top : tops) {
+        pool.insert(pool.end(), top.candidates().begin(), top.candidates().end());
+    }
+    std::sort(pool.begin(), pool.end(), by_distance);
+    std::vector<DTWMatch> out;
+    for (const DTWMatch &c : pool) {
+        if (out.size() >= opts.k) {
+            break;
+        }
+        if (std::none_of(out.begin(), out.end(), [&](const DTWMatch &it) {
+                return overlaps(it, c.series, c.start, static_cast<int64_t>(m));
+            })) {
+            out.push_back(c);
+        }
+    }
+    for (DTWMatch &match : out) {
+        match.distance = std::sqrt(match.distance);
+    }
+    return out;
+}
+
+double dtw_distance(const double *a, const double *b, size_t m, size_t radius) {
+    if (m == 0) {
+        return 0.0;
+    }
+    const size_t r = std::min(radius, m - 1);
+    ArenaScope scope;
+    ScratchVector<double> cb = scratch<double>(m + 1, 0.0);
+    ScratchVector<double> cost = scratch<double>(2 * r + 1), prev = scratch<double>(2 * r + 1);
+    return std::sqrt(dtw_banded(a, b, cb.data(), m, r, kBig, cost.data(), prev.data()));
+}
+
+}  // namespace alphasignal
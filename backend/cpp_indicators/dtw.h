@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "batch.h"
+
+namespace alphasignal {
+
+// Subsequence similarity search under z-normalized dynamic time warping
+// (UCR suite). Every window of every series is compared with the query
+// after normalizing both to zero mean and unit variance; candidates are
+// discarded by the cascade LB_Kim -> LB_Keogh(query envelope) ->
+// LB_Keogh(data envelope) -> early-abandoning DTW.
+struct DTWSearchOptions {
+    double band = 0.1;   // Sakoe-Chiba radius as a fraction of the query length
+    size_t k = 10;       // number of matches to return
+    // Skip windows of this series that overlap [exclude_start, exclude_start + m),
+    // e.g. the window the query was cut from (-1: nothing excluded)
+    int64_t exclude_series = -1;
+    int64_t exclude_start = -1;
+};
+
+struct DTWMatch {
+    int64_t series;
+    int64_t start;    // relative to the series' first row
+    double distance;  // sqrt of the accumulated squared cost
+};
+
+// Windows containing NaN are skipped. Matches are picked greedily by
+// ascending distance, dropping any window that overlaps an already picked
+// one of the same series, so the top-k are distinct occurrences; the
+// result equals that pick over a brute-force scan (up to exact ties).
+// Series are spread over the shared thread pool and share a single
+// pruning bound.
+std::vector<DTWMatch> dtw_search(const double *values, const RaggedBatch &batch,
+                                 const double *query, size_t m,
+                                 const DTWSearchOptions &opts = DTWSearchOptions());
+
+// Banded DTW between two equal-length sequences (no normalization);
+// returns the square root of the accumulated squared cost
+double dtw_distance(const double *a, const double *b, size_t m, size_t radius);
+
+}  // namespace alphasignal
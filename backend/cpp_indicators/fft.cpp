@@ -0,0 +1,75 @@
+#include "fft.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace alphasignal {
+
+size_t next_pow2(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+FFTPlan::FFTPlan(size_t n) : n_(n) {
+    if (n == 0 || (n & (n - 1)) != 0) {
+        throw std::invalid_argument("FFT size must be a power of two");
+    }
+    // Literal 2*pi: M_PI is not portable and the module builds with -ffast-math
+    constexpr double kTwoPi = 6.283185307179586476925286766559;
+    twiddle_.resize(n / 2);
+    for (size_t k = 0; k < n / 2; ++k) {
+        const double angle = -kTwoPi * static_cast<double>(k) / static_cast<double>(n);
+        twiddle_[k] = Complex(std::cos(angle), std::sin(angle));
+    }
+
+    int bits = 0;
+    while ((size_t{1} << bits) < n) {
+        ++bits;
+    }
+    bitrev_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t r = 0;
+        for (int b = 0; b < bits; ++b) {
+            r |= ((i >> b) & 1u) << (bits - 1 - b);
+        }
+        bitrev_[i] = r;
+    }
+}
+
+void FFTPlan::forward(Complex *data) const { transform(data, false); }
+
+void FFTPlan::inverse(Complex *data) const {
+    transform(data, true);
+    const double scale = 1.0 / static_cast<double>(n_);
+    for (size_t i = 0; i < n_; ++i) {
+        data[i] *= scale;
+    }
+}
+
+void FFTPlan::transform(Complex *data, bool inverse) const {
+    for (size_t i = 0; i < n_; ++i) {
+        const size_t j = bitrev_[i];
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+    for (size_t len = 2; len <= n_; len <<= 1) {
+        const size_t half = len / 2;
+        const size_t stride = n_ / len;
+        for (size_t i = 0; i < n_; i += len) {
+            for (size_t j = 0; j < half; ++j) {
+                const Complex w = inverse ? std::conj(twiddle_[j * stride]) : twiddle_[j * stride];
+                const Complex u = data[i + j];
+                const Complex v = data[i + j + half] * w;
+                data[i + j] = u + v;
+                data[i + j + half] = u - v;
+            }
+        }
+    }
+}
+
+}  // namespace alphasignal
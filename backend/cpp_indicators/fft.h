@@ -0,0 +1,36 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace alphasignal {
+
+using Complex = std::complex<double>;
+
+// Smallest power of two >= n
+size_t next_pow2(size_t n);
+
+// Iterative radix-2 FFT with precomputed twiddles and bit-reversal table.
+// A plan is immutable after construction, so one plan can be shared by
+// every thread.
+class FFTPlan {
+public:
+    explicit FFTPlan(size_t n);  // n must be a power of two
+
+    size_t size() const { return n_; }
+
+    void forward(Complex *data) const;
+    // Includes the 1/n scaling, so inverse(forward(x)) == x
+    void inverse(Complex *data) const;
+
+private:
+    void transform(Complex *data, bool inverse) const;
+
+    size_t n_;
+    std::vector<Complex> twiddle_;  // exp(-2 pi i k / n), k < n / 2
+    std::vector<uint32_t> bitrev_;
+};
+
+}  // namespace alphasignal
@@ -0,0 +1,357 @@
+#include "frame.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+#include "arena.h"
+#include "batch.h"
+#include "calendar.h"
+#include "candles.h"
+#include "returns.h"
+#include "technical.h"
+
+namespace alphasignal {
+
+namespace {
+
+const double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+}  // namespace
+
+// ---- CsvTable ----
+
+void CsvTable::read(std::istream &in) {
+    text_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    header_.clear();
+    cells_.clear();
+    n_rows_ = 0;
+    size_t pos = 0;
+    std::vector<Cell> row;
+    if (!next_row(pos, row)) {
+        throw std::runtime_error("input has no header row");
+    }
+    for (const Cell &c : row) {
+        header_.push_back(cell_text(c));
+    }
+    while (next_row(pos, row)) {
+        if (row.size() == 1 && row[0].len == 0) {
+            continue;  // blank line
+        }
+        if (row.size() != header_.size()) {
+            throw std::runtime_error("row " + std::to_string(n_rows_ + 2) + " has " +
+                                     std::to_string(row.size()) + " fields, expected " +
+                                     std::to_string(header_.size()));
+        }
+        cells_.insert(cells_.end(), row.begin(), row.end());
+        ++n_rows_;
+    }
+}
+
+CsvTable CsvTable::load(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    CsvTable table;
+    table.read(in);
+    return table;
+}
+
+int CsvTable::find(const std::string &name) const {
+    for (size_t i = 0; i < header_.size(); ++i) {
+        if (header_[i] == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+int CsvTable::require(const std::string &name) const {
+    const int c = find(name);
+    if (c < 0) {
+        throw std::runtime_error("input has no '" + name + "' column");
+    }
+    return c;
+}
+
+std::string CsvTable::text(size_t row, int col) const {
+    return cell_text(cells_[row * header_.size() + static_cast<size_t>(col)]);
+}
+
+std::vector<double> CsvTable::numeric(int col) const {
+    std::vector<double> out(n_rows_);
+    std::string buf;
+    for (size_t r = 0; r < n_rows_; ++r) {
+        const Cell &c = cells_[r * header_.size() + static_cast<size_t>(col)];
+        buf.assign(text_, c.begin, c.len);
+        char *end = nullptr;
+        const double v = std::strtod(buf.c_str(), &end);
+        out[r] = (c.len > 0 && end && *end == '\0') ? v : kNaN;
+    }
+    return out;
+}
+
+bool CsvTable::next_row(size_t &pos, std::vector<Cell> &row) const {
+    row.clear();
+    if (pos >= text_.size()) {
+        return false;
+    }
+    size_t start = pos;
+    for (;;) {
+        const bool eol = pos == text_.size() || text_[pos] == '\n';
+        if (eol || text_[pos] == ',') {
+            size_t end = pos;
+            if (eol && end > start && text_[end - 1] == '\r') {
+                --end;
+            }
+            row.push_back(Cell{start, end - start});
+            ++pos;
+            start = pos;
+            if (eol) {
+                return true;
+            }
+            continue;
+        }
+        ++pos;
+    }
+}
+
+// ---- Dates ----
+
+// Howard Hinnant's days_from_civil
+int64_t parse_date(const std::string &s) {
+    int y, m, d;
+    if (std::sscanf(s.c_str(), "%d-%d-%d", &y, &m, &d) != 3 || m < 1 || m > 12 || d < 1 ||
+        d > 31) {
+        throw std::runtime_error("bad date '" + s + "' (expected YYYY-MM-DD)");
+    }
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const int64_t yoe = y - era * 400;
+    const int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+std::vector<int64_t> load_holidays(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    std::vector<int64_t> days;
+    for (std::string line; std::getline(in, line);) {
+        if (!line.empty() && line[0] != '#' && line[0] != '\r') {
+            days.push_back(parse_date(line));
+        }
+    }
+    return days;
+}
+
+// ---- FeatureFrame ----
+
+FeatureFrame::FeatureFrame(std::shared_ptr<const CsvTable> input, const FrameOptions &opts)
+    : input_(std::move(input)), opts_(opts) {
+    ticker_col_ = input_->find(opts_.ticker_col);
+    date_col_ = input_->find(opts_.date_col);
+
+    const size_t n = input_->rows();
+    if (ticker_col_ < 0) {
+        if (n > 0) {
+            runs_.emplace_back(0, n);
+        }
+    } else {
+        size_t begin = 0;
+        for (size_t r = 1; r <= n; ++r) {
+            if (r < n && input_->text(r, ticker_col_) == input_->text(begin, ticker_col_)) {
+                continue;
+            }
+            runs_.emplace_back(begin, r);
+            begin = r;
+        }
+    }
+
+    if (ticker_col_ >= 0) {
+        copy(opts_.ticker_col);
+    }
+    if (date_col_ >= 0) {
+        copy(opts_.date_col);
+    }
+}
+
+void FeatureFrame::copy(const std::string &name) {
+    names_.push_back(name);
+    source_.push_back(input_->require(name));
+    values_.emplace_back();
+}
+
+std::vector<double> &FeatureFrame::add(const std::string &name) {
+    names_.push_back(name);
+    source_.push_back(-1);
+    values_.emplace_back(rows(), kNaN);
+    return values_.back();
+}
+
+std::vector<double> FeatureFrame::column(const std::string &name) const {
+    for (size_t c = 0; c < names_.size(); ++c) {
+        if (names_[c] == name && source_[c] < 0) {
+            return values_[c];
+        }
+    }
+    const int col = input_->find(name);
+    if (col < 0) {
+        throw std::runtime_error("no column '" + name + "'");
+    }
+    return input_->numeric(col);
+}
+
+void FeatureFrame::add_indicators() {
+    copy("close");
+    const std::vector<double> close = column("close");
+    std::vector<double> &rsi_col = add("rsi");
+    std::vector<double> &macd_col = add("macd");
+    std::vector<double> &signal_col = add("macd_signal");
+    std::vector<double> &hist_col = add("macd_hist");
+    std::vector<double> &upper = add("bb_upper");
+    std::vector<double> &middle = add("bb_middle");
+    std::vector<double> &lower = add("bb_lower");
+    for (const auto &run : runs_) {
+        const size_t b = run.first, len = run.second - run.first;
+        const double *p = close.data() + b;
+        rsi(p, len, 14, rsi_col.data() + b);
+        macd(p, len, 12, 26, 9, macd_col.data() + b, signal_col.data() + b, hist_col.data() + b);
+        bollinger_bands(p, len, 20, 2.0, upper.data() + b, middle.data() + b, lower.data() + b);
+    }
+}
+
+void FeatureFrame::add_features() {
+    ArenaScope scope;
+    const size_t n = rows();
+    const std::vector<double> close = column("close");
+
+    // Returns, horizon-major per ticker run
+    ReturnsOptions ret;
+    const size_t nh = ret.horizons.size();
+    std::vector<std::vector<double> *> simple(nh), logr(nh);
+    for (size_t h = 0; h < nh; ++h) {
+        const std::string suffix = std::to_string(ret.horizons[h]);
+        simple[h] = &add("return_" + suffix);
+        logr[h] = &add("log_return_" + suffix);
+    }
+    ScratchVector<double> s = scratch<double>(0), l = scratch<double>(0);
+    for (const auto &run : runs_) {
+        const size_t b = run.first, len = run.second - run.first;
+        s.resize(nh * len);
+        l.resize(nh * len);
+        compute_returns(close.data() + b, len, ret,
+                        ReturnsOutput{s.data(), l.data(), nullptr, nullptr, len});
+        for (size_t h = 0; h < nh; ++h) {
+            std::copy(s.begin() + h * len, s.begin() + (h + 1) * len, simple[h]->begin() + b);
+            std::copy(l.begin() + h * len, l.begin() + (h + 1) * len, logr[h]->begin() + b);
+        }
+    }
+
+    // Candlesticks when the bar has a full OHLC
+    const int c_open = input_->find("open"), c_high = input_->find("high"),
+              c_low = input_->find("low");
+    if (c_open >= 0 && c_high >= 0 && c_low >= 0) {
+        const std::vector<double> open = input_->numeric(c_open), high = input_->numeric(c_high),
+                                  low = input_->numeric(c_low);
+        std::vector<std::vector<double> *> shape(kNumCandleFeatures);
+        const auto &shape_names = candle_feature_names();
+        for (size_t k = 0; k < kNumCandleFeatures; ++k) {
+            shape[k] = &add(shape_names[k]);
+        }
+        std::vector<double> &patterns = add("candle_patterns");
+        ScratchVector<uint64_t> bits = scratch<uint64_t>(0);
+        ScratchVector<double> f = scratch<double>(0);
+        for (const auto &run : runs_) {
+            const size_t b = run.first, len = run.second - run.first;
+            bits.resize(len);
+            f.resize(kNumCandleFeatures * len);
+            candle_patterns(OHLCVColumns{open.data() + b, high.data() + b, low.data() + b,
+                                         close.data() + b, nullptr},
+                            len, CandleOptions(), bits.data(), f.data(), len);
+            for (size_t k = 0; k < kNumCandleFeatures; ++k) {
+                std::copy(f.begin() + k * len, f.begin() + (k + 1) * len, shape[k]->begin() + b);
+            }
+            for (size_t r = 0; r < len; ++r) {
+                patterns[b + r] = static_cast<double>(bits[r]);
+            }
+        }
+    }
+
+    // Calendar fields from the date column
+    if (date_col_ >= 0) {
+        ScratchVector<int64_t> days = scratch<int64_t>(n);
+        for (size_t r = 0; r < n; ++r) {
+            days[r] = parse_date(input_->text(r, date_col_));
+        }
+        ScratchVector<double> cal = scratch<double>(kNumCalendarFeatures * n);
+        calendar_features(days.data(), n, opts_.holidays.data(), opts_.holidays.size(),
+                          cal.data());
+        const auto &cal_names = calendar_feature_names();
+        for (int k = 0; k < kNumCalendarFeatures; ++k) {
+            std::copy(cal.begin() + k * n, cal.begin() + (k + 1) * n, add(cal_names[k]).begin());
+        }
+    }
+}
+
+void FeatureFrame::add_scores(const TreeEnsemble &model) {
+    std::vector<std::vector<double>> cols;
+    if (!model.feature_names.empty()) {
+        for (const std::string &name : model.feature_names) {
+            cols.push_back(column(name));
+        }
+    } else {
+        for (int c = 0; c < static_cast<int>(input_->header().size()); ++c) {
+            if (c != ticker_col_ && c != date_col_) {
+                cols.push_back(input_->numeric(c));
+            }
+        }
+    }
+    if (static_cast<int32_t>(cols.size()) != model.n_features) {
+        throw std::runtime_error("model expects " + std::to_string(model.n_features) +
+                                 " feature columns, input has " + std::to_string(cols.size()));
+    }
+
+    ArenaScope scope;
+    const size_t n = rows(), nf = cols.size();
+    ScratchVector<double> rows_buf = scratch<double>(n * nf);
+    for (size_t k = 0; k < nf; ++k) {
+        for (size_t r = 0; r < n; ++r) {
+            rows_buf[r * nf + k] = cols[k][r];
+        }
+    }
+    model.predict_batch(rows_buf.data(), n, add("probability_up").data());
+}
+
+void FeatureFrame::write(std::ostream &out) const {
+    for (size_t c = 0; c < names_.size(); ++c) {
+        out << (c ? "," : "") << names_[c];
+    }
+    out << '\n';
+    char buf[32];
+    for (size_t r = 0; r < rows(); ++r) {
+        for (size_t c = 0; c < names_.size(); ++c) {
+            if (c) {
+                out << ',';
+            }
+            if (source_[c] >= 0) {
+                out << input_->text(r, source_[c]);
+            } else if (!is_missing(values_[c][r])) {
+                std::snprintf(buf, sizeof(buf), "%.10g", values_[c][r]);
+                out << buf;
+            }
+        }
+        out << '\n';
+    }
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tree_model.h"
+
+namespace alphasignal {
+
+// Unquoted CSV (no commas or newlines inside fields, as our exports are)
+// held as one text buffer; numeric columns are parsed on demand.
+class CsvTable {
+public:
+    void read(std::istream &in);
+    // Throws std::runtime_error if the file cannot be opened or parsed
+    static CsvTable load(const std::string &path);
+
+    size_t rows() const { return n_rows_; }
+    const std::vector<std::string> &header() const { return header_; }
+
+    int find(const std::string &name) const;  // -1 if absent
+    int require(const std::string &name) const;
+
+    std::string text(size_t row, int col) const;
+    // Empty or unparsable cells become NaN
+    std::vector<double> numeric(int col) const;
+
+private:
+    struct Cell {
+        size_t begin;
+        size_t len;
+    };
+
+    bool next_row(size_t &pos, std::vector<Cell> &row) const;
+    std::string cell_text(const Cell &c) const { return text_.substr(c.begin, c.len); }
+
+    std::string text_;
+    std::vector<std::string> header_;
+    std::vector<Cell> cells_;
+    size_t n_rows_ = 0;
+};
+
+// "YYYY-MM-DD[...]" -> epoch days
+int64_t parse_date(const std::string &s);
+// One date per line; blank lines and '#' comments are skipped
+std::vector<int64_t> load_holidays(const std::string &path);
+
+struct FrameOptions {
+    std::string ticker_col = "ticker";  // optional; one series if absent
+    std::string date_col = "date";      // optional; calendar features need it
+    std::vector<int64_t> holidays;      // epoch days
+};
+
+// Result table of the batch pipelines: the input's key columns plus computed
+// columns, all n rows long. Rows of one ticker must be contiguous and in
+// time order; look-back windows never cross tickers.
+class FeatureFrame {
+public:
+    FeatureFrame(std::shared_ptr<const CsvTable> input, const FrameOptions &opts);
+
+    size_t rows() const { return input_->rows(); }
+    const CsvTable &input() const { return *input_; }
+    const std::vector<std::string> &names() const { return names_; }
+
+    // Copy an input column through unchanged
+    void copy(const std::string &name);
+    // New computed column, NaN-filled
+    std::vector<double> &add(const std::string &name);
+    // Computed column, else the input column of that name parsed as numbers
+    std::vector<double> column(const std::string &name) const;
+
+    // close, RSI(14), MACD(12, 26, 9), Bollinger(20, 2) from the close column
+    void add_indicators();
+    // Returns (1, 5, 20), candlestick shapes when open/high/low exist,
+    // calendar fields when the date column exists
+    void add_features();
+    // probability_up from the model's named features (any input or computed
+    // column), or from every input column except the keys, in file order,
+    // when the model carries no names
+    void add_scores(const TreeEnsemble &model);
+
+    void write(std::ostream &out) const;
+
+private:
+    using Runs = std::vector<std::pair<size_t, size_t>>;  // [begin, end) per ticker
+
+    std::shared_ptr<const CsvTable> input_;
+    FrameOptions opts_;
+    int ticker_col_;
+    int date_col_;
+    Runs runs_;
+    std::vector<std::string> names_;
+    std::vector<int> source_;  // input column, or -1 for computed
+    std::deque<std::vector<double>> values_;  // deque: add() references stay valid
+};
+
+}  // namespace alphasignal
@@ -0,0 +1,310 @@
+#include "fund_metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "arena.h"
+#include "thread_pool.h"
+
+namespace alphasignal {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+constexpr double kMinX = -10.0;  // log(1 + r) search range
+constexpr double kMaxX = 10.0;
+constexpr double kTolX = 1e-12;
+constexpr int kMaxIterations = 100;
+
+// NPV and its derivative in x = log(1 + r)
+inline void npv(const double *t, const double *a, size_t n, double x, double &f, double &df) {
+    f = 0.0;
+    df = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        const double v = a[i] * std::exp(-x * t[i]);
+        f += v;
+        df -= t[i] * v;
+    }
+}
+
+double solve(const double *t, const double *a, size_t n, double guess, int &iterations) {
+    iterations = 0;
+    bool has_in = false, has_out = false;
+    for (size_t i = 0; i < n; ++i) {
+        has_in |= a[i] > 0.0;
+        has_out |= a[i] < 0.0;
+    }
+    if (!has_in || !has_out) {
+        return kNaN;
+    }
+
+    const double x0 =
+        is_missing(guess) || guess <= -1.0 ? std::log1p(0.1)
+                                           : std::min(kMaxX, std::max(kMinX, std::log1p(guess)));
+    double f0, df0;
+    npv(t, a, n, x0, f0, df0);
+    ++iterations;
+    if (f0 == 0.0) {
+        return std::expm1(x0);
+    }
+
+    // Grow a bracket outward from the guess; a close guess closes it in a step
+    double lo = x0, hi = x0, f_lo = f0, f_hi = f0;
+    bool bracketed = false;
+    for (double h = 0.05; !bracketed; h *= 2.0) {
+        const bool at_limits = lo <= kMinX && hi >= kMaxX;
+        if (at_limits) {
+            return kNaN;
+        }
+        double unused;
+        if (hi < kMaxX) {
+            const double x = std::min(kMaxX, x0 + h);
+            double f;
+            npv(t, a, n, x, f, unused);
+            ++iterations;
+            if ((f < 0.0) != (f0 < 0.0) || f == 0.0) {
+                lo = hi;
+                f_lo = f_hi;
+                hi = x;
+                f_hi = f;
+                bracketed = true;
+                break;
+            }
+            hi = x;
+            f_hi = f;
+        }
+        if (lo > kMinX) {
+            const double x = std::max(kMinX, x0 - h);
+            double f;
+            npv(t, a, n, x, f, unused);
+            ++iterations;
+            if ((f < 0.0) != (f0 < 0.0) || f == 0.0) {
+                hi = lo;
+                f_hi = f_lo;
+                lo = x;
+                f_lo = f;
+                bracketed = true;
+                break;
+            }
+            lo = x;
+            f_lo = f;
+        }
+    }
+    if (f_lo == 0.0) {
+        return std::expm1(lo);
+    }
+    if (f_hi == 0.0) {
+        return std::expm1(hi);
+    }
+
+    // Safeguarded Newton (rtsafe) with xl on the negative side
+    double xl = f_lo < 0.0 ? lo : hi;
+    double xh = f_lo < 0.0 ? hi : lo;
+    double x = x0;
+    double f = f0, df = df0;
+    if (x < lo || x > hi) {
+        // The bracket grew past the guess: start from its nearer end
+        x = x < lo ? lo : hi;
+        npv(t, a, n, x, f, df);
+        ++iterations;
+    }
+    double dx_old = std::fabs(hi - lo);
+    double dx = dx_old;
+    for (int k = 0; k < kMaxIterations; ++k) {
+        const bool leaves = ((x - xh) * df - f) * ((x - xl) * df - f) > 0.0;
+        if (leaves || std::fabs(2.0 * f) > std::fabs(dx_old * df)) {
+            dx_old = dx;
+            dx = 0.5 * (xh - xl);
+            x = xl + dx;
+        } else {
+            dx_old = dx;
+            dx = f / df;
+            x -= dx;
+        }
+        if (std::fabs(dx) < kTolX) {
+            return std::expm1(x);
+        }
+        npv(t, a, n, x, f, df);
+        ++iterations;
+        if (f == 0.0) {
+            return std::expm1(x);
+        }
+        if (f < 0.0) {
+            xl = x;
+        } else {
+            xh = x;
+        }
+    }
+    return std::expm1(x);
+}
+
+void finish_multiples(PerformanceMetrics &m) {
+    if (m.paid_in > 0.0) {
+        m.dpi = m.distributed / m.paid_in;
+        m.rvpi = m.nav / m.paid_in;
+        m.tvpi = m.dpi + m.rvpi;
+    } else {
+        m.dpi = m.rvpi = m.tvpi = kNaN;
+    }
+}
+
+double solve_flows(const CashFlowPoint *flows, size_t n, double guess, int &iterations) {
+    if (n == 0) {
+        iterations = 0;
+        return kNaN;
+    }
+    ScratchVector<double> t = scratch<double>(n);
+    ScratchVector<double> a = scratch<double>(n);
+    const int32_t day0 = flows[0].day;
+    for (size_t k = 0; k < n; ++k) {
+        t[k] = (flows[k].day - day0) / 365.0;
+        a[k] = flows[k].amount;
+    }
+    return solve(t.data(), a.data(), n, guess, iterations);
+}
+
+}  // namespace
+
+int32_t deal_cash_flows(const FlowTable &flows, const DealInputs &deals, size_t i,
+                        ScratchVector<CashFlowPoint> &out, PerformanceMetrics &m) {
+    const size_t b = flows.batch.begin(i);
+    const size_t len = flows.batch.length(i);
+    double last_mark = kNaN;
+    for (size_t k = b; k < b + len; ++k) {
+        if (k > b && flows.day[k] < flows.day[k - 1]) {
+            throw std::invalid_argument("cash flow days must ascend within each deal");
+        }
+        const double amount = std::fabs(flows.amount[k]);
+        if (is_missing(amount) || flows.day[k] > deals.as_of_day) {
+            continue;
+        }
+        switch (flows.kind[k]) {
+        case kContribution:
+            m.paid_in += amount;
+            out.push_back(CashFlowPoint{flows.day[k], -amount});
+            break;
+        case kDistribution:
+            m.distributed += amount;
+            out.push_back(CashFlowPoint{flows.day[k], amount});
+            break;
+        case kNavMark:
+            last_mark = amount;
+            break;
+        default:
+            throw std::invalid_argument("unknown cash flow kind " +
+                                        std::to_string(int(flows.kind[k])));
+        }
+    }
+    // nav_latest is today's NAV; a back-dated valuation uses the marks
+    const double nav_latest =
+        deals.as_of_day >= deals.nav_latest_day ? deals.nav_latest[i] : kNaN;
+    m.nav = !is_missing(nav_latest) ? nav_latest : (is_missing(last_mark) ? 0.0 : last_mark);
+    return deals.as_of_day;
+}
+
+FundMembers group_by_fund(const DealInputs &deals, size_t n_deals) {
+    FundMembers g;
+    g.start.assign(deals.n_funds + 1, 0);
+    for (size_t i = 0; i < n_deals; ++i) {
+        const int32_t f = deals.fund[i];
+        if (f >= 0 && static_cast<size_t>(f) >= deals.n_funds) {
+            throw std::invalid_argument("deal fund " + std::to_string(f) +
+                                        " is outside the fund table");
+        }
+        if (f >= 0) {
+            ++g.start[f + 1];
+        }
+    }
+    for (size_t f = 0; f < deals.n_funds; ++f) {
+        g.start[f + 1] += g.start[f];
+    }
+    g.deals.resize(g.start[deals.n_funds]);
+    std::vector<size_t> fill(g.start.begin(), g.start.end() - 1);
+    for (size_t i = 0; i < n_deals; ++i) {
+        if (deals.fund[i] >= 0) {
+            g.deals[fill[deals.fund[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+    return g;
+}
+
+double xirr(const int32_t *day, const double *amount, size_t n, double guess, int *iterations) {
+    ArenaScope scope;
+    ScratchVector<CashFlowPoint> flows(&scope.arena());
+    flows.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (!is_missing(amount[i])) {
+            flows.push_back(CashFlowPoint{day[i], amount[i]});
+        }
+    }
+    std::stable_sort(flows.begin(), flows.end(),
+                     [](const CashFlowPoint &x, const CashFlowPoint &y) { return x.day < y.day; });
+    return xirr(flows.data(), flows.size(), guess, iterations);
+}
+
+double xirr(const CashFlowPoint *flows, size_t n, double guess, int *iterations) {
+    ArenaScope scope;
+    int iters;
+    const double r = solve_flows(flows, n, guess, iters);
+    if (iterations) {
+        *iterations = iters;
+    }
+    return r;
+}
+
+PerformanceReport compute_performance(const FlowTable &flows, const DealInputs &deals) {
+    const size_t n_deals = flows.batch.n_series;
+    PerformanceReport report;
+    report.deals.resize(n_deals);
+    report.funds.resize(deals.n_funds);
+
+    const FundMembers members = group_by_fund(deals, n_deals);
+
+    parallel_for(n_deals, [&](size_t i) {
+        ArenaScope scope;
+        ScratchVector<CashFlowPoint> signed_flows(&scope.arena());
+        PerformanceMetrics &m = report.deals[i];
+        const int32_t valuation_day = deal_cash_flows(flows, deals, i, signed_flows, m);
+        if (m.nav != 0.0) {
+            signed_flows.push_back(CashFlowPoint{valuation_day, m.nav});
+        }
+        finish_multiples(m);
+        const double guess = deals.guess ? deals.guess[i] : kNaN;
+        m.irr = solve_flows(signed_flows.data(), signed_flows.size(), guess, m.iterations);
+    });
+
+    // Funds pool their deals' flows; the paid-in weighted deal IRR seeds the solve
+    parallel_for(deals.n_funds, [&](size_t f) {
+        ArenaScope scope;
+        ScratchVector<CashFlowPoint> pooled(&scope.arena());
+        PerformanceMetrics &m = report.funds[f];
+        double seed_sum = 0.0, seed_weight = 0.0;
+        for (size_t k = members.start[f]; k < members.start[f + 1]; ++k) {
+            const size_t i = members.deals[k];
+            PerformanceMetrics deal;
+            const int32_t valuation_day = deal_cash_flows(flows, deals, i, pooled, deal);
+            if (deal.nav != 0.0) {
+                pooled.push_back(CashFlowPoint{valuation_day, deal.nav});
+            }
+            m.paid_in += deal.paid_in;
+            m.distributed += deal.distributed;
+            m.nav += deal.nav;
+            const double irr = report.deals[i].irr;
+            if (!is_missing(irr) && deal.paid_in > 0.0) {
+                seed_sum += irr * deal.paid_in;
+                seed_weight += deal.paid_in;
+            }
+        }
+        finish_multiples(m);
+        std::stable_sort(pooled.begin(), pooled.end(),
+                         [](const CashFlowPoint &x, const CashFlowPoint &y) { return x.day < y.day; });
+        m.irr = solve_flows(pooled.data(), pooled.size(),
+                            seed_weight > 0.0 ? seed_sum / seed_weight : kNaN, m.iterations);
+    });
+    return report;
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "arena.h"
+#include "batch.h"
+
+namespace alphasignal {
+
+// CashFlow.flow_type
+enum FlowKind : int8_t { kContribution = 0, kDistribution = 1, kNavMark = 2 };
+
+// Cash flows of many deals laid out by batch, days (epoch days) ascending
+// within each deal. Amounts are magnitudes; kind gives the direction.
+struct FlowTable {
+    const int32_t *day;
+    const double *amount;
+    const int8_t *kind;
+    RaggedBatch batch;
+};
+
+// One entry per deal
+struct DealInputs {
+    const double *nav_latest;  // current NAV, NaN = use the deal's last NAV mark, else 0
+    const int32_t *fund;       // index into the fund results, -1 = no fund
+    const double *guess;       // previous IRR per deal, NaN = none; may be null
+    size_t n_funds;
+    int32_t as_of_day;         // valuation date of the residual NAV; later flows are ignored
+    int32_t nav_latest_day;    // day nav_latest is current on (today); an earlier
+                               // as_of_day uses the last mark on or before it instead
+};
+
+struct PerformanceMetrics {
+    double paid_in = 0.0;
+    double distributed = 0.0;
+    double nav = 0.0;
+    double tvpi = 0.0;  // (distributed + nav) / paid_in; NaN without paid-in capital
+    double dpi = 0.0;
+    double rvpi = 0.0;
+    double irr = 0.0;   // annualised XIRR, NaN if the flows have no root
+    int iterations = 0;
+};
+
+struct CashFlowPoint {
+    int32_t day;
+    double amount;  // signed: contributions negative
+};
+
+struct PerformanceReport {
+    std::vector<PerformanceMetrics> deals;
+    std::vector<PerformanceMetrics> funds;  // pooled flows of each fund's deals
+};
+
+// Rate r with sum(amount_i / (1 + r)^((day_i - day_0) / 365)) = 0 for
+// signed amounts (contributions negative). Solved in x = log(1 + r):
+// a bracket is grown outward from the guess and Newton steps that leave
+// it, or stop halving the residual, fall back to bisection. Returns NaN
+// when no sign change exists for r in (-0.99995, 22025).
+double xirr(const int32_t *day, const double *amount, size_t n, double guess = 0.1,
+            int *iterations = nullptr);
+
+// The same for flows already in day order
+double xirr(const CashFlowPoint *flows, size_t n, double guess = 0.1, int *iterations = nullptr);
+
+// Contributions (negative) and distributions of deal i on or before
+// as_of_day appended to out in day order; fills paid_in, distributed and
+// nav of m. NAV marks are not cash flows. The NAV is nav_latest when
+// as_of_day >= nav_latest_day, else (or when it is NaN) the last mark on or
+// before as_of_day. Returns the valuation day of the residual NAV, as_of_day.
+int32_t deal_cash_flows(const FlowTable &flows, const DealInputs &deals, size_t i,
+                        ScratchVector<CashFlowPoint> &out, PerformanceMetrics &m);
+
+// Deals of fund f are deals[start[f] .. start[f + 1]), in deal order
+struct FundMembers {
+    std::vector<size_t> start;
+    std::vector<uint32_t> deals;
+};
+
+// Throws std::invalid_argument on a fund index outside n_funds
+FundMembers group_by_fund(const DealInputs &deals, size_t n_deals);
+
+// Multiples and XIRR of every deal, in parallel, and of every fund from the
+// same per-deal sums plus its deals' flows pooled. The residual NAV is a
+// final inflow on the deal's valuation day.
+PerformanceReport compute_performance(const FlowTable &flows, const DealInputs &deals);
+
+}  // namespace alphasignal
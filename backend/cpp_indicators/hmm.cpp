@@ -0,0 +1,448 @@
+#include "hmm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "arena.h"
+#include "thread_pool.h"
+
+namespace alphasignal {
+
+namespace {
+
+const double kLog2Pi = 1.8378770664093454836;  // log(2 * pi)
+
+// Everything stays finite: the module is built with -ffast-math, which
+// assumes no infinities, so log(0) is clamped instead of returning -inf.
+inline double safe_log(double x) {
+    return std::log(std::max(x, 1e-300));
+}
+
+inline double log_sum_exp(const double *a, int n) {
+    double m = a[0];
+    for (int i = 1; i < n; ++i) {
+        m = std::max(m, a[i]);
+    }
+    double s = 0.0;
+    for (int i = 0; i < n; ++i) {
+        s += std::exp(a[i] - m);
+    }
+    return m + std::log(s);
+}
+
+// Per state/dimension constants of the diagonal Gaussian log density;
+// inv_var and log_norm hold variances.size() entries
+void emission_constants(const std::vector<double> &variances, double *inv_var,
+                        double *log_norm) {
+    for (size_t i = 0; i < variances.size(); ++i) {
+        inv_var[i] = 1.0 / variances[i];
+        log_norm[i] = -0.5 * (kLog2Pi + std::log(variances[i]));
+    }
+}
+
+GaussianHMM flat_model(int n_states, int n_dims) {
+    GaussianHMM model;
+    model.n_states = n_states;
+    model.n_dims = n_dims;
+    model.log_start.assign(n_states, -std::log(static_cast<double>(n_states)));
+    model.log_trans.assign(n_states * n_states, -std::log(static_cast<double>(n_states)));
+    model.means.assign(n_states * n_dims, 0.0);
+    model.variances.assign(n_states * n_dims, 1.0);
+    return model;
+}
+
+// Split the rows into n_states quantile groups of dimension 0 and seed each
+// state with its group's moments. Returns false if there is too little data.
+bool init_from_quantiles(const double *obs, size_t n_rows, int n_dims,
+                         const HMMFitOptions &opts, GaussianHMM &model) {
+    const int K = opts.n_states;
+    const int D = n_dims;
+
+    ScratchVector<std::pair<double, size_t>> ranked = scratch<std::pair<double, size_t>>(0);
+    ranked.reserve(n_rows);
+    for (size_t t = 0; t < n_rows; ++t) {
+        double v = obs[t * D];
+        if (!is_missing(v)) {
+            ranked.emplace_back(v, t);
+        }
+    }
+    if (ranked.size() < static_cast<size_t>(2 * K)) {
+        return false;
+    }
+    std::sort(ranked.begin(), ranked.end());
+
+    ScratchVector<double> w = scratch<double>(K * D, 0.0), s = scratch<double>(K * D, 0.0);
+    ScratchVector<double> ss = scratch<double>(K * D, 0.0);
+    for (size_t r = 0; r < ranked.size(); ++r) {
+        int k = static_cast<int>(r * K / ranked.size());
+        const double *x = obs + ranked[r].second * D;
+        for (int d = 0; d < D; ++d) {
+            if (!is_missing(x[d])) {
+                w[k * D + d] += 1.0;
+                s[k * D + d] += x[d];
+                ss[k * D + d] += x[d] * x[d];
+            }
+        }
+    }
+
+    model = flat_model(K, D);
+    for (int i = 0; i < K * D; ++i) {
+        if (w[i] > 0.0) {
+            double mean = s[i] / w[i];
+            model.means[i] = mean;
+            model.variances[i] = std::max(ss[i] / w[i] - mean * mean, opts.min_variance);
+        }
+    }
+
+    // Sticky transitions: regimes persist for a while
+    const double stay = K > 1 ? 0.9 : 1.0;
+    const double move = K > 1 ? (1.0 - stay) / (K - 1) : 0.0;
+    for (int i = 0; i < K; ++i) {
+        for (int j = 0; j < K; ++j) {
+            model.log_trans[i * K + j] = safe_log(i == j ? stay : move);
+        }
+    }
+    return true;
+}
+
+// Reorder states by ascending variance of dimension 0
+void canonical_order(GaussianHMM &model) {
+    const int K = model.n_states;
+    const int D = model.n_dims;
+    ArenaScope scope;
+    ScratchVector<int> order = scratch<int>(K);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return model.variances[a * D] < model.variances[b * D];
+    });
+
+    GaussianHMM sorted = model;
+    for (int i = 0; i < K; ++i) {
+        int oi = order[i];
+        sorted.log_start[i] = model.log_start[oi];
+        for (int j = 0; j < K; ++j) {
+            sorted.log_trans[i * K + j] = model.log_trans[oi * K + order[j]];
+        }
+        for (int d = 0; d < D; ++d) {
+            sorted.means[i * D + d] = model.means[oi * D + d];
+            sorted.variances[i * D + d] = model.variances[oi * D + d];
+        }
+    }
+    model = std::move(sorted);
+}
+
+}  // namespace
+
+void hmm_log_emissions(const GaussianHMM &model, const double *obs, size_t n_rows,
+                       double *out) {
+    const int K = model.n_states;
+    const int D = model.n_dims;
+    ArenaScope scope;
+    ScratchVector<double> inv_var = scratch<double>(model.variances.size());
+    ScratchVector<double> log_norm = scratch<double>(model.variances.size());
+    emission_constants(model.variances, inv_var.data(), log_norm.data());
+
+    // State-major output keeps the inner loop contiguous over time so the
+    // compiler can vectorize it; missing values are masked with a select.
+    std::fill(out, out + K * n_rows, 0.0);
+    for (int k = 0; k < K; ++k) {
+        double *row = out + k * n_rows;
+        for (int d = 0; d < D; ++d) {
+            const double mu = model.means[k * D + d];
+            const double iv = inv_var[k * D + d];
+            const double ln = log_norm[k * D + d];
+            for (size_t t = 0; t < n_rows; ++t) {
+                double x = obs[t * D + d];
+                double diff = x - mu;
+                double term = ln - 0.5 * diff * diff * iv;
+                row[t] += is_missing(x) ? 0.0 : term;
+            }
+        }
+    }
+}
+
+GaussianHMM fit_gaussian_hmm(const double *obs, size_t n_rows, int n_dims,
+                             const HMMFitOptions &opts) {
+    if (opts.n_states < 1 || n_dims < 1) {
+        throw std::invalid_argument("n_states and n_dims must be positive");
+    }
+    const int K = opts.n_states;
+    const int D = n_dims;
+    const size_t n = n_rows;
+
+    ArenaScope scope;
+    GaussianHMM model;
+    if (!init_from_quantiles(obs, n, D, opts, model)) {
+        return flat_model(K, D);
+    }
+
+    ScratchVector<double> log_b = scratch<double>(K * n);
+    ScratchVector<double> log_alpha = scratch<double>(n * K);
+    ScratchVector<double> log_beta = scratch<double>(n * K);
+    ScratchVector<double> tmp = scratch<double>(K);
+    ScratchVector<double> trans = scratch<double>(K * K);
+
+    ScratchVector<double> start_acc = scratch<double>(K), trans_acc = scratch<double>(K * K);
+    ScratchVector<double> w = scratch<double>(K * D), s = scratch<double>(K * D);
+    ScratchVector<double> ss = scratch<double>(K * D);
+
+    double prev_ll = std::numeric_limits<double>::lowest();
+    for (int iter = 0; iter < opts.max_iter; ++iter) {
+        hmm_log_emissions(model, obs, n, log_b.data());
+
+        for (int i = 0; i < K * K; ++i) {
+            trans[i] = std::exp(model.log_trans[i]);
+        }
+
+        // Forward pass. Messages stay in log space; each step shifts by the
+        // previous max so the K x K product runs on linear values with only
+        // K exp/log calls per bar.
+        for (int j = 0; j < K; ++j) {
+            log_alpha[j] = model.log_start[j] + log_b[j * n];
+        }
+        for (size_t t = 1; t < n; ++t) {
+            const double *prev = &log_alpha[(t - 1) * K];
+            const double m = *std::max_element(prev, prev + K);
+            for (int i = 0; i < K; ++i) {
+                tmp[i] = std::exp(prev[i] - m);
+            }
+            for (int j = 0; j < K; ++j) {
+                double acc = 0.0;
+                for (int i = 0; i < K; ++i) {
+                    acc += tmp[i] * trans[i * K + j];
+                }
+                log_alpha[t * K + j] = log_b[j * n + t] + m + safe_log(acc);
+            }
+        }
+        const double ll = log_sum_exp(&log_alpha[(n - 1) * K], K);
+
+        // Backward pass, same shifting trick
+        std::fill(&log_beta[(n - 1) * K], &log_beta[n * K], 0.0);
+        for (size_t t = n - 1; t-- > 0;) {
+            const double *next = &log_beta[(t + 1) * K];
+            double m = std::numeric_limits<double>::lowest();
+            for (int j = 0; j < K; ++j) {
+                tmp[j] = log_b[j * n + t + 1] + next[j];
+                m = std::max(m, tmp[j]);
+            }
+            for (int j = 0; j < K; ++j) {
+                tmp[j] = std::exp(tmp[j] - m);
+            }
+            for (int i = 0; i < K; ++i) {
+                double acc = 0.0;
+                for (int j = 0; j < K; ++j) {
+                    acc += trans[i * K + j] * tmp[j];
+                }
+                log_beta[t * K + i] = m + safe_log(acc);
+            }
+        }
+
+        // E-step: expected state occupancy and transition counts
+        std::fill(trans_acc.begin(), trans_acc.end(), 0.0);
+        std::fill(w.begin(), w.end(), 0.0);
+        std::fill(s.begin(), s.end(), 0.0);
+        std::fill(ss.begin(), ss.end(), 0.0);
+        for (size_t t = 0; t < n; ++t) {
+            const double *x = obs + t * D;
+            for (int k = 0; k < K; ++k) {
+                double g = std::exp(log_alpha[t * K + k] + log_beta[t * K + k] - ll);
+                if (t == 0) {
+                    start_acc[k] = g;
+                }
+                for (int d = 0; d < D; ++d) {
+                    if (!is_missing(x[d])) {
+                        w[k * D + d] += g;
+                        s[k * D + d] += g * x[d];
+                        ss[k * D + d] += g * x[d] * x[d];
+                    }
+                }
+            }
+            if (t + 1 < n) {
+                // xi_ij = alpha_i * A_ij * b_j(t+1) * beta_j(t+1) / L, factored
+                // into two max-shifted vectors
+                const double *la = &log_alpha[t * K];
+                const double *lb = &log_beta[(t + 1) * K];
+                double ma = *std::max_element(la, la + K);
+                double mb = std::numeric_limits<double>::lowest();
+                for (int j = 0; j < K; ++j) {
+                    tmp[j] = log_b[j * n + t + 1] + lb[j];
+                    mb = std::max(mb, tmp[j]);
+                }
+                const double scale = std::exp(ma + mb - ll);
+                for (int j = 0; j < K; ++j) {
+                    tmp[j] = std::exp(tmp[j] - mb);
+                }
+                for (int i = 0; i < K; ++i) {
+                    const double a = std::exp(la[i] - ma) * scale;
+                    for (int j = 0; j < K; ++j) {
+                        trans_acc[i * K + j] += a * trans[i * K + j] * tmp[j];
+                    }
+                }
+            }
+        }
+
+        // M-step
+        for (int k = 0; k < K; ++k) {
+            model.log_start[k] = safe_log(start_acc[k]);
+            double row = 0.0;
+            for (int j = 0; j < K; ++j) {
+                row += trans_acc[k * K + j];
+            }
+            if (row > 0.0) {
+                for (int j = 0; j < K; ++j) {
+                    model.log_trans[k * K + j] = safe_log(trans_acc[k * K + j] / row);
+                }
+            }
+            for (int d = 0; d < D; ++d) {
+                const int i = k * D + d;
+                if (w[i] > 1e-12) {
+                    double mean = s[i] / w[i];
+                    model.means[i] = mean;
+                    model.variances[i] = std::max(ss[i] / w[i] - mean * mean, opts.min_variance);
+                }
+            }
+        }
+
+        model.log_likelihood = ll;
+        model.n_iter = iter + 1;
+        if (ll - prev_ll < opts.tol) {
+            model.converged = true;
+            break;
+        }
+        prev_ll = ll;
+    }
+
+    canonical_order(model);
+    return model;
+}
+
+HMMFilter::HMMFilter(const GaussianHMM &model)
+    : n_states_(model.n_states), n_dims_(model.n_dims) {
+    const int K = n_states_;
+    start_.resize(K);
+    trans_.resize(K * K);
+    for (int k = 0; k < K; ++k) {
+        start_[k] = std::exp(model.log_start[k]);
+    }
+    for (int i = 0; i < K * K; ++i) {
+        trans_[i] = std::exp(model.log_trans[i]);
+    }
+    means_ = model.means;
+    inv_var_.resize(model.variances.size());
+    log_norm_.resize(model.variances.size());
+    emission_constants(model.variances, inv_var_.data(), log_norm_.data());
+    probs_.assign(K, 1.0 / K);
+    scratch_.resize(2 * K);
+}
+
+void HMMFilter::reset() {
+    started_ = false;
+    std::fill(probs_.begin(), probs_.end(), 1.0 / n_states_);
+}
+
+const double *HMMFilter::update(const double *x) {
+    const int K = n_states_;
+    const int D = n_dims_;
+    double *pred = scratch_.data();
+    double *log_b = scratch_.data() + K;
+
+    // Predict: pred_j = sum_i p_i * A_ij
+    if (!started_) {
+        std::copy(start_.begin(), start_.end(), pred);
+    } else {
+        std::fill(pred, pred + K, 0.0);
+        for (int i = 0; i < K; ++i) {
+            const double p = probs_[i];
+            const double *a = &trans_[i * K];
+            for (int j = 0; j < K; ++j) {
+                pred[j] += p * a[j];
+            }
+        }
+    }
+    started_ = true;
+
+    // Correct with the emission likelihood (scaled by its max to avoid underflow)
+    double max_lb = std::numeric_limits<double>::lowest();
+    for (int k = 0; k < K; ++k) {
+        double lb = 0.0;
+        for (int d = 0; d < D; ++d) {
+            double diff = x[d] - means_[k * D + d];
+            double term = log_norm_[k * D + d] - 0.5 * diff * diff * inv_var_[k * D + d];
+            lb += is_missing(x[d]) ? 0.0 : term;
+        }
+        log_b[k] = lb;
+        max_lb = std::max(max_lb, lb);
+    }
+    double total = 0.0;
+    for (int k = 0; k < K; ++k) {
+        log_b[k] = pred[k] * std::exp(log_b[k] - max_lb);
+        total += log_b[k];
+    }
+    if (total > 0.0) {
+        for (int k = 0; k < K; ++k) {
+            probs_[k] = log_b[k] / total;
+        }
+    } else {
+        std::copy(pred, pred + K, probs_.begin());
+    }
+    return probs_.data();
+}
+
+void hmm_forward_filter(const GaussianHMM &model, const double *obs, size_t n_rows,
+                        double *probs) {
+    HMMFilter filter(model);
+    const int K = model.n_states;
+    for (size_t t = 0; t < n_rows; ++t) {
+        const double *p = filter.update(obs + t * model.n_dims);
+        std::copy(p, p + K, probs + t * K);
+    }
+}
+
+GaussianHMM hmm_walk_forward(const double *obs, size_t n_rows, int n_dims,
+                             const HMMFitOptions &opts, const HMMWalkForward &schedule,
+                             double *probs) {
+    if (opts.n_states < 1 || n_dims < 1) {
+        throw std::invalid_argument("n_states and n_dims must be positive");
+    }
+    if (schedule.min_train < 1 || schedule.refit_every < 1) {
+        throw std::invalid_argument("min_train and refit_every must be positive");
+    }
+    const int K = opts.n_states;
+    std::fill(probs, probs + n_rows * K, 1.0 / K);
+
+    GaussianHMM model = flat_model(K, n_dims);
+    for (size_t t = schedule.min_train; t < n_rows; t += schedule.refit_every) {
+        const size_t end = std::min(n_rows, t + schedule.refit_every);
+        model = fit_gaussian_hmm(obs, t, n_dims, opts);
+        // Filtering restarts at row 0 under each frozen model; that is O(t)
+        // against the fit's O(max_iter * t), and keeps every row's
+        // probabilities a function of rows 0..t only.
+        HMMFilter filter(model);
+        for (size_t r = 0; r < end; ++r) {
+            const double *p = filter.update(obs + r * n_dims);
+            if (r >= t) {
+                std::copy(p, p + K, probs + r * K);
+            }
+        }
+    }
+    return model;
+}
+
+std::vector<GaussianHMM> fit_gaussian_hmm_batch(const double *obs, const RaggedBatch &batch,
+                                                int n_dims, const HMMFitOptions &opts,
+                                                const HMMWalkForward &schedule,
+                                                double *probs) {
+    std::vector<GaussianHMM> models(batch.n_series);
+    parallel_for(batch.n_series, [&](size_t i) {
+        const size_t begin = batch.begin(i);
+        const double *x = obs + begin * n_dims;
+        models[i] = hmm_walk_forward(x, batch.length(i), n_dims, opts, schedule,
+                                     probs + begin * opts.n_states);
+    });
+    return models;
+}
+
+}  // namespace alphasignal
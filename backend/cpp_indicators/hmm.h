@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "batch.h"
+
+namespace alphasignal {
+
+// Gaussian hidden Markov model with diagonal covariances.
+// Observations are row-major (n_rows x n_dims); NaN entries are treated as
+// missing and contribute no evidence. After fitting, states are ordered by
+// ascending variance of dimension 0, so state 0 is the calmest regime and
+// labels line up across tickers.
+struct GaussianHMM {
+    int n_states = 0;
+    int n_dims = 0;
+    std::vector<double> log_start;  // n_states
+    std::vector<double> log_trans;  // n_states x n_states, row = from-state
+    std::vector<double> means;      // n_states x n_dims
+    std::vector<double> variances;  // n_states x n_dims
+    double log_likelihood = 0.0;
+    int n_iter = 0;
+    bool converged = false;
+};
+
+struct HMMFitOptions {
+    int n_states = 4;
+    int max_iter = 50;
+    double tol = 1e-2;          // stop when the log-likelihood gain drops below this
+    double min_variance = 1e-10; // variance floor per state and dimension
+};
+
+// Baum-Welch (EM) in log space. Initial parameters come from quantiles of
+// dimension 0, so the fit is deterministic.
+GaussianHMM fit_gaussian_hmm(const double *obs, size_t n_rows, int n_dims,
+                             const HMMFitOptions &opts = HMMFitOptions());
+
+// Log emission densities in state-major layout: out[k * n_rows + t]
+void hmm_log_emissions(const GaussianHMM &model, const double *obs, size_t n_rows,
+                       double *out);
+
+// Causal per-bar regime probabilities P(state_t | obs_0..t), row-major
+// (n_rows x n_states). Uses the same recursion as HMMFilter.
+void hmm_forward_filter(const GaussianHMM &model, const double *obs, size_t n_rows,
+                        double *probs);
+
+// Streaming forward filter: O(n_states^2) per update, no allocation after
+// construction.
+class HMMFilter {
+public:
+    explicit HMMFilter(const GaussianHMM &model);
+
+    // Advance one bar; returns the filtered state probabilities
+    const double *update(const double *x);
+    const double *probabilities() const { return probs_.data(); }
+    void reset();
+
+    int n_states() const { return n_states_; }
+    int n_dims() const { return n_dims_; }
+
+private:
+    int n_states_;
+    int n_dims_;
+    bool started_ = false;
+    std::vector<double> start_;     // linear-space start probabilities
+    std::vector<double> trans_;     // linear-space transition matrix
+    std::vector<double> means_;
+    std::vector<double> inv_var_;
+    std::vector<double> log_norm_;  // per state and dimension
+    std::vector<double> probs_;
+    std::vector<double> scratch_;
+};
+
+// Walk-forward schedule: the model applied from row t on is fit on rows
+// [0, t) only, so probabilities never depend on later bars.
+struct HMMWalkForward {
+    size_t min_train = 120;   // rows before the first fit; earlier rows get flat probabilities
+    size_t refit_every = 21;  // rows between refits on the expanding window
+};
+
+// Out-of-sample regime probabilities (n_rows x n_states). Every refit_every
+// rows the model is refit on all earlier rows and frozen for the next block;
+// that block is forward-filtered with it. Returns the last model fitted
+// (flat if n_rows <= min_train).
+GaussianHMM hmm_walk_forward(const double *obs, size_t n_rows, int n_dims,
+                             const HMMFitOptions &opts, const HMMWalkForward &schedule,
+                             double *probs);
+
+// hmm_walk_forward for every ticker on the shared thread pool, writing
+// probs (total_rows x n_states). Series with fewer than 2 * n_states
+// observed training rows get a flat model.
+std::vector<GaussianHMM> fit_gaussian_hmm_batch(const double *obs, const RaggedBatch &batch,
+                                                int n_dims, const HMMFitOptions &opts,
+                                                const HMMWalkForward &schedule,
+                                                double *probs);
+
+}  // namespace alphasignal
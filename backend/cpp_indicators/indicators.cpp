@@ -1,201 +1,2289 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/numpy.h>
+#include <pybind11/stl.h>
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include "bars.h"
+#include "batch.h"
+#include "calendar.h"
+#include "candles.h"
+#include "changepoint.h"
+#include "corporate_actions.h"
+#include "dtw.h"
+#include "fund_metrics.h"
+#include "hmm.h"
+#include "kernel_cache.h"
+#include "leadlag.h"
+#include "matrix_profile.h"
+#include "outcome_resolver.h"
+#include "pairs.h"
+#include "pme.h"
+#include "prediction_log.h"
+#include "resample.h"
+#include "returns.h"
+#include "score_batcher.h"
+#include "technical.h"
+#include "tick_engine.h"
+#include "universe_state.h"
+#include "wavelet.h"
 
 namespace py = pybind11;
+namespace as = alphasignal;
 
-// RSI Calculator (Vectorized)
-py::array_t<double> calculate_rsi(py::array_t<double> prices, int period = 14) {
-    auto buf = prices.request();
-    double *ptr = static_cast<double *>(buf.ptr);
-    size_t n = buf.shape[0];
-
-    std::vector<double> rsi(n, 0.0);
-    std::vector<double> gains(n, 0.0);
-    std::vector<double> losses(n, 0.0);
-
-    // Calculate price changes
-    for (size_t i = 1; i < n; ++i) {
-        double change = ptr[i] - ptr[i-1];
-        if (change > 0) {
-            gains[i] = change;
-        } else {
-            losses[i] = -change;
-        }
-    }
+using DoubleArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+using OffsetArray = py::array_t<int64_t, py::array::c_style | py::array::forcecast>;
 
-    // Initial average (Simple Moving Average)
-    double avg_gain = 0.0, avg_loss = 0.0;
-    for (int i = 1; i <= period; ++i) {
-        avg_gain += gains[i];
-        avg_loss += losses[i];
-    }
-    avg_gain /= period;
-    avg_loss /= period;
+// ===== Helpers for the batched native kernels =====
+
+// Row-major view of a 1-D (n,) or 2-D (n, d) float64 array
+struct MatrixView {
+    const double *data;
+    size_t rows;
+    int cols;
+};
 
-    // Calculate RSI using Wilder's smoothing
-    for (size_t i = period; i < n; ++i) {
-        avg_gain = ((avg_gain * (period - 1)) + gains[i]) / period;
-        avg_loss = ((avg_loss * (period - 1)) + losses[i]) / period;
+static MatrixView as_matrix(const DoubleArray &a) {
+    auto buf = a.request();
+    if (buf.ndim == 1) {
+        return {static_cast<const double *>(buf.ptr), static_cast<size_t>(buf.shape[0]), 1};
+    }
+    if (buf.ndim == 2) {
+        return {static_cast<const double *>(buf.ptr), static_cast<size_t>(buf.shape[0]),
+                static_cast<int>(buf.shape[1])};
+    }
+    throw std::invalid_argument("expected a 1-D or 2-D float array");
+}
 
-        if (avg_loss == 0.0) {
-            rsi[i] = 100.0;
-        } else {
-            double rs = avg_gain / avg_loss;
-            rsi[i] = 100.0 - (100.0 / (1.0 + rs));
+// Validate ticker offsets (n_series + 1 entries, non-decreasing, ending at total_rows)
+static as::RaggedBatch as_batch(const OffsetArray &offsets, size_t total_rows) {
+    auto buf = offsets.request();
+    if (buf.ndim != 1 || buf.shape[0] < 1) {
+        throw std::invalid_argument("offsets must be a 1-D array with n_series + 1 entries");
+    }
+    const int64_t *off = static_cast<const int64_t *>(buf.ptr);
+    size_t n_series = static_cast<size_t>(buf.shape[0]) - 1;
+    if (off[0] != 0 || static_cast<size_t>(off[n_series]) != total_rows) {
+        throw std::invalid_argument("offsets must start at 0 and end at the number of rows");
+    }
+    for (size_t i = 0; i < n_series; ++i) {
+        if (off[i + 1] < off[i]) {
+            throw std::invalid_argument("offsets must be non-decreasing");
         }
     }
+    return {off, n_series};
+}
+
+static const double *as_vector(const DoubleArray &a, size_t &n) {
+    auto buf = a.request();
+    if (buf.ndim > 1) {
+        throw std::invalid_argument("expected a 1-D float array");
+    }
+    n = static_cast<size_t>(buf.size);
+    return static_cast<const double *>(buf.ptr);
+}
 
-    return py::array_t<double>(n, rsi.data());
+static py::array_t<double> to_numpy_2d(const double *data, size_t rows, size_t cols) {
+    return py::array_t<double>(
+        std::vector<py::ssize_t>{static_cast<py::ssize_t>(rows), static_cast<py::ssize_t>(cols)},
+        data);
 }
 
-// MACD Calculator
+// ===== Classic indicators =====
+
+// Python-facing results; the kernels themselves write plain arrays (technical.h)
 struct MACDResult {
     py::array_t<double> macd;
     py::array_t<double> signal;
     py::array_t<double> histogram;
 };
 
-MACDResult calculate_macd(
-    py::array_t<double> prices,
-    int fast_period = 12,
-    int slow_period = 26,
-    int signal_period = 9
-) {
-    auto buf = prices.request();
-    double *ptr = static_cast<double *>(buf.ptr);
-    size_t n = buf.shape[0];
+struct BollingerBands {
+    py::array_t<double> upper;
+    py::array_t<double> middle;
+    py::array_t<double> lower;
+};
+
+// Process-wide memo cache, off until enable_kernel_cache (see bind_kernel_cache).
+// Only touched with the GIL held.
+static std::unique_ptr<as::KernelCache> kernel_cache;
 
-    std::vector<double> ema_fast(n, 0.0);
-    std::vector<double> ema_slow(n, 0.0);
-    std::vector<double> macd(n, 0.0);
-    std::vector<double> signal(n, 0.0);
-    std::vector<double> histogram(n, 0.0);
+static py::array_t<double> calculate_rsi(const DoubleArray &prices, int period) {
+    size_t n;
+    const double *p = as_vector(prices, n);
+    py::array_t<double> out(n);
+    if (kernel_cache) {
+        kernel_cache->rsi(p, n, period, out.mutable_data());
+    } else {
+        as::rsi(p, n, period, out.mutable_data());
+    }
+    return out;
+}
+
+static MACDResult calculate_macd(const DoubleArray &prices, int fast_period, int slow_period,
+                                 int signal_period) {
+    size_t n;
+    const double *p = as_vector(prices, n);
+    MACDResult r{py::array_t<double>(n), py::array_t<double>(n), py::array_t<double>(n)};
+    if (kernel_cache) {
+        kernel_cache->macd(p, n, fast_period, slow_period, signal_period, r.macd.mutable_data(),
+                           r.signal.mutable_data(), r.histogram.mutable_data());
+    } else {
+        as::macd(p, n, fast_period, slow_period, signal_period, r.macd.mutable_data(),
+                 r.signal.mutable_data(), r.histogram.mutable_data());
+    }
+    return r;
+}
+
+static BollingerBands calculate_bollinger_bands(const DoubleArray &prices, int period,
+                                                double num_std) {
+    size_t n;
+    const double *p = as_vector(prices, n);
+    BollingerBands r{py::array_t<double>(n), py::array_t<double>(n), py::array_t<double>(n)};
+    if (kernel_cache) {
+        kernel_cache->bollinger_bands(p, n, period, num_std, r.upper.mutable_data(),
+                                      r.middle.mutable_data(), r.lower.mutable_data());
+    } else {
+        as::bollinger_bands(p, n, period, num_std, r.upper.mutable_data(),
+                            r.middle.mutable_data(), r.lower.mutable_data());
+    }
+    return r;
+}
+
+static py::array_t<double> rolling_correlation(const DoubleArray &x, const DoubleArray &y,
+                                               int window) {
+    size_t n, ny;
+    const double *px = as_vector(x, n);
+    const double *py_ = as_vector(y, ny);
+    if (ny < n) {
+        throw std::invalid_argument("y must be at least as long as x");
+    }
+    py::array_t<double> out(n);
+    as::rolling_correlation(px, py_, n, window, out.mutable_data());
+    return out;
+}
+
+// ===== Regime detection (Gaussian HMM) =====
 
-    // Calculate EMA multipliers
-    double alpha_fast = 2.0 / (fast_period + 1);
-    double alpha_slow = 2.0 / (slow_period + 1);
-    double alpha_signal = 2.0 / (signal_period + 1);
+static as::GaussianHMM fit_hmm(const DoubleArray &obs, int n_states, int max_iter, double tol) {
+    MatrixView x = as_matrix(obs);
+    as::HMMFitOptions opts;
+    opts.n_states = n_states;
+    opts.max_iter = max_iter;
+    opts.tol = tol;
+    py::gil_scoped_release release;
+    return as::fit_gaussian_hmm(x.data, x.rows, x.cols, opts);
+}
+
+static py::array_t<double> hmm_filter(const as::GaussianHMM &model, const DoubleArray &obs) {
+    MatrixView x = as_matrix(obs);
+    if (x.cols != model.n_dims) {
+        throw std::invalid_argument("observation width does not match the model");
+    }
+    std::vector<double> probs(x.rows * model.n_states);
+    {
+        py::gil_scoped_release release;
+        as::hmm_forward_filter(model, x.data, x.rows, probs.data());
+    }
+    return to_numpy_2d(probs.data(), x.rows, model.n_states);
+}
 
-    // Initialize EMAs
-    ema_fast[0] = ptr[0];
-    ema_slow[0] = ptr[0];
+static as::HMMWalkForward walk_forward(size_t min_train, size_t refit_every) {
+    as::HMMWalkForward schedule;
+    schedule.min_train = min_train;
+    schedule.refit_every = refit_every;
+    return schedule;
+}
 
-    // Calculate EMAs
-    for (size_t i = 1; i < n; ++i) {
-        ema_fast[i] = alpha_fast * ptr[i] + (1 - alpha_fast) * ema_fast[i-1];
-        ema_slow[i] = alpha_slow * ptr[i] + (1 - alpha_slow) * ema_slow[i-1];
-        macd[i] = ema_fast[i] - ema_slow[i];
+static py::array_t<double> hmm_walk_forward(const DoubleArray &obs, int n_states,
+                                            size_t min_train, size_t refit_every,
+                                            int max_iter, double tol) {
+    if (n_states < 1) {
+        throw std::invalid_argument("n_states must be positive");
     }
+    MatrixView x = as_matrix(obs);
+    as::HMMFitOptions opts;
+    opts.n_states = n_states;
+    opts.max_iter = max_iter;
+    opts.tol = tol;
+    std::vector<double> probs(x.rows * n_states);
+    {
+        py::gil_scoped_release release;
+        as::hmm_walk_forward(x.data, x.rows, x.cols, opts, walk_forward(min_train, refit_every),
+                             probs.data());
+    }
+    return to_numpy_2d(probs.data(), x.rows, n_states);
+}
 
-    // Calculate signal line (EMA of MACD)
-    signal[slow_period] = macd[slow_period];
-    for (size_t i = slow_period + 1; i < n; ++i) {
-        signal[i] = alpha_signal * macd[i] + (1 - alpha_signal) * signal[i-1];
-        histogram[i] = macd[i] - signal[i];
+static py::tuple fit_hmm_batch(const DoubleArray &obs, const OffsetArray &offsets,
+                               int n_states, size_t min_train, size_t refit_every,
+                               int max_iter, double tol) {
+    if (n_states < 1) {
+        throw std::invalid_argument("n_states must be positive");
+    }
+    MatrixView x = as_matrix(obs);
+    as::RaggedBatch batch = as_batch(offsets, x.rows);
+    as::HMMFitOptions opts;
+    opts.n_states = n_states;
+    opts.max_iter = max_iter;
+    opts.tol = tol;
+    std::vector<double> probs(x.rows * n_states);
+    std::vector<as::GaussianHMM> models;
+    {
+        py::gil_scoped_release release;
+        models = as::fit_gaussian_hmm_batch(x.data, batch, x.cols, opts,
+                                            walk_forward(min_train, refit_every), probs.data());
     }
+    return py::make_tuple(models, to_numpy_2d(probs.data(), x.rows, n_states));
+}
+
+static void bind_regime(py::module_ &m) {
+    py::class_<as::GaussianHMM>(m, "GaussianHMM")
+        .def_readonly("n_states", &as::GaussianHMM::n_states)
+        .def_readonly("n_dims", &as::GaussianHMM::n_dims)
+        .def_readonly("log_likelihood", &as::GaussianHMM::log_likelihood)
+        .def_readonly("n_iter", &as::GaussianHMM::n_iter)
+        .def_readonly("converged", &as::GaussianHMM::converged)
+        .def_property_readonly("start_prob", [](const as::GaussianHMM &h) {
+            std::vector<double> p(h.log_start.size());
+            std::transform(h.log_start.begin(), h.log_start.end(), p.begin(),
+                           [](double v) { return std::exp(v); });
+            return py::array_t<double>(p.size(), p.data());
+        })
+        .def_property_readonly("transmat", [](const as::GaussianHMM &h) {
+            std::vector<double> p(h.log_trans.size());
+            std::transform(h.log_trans.begin(), h.log_trans.end(), p.begin(),
+                           [](double v) { return std::exp(v); });
+            return to_numpy_2d(p.data(), h.n_states, h.n_states);
+        })
+        .def_property_readonly("means", [](const as::GaussianHMM &h) {
+            return to_numpy_2d(h.means.data(), h.n_states, h.n_dims);
+        })
+        .def_property_readonly("variances", [](const as::GaussianHMM &h) {
+            return to_numpy_2d(h.variances.data(), h.n_states, h.n_dims);
+        })
+        .def("filter", &hmm_filter,
+             "Causal per-bar state probabilities, shape (n, n_states)",
+             py::arg("obs"));
+
+    py::class_<as::HMMFilter>(m, "HMMFilter")
+        .def(py::init<const as::GaussianHMM &>(), py::arg("model"))
+        .def("update", [](as::HMMFilter &f, const DoubleArray &x) {
+            auto buf = x.request();
+            if (buf.size != f.n_dims()) {
+                throw std::invalid_argument("observation width does not match the model");
+            }
+            const double *p = f.update(static_cast<const double *>(buf.ptr));
+            return py::array_t<double>(f.n_states(), p);
+        }, "Advance one bar and return the filtered state probabilities", py::arg("x"))
+        .def("reset", &as::HMMFilter::reset)
+        .def_property_readonly("probabilities", [](const as::HMMFilter &f) {
+            return py::array_t<double>(f.n_states(), f.probabilities());
+        });
 
-    MACDResult result;
-    result.macd = py::array_t<double>(n, macd.data());
-    result.signal = py::array_t<double>(n, signal.data());
-    result.histogram = py::array_t<double>(n, histogram.data());
+    m.def("fit_hmm", &fit_hmm,
+          "Fit a Gaussian HMM (diagonal covariance) with log-space Baum-Welch",
+          py::arg("obs"),
+          py::arg("n_states") = 4,
+          py::arg("max_iter") = 50,
+          py::arg("tol") = 1e-2);
 
+    m.def("hmm_walk_forward", &hmm_walk_forward,
+          "Out-of-sample regime probabilities: refit every refit_every rows on the rows "
+          "before, filter the next block with the frozen model; shape (n, n_states)",
+          py::arg("obs"),
+          py::arg("n_states") = 4,
+          py::arg("min_train") = 120,
+          py::arg("refit_every") = 21,
+          py::arg("max_iter") = 50,
+          py::arg("tol") = 1e-2);
+
+    m.def("fit_hmm_batch", &fit_hmm_batch,
+          "hmm_walk_forward per ticker in parallel; returns (last models, probabilities)",
+          py::arg("obs"),
+          py::arg("offsets"),
+          py::arg("n_states") = 4,
+          py::arg("min_train") = 120,
+          py::arg("refit_every") = 21,
+          py::arg("max_iter") = 50,
+          py::arg("tol") = 1e-2);
+}
+
+// ===== Change-point detection =====
+
+struct BOCPDResult {
+    py::array_t<double> change_prob;
+    py::array_t<double> map_run_length;
+    py::array_t<double> expected_run_length;
+};
+
+static as::BOCPDOptions bocpd_options(double expected_run_length, double mu0, double kappa0,
+                                      double alpha0, double beta0, double prune_threshold,
+                                      size_t max_hypotheses, int alert_window) {
+    as::BOCPDOptions opts;
+    opts.expected_run_length = expected_run_length;
+    opts.mu0 = mu0;
+    opts.kappa0 = kappa0;
+    opts.alpha0 = alpha0;
+    opts.beta0 = beta0;
+    opts.prune_threshold = prune_threshold;
+    opts.max_hypotheses = max_hypotheses;
+    opts.alert_window = alert_window;
+    as::BOCPD validate(opts);  // throws on bad parameters before any work starts
+    return opts;
+}
+
+static as::PeltOptions pelt_options(const std::string &cost, double penalty, int min_size) {
+    as::PeltOptions opts;
+    if (cost == "mean") {
+        opts.cost = as::PeltCost::Mean;
+    } else if (cost == "meanvar") {
+        opts.cost = as::PeltCost::MeanVar;
+    } else {
+        throw std::invalid_argument("cost must be 'mean' or 'meanvar'");
+    }
+    opts.penalty = penalty;
+    opts.min_size = min_size;
+    return opts;
+}
+
+// threshold may be a scalar or one value per bar
+static const double *cusum_threshold(const DoubleArray &threshold, size_t n, bool &per_bar) {
+    size_t m;
+    const double *h = as_vector(threshold, m);
+    if (m == 1) {
+        per_bar = false;
+    } else if (m == n) {
+        per_bar = true;
+    } else {
+        throw std::invalid_argument("threshold must be a scalar or have one value per bar");
+    }
+    return h;
+}
+
+static py::array_t<int8_t> cusum_filter(const DoubleArray &x, const DoubleArray &threshold,
+                                        double drift) {
+    size_t n;
+    const double *px = as_vector(x, n);
+    bool per_bar;
+    const double *h = cusum_threshold(threshold, n, per_bar);
+    py::array_t<int8_t> events(n);
+    int8_t *out = events.mutable_data();
+    {
+        py::gil_scoped_release release;
+        as::cusum_filter(px, n, h, per_bar, drift, out);
+    }
+    return events;
+}
+
+static py::array_t<int8_t> cusum_filter_batch(const DoubleArray &x, const OffsetArray &offsets,
+                                              const DoubleArray &threshold, double drift) {
+    size_t n;
+    const double *px = as_vector(x, n);
+    as::RaggedBatch batch = as_batch(offsets, n);
+    bool per_bar;
+    const double *h = cusum_threshold(threshold, n, per_bar);
+    py::array_t<int8_t> events(n);
+    int8_t *out = events.mutable_data();
+    {
+        py::gil_scoped_release release;
+        as::cusum_filter_batch(px, batch, h, per_bar, drift, out);
+    }
+    return events;
+}
+
+static BOCPDResult bocpd_result(size_t n, const std::function<void(double *, double *, double *)> &run) {
+    std::vector<double> cp(n), map_rl(n), exp_rl(n);
+    {
+        py::gil_scoped_release release;
+        run(cp.data(), map_rl.data(), exp_rl.data());
+    }
+    BOCPDResult result;
+    result.change_prob = py::array_t<double>(n, cp.data());
+    result.map_run_length = py::array_t<double>(n, map_rl.data());
+    result.expected_run_length = py::array_t<double>(n, exp_rl.data());
     return result;
 }
 
-// Bollinger Bands
-struct BollingerBands {
-    py::array_t<double> upper;
-    py::array_t<double> middle;
-    py::array_t<double> lower;
+static BOCPDResult bocpd(const DoubleArray &x, double expected_run_length, double mu0,
+                         double kappa0, double alpha0, double beta0, double prune_threshold,
+                         size_t max_hypotheses, int alert_window) {
+    size_t n;
+    const double *px = as_vector(x, n);
+    as::BOCPDOptions opts = bocpd_options(expected_run_length, mu0, kappa0, alpha0, beta0,
+                                          prune_threshold, max_hypotheses, alert_window);
+    return bocpd_result(n, [&](double *cp, double *map_rl, double *exp_rl) {
+        as::bocpd(px, n, opts, cp, map_rl, exp_rl);
+    });
+}
+
+static BOCPDResult bocpd_batch(const DoubleArray &x, const OffsetArray &offsets,
+                               double expected_run_length, double mu0, double kappa0,
+                               double alpha0, double beta0, double prune_threshold,
+                               size_t max_hypotheses, int alert_window) {
+    size_t n;
+    const double *px = as_vector(x, n);
+    as::RaggedBatch batch = as_batch(offsets, n);
+    as::BOCPDOptions opts = bocpd_options(expected_run_length, mu0, kappa0, alpha0, beta0,
+                                          prune_threshold, max_hypotheses, alert_window);
+    return bocpd_result(n, [&](double *cp, double *map_rl, double *exp_rl) {
+        as::bocpd_batch(px, batch, opts, cp, map_rl, exp_rl);
+    });
+}
+
+static py::array_t<int64_t> pelt(const DoubleArray &x, const std::string &cost, double penalty,
+                                 int min_size) {
+    size_t n;
+    const double *px = as_vector(x, n);
+    as::PeltOptions opts = pelt_options(cost, penalty, min_size);
+    std::vector<int64_t> cps;
+    {
+        py::gil_scoped_release release;
+        cps = as::pelt(px, n, opts);
+    }
+    return py::array_t<int64_t>(cps.size(), cps.data());
+}
+
+static py::tuple pelt_batch(const DoubleArray &x, const OffsetArray &offsets,
+                            const std::string &cost, double penalty, int min_size) {
+    size_t n;
+    const double *px = as_vector(x, n);
+    as::RaggedBatch batch = as_batch(offsets, n);
+    as::PeltOptions opts = pelt_options(cost, penalty, min_size);
+    std::vector<int64_t> cps, cp_offsets;
+    {
+        py::gil_scoped_release release;
+        as::pelt_batch(px, batch, opts, cps, cp_offsets);
+    }
+    return py::make_tuple(py::array_t<int64_t>(cps.size(), cps.data()),
+                          py::array_t<int64_t>(cp_offsets.size(), cp_offsets.data()));
+}
+
+static void bind_changepoint(py::module_ &m) {
+    py::class_<as::CusumFilter>(m, "CusumFilter")
+        .def(py::init<double>(), py::arg("drift") = 0.0)
+        .def("update", &as::CusumFilter::update,
+             "Feed one increment; returns +1/-1 on an upward/downward event, else 0",
+             py::arg("x"), py::arg("threshold"))
+        .def("reset", &as::CusumFilter::reset)
+        .def_property_readonly("pos", &as::CusumFilter::pos)
+        .def_property_readonly("neg", &as::CusumFilter::neg);
+
+    py::class_<as::BOCPDOutput>(m, "BOCPDOutput")
+        .def_readonly("change_prob", &as::BOCPDOutput::change_prob)
+        .def_readonly("map_run_length", &as::BOCPDOutput::map_run_length)
+        .def_readonly("expected_run_length", &as::BOCPDOutput::expected_run_length);
+
+    py::class_<as::BOCPD>(m, "BOCPD")
+        .def(py::init([](double expected_run_length, double mu0, double kappa0, double alpha0,
+                         double beta0, double prune_threshold, size_t max_hypotheses,
+                         int alert_window) {
+                 return as::BOCPD(bocpd_options(expected_run_length, mu0, kappa0, alpha0, beta0,
+                                                prune_threshold, max_hypotheses, alert_window));
+             }),
+             py::arg("expected_run_length") = 250.0,
+             py::arg("mu0") = 0.0,
+             py::arg("kappa0") = 1.0,
+             py::arg("alpha0") = 1.0,
+             py::arg("beta0") = 1e-4,
+             py::arg("prune_threshold") = 1e-5,
+             py::arg("max_hypotheses") = 256,
+             py::arg("alert_window") = 5)
+        .def("update", &as::BOCPD::update, py::arg("x"))
+        .def("reset", &as::BOCPD::reset)
+        .def_property_readonly("n_hypotheses", &as::BOCPD::n_hypotheses);
+
+    py::class_<BOCPDResult>(m, "BOCPDResult")
+        .def_readonly("change_prob", &BOCPDResult::change_prob)
+        .def_readonly("map_run_length", &BOCPDResult::map_run_length)
+        .def_readonly("expected_run_length", &BOCPDResult::expected_run_length);
+
+    m.def("cusum_filter", &cusum_filter,
+          "Symmetric CUSUM events (+1/-1/0 per bar) on an increment series",
+          py::arg("x"), py::arg("threshold"), py::arg("drift") = 0.0);
+
+    m.def("cusum_filter_batch", &cusum_filter_batch,
+          "CUSUM events for many tickers laid out by offsets",
+          py::arg("x"), py::arg("offsets"), py::arg("threshold"), py::arg("drift") = 0.0);
+
+    m.def("bocpd", &bocpd,
+          "Bayesian online change-point detection (Gaussian, unknown mean and variance)",
+          py::arg("x"),
+          py::arg("expected_run_length") = 250.0,
+          py::arg("mu0") = 0.0,
+          py::arg("kappa0") = 1.0,
+          py::arg("alpha0") = 1.0,
+          py::arg("beta0") = 1e-4,
+          py::arg("prune_threshold") = 1e-5,
+          py::arg("max_hypotheses") = 256,
+          py::arg("alert_window") = 5);
+
+    m.def("bocpd_batch", &bocpd_batch,
+          "BOCPD for many tickers laid out by offsets",
+          py::arg("x"),
+          py::arg("offsets"),
+          py::arg("expected_run_length") = 250.0,
+          py::arg("mu0") = 0.0,
+          py::arg("kappa0") = 1.0,
+          py::arg("alpha0") = 1.0,
+          py::arg("beta0") = 1e-4,
+          py::arg("prune_threshold") = 1e-5,
+          py::arg("max_hypotheses") = 256,
+          py::arg("alert_window") = 5);
+
+    m.def("pelt", &pelt,
+          "PELT segmentation; returns the start index of each new segment",
+          py::arg("x"),
+          py::arg("cost") = "meanvar",
+          py::arg("penalty") = 0.0,
+          py::arg("min_size") = 5);
+
+    m.def("pelt_batch", &pelt_batch,
+          "PELT for many tickers; returns (change points, per-ticker offsets)",
+          py::arg("x"),
+          py::arg("offsets"),
+          py::arg("cost") = "meanvar",
+          py::arg("penalty") = 0.0,
+          py::arg("min_size") = 5);
+}
+
+// ===== Matrix profile / analogue search =====
+
+static as::MatrixProfileOptions mp_options(int window, double exclusion, double fraction,
+                                           uint64_t seed) {
+    as::MatrixProfileOptions opts;
+    opts.window = window;
+    opts.exclusion = exclusion;
+    opts.fraction = fraction;
+    opts.seed = seed;
+    return opts;
+}
+
+static as::MatrixProfile matrix_profile(const DoubleArray &t, int window, double exclusion,
+                                        double fraction, uint64_t seed) {
+    size_t n;
+    const double *pt = as_vector(t, n);
+    as::MatrixProfileOptions opts = mp_options(window, exclusion, fraction, seed);
+    py::gil_scoped_release release;
+    return as::matrix_profile(pt, n, opts);
+}
+
+static as::JoinProfile matrix_profile_ab(const DoubleArray &a, const DoubleArray &b, int window,
+                                         double fraction, uint64_t seed) {
+    size_t na, nb;
+    const double *pa = as_vector(a, na);
+    const double *pb = as_vector(b, nb);
+    as::MatrixProfileOptions opts = mp_options(window, 0.0, fraction, seed);
+    py::gil_scoped_release release;
+    return as::matrix_profile_ab(pa, na, pb, nb, opts);
+}
+
+static std::vector<as::Neighbor> find_analogues(const DoubleArray &t, int window, size_t k,
+                                                int64_t query_start, double exclusion) {
+    size_t n;
+    const double *pt = as_vector(t, n);
+    if (window < 1 || static_cast<size_t>(window) > n) {
+        throw std::invalid_argument("window must be between 1 and the series length");
+    }
+    size_t start = query_start < 0 ? n - window : static_cast<size_t>(query_start);
+    py::gil_scoped_release release;
+    return as::find_analogues(pt, n, window, start, k, exclusion);
+}
+
+static void bind_matrix_profile(py::module_ &m) {
+    py::class_<as::MatrixProfile>(m, "MatrixProfile")
+        .def_readonly("window", &as::MatrixProfile::window)
+        .def_readonly("exclusion", &as::MatrixProfile::exclusion)
+        .def_property_readonly("distance", [](const as::MatrixProfile &p) {
+            return py::array_t<double>(p.distance.size(), p.distance.data());
+        })
+        .def_property_readonly("index", [](const as::MatrixProfile &p) {
+            return py::array_t<int64_t>(p.index.size(), p.index.data());
+        })
+        .def_property_readonly("left_distance", [](const as::MatrixProfile &p) {
+            return py::array_t<double>(p.left_distance.size(), p.left_distance.data());
+        })
+        .def_property_readonly("left_index", [](const as::MatrixProfile &p) {
+            return py::array_t<int64_t>(p.left_index.size(), p.left_index.data());
+        });
+
+    py::class_<as::JoinProfile>(m, "JoinProfile")
+        .def_readonly("window", &as::JoinProfile::window)
+        .def_property_readonly("distance_a", [](const as::JoinProfile &p) {
+            return py::array_t<double>(p.distance_a.size(), p.distance_a.data());
+        })
+        .def_property_readonly("index_a", [](const as::JoinProfile &p) {
+            return py::array_t<int64_t>(p.index_a.size(), p.index_a.data());
+        })
+        .def_property_readonly("distance_b", [](const as::JoinProfile &p) {
+            return py::array_t<double>(p.distance_b.size(), p.distance_b.data());
+        })
+        .def_property_readonly("index_b", [](const as::JoinProfile &p) {
+            return py::array_t<int64_t>(p.index_b.size(), p.index_b.data());
+        });
+
+    py::class_<as::Motif>(m, "Motif")
+        .def_readonly("first", &as::Motif::first)
+        .def_readonly("second", &as::Motif::second)
+        .def_readonly("distance", &as::Motif::distance);
+
+    py::class_<as::Neighbor>(m, "Neighbor")
+        .def_readonly("index", &as::Neighbor::index)
+        .def_readonly("distance", &as::Neighbor::distance);
+
+    m.def("matrix_profile", &matrix_profile,
+          "Self-join matrix profile (z-normalized Euclidean), multithreaded across diagonals",
+          py::arg("t"),
+          py::arg("window"),
+          py::arg("exclusion") = 0.25,
+          py::arg("fraction") = 1.0,
+          py::arg("seed") = 0);
+
+    m.def("matrix_profile_ab", &matrix_profile_ab,
+          "AB-join matrix profile between two series",
+          py::arg("a"),
+          py::arg("b"),
+          py::arg("window"),
+          py::arg("fraction") = 1.0,
+          py::arg("seed") = 0);
+
+    m.def("find_motifs", &as::find_motifs,
+          "Top-k motif pairs from a matrix profile",
+          py::arg("profile"), py::arg("k") = 3);
+
+    m.def("find_discords", &as::find_discords,
+          "Top-k discords from a matrix profile",
+          py::arg("profile"), py::arg("k") = 3);
+
+    m.def("find_analogues", &find_analogues,
+          "k past windows most similar to the query window (default: the latest one)",
+          py::arg("t"),
+          py::arg("window"),
+          py::arg("k") = 5,
+          py::arg("query_start") = -1,
+          py::arg("exclusion") = 0.25);
+}
+
+// ===== DTW subsequence search =====
+
+static py::tuple dtw_search(const DoubleArray &values, const OffsetArray &offsets,
+                            const DoubleArray &query, size_t k, double band,
+                            int64_t exclude_series, int64_t exclude_start) {
+    size_t n, m;
+    const double *pv = as_vector(values, n);
+    const double *pq = as_vector(query, m);
+    as::RaggedBatch batch = as_batch(offsets, n);
+    as::DTWSearchOptions opts;
+    opts.k = k;
+    opts.band = band;
+    opts.exclude_series = exclude_series;
+    opts.exclude_start = exclude_start;
+
+    std::vector<as::DTWMatch> matches;
+    {
+        py::gil_scoped_release release;
+        matches = as::dtw_search(pv, batch, pq, m, opts);
+    }
+    std::vector<int64_t> series, start;
+    std::vector<double> distance;
+    for (const as::DTWMatch &match : matches) {
+        series.push_back(match.series);
+        start.push_back(match.start);
+        distance.push_back(match.distance);
+    }
+    return py::make_tuple(py::array_t<int64_t>(series.size(), series.data()),
+                          py::array_t<int64_t>(start.size(), start.data()),
+                          py::array_t<double>(distance.size(), distance.data()));
+}
+
+static double dtw_distance(const DoubleArray &a, const DoubleArray &b, double band) {
+    size_t na, nb;
+    const double *pa = as_vector(a, na);
+    const double *pb = as_vector(b, nb);
+    if (na != nb) {
+        throw std::invalid_argument("sequences must have the same length");
+    }
+    if (!(band >= 0.0 && band <= 1.0)) {
+        throw std::invalid_argument("band must be in [0, 1]");
+    }
+    return as::dtw_distance(pa, pb, na, static_cast<size_t>(band * na));
+}
+
+static void bind_dtw(py::module_ &m) {
+    m.def("dtw_search", &dtw_search,
+          "Top-k z-normalized DTW matches of query across a ragged batch of series; "
+          "returns (series, start, distance) arrays sorted by distance",
+          py::arg("values"),
+          py::arg("offsets"),
+          py::arg("query"),
+          py::arg("k") = 10,
+          py::arg("band") = 0.1,
+          py::arg("exclude_series") = -1,
+          py::arg("exclude_start") = -1);
+
+    m.def("dtw_distance", &dtw_distance,
+          "Banded DTW distance between two equal-length sequences (no normalization)",
+          py::arg("a"), py::arg("b"), py::arg("band") = 0.1);
+}
+
+// ===== Pairs screener =====
+
+struct PairScreenResult {
+    py::array_t<int64_t> first;
+    py::array_t<int64_t> second;
+    py::array_t<double> correlation;
+    py::array_t<double> hedge_ratio;
+    py::array_t<double> intercept;
+    py::array_t<double> adf_stat;
+    py::array_t<double> p_value;
+    py::array_t<double> half_life;
+    py::array_t<int64_t> n_obs;
 };
 
-BollingerBands calculate_bollinger_bands(
-    py::array_t<double> prices,
-    int period = 20,
-    double num_std = 2.0
-) {
+static PairScreenResult screen_pairs(const DoubleArray &prices, double min_correlation,
+                                     size_t max_candidates, int adf_lags, int min_overlap) {
     auto buf = prices.request();
-    double *ptr = static_cast<double *>(buf.ptr);
-    size_t n = buf.shape[0];
-
-    std::vector<double> middle(n, 0.0);
-    std::vector<double> upper(n, 0.0);
-    std::vector<double> lower(n, 0.0);
-
-    // Calculate rolling mean and std
-    for (size_t i = period - 1; i < n; ++i) {
-        double sum = 0.0;
-        for (int j = 0; j < period; ++j) {
-            sum += ptr[i - j];
+    if (buf.ndim != 2) {
+        throw std::invalid_argument("prices must be a 2-D (n_obs, n_tickers) array");
+    }
+    const double *pp = static_cast<const double *>(buf.ptr);
+    const size_t n_obs = static_cast<size_t>(buf.shape[0]);
+    const size_t n_tickers = static_cast<size_t>(buf.shape[1]);
+    as::PairScreenOptions opts;
+    opts.min_correlation = min_correlation;
+    opts.max_candidates = max_candidates;
+    opts.adf_lags = adf_lags;
+    opts.min_overlap = min_overlap;
+
+    std::vector<as::PairResult> pairs;
+    {
+        py::gil_scoped_release release;
+        pairs = as::screen_pairs(pp, n_obs, n_tickers, opts);
+    }
+
+    const size_t n = pairs.size();
+    std::vector<int64_t> first(n), second(n), n_used(n);
+    std::vector<double> corr(n), beta(n), alpha(n), stat(n), pval(n), half_life(n);
+    for (size_t i = 0; i < n; ++i) {
+        first[i] = pairs[i].first;
+        second[i] = pairs[i].second;
+        corr[i] = pairs[i].correlation;
+        beta[i] = pairs[i].hedge_ratio;
+        alpha[i] = pairs[i].intercept;
+        stat[i] = pairs[i].adf_stat;
+        pval[i] = pairs[i].p_value;
+        half_life[i] = pairs[i].half_life;
+        n_used[i] = pairs[i].n_obs;
+    }
+    PairScreenResult result;
+    result.first = py::array_t<int64_t>(n, first.data());
+    result.second = py::array_t<int64_t>(n, second.data());
+    result.correlation = py::array_t<double>(n, corr.data());
+    result.hedge_ratio = py::array_t<double>(n, beta.data());
+    result.intercept = py::array_t<double>(n, alpha.data());
+    result.adf_stat = py::array_t<double>(n, stat.data());
+    result.p_value = py::array_t<double>(n, pval.data());
+    result.half_life = py::array_t<double>(n, half_life.data());
+    result.n_obs = py::array_t<int64_t>(n, n_used.data());
+    return result;
+}
+
+static as::PairResult engle_granger(const DoubleArray &log_y, const DoubleArray &log_x,
+                                    int adf_lags) {
+    size_t ny, nx;
+    const double *py_ = as_vector(log_y, ny);
+    const double *px = as_vector(log_x, nx);
+    if (ny != nx) {
+        throw std::invalid_argument("series must have the same length");
+    }
+    if (adf_lags < 0) {
+        throw std::invalid_argument("adf_lags must be non-negative");
+    }
+    py::gil_scoped_release release;
+    return as::engle_granger(py_, px, ny, adf_lags);
+}
+
+static void bind_pairs(py::module_ &m) {
+    py::class_<PairScreenResult>(m, "PairScreenResult")
+        .def_readonly("first", &PairScreenResult::first)
+        .def_readonly("second", &PairScreenResult::second)
+        .def_readonly("correlation", &PairScreenResult::correlation)
+        .def_readonly("hedge_ratio", &PairScreenResult::hedge_ratio)
+        .def_readonly("intercept", &PairScreenResult::intercept)
+        .def_readonly("adf_stat", &PairScreenResult::adf_stat)
+        .def_readonly("p_value", &PairScreenResult::p_value)
+        .def_readonly("half_life", &PairScreenResult::half_life)
+        .def_readonly("n_obs", &PairScreenResult::n_obs);
+
+    py::class_<as::PairResult>(m, "PairResult")
+        .def_readonly("first", &as::PairResult::first)
+        .def_readonly("second", &as::PairResult::second)
+        .def_readonly("hedge_ratio", &as::PairResult::hedge_ratio)
+        .def_readonly("intercept", &as::PairResult::intercept)
+        .def_readonly("adf_stat", &as::PairResult::adf_stat)
+        .def_readonly("p_value", &as::PairResult::p_value)
+        .def_readonly("half_life", &as::PairResult::half_life)
+        .def_readonly("n_obs", &as::PairResult::n_obs);
+
+    m.def("screen_pairs", &screen_pairs,
+          "All-pairs return correlation (blocked) followed by Engle-Granger tests on the "
+          "strongest pairs; prices is (n_obs, n_tickers). Sorted by p-value.",
+          py::arg("prices"),
+          py::arg("min_correlation") = 0.7,
+          py::arg("max_candidates") = 5000,
+          py::arg("adf_lags") = 1,
+          py::arg("min_overlap") = 60);
+
+    m.def("engle_granger", &engle_granger,
+          "Engle-Granger cointegration test on two log-price series",
+          py::arg("log_y"), py::arg("log_x"), py::arg("adf_lags") = 1);
+
+    m.def("mackinnon_p_value", &as::mackinnon_p_value,
+          "MacKinnon approximate p-value for a two-variable cointegration ADF statistic",
+          py::arg("adf_stat"));
+}
+
+// ===== Lead-lag cross-correlation =====
+
+static py::array_t<double> cross_correlation(const DoubleArray &x, const DoubleArray &y,
+                                             int max_lag) {
+    size_t nx, ny;
+    const double *px = as_vector(x, nx);
+    const double *py_ = as_vector(y, ny);
+    if (nx != ny) {
+        throw std::invalid_argument("series must have the same length");
+    }
+    if (max_lag < 0 || static_cast<size_t>(max_lag) >= nx) {
+        throw std::invalid_argument("max_lag must be in [0, n)");
+    }
+    std::vector<double> out(2 * max_lag + 1);
+    {
+        py::gil_scoped_release release;
+        as::cross_correlation(px, py_, nx, max_lag, out.data());
+    }
+    return py::array_t<double>(out.size(), out.data());
+}
+
+static py::tuple lead_lag_scan(const DoubleArray &panel, const OffsetArray &pairs, int max_lag,
+                               size_t window, size_t step, bool sliding) {
+    auto buf = panel.request();
+    if (buf.ndim != 2) {
+        throw std::invalid_argument("panel must be a 2-D (n_obs, n_series) array");
+    }
+    auto pbuf = pairs.request();
+    if (pbuf.ndim != 2 || pbuf.shape[1] != 2) {
+        throw std::invalid_argument("pairs must be an (n_pairs, 2) integer array");
+    }
+    as::LeadLagOptions opts;
+    opts.max_lag = max_lag;
+    opts.window = window;
+    opts.step = step;
+    opts.sliding = sliding;
+
+    as::LeadLagScan scan;
+    {
+        py::gil_scoped_release release;
+        scan = as::lead_lag_scan(static_cast<const double *>(buf.ptr),
+                                 static_cast<size_t>(buf.shape[0]),
+                                 static_cast<size_t>(buf.shape[1]),
+                                 static_cast<const int64_t *>(pbuf.ptr),
+                                 static_cast<size_t>(pbuf.shape[0]), opts);
+    }
+    std::vector<py::ssize_t> shape{static_cast<py::ssize_t>(scan.n_pairs),
+                                   static_cast<py::ssize_t>(scan.n_windows)};
+    return py::make_tuple(py::array_t<int64_t>(scan.window_end.size(), scan.window_end.data()),
+                          py::array_t<int64_t>(shape, scan.peak_lag.data()),
+                          to_numpy_2d(scan.peak_corr.data(), scan.n_pairs, scan.n_windows));
+}
+
+static void bind_leadlag(py::module_ &m) {
+    m.def("cross_correlation", &cross_correlation,
+          "FFT cross-correlation r(k) = corr(x_t, y_{t+k}) for k in [-max_lag, max_lag]; "
+          "positive k means x leads y",
+          py::arg("x"), py::arg("y"), py::arg("max_lag") = 10);
+
+    m.def("lead_lag_scan", &lead_lag_scan,
+          "Peak lag and correlation for each (x, y) column pair over rolling windows; "
+          "returns (window_end, peak_lag, peak_corr)",
+          py::arg("panel"),
+          py::arg("pairs"),
+          py::arg("max_lag") = 10,
+          py::arg("window") = 0,
+          py::arg("step") = 0,
+          py::arg("sliding") = false);
+}
+
+// ===== Wavelet multi-resolution decomposition =====
+
+struct WaveletResult {
+    py::array_t<double> detail;  // (levels, n)
+    py::array_t<double> smooth;  // (levels, n)
+    py::object energy;           // (levels, n), or None without an energy window
+};
+
+static as::WaveletOptions wavelet_options(int levels, const std::string &filter,
+                                          const std::string &transform, bool causal,
+                                          int energy_window) {
+    as::WaveletOptions opts;
+    opts.levels = levels;
+    opts.filter = as::parse_wavelet_filter(filter);
+    if (transform == "atrous") {
+        opts.transform = as::WaveletTransform::ATrous;
+    } else if (transform == "modwt") {
+        opts.transform = as::WaveletTransform::Modwt;
+    } else {
+        throw std::invalid_argument("transform must be 'atrous' or 'modwt'");
+    }
+    if (levels < 1) {
+        throw std::invalid_argument("levels must be at least 1");
+    }
+    opts.causal = causal;
+    opts.energy_window = energy_window;
+    return opts;
+}
+
+static WaveletResult wavelet_result(size_t n, const as::WaveletOptions &opts,
+                                    const std::function<void(double *, double *, double *)> &run) {
+    const size_t levels = static_cast<size_t>(opts.levels);
+    std::vector<double> detail(levels * n), smooth(levels * n), energy;
+    if (opts.energy_window > 0) {
+        energy.resize(levels * n);
+    }
+    {
+        py::gil_scoped_release release;
+        run(detail.data(), smooth.data(), energy.empty() ? nullptr : energy.data());
+    }
+    WaveletResult result;
+    result.detail = to_numpy_2d(detail.data(), levels, n);
+    result.smooth = to_numpy_2d(smooth.data(), levels, n);
+    result.energy = energy.empty() ? py::object(py::none())
+                                   : py::object(to_numpy_2d(energy.data(), levels, n));
+    return result;
+}
+
+static WaveletResult wavelet_decompose(const DoubleArray &x, int levels, const std::string &filter,
+                                       const std::string &transform, bool causal,
+                                       int energy_window) {
+    size_t n;
+    const double *px = as_vector(x, n);
+    as::WaveletOptions opts = wavelet_options(levels, filter, transform, causal, energy_window);
+    return wavelet_result(n, opts, [&](double *d, double *s, double *e) {
+        as::wavelet_decompose(px, n, opts, d, s, e, n);
+    });
+}
+
+static WaveletResult wavelet_decompose_batch(const DoubleArray &x, const OffsetArray &offsets,
+                                             int levels, const std::string &filter,
+                                             const std::string &transform, bool causal,
+                                             int energy_window) {
+    size_t n;
+    const double *px = as_vector(x, n);
+    as::RaggedBatch batch = as_batch(offsets, n);
+    as::WaveletOptions opts = wavelet_options(levels, filter, transform, causal, energy_window);
+    return wavelet_result(n, opts, [&](double *d, double *s, double *e) {
+        as::wavelet_decompose_batch(px, batch, opts, d, s, e);
+    });
+}
+
+static void bind_wavelet(py::module_ &m) {
+    py::class_<WaveletResult>(m, "WaveletResult")
+        .def_readonly("detail", &WaveletResult::detail)
+        .def_readonly("smooth", &WaveletResult::smooth)
+        .def_readonly("energy", &WaveletResult::energy);
+
+    m.def("wavelet_decompose", &wavelet_decompose,
+          "Undecimated wavelet decomposition; detail/smooth are (levels, n), level 1 first",
+          py::arg("x"),
+          py::arg("levels") = 4,
+          py::arg("filter") = "haar",
+          py::arg("transform") = "atrous",
+          py::arg("causal") = true,
+          py::arg("energy_window") = 0);
+
+    m.def("wavelet_decompose_batch", &wavelet_decompose_batch,
+          "Batched wavelet decomposition over tickers; outputs are (levels, total_rows)",
+          py::arg("x"),
+          py::arg("offsets"),
+          py::arg("levels") = 4,
+          py::arg("filter") = "haar",
+          py::arg("transform") = "atrous",
+          py::arg("causal") = true,
+          py::arg("energy_window") = 0);
+}
+
+// ===== Tick-to-bar aggregation =====
+
+// Closed bars as columns, one entry per bar
+struct BarColumns {
+    py::array_t<int64_t> start_ns;
+    py::array_t<int64_t> end_ns;
+    py::array_t<double> open;
+    py::array_t<double> high;
+    py::array_t<double> low;
+    py::array_t<double> close;
+    py::array_t<double> volume;
+    py::array_t<double> dollar_volume;
+    py::array_t<double> vwap;
+    py::array_t<double> buy_volume;
+    py::array_t<int64_t> ticks;
+};
+
+static BarColumns bar_columns(const std::vector<as::Bar> &bars) {
+    const size_t n = bars.size();
+    std::vector<int64_t> start(n), end(n), ticks(n);
+    std::vector<double> open(n), high(n), low(n), close(n), volume(n), dollar(n), vwap(n), buy(n);
+    for (size_t i = 0; i < n; ++i) {
+        const as::Bar &b = bars[i];
+        start[i] = b.start_ns;
+        end[i] = b.end_ns;
+        open[i] = b.open;
+        high[i] = b.high;
+        low[i] = b.low;
+        close[i] = b.close;
+        volume[i] = b.volume;
+        dollar[i] = b.dollar_volume;
+        vwap[i] = b.vwap;
+        buy[i] = b.buy_volume;
+        ticks[i] = b.ticks;
+    }
+    BarColumns cols;
+    cols.start_ns = py::array_t<int64_t>(n, start.data());
+    cols.end_ns = py::array_t<int64_t>(n, end.data());
+    cols.open = py::array_t<double>(n, open.data());
+    cols.high = py::array_t<double>(n, high.data());
+    cols.low = py::array_t<double>(n, low.data());
+    cols.close = py::array_t<double>(n, close.data());
+    cols.volume = py::array_t<double>(n, volume.data());
+    cols.dollar_volume = py::array_t<double>(n, dollar.data());
+    cols.vwap = py::array_t<double>(n, vwap.data());
+    cols.buy_volume = py::array_t<double>(n, buy.data());
+    cols.ticks = py::array_t<int64_t>(n, ticks.data());
+    return cols;
+}
+
+static as::BarOptions bar_options(const std::string &type, int64_t interval_ns, double threshold,
+                                  double expected_ticks, double expected_imbalance,
+                                  double ewma_span) {
+    as::BarOptions opts;
+    opts.type = as::parse_bar_type(type);
+    opts.interval_ns = interval_ns;
+    opts.threshold = threshold;
+    opts.expected_ticks = expected_ticks;
+    opts.expected_imbalance = expected_imbalance;
+    opts.ewma_span = ewma_span;
+    return opts;
+}
+
+// Validates a tick chunk: int64 ns timestamps, prices and sizes of equal length
+static size_t tick_arrays(const OffsetArray &ts, const DoubleArray &price, const DoubleArray &size,
+                          const int64_t *&pts, const double *&pp, const double *&ps) {
+    size_t n, m;
+    pp = as_vector(price, n);
+    ps = as_vector(size, m);
+    auto buf = ts.request();
+    if (buf.ndim != 1 || static_cast<size_t>(buf.size) != n || m != n) {
+        throw std::invalid_argument("timestamps, prices and sizes must be 1-D and equal length");
+    }
+    pts = static_cast<const int64_t *>(buf.ptr);
+    return n;
+}
+
+static BarColumns bar_builder_update(as::BarBuilder &builder, const OffsetArray &ts,
+                                     const DoubleArray &price, const DoubleArray &size) {
+    const int64_t *pts;
+    const double *pp, *ps;
+    const size_t n = tick_arrays(ts, price, size, pts, pp, ps);
+    std::vector<as::Bar> bars;
+    {
+        py::gil_scoped_release release;
+        builder.update(pts, pp, ps, n, bars);
+    }
+    return bar_columns(bars);
+}
+
+static BarColumns bar_builder_flush(as::BarBuilder &builder) {
+    std::vector<as::Bar> bars(1);
+    if (!builder.flush(bars[0])) {
+        bars.clear();
+    }
+    return bar_columns(bars);
+}
+
+static BarColumns make_bars(const OffsetArray &ts, const DoubleArray &price,
+                            const DoubleArray &size, const std::string &type, int64_t interval_ns,
+                            double threshold, double expected_ticks, double expected_imbalance,
+                            double ewma_span) {
+    const int64_t *pts;
+    const double *pp, *ps;
+    const size_t n = tick_arrays(ts, price, size, pts, pp, ps);
+    as::BarOptions opts = bar_options(type, interval_ns, threshold, expected_ticks,
+                                      expected_imbalance, ewma_span);
+    std::vector<as::Bar> bars;
+    {
+        py::gil_scoped_release release;
+        bars = as::make_bars(pts, pp, ps, n, opts);
+    }
+    return bar_columns(bars);
+}
+
+static void bind_bars(py::module_ &m) {
+    py::class_<BarColumns>(m, "BarColumns")
+        .def_readonly("start_ns", &BarColumns::start_ns)
+        .def_readonly("end_ns", &BarColumns::end_ns)
+        .def_readonly("open", &BarColumns::open)
+        .def_readonly("high", &BarColumns::high)
+        .def_readonly("low", &BarColumns::low)
+        .def_readonly("close", &BarColumns::close)
+        .def_readonly("volume", &BarColumns::volume)
+        .def_readonly("dollar_volume", &BarColumns::dollar_volume)
+        .def_readonly("vwap", &BarColumns::vwap)
+        .def_readonly("buy_volume", &BarColumns::buy_volume)
+        .def_readonly("ticks", &BarColumns::ticks);
+
+    py::class_<as::BarBuilder>(m, "BarBuilder")
+        .def(py::init([](const std::string &type, int64_t interval_ns, double threshold,
+                         double expected_ticks, double expected_imbalance, double ewma_span) {
+                 return as::BarBuilder(bar_options(type, interval_ns, threshold, expected_ticks,
+                                                   expected_imbalance, ewma_span));
+             }),
+             py::arg("type") = "time",
+             py::arg("interval_ns") = 60'000'000'000LL,
+             py::arg("threshold") = 0.0,
+             py::arg("expected_ticks") = 1000.0,
+             py::arg("expected_imbalance") = 0.1,
+             py::arg("ewma_span") = 20.0)
+        .def("update", &bar_builder_update,
+             "Feed a chunk of ticks (int64 ns timestamps, prices, sizes); returns the bars it closed",
+             py::arg("timestamps"), py::arg("prices"), py::arg("sizes"))
+        .def("flush", &bar_builder_flush, "Close the partial bar, if any (0 or 1 bars)")
+        .def("reset", &as::BarBuilder::reset)
+        .def_property_readonly("has_partial", &as::BarBuilder::has_partial)
+        .def_property_readonly("imbalance_threshold", &as::BarBuilder::imbalance_threshold);
+
+    m.def("make_bars", &make_bars,
+          "Aggregate ticks into time, tick, volume, dollar or tick_imbalance bars "
+          "(OHLCV + VWAP); the partial last bar is included",
+          py::arg("timestamps"),
+          py::arg("prices"),
+          py::arg("sizes"),
+          py::arg("type") = "time",
+          py::arg("interval_ns") = 60'000'000'000LL,
+          py::arg("threshold") = 0.0,
+          py::arg("expected_ticks") = 1000.0,
+          py::arg("expected_imbalance") = 0.1,
+          py::arg("ewma_span") = 20.0);
+}
+
+// ===== Multi-timeframe resampling =====
+
+struct ResampleColumns {
+    py::array_t<double> open, high, low, close, volume;
+    py::array_t<int64_t> first_row, last_row, bar_offsets;
+    py::array_t<int64_t> period, last_complete;
+    py::object running;  // (5, n) running open/high/low/close/volume, or None
+};
+
+static ResampleColumns resample_ohlcv(const DoubleArray &open, const DoubleArray &high,
+                                      const DoubleArray &low, const DoubleArray &close,
+                                      const DoubleArray &volume, const py::object &keys,
+                                      const OffsetArray &offsets, const std::string &period,
+                                      int bars, bool running) {
+    size_t n;
+    as::OHLCVColumns in;
+    in.close = as_vector(close, n);
+    for (auto col : {std::make_pair(&open, &in.open), std::make_pair(&high, &in.high),
+                     std::make_pair(&low, &in.low), std::make_pair(&volume, &in.volume)}) {
+        size_t m;
+        *col.second = as_vector(*col.first, m);
+        if (m != n) {
+            throw std::invalid_argument("open, high, low, close and volume must have equal length");
+        }
+    }
+    as::ResampleOptions opts;
+    opts.period = as::parse_resample_period(period);
+    opts.bars = bars;
+    opts.running = running;
+
+    OffsetArray key_array;
+    const int64_t *pk = nullptr;
+    if (!keys.is_none()) {
+        key_array = keys.cast<OffsetArray>();
+        auto buf = key_array.request();
+        if (buf.ndim != 1 || static_cast<size_t>(buf.size) != n) {
+            throw std::invalid_argument("keys must be 1-D with one entry per row");
         }
-        double mean = sum / period;
-        middle[i] = mean;
-
-        // Calculate standard deviation
-        double variance = 0.0;
-        for (int j = 0; j < period; ++j) {
-            double diff = ptr[i - j] - mean;
-            variance += diff * diff;
+        pk = static_cast<const int64_t *>(buf.ptr);
+    }
+    as::RaggedBatch batch = as_batch(offsets, n);
+    as::ResampleResult r;
+    {
+        py::gil_scoped_release release;
+        r = as::resample_ohlcv(in, pk, batch, opts);
+    }
+
+    const size_t n_bars = r.open.size();
+    ResampleColumns cols;
+    cols.open = py::array_t<double>(n_bars, r.open.data());
+    cols.high = py::array_t<double>(n_bars, r.high.data());
+    cols.low = py::array_t<double>(n_bars, r.low.data());
+    cols.close = py::array_t<double>(n_bars, r.close.data());
+    cols.volume = py::array_t<double>(n_bars, r.volume.data());
+    cols.first_row = py::array_t<int64_t>(n_bars, r.first_row.data());
+    cols.last_row = py::array_t<int64_t>(n_bars, r.last_row.data());
+    cols.bar_offsets = py::array_t<int64_t>(r.bar_offsets.size(), r.bar_offsets.data());
+    cols.period = py::array_t<int64_t>(n, r.period.data());
+    cols.last_complete = py::array_t<int64_t>(n, r.last_complete.data());
+    if (running) {
+        std::vector<double> run(5 * n);
+        std::copy(r.run_open.begin(), r.run_open.end(), run.begin());
+        std::copy(r.run_high.begin(), r.run_high.end(), run.begin() + n);
+        std::copy(r.run_low.begin(), r.run_low.end(), run.begin() + 2 * n);
+        std::copy(r.run_close.begin(), r.run_close.end(), run.begin() + 3 * n);
+        std::copy(r.run_volume.begin(), r.run_volume.end(), run.begin() + 4 * n);
+        cols.running = to_numpy_2d(run.data(), 5, n);
+    } else {
+        cols.running = py::none();
+    }
+    return cols;
+}
+
+static void bind_resample(py::module_ &m) {
+    py::class_<ResampleColumns>(m, "ResampleColumns")
+        .def_readonly("open", &ResampleColumns::open)
+        .def_readonly("high", &ResampleColumns::high)
+        .def_readonly("low", &ResampleColumns::low)
+        .def_readonly("close", &ResampleColumns::close)
+        .def_readonly("volume", &ResampleColumns::volume)
+        .def_readonly("first_row", &ResampleColumns::first_row)
+        .def_readonly("last_row", &ResampleColumns::last_row)
+        .def_readonly("bar_offsets", &ResampleColumns::bar_offsets)
+        .def_readonly("period", &ResampleColumns::period)
+        .def_readonly("last_complete", &ResampleColumns::last_complete)
+        .def_readonly("running", &ResampleColumns::running);
+
+    m.def("resample_ohlcv", &resample_ohlcv,
+          "Aggregate daily OHLCV to weekly ('W'), monthly ('M'), quarterly ('Q'), yearly ('Y'), "
+          "fixed-row ('bars') or custom-keyed periods for tickers laid out by offsets. keys are "
+          "epoch days (or the custom period keys); last_complete maps each row to the latest "
+          "finished period, for joins without look-ahead",
+          py::arg("open"),
+          py::arg("high"),
+          py::arg("low"),
+          py::arg("close"),
+          py::arg("volume"),
+          py::arg("keys"),
+          py::arg("offsets"),
+          py::arg("period") = "W",
+          py::arg("bars") = 5,
+          py::arg("running") = false);
+}
+
+// ===== Corporate-action adjustment =====
+
+struct AdjustedColumns {
+    py::array_t<double> open, high, low, close, volume, total_return, factor;
+};
+
+static AdjustedColumns adjust_corporate_actions(const DoubleArray &open, const DoubleArray &high,
+                                                const DoubleArray &low, const DoubleArray &close,
+                                                const DoubleArray &volume, const DoubleArray &split,
+                                                const DoubleArray &dividend,
+                                                const py::object &offsets) {
+    size_t n;
+    as::OHLCVColumns raw;
+    as::CorporateActions actions;
+    raw.close = as_vector(close, n);
+    for (auto col : {std::make_pair(&open, &raw.open), std::make_pair(&high, &raw.high),
+                     std::make_pair(&low, &raw.low), std::make_pair(&volume, &raw.volume),
+                     std::make_pair(&split, &actions.split),
+                     std::make_pair(&dividend, &actions.dividend)}) {
+        size_t m;
+        *col.second = as_vector(*col.first, m);
+        if (m != n) {
+            throw std::invalid_argument("price, volume and action columns must have equal length");
         }
-        double std = std::sqrt(variance / period);
+    }
 
-        upper[i] = mean + num_std * std;
-        lower[i] = mean - num_std * std;
+    std::vector<double> buf(7 * n);
+    const as::AdjustedOHLCV out{buf.data(),         buf.data() + n,     buf.data() + 2 * n,
+                                buf.data() + 3 * n, buf.data() + 4 * n, buf.data() + 5 * n,
+                                buf.data() + 6 * n};
+    if (offsets.is_none()) {
+        py::gil_scoped_release release;
+        as::adjust_corporate_actions(raw, actions, n, out);
+    } else {
+        OffsetArray off = offsets.cast<OffsetArray>();
+        as::RaggedBatch batch = as_batch(off, n);
+        py::gil_scoped_release release;
+        as::adjust_corporate_actions_batch(raw, actions, batch, out);
     }
 
-    BollingerBands result;
-    result.upper = py::array_t<double>(n, upper.data());
-    result.middle = py::array_t<double>(n, middle.data());
-    result.lower = py::array_t<double>(n, lower.data());
+    AdjustedColumns cols;
+    cols.open = py::array_t<double>(n, out.open);
+    cols.high = py::array_t<double>(n, out.high);
+    cols.low = py::array_t<double>(n, out.low);
+    cols.close = py::array_t<double>(n, out.close);
+    cols.volume = py::array_t<double>(n, out.volume);
+    cols.total_return = py::array_t<double>(n, out.total_return);
+    cols.factor = py::array_t<double>(n, out.factor);
+    return cols;
+}
+
+static void bind_corporate_actions(py::module_ &m) {
+    py::class_<AdjustedColumns>(m, "AdjustedColumns")
+        .def_readonly("open", &AdjustedColumns::open)
+        .def_readonly("high", &AdjustedColumns::high)
+        .def_readonly("low", &AdjustedColumns::low)
+        .def_readonly("close", &AdjustedColumns::close)
+        .def_readonly("volume", &AdjustedColumns::volume)
+        .def_readonly("total_return", &AdjustedColumns::total_return)
+        .def_readonly("factor", &AdjustedColumns::factor);
+
+    m.def("adjust_corporate_actions", &adjust_corporate_actions,
+          "Backward split/dividend adjustment of raw OHLCV plus a total-return index "
+          "(1.0 at the first valid close); split and dividend are per row on the ex-date. "
+          "Pass offsets to adjust many tickers at once",
+          py::arg("open"),
+          py::arg("high"),
+          py::arg("low"),
+          py::arg("close"),
+          py::arg("volume"),
+          py::arg("split"),
+          py::arg("dividend"),
+          py::arg("offsets") = py::none());
+}
+
+// ===== Fused returns / momentum / forward targets =====
+
+struct ReturnsResult {
+    py::array_t<double> simple;  // (len(horizons), n)
+    py::object log;              // (len(horizons), n) or None
+    py::object roc;              // (len(horizons), n) or None
+    py::object forward;          // (len(forward_horizons), n) or None
+};
+
+static ReturnsResult compute_returns(const DoubleArray &close, const std::vector<int> &horizons,
+                                     const std::vector<int> &forward_horizons, bool log, bool roc,
+                                     const py::object &offsets) {
+    size_t n;
+    const double *pc = as_vector(close, n);
+    as::ReturnsOptions opts;
+    opts.horizons = horizons;
+    opts.forward_horizons = forward_horizons;
+    opts.log = log;
+    opts.roc = roc;
+
+    const size_t h = horizons.size(), f = forward_horizons.size();
+    std::vector<double> simple(h * n), log_ret(log ? h * n : 0), rate(roc ? h * n : 0),
+        forward(f * n);
+    const as::ReturnsOutput out{simple.data(), log ? log_ret.data() : nullptr,
+                                roc ? rate.data() : nullptr, f ? forward.data() : nullptr, n};
+    if (offsets.is_none()) {
+        py::gil_scoped_release release;
+        as::compute_returns(pc, n, opts, out);
+    } else {
+        OffsetArray off = offsets.cast<OffsetArray>();
+        as::RaggedBatch batch = as_batch(off, n);
+        py::gil_scoped_release release;
+        as::compute_returns_batch(pc, batch, opts, out);
+    }
 
+    ReturnsResult result;
+    result.simple = to_numpy_2d(simple.data(), h, n);
+    result.log = log ? py::object(to_numpy_2d(log_ret.data(), h, n)) : py::object(py::none());
+    result.roc = roc ? py::object(to_numpy_2d(rate.data(), h, n)) : py::object(py::none());
+    result.forward = f ? py::object(to_numpy_2d(forward.data(), f, n)) : py::object(py::none());
     return result;
 }
 
-// Rolling Correlation (Fast)
-py::array_t<double> rolling_correlation(
-    py::array_t<double> x,
-    py::array_t<double> y,
-    int window = 20
-) {
-    auto buf_x = x.request();
-    auto buf_y = y.request();
-    double *ptr_x = static_cast<double *>(buf_x.ptr);
-    double *ptr_y = static_cast<double *>(buf_y.ptr);
-    size_t n = buf_x.shape[0];
-
-    std::vector<double> corr(n, 0.0);
-
-    for (size_t i = window - 1; i < n; ++i) {
-        double sum_x = 0.0, sum_y = 0.0;
-        double sum_xx = 0.0, sum_yy = 0.0, sum_xy = 0.0;
-
-        for (int j = 0; j < window; ++j) {
-            double vx = ptr_x[i - j];
-            double vy = ptr_y[i - j];
-
-            sum_x += vx;
-            sum_y += vy;
-            sum_xx += vx * vx;
-            sum_yy += vy * vy;
-            sum_xy += vx * vy;
+static void bind_returns(py::module_ &m) {
+    py::class_<ReturnsResult>(m, "ReturnsResult")
+        .def_readonly("simple", &ReturnsResult::simple)
+        .def_readonly("log", &ReturnsResult::log)
+        .def_readonly("roc", &ReturnsResult::roc)
+        .def_readonly("forward", &ReturnsResult::forward);
+
+    m.def("compute_returns", &compute_returns,
+          "Simple (= momentum), log and ROC returns for each horizon plus forward returns "
+          "for each target horizon, in one call; pass offsets for many tickers",
+          py::arg("close"),
+          py::arg("horizons") = std::vector<int>{1, 5, 20},
+          py::arg("forward_horizons") = std::vector<int>{},
+          py::arg("log") = true,
+          py::arg("roc") = false,
+          py::arg("offsets") = py::none());
+}
+
+// ===== Candlestick patterns =====
+
+struct CandleResult {
+    py::array_t<uint64_t> patterns;  // (n,) bit k set = candle_pattern_names()[k]
+    py::array_t<double> features;    // (len(candle_feature_names()), n)
+};
+
+static CandleResult candle_patterns(const DoubleArray &open, const DoubleArray &high,
+                                    const DoubleArray &low, const DoubleArray &close,
+                                    const py::object &offsets, double doji_body,
+                                    double small_body, double long_body, double shadow_ratio,
+                                    double gap_threshold, int trend_lookback) {
+    size_t n;
+    as::OHLCVColumns ohlc{nullptr, nullptr, nullptr, nullptr, nullptr};
+    ohlc.close = as_vector(close, n);
+    for (auto col : {std::make_pair(&open, &ohlc.open), std::make_pair(&high, &ohlc.high),
+                     std::make_pair(&low, &ohlc.low)}) {
+        size_t m;
+        *col.second = as_vector(*col.first, m);
+        if (m != n) {
+            throw std::invalid_argument("open, high, low and close must have equal length");
+        }
+    }
+    as::CandleOptions opts;
+    opts.doji_body = doji_body;
+    opts.small_body = small_body;
+    opts.long_body = long_body;
+    opts.shadow_ratio = shadow_ratio;
+    opts.gap_threshold = gap_threshold;
+    opts.trend_lookback = trend_lookback;
+
+    std::vector<uint64_t> patterns(n);
+    std::vector<double> features(as::kNumCandleFeatures * n);
+    if (offsets.is_none()) {
+        py::gil_scoped_release release;
+        as::candle_patterns(ohlc, n, opts, patterns.data(), features.data(), n);
+    } else {
+        OffsetArray off = offsets.cast<OffsetArray>();
+        as::RaggedBatch batch = as_batch(off, n);
+        py::gil_scoped_release release;
+        as::candle_patterns_batch(ohlc, batch, opts, patterns.data(), features.data());
+    }
+
+    CandleResult result;
+    result.patterns = py::array_t<uint64_t>(n, patterns.data());
+    result.features = to_numpy_2d(features.data(), as::kNumCandleFeatures, n);
+    return result;
+}
+
+static void bind_candles(py::module_ &m) {
+    py::class_<CandleResult>(m, "CandleResult")
+        .def_readonly("patterns", &CandleResult::patterns)
+        .def_readonly("features", &CandleResult::features);
+
+    m.def("candle_pattern_names", &as::candle_pattern_names,
+          "Pattern name of each bit in CandleResult.patterns");
+    m.def("candle_feature_names", &as::candle_feature_names,
+          "Row names of CandleResult.features");
+
+    m.def("candle_patterns", &candle_patterns,
+          "Candlestick shape features and classic 1-3 bar patterns as a uint64 bitmask per bar; "
+          "pass offsets for many tickers",
+          py::arg("open"),
+          py::arg("high"),
+          py::arg("low"),
+          py::arg("close"),
+          py::arg("offsets") = py::none(),
+          py::arg("doji_body") = 0.1,
+          py::arg("small_body") = 0.3,
+          py::arg("long_body") = 0.6,
+          py::arg("shadow_ratio") = 2.0,
+          py::arg("gap_threshold") = 0.02,
+          py::arg("trend_lookback") = 5);
+}
+
+// ===== Calendar features =====
+
+static py::array_t<double> calendar_features(const OffsetArray &dates, const std::string &unit,
+                                             const py::object &holidays) {
+    auto buf = dates.request();
+    if (buf.ndim != 1) {
+        throw std::invalid_argument("dates must be a 1-D int64 array");
+    }
+    if (unit != "D" && unit != "ns") {
+        throw std::invalid_argument("unit must be 'D' (epoch days) or 'ns'");
+    }
+    const size_t n = static_cast<size_t>(buf.size);
+    const int64_t *pd = static_cast<const int64_t *>(buf.ptr);
+
+    OffsetArray hol;
+    const int64_t *ph = nullptr;
+    size_t n_hol = 0;
+    if (!holidays.is_none()) {
+        hol = holidays.cast<OffsetArray>();
+        auto hbuf = hol.request();
+        ph = static_cast<const int64_t *>(hbuf.ptr);
+        n_hol = static_cast<size_t>(hbuf.size);
+    }
+
+    std::vector<double> out(as::kNumCalendarFeatures * n);
+    {
+        py::gil_scoped_release release;
+        std::vector<int64_t> days;
+        if (unit == "ns") {
+            days.resize(n);
+            as::days_from_ns(pd, n, days.data());
+            pd = days.data();
+        }
+        as::calendar_features(pd, n, ph, n_hol, out.data());
+    }
+    return to_numpy_2d(out.data(), as::kNumCalendarFeatures, n);
+}
+
+static void bind_calendar(py::module_ &m) {
+    m.def("calendar_feature_names", &as::calendar_feature_names,
+          "Row names of calendar_features");
+
+    m.def("calendar_features", &calendar_features,
+          "Calendar and trading-calendar features (n_features, n) from int64 epoch days "
+          "(unit='D') or nanoseconds (unit='ns'); holidays are epoch days",
+          py::arg("dates"),
+          py::arg("unit") = "D",
+          py::arg("holidays") = py::none());
+}
+
+// ===== Real-time tick engine =====
+
+static size_t tick_engine_push_batch(as::TickEngine &engine, const OffsetArray &tickers,
+                                     const OffsetArray &ts, const DoubleArray &price,
+                                     const DoubleArray &volume, size_t producer, bool wait) {
+    const int64_t *pts;
+    const double *pp, *pv;
+    const size_t n = tick_arrays(ts, price, volume, pts, pp, pv);
+    auto buf = tickers.request();
+    if (buf.ndim != 1 || static_cast<size_t>(buf.size) != n) {
+        throw std::invalid_argument("tickers must be 1-D and match the tick arrays");
+    }
+    const int64_t *pk = static_cast<const int64_t *>(buf.ptr);
+    size_t pushed = 0;
+    {
+        py::gil_scoped_release release;
+        for (size_t i = 0; i < n; ++i) {
+            const as::Tick tick{pts[i], pp[i], pv[i], static_cast<int32_t>(pk[i])};
+            pushed += engine.push(tick, producer, wait) ? 1 : 0;
+        }
+    }
+    return pushed;
+}
+
+static py::array_t<double> tick_engine_snapshot(const as::TickEngine &engine) {
+    std::vector<double> out(engine.n_tickers() * as::kNumStreamFeatures);
+    engine.snapshot_all(out.data());
+    return to_numpy_2d(out.data(), engine.n_tickers(), as::kNumStreamFeatures);
+}
+
+static py::array_t<double> tick_engine_snapshot_ticker(const as::TickEngine &engine,
+                                                       size_t ticker) {
+    double out[as::kNumStreamFeatures];
+    engine.snapshot(ticker, out);
+    return py::array_t<double>(as::kNumStreamFeatures, out);
+}
+
+static py::dict tick_engine_stats(const as::TickEngine &engine) {
+    const as::TickEngineStats s = engine.stats();
+    py::dict d;
+    d["processed"] = s.processed;
+    d["dropped"] = s.dropped;
+    d["queued"] = s.queued;
+    return d;
+}
+
+static void bind_tick_engine(py::module_ &m) {
+    m.def("stream_feature_names", &as::stream_feature_names,
+          "Column names of TickEngine snapshots");
+
+    py::class_<as::TickEngine>(m, "TickEngine")
+        .def(py::init([](size_t n_tickers, int n_shards, size_t queue_capacity,
+                         const std::string &mode, int producers, int rsi_period, int macd_fast,
+                         int macd_slow, int macd_signal, double vol_halflife) {
+                 as::TickEngineOptions opts;
+                 opts.n_shards = n_shards;
+                 opts.queue_capacity = queue_capacity;
+                 opts.mode = as::parse_queue_mode(mode);
+                 opts.producers = producers;
+                 opts.rsi_period = rsi_period;
+                 opts.macd_fast = macd_fast;
+                 opts.macd_slow = macd_slow;
+                 opts.macd_signal = macd_signal;
+                 opts.vol_halflife = vol_halflife;
+                 return std::make_unique<as::TickEngine>(n_tickers, opts);
+             }),
+             py::arg("n_tickers"),
+             py::arg("n_shards") = 0,
+             py::arg("queue_capacity") = 1 << 16,
+             py::arg("mode") = "mpsc",
+             py::arg("producers") = 1,
+             py::arg("rsi_period") = 14,
+             py::arg("macd_fast") = 12,
+             py::arg("macd_slow") = 26,
+             py::arg("macd_signal") = 9,
+             py::arg("vol_halflife") = 100.0)
+        .def("start", &as::TickEngine::start, "Start one consumer thread per shard")
+        .def("stop", &as::TickEngine::stop, "Drain the queues and join the consumers",
+             py::call_guard<py::gil_scoped_release>())
+        .def("push",
+             [](as::TickEngine &engine, int32_t ticker, int64_t ts, double price, double volume,
+                size_t producer) {
+                 return engine.push(as::Tick{ts, price, volume, ticker}, producer);
+             },
+             "Queue one tick; False if it was dropped",
+             py::arg("ticker"), py::arg("timestamp"), py::arg("price"), py::arg("volume"),
+             py::arg("producer") = 0)
+        .def("push_batch", &tick_engine_push_batch,
+             "Queue ticks (int64 ticker ids, int64 ns timestamps, prices, volumes); with wait, "
+             "full queues are retried while the engine runs. Returns the number queued",
+             py::arg("tickers"), py::arg("timestamps"), py::arg("prices"), py::arg("volumes"),
+             py::arg("producer") = 0, py::arg("wait") = true)
+        .def("snapshot", &tick_engine_snapshot,
+             "Latest features of every ticker, shape (n_tickers, n_features)")
+        .def("snapshot_ticker", &tick_engine_snapshot_ticker, py::arg("ticker"))
+        .def("stats", &tick_engine_stats)
+        .def_property_readonly("running", &as::TickEngine::running)
+        .def_property_readonly("n_tickers", &as::TickEngine::n_tickers)
+        .def_property_readonly("n_shards", &as::TickEngine::n_shards);
+}
+
+// ===== Universe-wide streaming state =====
+
+static py::array_t<double> universe_features(const as::UniverseState &state) {
+    std::vector<double> out(as::kNumUniverseFeatures * state.n_tickers());
+    state.features(out.data());
+    return to_numpy_2d(out.data(), as::kNumUniverseFeatures, state.n_tickers());
+}
+
+static py::array_t<double> universe_update_all(as::UniverseState &state,
+                                               const DoubleArray &prices) {
+    size_t n;
+    const double *p = as_vector(prices, n);
+    if (n != state.n_tickers()) {
+        throw std::invalid_argument("prices must have one entry per ticker");
+    }
+    {
+        py::gil_scoped_release release;
+        state.update_all(p);
+    }
+    return universe_features(state);
+}
+
+static py::array_t<double> universe_update_many(as::UniverseState &state,
+                                                const DoubleArray &panel) {
+    const MatrixView x = as_matrix(panel);
+    if (static_cast<size_t>(x.cols) != state.n_tickers()) {
+        throw std::invalid_argument("panel must be (n_timestamps, n_tickers)");
+    }
+    {
+        py::gil_scoped_release release;
+        for (size_t t = 0; t < x.rows; ++t) {
+            state.update_all(x.data + t * x.cols);
         }
+    }
+    return universe_features(state);
+}
+
+static void bind_universe_state(py::module_ &m) {
+    m.def("universe_feature_names", &as::universe_feature_names,
+          "Row names of UniverseState features");
+
+    py::class_<as::UniverseState>(m, "UniverseState")
+        .def(py::init([](size_t n_tickers, int rsi_period, int macd_fast, int macd_slow,
+                         int macd_signal, int bb_period, double bb_std) {
+                 as::UniverseOptions opts;
+                 opts.rsi_period = rsi_period;
+                 opts.macd_fast = macd_fast;
+                 opts.macd_slow = macd_slow;
+                 opts.macd_signal = macd_signal;
+                 opts.bb_period = bb_period;
+                 opts.bb_std = bb_std;
+                 return as::UniverseState(n_tickers, opts);
+             }),
+             py::arg("n_tickers"),
+             py::arg("rsi_period") = 14,
+             py::arg("macd_fast") = 12,
+             py::arg("macd_slow") = 26,
+             py::arg("macd_signal") = 9,
+             py::arg("bb_period") = 20,
+             py::arg("bb_std") = 2.0)
+        .def("update_all", &universe_update_all,
+             "Advance every ticker by one timestamp (NaN = no price); returns features "
+             "(n_features, n_tickers)",
+             py::arg("prices"))
+        .def("update_many", &universe_update_many,
+             "Advance through a (n_timestamps, n_tickers) panel; returns the final features",
+             py::arg("panel"))
+        .def("features", &universe_features)
+        .def("reset", &as::UniverseState::reset)
+        .def_property_readonly("steps", &as::UniverseState::steps)
+        .def_property_readonly("n_tickers", &as::UniverseState::n_tickers);
+}
+
+// ===== Micro-batched model scoring =====
+
+// Joining the dispatcher waits for callbacks that need the GIL, so the
+// batcher is destroyed with the GIL released
+struct ScoreBatcherDeleter {
+    void operator()(as::ScoreBatcher *batcher) const {
+        py::gil_scoped_release release;
+        delete batcher;
+    }
+};
 
-        double mean_x = sum_x / window;
-        double mean_y = sum_y / window;
+using ScoreBatcherHolder = std::unique_ptr<as::ScoreBatcher, ScoreBatcherDeleter>;
 
-        double cov = (sum_xy / window) - (mean_x * mean_y);
-        double std_x = std::sqrt((sum_xx / window) - (mean_x * mean_x));
-        double std_y = std::sqrt((sum_yy / window) - (mean_y * mean_y));
+static const double *batcher_row(const as::ScoreBatcher &batcher, const DoubleArray &row) {
+    size_t n;
+    const double *p = as_vector(row, n);
+    if (n != static_cast<size_t>(batcher.model().n_features)) {
+        throw std::invalid_argument("row has " + std::to_string(n) + " values, model expects " +
+                                    std::to_string(batcher.model().n_features));
+    }
+    return p;
+}
 
-        if (std_x > 0 && std_y > 0) {
-            corr[i] = cov / (std_x * std_y);
+static void score_batcher_submit(as::ScoreBatcher &batcher, const DoubleArray &row,
+                                 py::function callback) {
+    const double *p = batcher_row(batcher, row);
+    // The callback runs, and is released, on the dispatcher thread
+    std::shared_ptr<py::function> cb(new py::function(std::move(callback)), [](py::function *f) {
+        py::gil_scoped_acquire gil;
+        delete f;
+    });
+    batcher.submit(p, [cb](double score, std::exception_ptr error) {
+        py::gil_scoped_acquire gil;
+        try {
+            if (!error) {
+                (*cb)(score, py::none());
+                return;
+            }
+            try {
+                std::rethrow_exception(error);
+            } catch (const std::exception &e) {
+                (*cb)(py::none(), py::str(e.what()));
+            }
+        } catch (py::error_already_set &e) {
+            e.discard_as_unraisable("ScoreBatcher callback");
         }
+    });
+}
+
+static double score_batcher_score(as::ScoreBatcher &batcher, const DoubleArray &row) {
+    std::future<double> result = batcher.submit(batcher_row(batcher, row));
+    py::gil_scoped_release release;
+    return result.get();
+}
+
+static py::dict score_batcher_stats(const as::ScoreBatcher &batcher) {
+    const as::BatcherStats s = batcher.stats();
+    py::dict d;
+    d["rows"] = s.rows;
+    d["batches"] = s.batches;
+    d["largest_batch"] = s.largest_batch;
+    d["queued"] = s.queued;
+    return d;
+}
+
+static void bind_score_batcher(py::module_ &m) {
+    py::class_<as::ScoreBatcher, ScoreBatcherHolder>(m, "ScoreBatcher")
+        .def(py::init([](const std::string &model_path, size_t max_batch, int64_t max_delay_us) {
+                 auto model =
+                     std::make_shared<const as::TreeEnsemble>(as::load_tree_ensemble(model_path));
+                 return ScoreBatcherHolder(new as::ScoreBatcher(
+                     std::move(model), as::BatcherOptions{max_batch, max_delay_us}));
+             }),
+             py::arg("model_path"),
+             py::arg("max_batch") = 64,
+             py::arg("max_delay_us") = 2000)
+        .def("submit", &score_batcher_submit,
+             "Queue one raw feature row; callback(probability, error) runs on the "
+             "dispatcher thread when its batch is scored",
+             py::arg("row"), py::arg("callback"))
+        .def("score", &score_batcher_score,
+             "Queue one row and block (GIL released) until its probability is ready",
+             py::arg("row"))
+        .def("close", &as::ScoreBatcher::close, "Stop accepting rows; queued rows are still scored")
+        .def("stats", &score_batcher_stats)
+        .def_property_readonly("n_features",
+                               [](const as::ScoreBatcher &b) { return b.model().n_features; })
+        .def_property_readonly("max_batch",
+                               [](const as::ScoreBatcher &b) { return b.options().max_batch; })
+        .def_property_readonly("max_delay_us",
+                               [](const as::ScoreBatcher &b) { return b.options().max_delay_us; });
+}
+
+// ===== Kernel memo cache =====
+
+static void enable_kernel_cache(size_t budget_bytes) {
+    if (kernel_cache) {
+        kernel_cache->set_budget(budget_bytes);
+    } else {
+        kernel_cache = std::make_unique<as::KernelCache>(budget_bytes);
+    }
+}
+
+static py::dict kernel_cache_stats() {
+    py::dict d;
+    const as::KernelCacheStats s = kernel_cache ? kernel_cache->stats() : as::KernelCacheStats();
+    d["enabled"] = static_cast<bool>(kernel_cache);
+    d["hits"] = s.hits;
+    d["extensions"] = s.extensions;
+    d["misses"] = s.misses;
+    d["evictions"] = s.evictions;
+    d["entries"] = s.entries;
+    d["bytes"] = s.bytes;
+    d["budget_bytes"] = s.budget_bytes;
+    return d;
+}
+
+static void bind_kernel_cache(py::module_ &m) {
+    m.def("enable_kernel_cache", &enable_kernel_cache,
+          "Memoise calculate_rsi / calculate_macd / calculate_bollinger_bands by input "
+          "fingerprint and parameters, LRU-evicted under budget_bytes. Inputs that only "
+          "grew at the end reuse the cached rows. Calling again resizes the budget.",
+          py::arg("budget_bytes") = size_t(64) << 20);
+    m.def("disable_kernel_cache", [] { kernel_cache.reset(); },
+          "Drop the cache and go back to computing every call");
+    m.def("clear_kernel_cache", [] {
+              if (kernel_cache) {
+                  kernel_cache->clear();
+              }
+          },
+          "Drop every cached result, keeping the cache enabled");
+    m.def("kernel_cache_stats", &kernel_cache_stats,
+          "enabled, hits, extensions, misses, evictions, entries, bytes, budget_bytes");
+    m.def("fingerprint", [](const DoubleArray &x) {
+              size_t n;
+              const double *p = as_vector(x, n);
+              return as::fingerprint(p, n);
+          },
+          "64-bit fingerprint of a float64 array (the cache key hash)", py::arg("x"));
+}
+
+// ===== Prediction accuracy log =====
+
+static size_t checked_length(const py::buffer_info &buf, size_t n, const char *name) {
+    if (buf.ndim != 1 || static_cast<size_t>(buf.size) != n) {
+        throw std::invalid_argument(std::string(name) + " must be 1-D and match ids");
+    }
+    return n;
+}
+
+static size_t prediction_log_append(as::PredictionLog &log, const OffsetArray &ids,
+                                    const std::vector<std::string> &tickers,
+                                    const std::vector<std::string> &model_versions,
+                                    const OffsetArray &days, const DoubleArray &confidence) {
+    auto id_buf = ids.request();
+    if (id_buf.ndim != 1) {
+        throw std::invalid_argument("ids must be a 1-D array");
     }
+    const size_t n = static_cast<size_t>(id_buf.size);
+    if (tickers.size() != n || model_versions.size() != n) {
+        throw std::invalid_argument("tickers and model_versions must match ids");
+    }
+    auto day_buf = days.request();
+    auto conf_buf = confidence.request();
+    checked_length(day_buf, n, "days");
+    checked_length(conf_buf, n, "confidence");
+    const int64_t *pd = static_cast<const int64_t *>(day_buf.ptr);
+    std::vector<int32_t> day32(n);
+    for (size_t i = 0; i < n; ++i) {
+        day32[i] = static_cast<int32_t>(pd[i]);
+    }
+    py::gil_scoped_release release;
+    return log.append(static_cast<const int64_t *>(id_buf.ptr), tickers.data(),
+                      model_versions.data(), day32.data(),
+                      static_cast<const double *>(conf_buf.ptr), n);
+}
+
+static size_t prediction_log_resolve(as::PredictionLog &log, const OffsetArray &ids,
+                                     const py::array_t<uint8_t, py::array::c_style |
+                                                                    py::array::forcecast> &correct) {
+    auto id_buf = ids.request();
+    if (id_buf.ndim != 1) {
+        throw std::invalid_argument("ids must be a 1-D array");
+    }
+    const size_t n = checked_length(correct.request(), static_cast<size_t>(id_buf.size),
+                                    "correct");
+    const uint8_t *pc = correct.data();
+    py::gil_scoped_release release;
+    return log.resolve(static_cast<const int64_t *>(id_buf.ptr), pc, n);
+}
 
-    return py::array_t<double>(n, corr.data());
+static as::PredictionFilter prediction_filter(const std::string &ticker,
+                                              const std::string &model_version,
+                                              std::optional<int32_t> from_day,
+                                              std::optional<int32_t> to_day) {
+    as::PredictionFilter f;
+    f.ticker = ticker;
+    f.model_version = model_version;
+    if (from_day) {
+        f.from_day = *from_day;
+    }
+    if (to_day) {
+        f.to_day = *to_day;
+    }
+    return f;
+}
+
+static py::dict accuracy_dict(const as::AccuracySummary &s) {
+    static const char *bucket_names[as::kNumConfidenceBuckets] = {"low", "medium", "high"};
+    py::dict d;
+    d["predictions"] = s.predictions;
+    d["total"] = s.all.total;
+    d["correct"] = s.all.correct;
+    for (int b = 0; b < as::kNumConfidenceBuckets; ++b) {
+        py::dict bucket;
+        bucket["count"] = s.buckets[b].total;
+        bucket["correct"] = s.buckets[b].correct;
+        d[bucket_names[b]] = bucket;
+    }
+    return d;
+}
+
+static as::PredictionLog::GroupBy prediction_group(const std::string &group) {
+    if (group == "ticker") {
+        return as::PredictionLog::GroupBy::Ticker;
+    }
+    if (group == "model_version") {
+        return as::PredictionLog::GroupBy::ModelVersion;
+    }
+    if (group == "bucket") {
+        return as::PredictionLog::GroupBy::Bucket;
+    }
+    throw std::invalid_argument("group must be 'ticker', 'model_version' or 'bucket'");
+}
+
+static void bind_prediction_log(py::module_ &m) {
+    py::class_<as::PredictionLog>(m, "PredictionLog")
+        .def(py::init<const std::string &>(),
+             "Columnar mirror of the Predictions table; with a path, appends and outcomes "
+             "are journaled to disk and replayed on open",
+             py::arg("path") = "")
+        .def("append", &prediction_log_append,
+             "Add predictions (int64 ids, tickers, model versions, epoch days, confidence); "
+             "ids already present are skipped. Returns rows added",
+             py::arg("ids"), py::arg("tickers"), py::arg("model_versions"), py::arg("days"),
+             py::arg("confidence"))
+        .def("resolve", &prediction_log_resolve,
+             "Record outcomes (0/1) by prediction id. Returns rows whose outcome changed",
+             py::arg("ids"), py::arg("correct"))
+        .def("accuracy",
+             [](const as::PredictionLog &log, const std::string &ticker,
+                const std::string &model_version, std::optional<int32_t> from_day,
+                std::optional<int32_t> to_day) {
+                 const as::PredictionFilter f =
+                     prediction_filter(ticker, model_version, from_day, to_day);
+                 as::AccuracySummary s;
+                 {
+                     py::gil_scoped_release release;
+                     s = log.accuracy(f);
+                 }
+                 return accuracy_dict(s);
+             },
+             "predictions, total, correct and low/medium/high {count, correct} of the "
+             "matching rows; empty strings match everything, days are inclusive",
+             py::arg("ticker") = "", py::arg("model_version") = "",
+             py::arg("from_day") = py::none(), py::arg("to_day") = py::none())
+        .def("accuracy_by",
+             [](const as::PredictionLog &log, const std::string &group,
+                const std::string &ticker, const std::string &model_version,
+                std::optional<int32_t> from_day, std::optional<int32_t> to_day) {
+                 const as::PredictionLog::GroupBy by = prediction_group(group);
+                 const as::PredictionFilter f =
+                     prediction_filter(ticker, model_version, from_day, to_day);
+                 std::vector<as::GroupAccuracy> groups;
+                 {
+                     py::gil_scoped_release release;
+                     groups = log.accuracy_by(by, f);
+                 }
+                 py::list out;
+                 for (const as::GroupAccuracy &g : groups) {
+                     py::dict d = accuracy_dict(g.summary);
+                     d["key"] = g.key;
+                     out.append(d);
+                 }
+                 return out;
+             },
+             "accuracy() per ticker, model_version or confidence bucket",
+             py::arg("group"), py::arg("ticker") = "", py::arg("model_version") = "",
+             py::arg("from_day") = py::none(), py::arg("to_day") = py::none())
+        .def("rolling_accuracy",
+             [](const as::PredictionLog &log, int32_t window_days, const std::string &ticker,
+                const std::string &model_version, std::optional<int32_t> from_day,
+                std::optional<int32_t> to_day) {
+                 const as::PredictionFilter f =
+                     prediction_filter(ticker, model_version, from_day, to_day);
+                 as::RollingAccuracy r;
+                 {
+                     py::gil_scoped_release release;
+                     r = log.rolling_accuracy(f, window_days);
+                 }
+                 py::dict d;
+                 d["day"] = py::array_t<int32_t>(r.days.size(), r.days.data());
+                 d["total"] = py::array_t<uint64_t>(r.total.size(), r.total.data());
+                 d["correct"] = py::array_t<uint64_t>(r.correct.size(), r.correct.data());
+                 return d;
+             },
+             "Resolved predictions and hits over the window_days days ending at each "
+             "prediction day",
+             py::arg("window_days"), py::arg("ticker") = "", py::arg("model_version") = "",
+             py::arg("from_day") = py::none(), py::arg("to_day") = py::none())
+        .def("__len__", &as::PredictionLog::size)
+        .def("__contains__", &as::PredictionLog::contains, py::arg("id"))
+        .def_property_readonly("last_id", &as::PredictionLog::last_id)
+        .def_property_readonly("min_unresolved_id", &as::PredictionLog::min_unresolved_id)
+        .def("unresolved_ids",
+             [](const as::PredictionLog &log) {
+                 const std::vector<int64_t> ids = log.unresolved_ids();
+                 return py::array_t<int64_t>(ids.size(), ids.data());
+             },
+             "Ids of predictions without an outcome");
+}
+
+// ===== Prediction outcome resolution =====
+
+using DayArray = py::array_t<int32_t, py::array::c_style | py::array::forcecast>;
+using FlagArray = py::array_t<int8_t, py::array::c_style | py::array::forcecast>;
+
+static const int32_t *day_column(const DayArray &a, size_t n, const char *name) {
+    auto buf = a.request();
+    if (buf.ndim != 1 || static_cast<size_t>(buf.size) != n) {
+        throw std::invalid_argument(std::string(name) + " must be 1-D with one entry per row");
+    }
+    return static_cast<const int32_t *>(buf.ptr);
+}
+
+static py::tuple resolve_outcomes(const DayArray &pred_ticker, const DayArray &pred_day,
+                                  const DayArray &target_day, const FlagArray &predicted,
+                                  const OffsetArray &price_offsets, const DayArray &price_day,
+                                  const DoubleArray &close) {
+    size_t n_prices;
+    const double *pc = as_vector(close, n_prices);
+    const size_t n = static_cast<size_t>(pred_ticker.size());
+    as::PredictionRows rows{day_column(pred_ticker, n, "ticker"), day_column(pred_day, n, "day"),
+                            day_column(target_day, n, "target_day"), nullptr, n};
+    auto pbuf = predicted.request();
+    if (pbuf.ndim != 1 || static_cast<size_t>(pbuf.size) != n) {
+        throw std::invalid_argument("predicted must be 1-D with one entry per prediction");
+    }
+    rows.predicted = static_cast<const int8_t *>(pbuf.ptr);
+    const as::PriceTable prices{day_column(price_day, n_prices, "price_day"), pc,
+                                as_batch(price_offsets, n_prices)};
+
+    py::array_t<int8_t> actual(n), correct(n);
+    const as::OutcomeColumns out{actual.mutable_data(), correct.mutable_data()};
+    size_t resolved;
+    {
+        py::gil_scoped_release release;
+        resolved = as::resolve_outcomes(prices, rows, out);
+    }
+    return py::make_tuple(actual, correct, resolved);
+}
+
+static void bind_outcome_resolver(py::module_ &m) {
+    m.def("resolve_outcomes", &resolve_outcomes,
+          "Actual direction (1 UP / 0 DOWN) and correctness of predictions from as-of "
+          "closes on the prediction and target days; -1 where not yet resolvable. "
+          "ticker indexes the price series laid out by price_offsets (-1 = no prices), "
+          "days are epoch days, predicted is 1/0/-1. Returns (actual, correct, n_resolved)",
+          py::arg("ticker"),
+          py::arg("day"),
+          py::arg("target_day"),
+          py::arg("predicted"),
+          py::arg("price_offsets"),
+          py::arg("price_day"),
+          py::arg("close"));
+}
+
+// ===== Private-equity fund performance and PME =====
+
+static py::dict performance_columns(const std::vector<as::PerformanceMetrics> &rows) {
+    const size_t n = rows.size();
+    py::array_t<double> paid_in(n), distributed(n), nav(n), tvpi(n), dpi(n), rvpi(n), irr(n);
+    py::array_t<int32_t> iterations(n);
+    double *p[7] = {paid_in.mutable_data(), distributed.mutable_data(), nav.mutable_data(),
+                    tvpi.mutable_data(),    dpi.mutable_data(),         rvpi.mutable_data(),
+                    irr.mutable_data()};
+    int32_t *it = iterations.mutable_data();
+    for (size_t i = 0; i < n; ++i) {
+        const as::PerformanceMetrics &m = rows[i];
+        p[0][i] = m.paid_in;
+        p[1][i] = m.distributed;
+        p[2][i] = m.nav;
+        p[3][i] = m.tvpi;
+        p[4][i] = m.dpi;
+        p[5][i] = m.rvpi;
+        p[6][i] = m.irr;
+        it[i] = m.iterations;
+    }
+    py::dict d;
+    d["paid_in"] = paid_in;
+    d["distributed"] = distributed;
+    d["nav"] = nav;
+    d["tvpi"] = tvpi;
+    d["dpi"] = dpi;
+    d["rvpi"] = rvpi;
+    d["irr"] = irr;
+    d["iterations"] = iterations;
+    return d;
+}
+
+// Validated views of the deal and cash-flow columns
+static void deal_tables(const OffsetArray &deal_offsets, const DayArray &day,
+                        const DoubleArray &amount, const FlagArray &kind,
+                        const DoubleArray &nav_latest, const DayArray &fund, size_t n_funds,
+                        int32_t as_of_day, int32_t nav_latest_day, as::FlowTable &flows,
+                        as::DealInputs &deals) {
+    size_t n_flows;
+    const double *pa = as_vector(amount, n_flows);
+    auto kbuf = kind.request();
+    if (kbuf.ndim != 1 || static_cast<size_t>(kbuf.size) != n_flows) {
+        throw std::invalid_argument("kind must be 1-D with one entry per cash flow");
+    }
+    flows = as::FlowTable{day_column(day, n_flows, "day"), pa,
+                          static_cast<const int8_t *>(kbuf.ptr), as_batch(deal_offsets, n_flows)};
+    const size_t n_deals = flows.batch.n_series;
+
+    size_t n_nav;
+    deals = as::DealInputs{as_vector(nav_latest, n_nav), day_column(fund, n_deals, "fund"),
+                           nullptr, n_funds, as_of_day, nav_latest_day};
+    if (n_nav != n_deals) {
+        throw std::invalid_argument("nav_latest must have one entry per deal");
+    }
+}
+
+static py::dict fund_performance(const OffsetArray &deal_offsets, const DayArray &day,
+                                 const DoubleArray &amount, const FlagArray &kind,
+                                 const DoubleArray &nav_latest, const DayArray &fund,
+                                 size_t n_funds, int32_t as_of_day, int32_t nav_latest_day,
+                                 const py::object &guess) {
+    as::FlowTable flows;
+    as::DealInputs deals;
+    deal_tables(deal_offsets, day, amount, kind, nav_latest, fund, n_funds, as_of_day,
+                nav_latest_day, flows, deals);
+    DoubleArray seeds;
+    if (!guess.is_none()) {
+        seeds = guess.cast<DoubleArray>();
+        size_t n_seeds;
+        deals.guess = as_vector(seeds, n_seeds);
+        if (n_seeds != flows.batch.n_series) {
+            throw std::invalid_argument("guess must have one entry per deal");
+        }
+    }
+
+    as::PerformanceReport report;
+    {
+        py::gil_scoped_release release;
+        report = as::compute_performance(flows, deals);
+    }
+    py::dict d;
+    d["deals"] = performance_columns(report.deals);
+    d["funds"] = performance_columns(report.funds);
+    return d;
+}
+
+// (n_benchmarks, n) arrays per metric
+static py::dict pme_columns(const std::vector<as::PmeMetrics> &rows, size_t n_benchmarks) {
+    const size_t n = n_benchmarks ? rows.size() / n_benchmarks : 0;
+    std::vector<double> buf(5 * rows.size());
+    double *col[5];
+    for (int c = 0; c < 5; ++c) {
+        col[c] = buf.data() + c * rows.size();
+    }
+    for (size_t i = 0; i < rows.size(); ++i) {
+        col[0][i] = rows[i].fv_contributions;
+        col[1][i] = rows[i].fv_distributions;
+        col[2][i] = rows[i].ks_pme;
+        col[3][i] = rows[i].ln_irr;
+        col[4][i] = rows[i].direct_alpha;
+    }
+    static const char *names[5] = {"fv_contributions", "fv_distributions", "ks_pme", "ln_irr",
+                                   "direct_alpha"};
+    py::dict d;
+    for (int c = 0; c < 5; ++c) {
+        d[names[c]] = to_numpy_2d(col[c], n_benchmarks, n);
+    }
+    return d;
+}
+
+static py::dict public_market_equivalents(const OffsetArray &deal_offsets, const DayArray &day,
+                                          const DoubleArray &amount, const FlagArray &kind,
+                                          const DoubleArray &nav_latest, const DayArray &fund,
+                                          size_t n_funds, int32_t as_of_day,
+                                          int32_t nav_latest_day,
+                                          const OffsetArray &benchmark_offsets,
+                                          const DayArray &benchmark_day,
+                                          const DoubleArray &benchmark_level) {
+    as::FlowTable flows;
+    as::DealInputs deals;
+    deal_tables(deal_offsets, day, amount, kind, nav_latest, fund, n_funds, as_of_day,
+                nav_latest_day, flows, deals);
+    size_t n_levels;
+    const double *pl = as_vector(benchmark_level, n_levels);
+    const as::BenchmarkTable benchmarks{day_column(benchmark_day, n_levels, "benchmark_day"), pl,
+                                        as_batch(benchmark_offsets, n_levels)};
+
+    as::PmeReport report;
+    {
+        py::gil_scoped_release release;
+        report = as::compute_pme(flows, deals, benchmarks);
+    }
+    py::dict d;
+    d["deals"] = pme_columns(report.deals, report.n_benchmarks);
+    d["funds"] = pme_columns(report.funds, report.n_benchmarks);
+    return d;
+}
+
+static void bind_fund_metrics(py::module_ &m) {
+    m.def("xirr", [](const DayArray &day, const DoubleArray &amount, double guess) {
+              size_t n;
+              const double *pa = as_vector(amount, n);
+              const int32_t *pd = day_column(day, n, "day");
+              py::gil_scoped_release release;
+              return as::xirr(pd, pa, n, guess);
+          },
+          "Annualised IRR of signed cash flows (contributions negative) on epoch days; "
+          "NaN when no root exists",
+          py::arg("day"), py::arg("amount"), py::arg("guess") = 0.1);
+
+    m.def("fund_performance", &fund_performance,
+          "Paid-in, distributed, NAV, TVPI/DPI/RVPI and XIRR per deal and per fund. Cash "
+          "flows are laid out by deal_offsets with days ascending, amounts as magnitudes and "
+          "kind 0 contribution / 1 distribution / 2 NAV mark. Flows after as_of_day are "
+          "ignored. nav_latest is the NAV current on nav_latest_day (today); it values the "
+          "residual when as_of_day >= nav_latest_day, otherwise (or where NaN) the last mark "
+          "on or before as_of_day does. fund indexes the fund results (-1 = none); guess holds "
+          "previous deal IRRs to warm-start the solver. Returns {'deals': {...}, 'funds': {...}}",
+          py::arg("deal_offsets"),
+          py::arg("day"),
+          py::arg("amount"),
+          py::arg("kind"),
+          py::arg("nav_latest"),
+          py::arg("fund"),
+          py::arg("n_funds"),
+          py::arg("as_of_day"),
+          py::arg("nav_latest_day"),
+          py::arg("guess") = py::none());
+
+    m.def("public_market_equivalents", &public_market_equivalents,
+          "Kaplan-Schoar PME, Long-Nickels IRR and Direct Alpha of every deal and fund "
+          "against every benchmark, flows compounded by as-of index levels. Deal inputs as "
+          "in fund_performance; benchmark levels (adj_close) are laid out by "
+          "benchmark_offsets with days ascending. Returns {'deals': {...}, 'funds': {...}} "
+          "of (n_benchmarks, n) arrays; NaN where a benchmark has no level for a flow date",
+          py::arg("deal_offsets"),
+          py::arg("day"),
+          py::arg("amount"),
+          py::arg("kind"),
+          py::arg("nav_latest"),
+          py::arg("fund"),
+          py::arg("n_funds"),
+          py::arg("as_of_day"),
+          py::arg("nav_latest_day"),
+          py::arg("benchmark_offsets"),
+          py::arg("benchmark_day"),
+          py::arg("benchmark_level"));
 }
 
 // Pybind11 module definition
@@ -233,4 +2321,25 @@ PYBIND11_MODULE(cpp_indicators, m) {
         .def_readonly("upper", &BollingerBands::upper)
         .def_readonly("middle", &BollingerBands::middle)
         .def_readonly("lower", &BollingerBands::lower);
+
+    bind_regime(m);
+    bind_changepoint(m);
+    bind_matrix_profile(m);
+    bind_dtw(m);
+    bind_pairs(m);
+    bind_leadlag(m);
+    bind_wavelet(m);
+    bind_bars(m);
+    bind_resample(m);
+    bind_corporate_actions(m);
+    bind_returns(m);
+    bind_candles(m);
+    bind_calendar(m);
+    bind_tick_engine(m);
+    bind_universe_state(m);
+    bind_score_batcher(m);
+    bind_kernel_cache(m);
+    bind_prediction_log(m);
+    bind_outcome_resolver(m);
+    bind_fund_metrics(m);
 }
@@ -0,0 +1,355 @@
+#include "kernel_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+
+#include "technical.h"
+
+namespace alphasignal {
+
+namespace {
+
+constexpr uint64_t kPrime32_1 = 0x9E3779B1ULL;
+constexpr uint64_t kPrime64_1 = 0x9E3779B185EBCA87ULL;
+
+// Rows fingerprinted to pick a cache family; appends never change them
+constexpr size_t kHeadRows = 32;
+
+constexpr uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Lane keys, scramble keys and merge keys
+constexpr std::array<uint64_t, 24> make_keys() {
+    std::array<uint64_t, 24> k{};
+    for (size_t i = 0; i < k.size(); ++i) {
+        k[i] = splitmix64(0xA1F5C0DEULL + i);
+    }
+    return k;
+}
+constexpr std::array<uint64_t, 24> kKeys = make_keys();
+
+uint64_t mul_fold64(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    const __uint128_t p = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(p) ^ static_cast<uint64_t>(p >> 64);
+#else
+    const uint64_t a_lo = a & 0xFFFFFFFFULL, a_hi = a >> 32;
+    const uint64_t b_lo = b & 0xFFFFFFFFULL, b_hi = b >> 32;
+    const uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo;
+    const uint64_t lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+    const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFULL) + lo_hi;
+    const uint64_t hi = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    const uint64_t lo = (cross << 32) | (lo_lo & 0xFFFFFFFFULL);
+    return lo ^ hi;
+#endif
+}
+
+uint64_t avalanche(uint64_t h) {
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ULL;
+    return h ^ (h >> 32);
+}
+
+template <size_t L>
+void accumulate(std::array<uint64_t, L> &acc, const uint64_t *v) {
+    for (size_t i = 0; i < L; ++i) {
+        const uint64_t keyed = v[i] ^ kKeys[i];
+        acc[i ^ 1] += v[i];
+        acc[i] += (keyed & 0xFFFFFFFFULL) * (keyed >> 32);
+    }
+}
+
+}  // namespace
+
+// ---- Fingerprint ----
+
+Fingerprint::Fingerprint()
+    : acc_{kPrime32_1,         kPrime64_1, 0xC2B2AE3D27D4EB4FULL, 0x165667B19E3779F9ULL,
+           0x85EBCA77C2B2AE63ULL, 0x27D4EB2F165667C5ULL, 0x9E3779B97F4A7C15ULL,
+           0xD6E8FEB86659FD93ULL},
+      tail_{} {}
+
+void Fingerprint::stripe(const uint64_t *v) {
+    accumulate(acc_, v);
+    if (++stripes_ == kStripesPerBlock) {
+        for (size_t i = 0; i < kLanes; ++i) {
+            uint64_t a = acc_[i];
+            a ^= a >> 47;
+            a ^= kKeys[kLanes + i];
+            acc_[i] = a * kPrime32_1;
+        }
+        stripes_ = 0;
+    }
+}
+
+void Fingerprint::update(const double *x, size_t n) {
+    n_ += n;
+    size_t i = 0;
+    if (tail_len_ > 0) {
+        const size_t take = std::min(n, kLanes - tail_len_);
+        std::memcpy(tail_.data() + tail_len_, x, take * sizeof(double));
+        tail_len_ += take;
+        i = take;
+        if (tail_len_ < kLanes) {
+            return;
+        }
+        stripe(tail_.data());
+        tail_len_ = 0;
+    }
+    uint64_t v[kLanes];
+    for (; i + kLanes <= n; i += kLanes) {
+        std::memcpy(v, x + i, sizeof(v));
+        stripe(v);
+    }
+    tail_len_ = n - i;
+    std::memcpy(tail_.data(), x + i, tail_len_ * sizeof(double));
+}
+
+uint64_t Fingerprint::digest() const {
+    std::array<uint64_t, kLanes> acc = acc_;
+    if (tail_len_ > 0) {
+        std::array<uint64_t, kLanes> last{};
+        std::copy(tail_.begin(), tail_.begin() + tail_len_, last.begin());
+        accumulate(acc, last.data());
+    }
+    uint64_t h = static_cast<uint64_t>(n_) * kPrime64_1;
+    for (size_t i = 0; i < kLanes; i += 2) {
+        h += mul_fold64(acc[i] ^ kKeys[2 * kLanes + i], acc[i + 1] ^ kKeys[2 * kLanes + i + 1]);
+    }
+    return avalanche(h);
+}
+
+// ---- KernelCache ----
+
+size_t KernelCache::Entry::bytes() const {
+    return sizeof(Entry) + outputs.size() * sizeof(double) + 64;  // + list/map nodes
+}
+
+KernelCache::KernelCache(size_t budget_bytes) : budget_(budget_bytes) {}
+
+void KernelCache::rsi(const double *prices, size_t n, int period, double *out) {
+    run(Kernel::Rsi, Params{double(period), 0.0, 0.0}, prices, n, {out},
+        [&](State &s) {
+            RsiState st;
+            alphasignal::rsi(prices, n, period, out, st);
+            s = State{st.avg_gain, st.avg_loss, 0.0};
+            return n > static_cast<size_t>(period);
+        },
+        [&](size_t from, State &s) {
+            RsiState st{s[0], s[1]};
+            rsi_extend(prices, from, n, period, st, out);
+            s = State{st.avg_gain, st.avg_loss, 0.0};
+        });
+}
+
+void KernelCache::macd(const double *prices, size_t n, int fast_period, int slow_period,
+                       int signal_period, double *macd_out, double *signal_out,
+                       double *hist_out) {
+    run(Kernel::Macd, Params{double(fast_period), double(slow_period), double(signal_period)},
+        prices, n, {macd_out, signal_out, hist_out},
+        [&](State &s) {
+            MacdState st;
+            alphasignal::macd(prices, n, fast_period, slow_period, signal_period, macd_out,
+                              signal_out, hist_out, st);
+            s = State{st.ema_fast, st.ema_slow, st.signal};
+            return n >= 1;
+        },
+        [&](size_t from, State &s) {
+            MacdState st{s[0], s[1], s[2]};
+            macd_extend(prices, from, n, fast_period, slow_period, signal_period, st, macd_out,
+                        signal_out, hist_out);
+            s = State{st.ema_fast, st.ema_slow, st.signal};
+        });
+}
+
+void KernelCache::bollinger_bands(const double *prices, size_t n, int period, double num_std,
+                                  double *upper, double *middle, double *lower) {
+    run(Kernel::Bollinger, Params{double(period), num_std, 0.0}, prices, n,
+        {upper, middle, lower},
+        [&](State &) {
+            alphasignal::bollinger_bands(prices, n, period, num_std, upper, middle, lower);
+            return true;
+        },
+        [&](size_t from, State &) {
+            bollinger_bands_extend(prices, from, n, period, num_std, upper, middle, lower);
+        });
+}
+
+template <class Compute, class Extend>
+void KernelCache::run(Kernel kernel, const Params &params, const double *prices, size_t n,
+                      std::initializer_list<double *> outs_list, Compute compute,
+                      Extend extend) {
+    const std::vector<double *> outs(outs_list);
+    if (n == 0) {
+        State unused;
+        compute(unused);
+        return;
+    }
+
+    uint64_t family = fingerprint(prices, std::min(n, kHeadRows));
+    family = splitmix64(family ^ static_cast<uint64_t>(kernel));
+    for (double p : params) {
+        uint64_t bits;
+        std::memcpy(&bits, &p, sizeof(bits));
+        family = splitmix64(family ^ bits);
+    }
+
+    uint64_t hash = 0;
+    const Found found = lookup(kernel, params, family, prices, n, hash, outs);
+    if (found.rows == n) {
+        return;
+    }
+
+    Entry entry{};
+    entry.state = found.state;
+    if (found.rows > 0) {
+        extend(found.rows, entry.state);
+        entry.resumable = true;
+    } else {
+        entry.resumable = compute(entry.state);
+    }
+    entry.kernel = kernel;
+    entry.params = params;
+    entry.family = family;
+    entry.n = n;
+    entry.hash = hash;
+    entry.last = prices[n - 1];
+    entry.outputs.resize(outs.size() * n);
+    for (size_t k = 0; k < outs.size(); ++k) {
+        std::copy(outs[k], outs[k] + n, entry.outputs.begin() + k * n);
+    }
+    insert(std::move(entry), found.id);
+}
+
+KernelCache::Found KernelCache::lookup(Kernel kernel, const Params &params, uint64_t family,
+                                       const double *prices, size_t n, uint64_t &hash,
+                                       const std::vector<double *> &outs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<EntryList::iterator> candidates;
+    const auto fam = families_.find(family);
+    if (fam != families_.end()) {
+        for (EntryList::iterator it : fam->second) {
+            if (it->kernel == kernel && it->params == params && it->n <= n) {
+                candidates.push_back(it);
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](EntryList::iterator a, EntryList::iterator b) { return a->n < b->n; });
+
+    // One pass over the input yields the fingerprint of every candidate's prefix
+    Fingerprint fp;
+    EntryList::iterator best = lru_.end();
+    for (EntryList::iterator it : candidates) {
+        fp.update(prices + fp.size(), it->n - fp.size());
+        if (fp.digest() != it->hash ||
+            std::memcmp(&prices[it->n - 1], &it->last, sizeof(double)) != 0) {
+            continue;
+        }
+        if (it->n == n || it->resumable) {
+            best = it;
+        }
+    }
+    fp.update(prices + fp.size(), n - fp.size());
+    hash = fp.digest();
+
+    Found found;
+    if (best == lru_.end()) {
+        ++stats_.misses;
+        return found;
+    }
+    for (size_t k = 0; k < outs.size(); ++k) {
+        const auto src = best->outputs.begin() + k * best->n;
+        std::copy(src, src + best->n, outs[k]);
+    }
+    found.rows = best->n;
+    found.id = best->id;
+    found.state = best->state;
+    lru_.splice(lru_.begin(), lru_, best);
+    if (best->n == n) {
+        ++stats_.hits;
+    } else {
+        ++stats_.extensions;
+    }
+    return found;
+}
+
+void KernelCache::insert(Entry entry, uint64_t replaces) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto fam = families_.find(entry.family);
+    if (fam != families_.end()) {
+        EntryList::iterator superseded = lru_.end();
+        for (EntryList::iterator it : fam->second) {
+            if (it->kernel == entry.kernel && it->params == entry.params &&
+                it->n == entry.n && it->hash == entry.hash) {
+                return;  // another thread got there first
+            }
+            if (it->id == replaces) {
+                superseded = it;
+            }
+        }
+        if (superseded != lru_.end()) {
+            erase(superseded);  // the extended entry takes its place
+        }
+    }
+    const size_t bytes = entry.bytes();
+    if (bytes > budget_) {
+        return;
+    }
+    entry.id = next_id_++;
+    lru_.push_front(std::move(entry));
+    families_[lru_.front().family].push_back(lru_.begin());
+    bytes_ += bytes;
+    evict_to(budget_);
+}
+
+void KernelCache::erase(EntryList::iterator it) {
+    auto fam = families_.find(it->family);
+    if (fam != families_.end()) {
+        auto &v = fam->second;
+        v.erase(std::remove(v.begin(), v.end(), it), v.end());
+        if (v.empty()) {
+            families_.erase(fam);
+        }
+    }
+    bytes_ -= it->bytes();
+    lru_.erase(it);
+}
+
+void KernelCache::evict_to(size_t budget) {
+    while (bytes_ > budget && !lru_.empty()) {
+        erase(std::prev(lru_.end()));
+        ++stats_.evictions;
+    }
+}
+
+KernelCacheStats KernelCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    KernelCacheStats s = stats_;
+    s.entries = lru_.size();
+    s.bytes = bytes_;
+    s.budget_bytes = budget_;
+    return s;
+}
+
+void KernelCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lru_.clear();
+    families_.clear();
+    bytes_ = 0;
+}
+
+void KernelCache::set_budget(size_t budget_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budget_ = budget_bytes;
+    evict_to(budget_);
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace alphasignal {
+
+// Streaming 64-bit fingerprint of a double buffer, in the style of XXH3:
+// eight independent 64-bit accumulators per 64-byte stripe (each a 32x32
+// multiply of the keyed input plus the neighbouring lane's input), so the
+// stripe loop vectorises, with a scramble every 1 KiB block and an
+// avalanche at the end. Not bit-compatible with XXH3 itself. digest() of a
+// prefix equals the one-shot hash of that prefix, which is what lets the
+// cache recognise appended series.
+class Fingerprint {
+public:
+    Fingerprint();
+
+    void update(const double *x, size_t n);
+    uint64_t digest() const;
+    size_t size() const { return n_; }
+
+private:
+    static constexpr size_t kLanes = 8;
+    static constexpr size_t kStripesPerBlock = 16;
+
+    void stripe(const uint64_t *v);
+
+    std::array<uint64_t, kLanes> acc_;
+    std::array<uint64_t, kLanes> tail_;
+    size_t tail_len_ = 0;
+    size_t stripes_ = 0;  // within the current block
+    size_t n_ = 0;
+};
+
+inline uint64_t fingerprint(const double *x, size_t n) {
+    Fingerprint f;
+    f.update(x, n);
+    return f.digest();
+}
+
+struct KernelCacheStats {
+    uint64_t hits = 0;       // exact repeat of an earlier input
+    uint64_t extensions = 0; // earlier input plus appended rows; only the new rows computed
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+    size_t budget_bytes = 0;
+};
+
+// Memoises RSI / MACD / Bollinger results by input fingerprint and kernel
+// parameters, under a byte budget with least-recently-used eviction. An
+// input that extends a cached one (same prefix, more rows) reuses the
+// cached rows and resumes the kernel from its saved state; the extended
+// result replaces the shorter entry. Results are identical to the uncached
+// kernels in technical.h. Thread-safe; kernels run outside the lock.
+class KernelCache {
+public:
+    explicit KernelCache(size_t budget_bytes);
+
+    void rsi(const double *prices, size_t n, int period, double *out);
+    void macd(const double *prices, size_t n, int fast_period, int slow_period, int signal_period,
+              double *macd_out, double *signal_out, double *hist_out);
+    void bollinger_bands(const double *prices, size_t n, int period, double num_std,
+                         double *upper, double *middle, double *lower);
+
+    KernelCacheStats stats() const;
+    void clear();
+    // Evicts down to the new budget at once
+    void set_budget(size_t budget_bytes);
+
+private:
+    enum class Kernel : uint8_t { Rsi, Macd, Bollinger };
+    using Params = std::array<double, 3>;
+    using State = std::array<double, 3>;
+
+    struct Entry {
+        uint64_t id;
+        Kernel kernel;
+        Params params;
+        uint64_t family;
+        size_t n;
+        uint64_t hash;
+        double last;  // cheap guard against fingerprint collisions
+        bool resumable;
+        State state;
+        std::vector<double> outputs;  // n_outputs blocks of n rows
+        size_t bytes() const;
+    };
+    using EntryList = std::list<Entry>;
+
+    // What lookup() found: the rows to copy, and where to resume from
+    struct Found {
+        size_t rows = 0;  // 0 = miss
+        uint64_t id = 0;
+        State state{};
+    };
+
+    template <class Compute, class Extend>
+    void run(Kernel kernel, const Params &params, const double *prices, size_t n,
+             std::initializer_list<double *> outs, Compute compute, Extend extend);
+
+    Found lookup(Kernel kernel, const Params &params, uint64_t family, const double *prices,
+                 size_t n, uint64_t &hash, const std::vector<double *> &outs);
+    void insert(Entry entry, uint64_t replaces);
+    void erase(EntryList::iterator it);
+    void evict_to(size_t budget);
+
+    mutable std::mutex mutex_;
+    size_t budget_;
+    size_t bytes_ = 0;
+    uint64_t next_id_ = 1;
+    EntryList lru_;  // most recent first
+    std::unordered_map<uint64_t, std::vector<EntryList::iterator>> families_;
+    KernelCacheStats stats_;
+};
+
+}  // namespace alphasignal
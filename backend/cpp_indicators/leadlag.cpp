@@ -0,0 +1,278 @@
+#include "leadlag.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "arena.h"
+#include "batch.h"
+#include "fft.h"
+#include "thread_pool.h"
+
+namespace alphasignal {
+
+namespace {
+
+// Sliding-DFT updates between exact FFT refreshes; bounds round-off drift
+constexpr size_t kRefresh = 64;
+constexpr double kTwoPi = 6.283185307179586476925286766559;
+
+inline double value(double x) { return is_missing(x) ? 0.0 : x; }
+
+// Spectra of two real, zero-padded windows from one complex FFT:
+// z = a + i b, A_k = (Z_k + conj(Z_{N-k})) / 2, B_k = (Z_k - conj(Z_{N-k})) / 2i
+void paired_spectra(const double *a, const double *b, size_t stride, size_t w,
+                    const FFTPlan &plan, Complex *spec_a, Complex *spec_b,
+                    std::vector<Complex> &z) {
+    const size_t n = plan.size();
+    z.assign(n, Complex(0.0, 0.0));
+    for (size_t t = 0; t < w; ++t) {
+        z[t] = Complex(value(a[t * stride]), b ? value(b[t * stride]) : 0.0);
+    }
+    plan.forward(z.data());
+    for (size_t k = 0; k < n; ++k) {
+        const Complex zk = z[k];
+        const Complex zr = std::conj(z[(n - k) & (n - 1)]);
+        spec_a[k] = 0.5 * (zk + zr);
+        if (spec_b) {
+            spec_b[k] = Complex(0.0, -0.5) * (zk - zr);
+        }
+    }
+}
+
+struct Moments {
+    double mean = 0.0;
+    double norm = 0.0;  // ||x - mean|| over the window
+};
+
+Moments window_moments(const double *x, size_t stride, size_t w) {
+    double sum = 0.0;
+    for (size_t t = 0; t < w; ++t) {
+        sum += value(x[t * stride]);
+    }
+    Moments m;
+    m.mean = sum / static_cast<double>(w);
+    double ss = 0.0;
+    for (size_t t = 0; t < w; ++t) {
+        const double d = value(x[t * stride]) - m.mean;
+        ss += d * d;
+    }
+    m.norm = std::sqrt(ss);
+    return m;
+}
+
+// Correlation of two demeaned windows at lags -max_lag..max_lag, packing
+// two pairs into one inverse FFT (their cross-correlations are real):
+// IFFT(C1 + i C2) = r1 + i r2 with C = conj(X~) Y~ and X~ = X - mean * D
+class CrossSpectrum {
+public:
+    CrossSpectrum(const FFTPlan &plan, const std::vector<Complex> &box)
+        : plan_(plan), box_(box), z_(plan.size()) {}
+
+    struct Input {
+        const Complex *x;
+        const Complex *y;
+        Moments mx;
+        Moments my;
+    };
+
+    // Writes r(k) for the first pair to out1[k + max_lag], likewise out2
+    // (second pair optional)
+    void correlate(const Input &p1, const Input *p2, int max_lag, double *out1, double *out2) {
+        const size_t n = plan_.size();
+        for (size_t k = 0; k < n; ++k) {
+            Complex c = cross(p1, k);
+            if (p2) {
+                c += Complex(0.0, 1.0) * cross(*p2, k);
+            }
+            z_[k] = c;
+        }
+        plan_.inverse(z_.data());
+        write(z_, p1, max_lag, out1, false);
+        if (p2) {
+            write(z_, *p2, max_lag, out2, true);
+        }
+    }
+
+private:
+    Complex cross(const Input &p, size_t k) const {
+        const Complex xk = p.x[k] - p.mx.mean * box_[k];
+        const Complex yk = p.y[k] - p.my.mean * box_[k];
+        return std::conj(xk) * yk;
+    }
+
+    void write(const std::vector<Complex> &z, const Input &p, int max_lag, double *out,
+               bool imag) const {
+        const size_t n = plan_.size();
+        const double denom = p.mx.norm * p.my.norm;
+        const double scale = denom > 0.0 ? 1.0 / denom : 0.0;
+        for (int k = -max_lag; k <= max_lag; ++k) {
+            const Complex v = z[k >= 0 ? static_cast<size_t>(k) : n - static_cast<size_t>(-k)];
+            out[k + max_lag] = (imag ? v.imag() : v.real()) * scale;
+        }
+    }
+
+    const FFTPlan &plan_;
+    const std::vector<Complex> &box_;
+    std::vector<Complex> z_;
+};
+
+// Spectrum of the indicator of [0, w): lets windows be demeaned in the
+// frequency domain
+std::vector<Complex> box_spectrum(const FFTPlan &plan, size_t w) {
+    std::vector<Complex> box(plan.size(), Complex(0.0, 0.0));
+    std::fill(box.begin(), box.begin() + w, Complex(1.0, 0.0));
+    plan.forward(box.data());
+    return box;
+}
+
+// Peak by |r|, scanning lags by increasing |k| so ties go to the shorter lag
+void find_peak(const double *r, int max_lag, int64_t &lag, double &corr) {
+    lag = 0;
+    corr = r[max_lag];
+    for (int d = 1; d <= max_lag; ++d) {
+        for (int k : {-d, d}) {
+            if (std::fabs(r[k + max_lag]) > std::fabs(corr)) {
+                corr = r[k + max_lag];
+                lag = k;
+            }
+        }
+    }
+}
+
+}  // namespace
+
+void cross_correlation(const double *x, const double *y, size_t n, int max_lag, double *out) {
+    if (max_lag < 0 || static_cast<size_t>(max_lag) >= n) {
+        throw std::invalid_argument("max_lag must be in [0, n)");
+    }
+    const FFTPlan plan(next_pow2(n + max_lag));
+    const std::vector<Complex> box = box_spectrum(plan, n);
+    std::vector<Complex> sx(plan.size()), sy(plan.size()), z;
+    paired_spectra(x, y, 1, n, plan, sx.data(), sy.data(), z);
+    CrossSpectrum cs(plan, box);
+    const CrossSpectrum::Input in{sx.data(), sy.data(), window_moments(x, 1, n),
+                                  window_moments(y, 1, n)};
+    cs.correlate(in, nullptr, max_lag, out, nullptr);
+}
+
+LeadLagScan lead_lag_scan(const double *panel, size_t n_obs, size_t n_series,
+                          const int64_t *pairs, size_t n_pairs, const LeadLagOptions &opts) {
+    const size_t w = opts.window ? opts.window : n_obs;
+    const size_t step = opts.step ? opts.step : w;
+    const int max_lag = opts.max_lag;
+    if (w < 2 || w > n_obs) {
+        throw std::invalid_argument("window must be between 2 and the number of rows");
+    }
+    if (max_lag < 0 || static_cast<size_t>(max_lag) >= w) {
+        throw std::invalid_argument("max_lag must be in [0, window)");
+    }
+
+    // Series referenced by at least one pair get a spectrum slot
+    ArenaScope scope;
+    ScratchVector<int64_t> slot_of = scratch<int64_t>(n_series, -1);
+    ScratchVector<size_t> used = scratch<size_t>(0);
+    used.reserve(std::min(n_series, 2 * n_pairs));
+    for (size_t p = 0; p < 2 * n_pairs; ++p) {
+        const int64_t id = pairs[p];
+        if (id < 0 || static_cast<size_t>(id) >= n_series) {
+            throw std::invalid_argument("pair index out of range");
+        }
+        if (slot_of[id] < 0) {
+            slot_of[id] = static_cast<int64_t>(used.size());
+            used.push_back(static_cast<size_t>(id));
+        }
+    }
+
+    LeadLagScan scan;
+    scan.n_pairs = n_pairs;
+    for (size_t end = w - 1; end < n_obs; end += step) {
+        scan.window_end.push_back(static_cast<int64_t>(end));
+    }
+    scan.n_windows = scan.window_end.size();
+    scan.peak_lag.assign(n_pairs * scan.n_windows, 0);
+    scan.peak_corr.assign(n_pairs * scan.n_windows, 0.0);
+    if (n_pairs == 0) {
+        return scan;
+    }
+
+    const FFTPlan plan(next_pow2(w + max_lag));
+    const size_t nfft = plan.size();
+    const std::vector<Complex> box = box_spectrum(plan, w);
+    const size_t n_used = used.size();
+    ScratchVector<Complex> spectra = scratch<Complex>(n_used * nfft);
+    ScratchVector<Moments> moments = scratch<Moments>(n_used);
+
+    // Sliding DFT of a zero-padded window moved forward by one row:
+    //   X'_k = e^{+2 pi i k / N} (X_k - x_old) + x_new e^{-2 pi i k (W - 1) / N}
+    ScratchVector<Complex> rotate = scratch<Complex>(opts.sliding ? nfft : 0);
+    ScratchVector<Complex> entry = scratch<Complex>(opts.sliding ? nfft : 0);
+    if (opts.sliding) {
+        for (size_t k = 0; k < nfft; ++k) {
+            const double a = kTwoPi * static_cast<double>(k) / static_cast<double>(nfft);
+            rotate[k] = Complex(std::cos(a), std::sin(a));
+            const double b = -a * static_cast<double>(w - 1);
+            entry[k] = Complex(std::cos(b), std::sin(b));
+        }
+    }
+
+    size_t since_refresh = 0;
+    for (size_t win = 0; win < scan.n_windows; ++win) {
+        const size_t start = static_cast<size_t>(scan.window_end[win]) + 1 - w;
+        const bool exact = !opts.sliding || win == 0 || since_refresh + step > kRefresh;
+
+        if (exact) {
+            parallel_for((n_used + 1) / 2, [&](size_t j) {
+                thread_local std::vector<Complex> z;
+                const size_t a = 2 * j, b = a + 1;
+                const double *col_b = b < n_used ? panel + start * n_series + used[b] : nullptr;
+                paired_spectra(panel + start * n_series + used[a], col_b, n_series, w, plan,
+                               &spectra[a * nfft], col_b ? &spectra[b * nfft] : nullptr, z);
+            });
+            since_refresh = 0;
+        } else {
+            const size_t prev = start - step;
+            parallel_for(n_used, [&](size_t u) {
+                Complex *x = &spectra[u * nfft];
+                const double *col = panel + used[u];
+                for (size_t s = 0; s < step; ++s) {
+                    const double x_old = value(col[(prev + s) * n_series]);
+                    const double x_new = value(col[(prev + s + w) * n_series]);
+                    for (size_t k = 0; k < nfft; ++k) {
+                        x[k] = rotate[k] * (x[k] - x_old) + x_new * entry[k];
+                    }
+                }
+            });
+            since_refresh += step;
+        }
+
+        parallel_for(n_used, [&](size_t u) {
+            moments[u] = window_moments(panel + start * n_series + used[u], n_series, w);
+        });
+
+        parallel_for((n_pairs + 1) / 2, [&](size_t j) {
+            thread_local std::vector<double> r;
+            r.resize(2 * (2 * max_lag + 1));
+            CrossSpectrum cs(plan, box);
+            CrossSpectrum::Input in[2];
+            const size_t p0 = 2 * j;
+            const size_t count = std::min<size_t>(2, n_pairs - p0);
+            for (size_t q = 0; q < count; ++q) {
+                const size_t sx = static_cast<size_t>(slot_of[pairs[2 * (p0 + q)]]);
+                const size_t sy = static_cast<size_t>(slot_of[pairs[2 * (p0 + q) + 1]]);
+                in[q] = {&spectra[sx * nfft], &spectra[sy * nfft], moments[sx], moments[sy]};
+            }
+            double *r1 = r.data();
+            double *r2 = r1 + 2 * max_lag + 1;
+            cs.correlate(in[0], count == 2 ? &in[1] : nullptr, max_lag, r1, r2);
+            for (size_t q = 0; q < count; ++q) {
+                const size_t idx = (p0 + q) * scan.n_windows + win;
+                find_peak(q == 0 ? r1 : r2, max_lag, scan.peak_lag[idx], scan.peak_corr[idx]);
+            }
+        });
+    }
+    return scan;
+}
+
+}  // namespace alphasignal
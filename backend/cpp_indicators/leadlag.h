@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace alphasignal {
+
+// Lead-lag cross-correlation via FFT. For a window of length W the series
+// are demeaned, zero-padded to a power of two >= W + max_lag and
+// correlated in the frequency domain:
+//   r(k) = sum_t x~_t y~_{t+k} / (||x~|| ||y~||),  k in [-max_lag, max_lag]
+// (the biased estimator, as in statsmodels' ccf). Positive k means x leads
+// y by k bars. NaNs are read as 0, so pass returns or signals, not prices.
+struct LeadLagOptions {
+    int max_lag = 10;
+    size_t window = 0;     // rows per window; 0 uses the whole series once
+    size_t step = 0;       // rows between window ends; 0 means step = window
+    bool sliding = false;  // advance spectra with a sliding DFT, O(nfft) per row,
+                           // instead of a fresh FFT per window (for small steps)
+};
+
+// out has 2 * max_lag + 1 entries, out[k + max_lag] = r(k)
+void cross_correlation(const double *x, const double *y, size_t n, int max_lag, double *out);
+
+struct LeadLagScan {
+    size_t n_pairs = 0;
+    size_t n_windows = 0;
+    std::vector<int64_t> window_end;  // last row of each window
+    std::vector<int64_t> peak_lag;    // n_pairs x n_windows, lag with the largest |r|
+    std::vector<double> peak_corr;    // signed r at that lag
+};
+
+// panel is row-major (n_obs x n_series); pairs holds n_pairs (x, y) column
+// indices. Spectra are computed once per series and window and shared by
+// every pair that uses the series; pairs run in parallel.
+LeadLagScan lead_lag_scan(const double *panel, size_t n_obs, size_t n_series,
+                          const int64_t *pairs, size_t n_pairs,
+                          const LeadLagOptions &opts = LeadLagOptions());
+
+}  // namespace alphasignal
@@ -0,0 +1,188 @@
+// alphasignal_loadgen: closed-loop load generator for alphasignal_server.
+// Each connection runs on its own thread and keeps one request in flight;
+// prints throughput and latency percentiles over all requests.
+//
+//   alphasignal_loadgen [--socket PATH] [--connections N] [--requests N]
+//                       [--tickers N] [--bars N] [--features N]
+//                       [--op indicators|score|ping]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client.h"
+
+using namespace alphasignal;
+
+namespace {
+
+struct LoadOptions {
+    std::string socket_path = "/tmp/alphasignal.sock";
+    int connections = 4;
+    int requests = 1000;  // per connection
+    int tickers = 50;     // series (or rows) per request
+    int bars = 250;
+    int features = 32;    // score rows; must match the served model
+    Op op = Op::Indicators;
+};
+
+void usage(const char *prog) {
+    std::fprintf(stderr,
+                 "usage: %s [--socket PATH] [--connections N] [--requests N] [--tickers N]\n"
+                 "          [--bars N] [--features N] [--op indicators|score|ping]\n",
+                 prog);
+}
+
+IndicatorRequest make_indicator_request(const LoadOptions &opts, std::mt19937_64 &rng) {
+    std::normal_distribution<double> step(0.0, 0.01);
+    IndicatorRequest req;
+    req.feature_mask = (1u << kNumServiceFeatures) - 1;
+    req.last_only = true;
+    req.tickers.resize(opts.tickers);
+    req.closes.resize(opts.tickers);
+    for (int s = 0; s < opts.tickers; ++s) {
+        req.tickers[s] = s;
+        std::vector<double> &close = req.closes[s];
+        close.resize(opts.bars);
+        double p = 100.0;
+        for (double &c : close) {
+            p *= std::exp(step(rng));
+            c = p;
+        }
+    }
+    return req;
+}
+
+ScoreRequest make_score_request(const LoadOptions &opts, std::mt19937_64 &rng) {
+    std::normal_distribution<double> value(0.0, 1.0);
+    ScoreRequest req;
+    req.n_rows = static_cast<uint32_t>(opts.tickers);
+    req.n_features = static_cast<uint32_t>(opts.features);
+    req.tickers.resize(req.n_rows);
+    req.rows.resize(size_t{req.n_rows} * req.n_features);
+    for (uint32_t r = 0; r < req.n_rows; ++r) {
+        req.tickers[r] = static_cast<int32_t>(r);
+    }
+    for (double &v : req.rows) {
+        v = value(rng);
+    }
+    return req;
+}
+
+double percentile(const std::vector<double> &sorted, double q) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const size_t i = static_cast<size_t>(q * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    LoadOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        const char *val = argv[++i];
+        if (arg == "--socket") {
+            opts.socket_path = val;
+        } else if (arg == "--connections") {
+            opts.connections = std::max(1, std::atoi(val));
+        } else if (arg == "--requests") {
+            opts.requests = std::max(1, std::atoi(val));
+        } else if (arg == "--tickers") {
+            opts.tickers = std::max(1, std::atoi(val));
+        } else if (arg == "--bars") {
+            opts.bars = std::max(1, std::atoi(val));
+        } else if (arg == "--features") {
+            opts.features = std::max(1, std::atoi(val));
+        } else if (arg == "--op") {
+            const std::string op = val;
+            if (op == "indicators") {
+                opts.op = Op::Indicators;
+            } else if (op == "score") {
+                opts.op = Op::Score;
+            } else if (op == "ping") {
+                opts.op = Op::Ping;
+            } else {
+                usage(argv[0]);
+                return 2;
+            }
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<std::vector<double>> latencies(opts.connections);  // microseconds
+    std::vector<std::string> errors(opts.connections);
+    std::vector<std::thread> threads;
+
+    const auto t0 = Clock::now();
+    for (int c = 0; c < opts.connections; ++c) {
+        threads.emplace_back([&, c] {
+            try {
+                std::mt19937_64 rng(1234 + c);
+                IndicatorClient client(opts.socket_path);
+                // One payload per connection keeps request building out of the timings
+                std::vector<uint8_t> payload;
+                if (opts.op == Op::Indicators) {
+                    encode_indicator_request(make_indicator_request(opts, rng), payload);
+                } else if (opts.op == Op::Score) {
+                    encode_score_request(make_score_request(opts, rng), payload);
+                }
+                std::vector<double> &lat = latencies[c];
+                lat.reserve(opts.requests);
+                for (int r = 0; r < opts.requests; ++r) {
+                    const auto start = Clock::now();
+                    const std::vector<uint8_t> body = client.call(opts.op, payload);
+                    lat.push_back(
+                        std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+                    WireReader in(body.data(), body.size());
+                    check_status(in);
+                }
+            } catch (const std::exception &e) {
+                errors[c] = e.what();
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    for (int c = 0; c < opts.connections; ++c) {
+        if (!errors[c].empty()) {
+            std::fprintf(stderr, "connection %d: %s\n", c, errors[c].c_str());
+        }
+    }
+    std::vector<double> all;
+    for (const auto &lat : latencies) {
+        all.insert(all.end(), lat.begin(), lat.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    std::printf("requests:    %zu in %.3f s\n", all.size(), elapsed);
+    std::printf("throughput:  %.0f req/s (%.0f series/s)\n", all.size() / elapsed,
+                opts.op == Op::Ping ? 0.0 : all.size() * opts.tickers / elapsed);
+    std::printf("latency us:  p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n", percentile(all, 0.50),
+                percentile(all, 0.90), percentile(all, 0.99), all.empty() ? 0.0 : all.back());
+    for (const auto &e : errors) {
+        if (!e.empty()) {
+            return 1;
+        }
+    }
+    return 0;
+}
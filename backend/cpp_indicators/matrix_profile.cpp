@@ -0,0 +1,575 @@
+#include "matrix_profile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+#include "arena.h"
+#include "batch.h"
+#include "thread_pool.h"
+
+namespace alphasignal {
+
+namespace {
+
+// Adjacent diagonals processed together; one row of a tile touches kLanes
+// contiguous columns, which the compiler turns into SIMD loads and blends
+constexpr int kLanes = 16;
+
+// Added to the correlation of any pair involving a window that holds a
+// missing value: far below the -2 an accumulator starts from, so such
+// pairs never become anyone's neighbour
+constexpr double kMasked = -4.0;
+
+// Per-window statistics for the MPX covariance recurrence. Arrays are
+// padded so a tile can advance one row past its end without bounds checks.
+// Missing values enter x as 0, which keeps the recurrence finite; windows
+// that contain one are masked through `bias`.
+// Lives on the calling thread's arena.
+struct WindowStats {
+    ScratchVector<double> x{&thread_arena()};  // series shifted by its global mean
+    ScratchVector<double> mu{&thread_arena()};
+    ScratchVector<double> invn{&thread_arena()};  // 1 / ||window - mu||, 0 for flat or masked
+    ScratchVector<double> bias{&thread_arena()};  // 0, or kMasked for windows with a missing value
+    ScratchVector<double> df{&thread_arena()};
+    ScratchVector<double> dg{&thread_arena()};
+    size_t n_sub = 0;
+    bool masked = false;  // any window masked
+
+    bool valid(size_t i) const { return bias[i] == 0.0; }
+};
+
+WindowStats window_stats(const double *t, size_t n, int m) {
+    WindowStats s;
+    s.n_sub = n - m + 1;
+    double total = 0.0;
+    size_t n_valid = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!is_missing(t[i])) {
+            total += t[i];
+            ++n_valid;
+        }
+    }
+    const double global_mean = n_valid > 0 ? total / n_valid : 0.0;
+    s.x.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        s.x[i] = is_missing(t[i]) ? 0.0 : t[i] - global_mean;
+    }
+
+    const size_t padded = s.n_sub + kLanes + 1;
+    s.mu.assign(padded, 0.0);
+    s.invn.assign(padded, 0.0);
+    s.bias.assign(padded, 0.0);
+    s.df.assign(padded, 0.0);
+    s.dg.assign(padded, 0.0);
+
+    // Extended-precision running sums; recentring above keeps them small
+    long double sum = 0.0L, sum2 = 0.0L, global_ss = 0.0L;
+    for (size_t i = 0; i < n; ++i) {
+        global_ss += static_cast<long double>(s.x[i]) * s.x[i];
+    }
+    const long double flat = 1e-12L * (global_ss / std::max<size_t>(n_valid, 1)) * m;
+    size_t missing = 0;
+    for (int l = 0; l < m; ++l) {
+        sum += s.x[l];
+        sum2 += static_cast<long double>(s.x[l]) * s.x[l];
+        missing += is_missing(t[l]);
+    }
+    for (size_t i = 0;; ++i) {
+        const long double mean = sum / m;
+        const long double ss = sum2 - sum * mean;
+        s.mu[i] = static_cast<double>(mean);
+        if (missing > 0) {
+            s.bias[i] = kMasked;
+            s.masked = true;
+        } else if (ss > flat) {
+            s.invn[i] = static_cast<double>(1.0L / std::sqrt(ss));
+        }
+        if (i + 1 == s.n_sub) {
+            break;
+        }
+        const double out = s.x[i], in = s.x[i + m];
+        sum += in - out;
+        sum2 += static_cast<long double>(in) * in - static_cast<long double>(out) * out;
+        missing += is_missing(t[i + m]);
+        missing -= is_missing(t[i]);
+    }
+
+    for (size_t i = 1; i < s.n_sub; ++i) {
+        s.df[i] = 0.5 * (s.x[i + m - 1] - s.x[i - 1]);
+        s.dg[i] = (s.x[i + m - 1] - s.mu[i]) + (s.x[i - 1] - s.mu[i - 1]);
+    }
+    return s;
+}
+
+double direct_cov(const WindowStats &a, size_t i, const WindowStats &b, size_t j, int m) {
+    double c = 0.0;
+    for (int l = 0; l < m; ++l) {
+        c += (a.x[i + l] - a.mu[i]) * (b.x[j + l] - b.mu[j]);
+    }
+    return c;
+}
+
+// Best Pearson correlation seen so far for windows [begin, begin + n) of
+// one side of the join, on the calling thread's arena
+struct ProfileAcc {
+    int64_t begin;
+    ScratchVector<double> corr;
+    ScratchVector<int64_t> index;
+
+    ProfileAcc(int64_t begin, size_t n)
+        : begin(begin), corr(scratch<double>(n + kLanes + 1, -2.0)),
+          index(scratch<int64_t>(n + kLanes + 1, -1)) {}
+
+    double &corr_at(int64_t i) { return corr[i - begin]; }
+    int64_t &index_at(int64_t i) { return index[i - begin]; }
+
+    // Higher correlation wins, ties go to the lower index, so the result
+    // does not depend on the order partial accumulators are merged in
+    void merge(const ProfileAcc &other, int64_t lo, int64_t hi) {
+        for (int64_t i = lo; i < hi; ++i) {
+            const double c = other.corr[i - other.begin];
+            const int64_t j = other.index[i - other.begin];
+            double &mine = corr_at(i);
+            if (j >= 0 && (c > mine || (c == mine && j < index_at(i)))) {
+                mine = c;
+                index_at(i) = j;
+            }
+        }
+    }
+};
+
+// Walks tiles of kLanes adjacent diagonals j = i + k. Rows of `a` update
+// `rows`, columns of `b` update `cols`.
+struct DiagonalWalker {
+    const WindowStats &a;
+    const WindowStats &b;
+    int m;
+
+    void visit(size_t i, size_t j, double cov, ProfileAcc &rows, ProfileAcc &cols) const {
+        const double corr = cov * a.invn[i] * b.invn[j] + a.bias[i] + b.bias[j];
+        if (corr > rows.corr_at(i)) {
+            rows.corr_at(i) = corr;
+            rows.index_at(i) = static_cast<int64_t>(j);
+        }
+        if (corr > cols.corr_at(j)) {
+            cols.corr_at(j) = corr;
+            cols.index_at(j) = static_cast<int64_t>(i);
+        }
+    }
+
+    double advance(size_t i, size_t j, double cov) const {
+        return cov + a.df[i + 1] * b.dg[j + 1] + b.df[j + 1] * a.dg[i + 1];
+    }
+
+    // One row of a full tile; restrict lets the lane loop become straight SIMD.
+    // Returns the row's best correlation across the lanes. The bias terms
+    // are only read when either side has masked windows.
+    template <bool kBiased>
+    static double body_row(int64_t i, double inva, double biasa, double dfa, double dga,
+                           const double *__restrict invb, const double *__restrict biasb,
+                           const double *__restrict dfb, const double *__restrict dgb,
+                           double *__restrict cov, double *__restrict col_corr,
+                           int64_t *__restrict col_index, double *__restrict corr) {
+        for (int v = 0; v < kLanes; ++v) {
+            corr[v] = cov[v] * inva * invb[v];
+            if (kBiased) {
+                corr[v] += biasa + biasb[v];
+            }
+            const bool better = corr[v] > col_corr[v];
+            col_corr[v] = better ? corr[v] : col_corr[v];
+            col_index[v] = better ? i : col_index[v];
+            cov[v] += dfa * dgb[v] + dfb[v] * dga;
+        }
+        double best = corr[0];
+        for (int v = 1; v < kLanes; ++v) {
+            best = std::max(best, corr[v]);
+        }
+        return best;
+    }
+
+    // SIMD body: row i meets columns i + k0 .. i + k0 + kLanes - 1
+    template <bool kBiased>
+    void body(int64_t k0, int64_t lo, int64_t hi, double *cov, ProfileAcc &rows,
+              ProfileAcc &cols) const {
+        alignas(64) double corr[kLanes];
+        double *row_corr = rows.corr.data();
+        int64_t *row_index = rows.index.data();
+        double *col_corr = cols.corr.data();
+        int64_t *col_index = cols.index.data();
+        for (int64_t i = lo; i < hi; ++i) {
+            const size_t j0 = static_cast<size_t>(i + k0);
+            const int64_t r = i - rows.begin, c = static_cast<int64_t>(j0) - cols.begin;
+            const double best = body_row<kBiased>(
+                i, a.invn[i], a.bias[i], a.df[i + 1], a.dg[i + 1], &b.invn[j0], &b.bias[j0],
+                &b.df[j0 + 1], &b.dg[j0 + 1], cov, &col_corr[c], &col_index[c], corr);
+            if (best > row_corr[r]) {
+                // Rare once the profile has converged, so the lane scan is cheap
+                int v = 0;
+                while (v + 1 < kLanes && corr[v] != best) {
+                    ++v;
+                }
+                row_corr[r] = best;
+                row_index[r] = static_cast<int64_t>(j0 + v);
+            }
+        }
+    }
+
+    // Diagonals k0 .. k0 + lanes - 1, restricted to rows [row_lo, row_hi)
+    void tile(int64_t k0, int lanes, int64_t row_lo, int64_t row_hi, ProfileAcc &rows,
+              ProfileAcc &cols) const {
+        const int64_t na = static_cast<int64_t>(a.n_sub);
+        const int64_t nb = static_cast<int64_t>(b.n_sub);
+
+        int64_t start[kLanes], end[kLanes];
+        alignas(64) double cov[kLanes];
+        int64_t body_lo = row_lo, body_hi = row_hi;
+        for (int v = 0; v < lanes; ++v) {
+            const int64_t k = k0 + v;
+            start[v] = std::max<int64_t>({row_lo, 0, -k});
+            end[v] = std::min<int64_t>({row_hi, na, nb - k});
+            body_lo = std::max(body_lo, start[v]);
+            body_hi = std::min(body_hi, end[v]);
+            if (start[v] < end[v]) {
+                cov[v] = direct_cov(a, start[v], b, start[v] + k, m);
+            }
+        }
+        if (lanes < kLanes) {
+            body_hi = body_lo;  // ragged last tile: scalar only
+        }
+        body_hi = std::max(body_hi, body_lo);
+
+        // Scalar head: bring every lane up to the common first row
+        for (int v = 0; v < lanes; ++v) {
+            const int64_t k = k0 + v;
+            const int64_t stop = std::min(body_lo, end[v]);
+            for (int64_t i = start[v]; i < stop; ++i) {
+                visit(i, i + k, cov[v], rows, cols);
+                cov[v] = advance(i, i + k, cov[v]);
+            }
+        }
+
+        if (a.masked || b.masked) {
+            body<true>(k0, body_lo, body_hi, cov, rows, cols);
+        } else {
+            body<false>(k0, body_lo, body_hi, cov, rows, cols);
+        }
+
+        // Scalar tail: lanes whose diagonals run past the common last row
+        for (int v = 0; v < lanes; ++v) {
+            const int64_t k = k0 + v;
+            for (int64_t i = std::max(body_hi, start[v]); i < end[v]; ++i) {
+                visit(i, i + k, cov[v], rows, cols);
+                cov[v] = advance(i, i + k, cov[v]);
+            }
+        }
+    }
+};
+
+// Rows per task and tiles per task. A task's private accumulators cover
+// kRowBlock rows plus the columns its diagonals reach, so memory stays
+// O(threads * (kRowBlock + kMaxGroup * kLanes)) whatever the series length.
+constexpr int64_t kRowBlock = 4096;
+constexpr size_t kMaxGroup = 64;
+// Entries of the shared accumulators guarded by one lock
+constexpr int64_t kStripe = 4096;
+
+// Runs tiles covering diagonals [k_min, k_max] across the thread pool.
+// Work is split into (row block, tile group) tasks; each task fills small
+// private accumulators and folds them into `rows` and `cols` under striped
+// locks. The result is independent of scheduling.
+void run_diagonals(const DiagonalWalker &walker, int64_t k_min, int64_t k_max,
+                   const MatrixProfileOptions &opts, ProfileAcc &rows, ProfileAcc &cols) {
+    if (k_max < k_min) {
+        return;
+    }
+    const int64_t na = static_cast<int64_t>(walker.a.n_sub);
+    const int64_t nb = static_cast<int64_t>(walker.b.n_sub);
+    const int64_t n_tiles = (k_max - k_min) / kLanes + 1;
+    ScratchVector<int64_t> tiles = scratch<int64_t>(n_tiles);
+    std::iota(tiles.begin(), tiles.end(), 0);
+    size_t n_run = tiles.size();
+    if (opts.fraction < 1.0) {
+        std::mt19937_64 rng(opts.seed);
+        std::shuffle(tiles.begin(), tiles.end(), rng);
+        n_run = std::max<size_t>(1, static_cast<size_t>(opts.fraction * tiles.size()));
+        tiles.resize(n_run);
+        // Neighbouring tiles share columns, so group them in diagonal order
+        std::sort(tiles.begin(), tiles.end());
+    }
+
+    // Smaller groups on short inputs so every thread gets work
+    const size_t threads = ThreadPool::shared().size();
+    const size_t group = std::clamp<size_t>(n_run / (4 * threads), 1, kMaxGroup);
+    const size_t n_groups = (n_run + group - 1) / group;
+    const int64_t n_blocks = (na + kRowBlock - 1) / kRowBlock;
+
+    struct Task {
+        int64_t row_lo, row_hi;
+        size_t first_tile, last_tile;  // into tiles, inclusive
+    };
+    ScratchVector<Task> tasks = scratch<Task>(0);
+    tasks.reserve(n_groups * static_cast<size_t>(n_blocks));
+    for (size_t g = 0; g < n_groups; ++g) {
+        const size_t first = g * group, last = std::min(n_run, first + group) - 1;
+        const int64_t k_lo = k_min + tiles[first] * kLanes;
+        const int64_t k_hi = std::min(k_max, k_min + tiles[last] * kLanes + kLanes - 1);
+        // Rows any of the group's diagonals pass through
+        const int64_t lo = std::max<int64_t>(0, -k_hi), hi = std::min(na, nb - k_lo);
+        for (int64_t r = 0; r < n_blocks; ++r) {
+            const int64_t row_lo = r * kRowBlock, row_hi = std::min(na, row_lo + kRowBlock);
+            if (row_lo < hi && row_hi > lo) {
+                tasks.push_back({row_lo, row_hi, first, last});
+            }
+        }
+    }
+
+    ScratchVector<std::mutex> row_locks((na + kStripe - 1) / kStripe, &thread_arena());
+    ScratchVector<std::mutex> col_locks((nb + kStripe - 1) / kStripe, &thread_arena());
+    auto fold = [](ProfileAcc &into, const ProfileAcc &from, int64_t lo, int64_t hi,
+                   ScratchVector<std::mutex> &locks) {
+        for (int64_t s = lo / kStripe; s * kStripe < hi; ++s) {
+            std::lock_guard<std::mutex> lock(locks[s]);
+            into.merge(from, std::max(lo, s * kStripe), std::min(hi, (s + 1) * kStripe));
+        }
+    };
+
+    parallel_for(tasks.size(), [&](size_t t) {
+        const Task &task = tasks[t];
+        const int64_t k_lo = k_min + tiles[task.first_tile] * kLanes;
+        const int64_t k_hi = std::min(k_max, k_min + tiles[task.last_tile] * kLanes + kLanes - 1);
+        const int64_t col_lo = std::max<int64_t>(0, task.row_lo + k_lo);
+        const int64_t col_hi = std::min(nb, task.row_hi + k_hi);
+        if (col_lo >= col_hi) {
+            return;
+        }
+
+        ArenaScope scope;
+        ProfileAcc local_rows(task.row_lo, task.row_hi - task.row_lo);
+        ProfileAcc local_cols(col_lo, col_hi - col_lo);
+        for (size_t i = task.first_tile; i <= task.last_tile; ++i) {
+            const int64_t k0 = k_min + tiles[i] * kLanes;
+            const int lanes = static_cast<int>(std::min<int64_t>(kLanes, k_max - k0 + 1));
+            walker.tile(k0, lanes, task.row_lo, task.row_hi, local_rows, local_cols);
+        }
+        fold(rows, local_rows, task.row_lo, task.row_hi, row_locks);
+        fold(cols, local_cols, col_lo, col_hi, col_locks);
+    });
+}
+
+double corr_to_distance(double corr, int m) {
+    return std::sqrt(std::max(0.0, 2.0 * m * (1.0 - corr)));
+}
+
+void to_distances(const ProfileAcc &acc, size_t n, int m, std::vector<double> &distance,
+                  std::vector<int64_t> &index) {
+    distance.resize(n);
+    index.assign(acc.index.begin(), acc.index.begin() + n);
+    for (size_t i = 0; i < n; ++i) {
+        // NaN, not infinity: -ffast-math assumes no infinities
+        distance[i] = index[i] < 0 ? std::numeric_limits<double>::quiet_NaN()
+                                   : corr_to_distance(acc.corr[i], m);
+    }
+}
+
+void validate(size_t n, const MatrixProfileOptions &opts) {
+    if (opts.window < 3) {
+        throw std::invalid_argument("window must be at least 3");
+    }
+    if (n < static_cast<size_t>(opts.window)) {
+        throw std::invalid_argument("series is shorter than the window");
+    }
+    if (!(opts.fraction > 0.0 && opts.fraction <= 1.0)) {
+        throw std::invalid_argument("fraction must be in (0, 1]");
+    }
+}
+
+size_t exclusion_zone(int window, double exclusion) {
+    return std::max<size_t>(1, static_cast<size_t>(std::ceil(window * exclusion)));
+}
+
+}  // namespace
+
+MatrixProfile matrix_profile(const double *t, size_t n, const MatrixProfileOptions &opts) {
+    validate(n, opts);
+    const int m = opts.window;
+    ArenaScope scope;
+    WindowStats stats = window_stats(t, n, m);
+    const size_t n_sub = stats.n_sub;
+
+    MatrixProfile mp;
+    mp.window = m;
+    mp.exclusion = exclusion_zone(m, opts.exclusion);
+
+    // Upper triangle only: row i sees its right neighbours, column j its left
+    ProfileAcc right(0, n_sub), left(0, n_sub);
+    DiagonalWalker walker{stats, stats, m};
+    run_diagonals(walker, static_cast<int64_t>(mp.exclusion), static_cast<int64_t>(n_sub) - 1,
+                  opts, right, left);
+
+    to_distances(left, n_sub, m, mp.left_distance, mp.left_index);
+    right.merge(left, 0, static_cast<int64_t>(n_sub));
+    to_distances(right, n_sub, m, mp.distance, mp.index);
+    return mp;
+}
+
+JoinProfile matrix_profile_ab(const double *a, size_t na, const double *b, size_t nb,
+                              const MatrixProfileOptions &opts) {
+    validate(na, opts);
+    validate(nb, opts);
+    const int m = opts.window;
+    ArenaScope scope;
+    WindowStats sa = window_stats(a, na, m);
+    WindowStats sb = window_stats(b, nb, m);
+
+    ProfileAcc rows(0, sa.n_sub), cols(0, sb.n_sub);
+    DiagonalWalker walker{sa, sb, m};
+    run_diagonals(walker, -(static_cast<int64_t>(sa.n_sub) - 1),
+                  static_cast<int64_t>(sb.n_sub) - 1, opts, rows, cols);
+
+    JoinProfile jp;
+    jp.window = m;
+    to_distances(rows, sa.n_sub, m, jp.distance_a, jp.index_a);
+    to_distances(cols, sb.n_sub, m, jp.distance_b, jp.index_b);
+    return jp;
+}
+
+namespace {
+
+void exclude_around(ScratchVector<char> &blocked, int64_t center, size_t zone) {
+    if (center < 0) {
+        return;
+    }
+    const size_t lo = center > static_cast<int64_t>(zone) ? center - zone : 0;
+    const size_t hi = std::min(blocked.size(), static_cast<size_t>(center) + zone + 1);
+    std::fill(blocked.begin() + lo, blocked.begin() + hi, 1);
+}
+
+}  // namespace
+
+std::vector<Motif> find_motifs(const MatrixProfile &mp, size_t k) {
+    const size_t n = mp.distance.size();
+    ArenaScope scope;
+    ScratchVector<size_t> order = scratch<size_t>(0);
+    order.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (mp.index[i] >= 0) {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(),
+              [&](size_t x, size_t y) { return mp.distance[x] < mp.distance[y]; });
+
+    ScratchVector<char> blocked = scratch<char>(n, 0);
+    std::vector<Motif> motifs;
+    for (size_t i : order) {
+        if (motifs.size() >= k) {
+            break;
+        }
+        const int64_t j = mp.index[i];
+        if (blocked[i] || blocked[j]) {
+            continue;
+        }
+        motifs.push_back({static_cast<int64_t>(std::min<size_t>(i, j)),
+                          static_cast<int64_t>(std::max<size_t>(i, j)), mp.distance[i]});
+        exclude_around(blocked, i, mp.exclusion);
+        exclude_around(blocked, j, mp.exclusion);
+    }
+    return motifs;
+}
+
+std::vector<Neighbor> find_discords(const MatrixProfile &mp, size_t k) {
+    const size_t n = mp.distance.size();
+    ArenaScope scope;
+    ScratchVector<size_t> order = scratch<size_t>(0);
+    order.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (mp.index[i] >= 0) {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(),
+              [&](size_t x, size_t y) { return mp.distance[x] > mp.distance[y]; });
+
+    ScratchVector<char> blocked = scratch<char>(n, 0);
+    std::vector<Neighbor> discords;
+    for (size_t i : order) {
+        if (discords.size() >= k) {
+            break;
+        }
+        if (blocked[i]) {
+            continue;
+        }
+        discords.push_back({static_cast<int64_t>(i), mp.distance[i]});
+        exclude_around(blocked, i, mp.exclusion);
+    }
+    return discords;
+}
+
+std::vector<Neighbor> find_analogues(const double *t, size_t n, int window, size_t query_start,
+                                     size_t k, double exclusion) {
+    MatrixProfileOptions opts;
+    opts.window = window;
+    validate(n, opts);
+    const int m = window;
+    ArenaScope scope;
+    WindowStats stats = window_stats(t, n, m);
+    if (query_start >= stats.n_sub) {
+        throw std::invalid_argument("query window runs past the end of the series");
+    }
+    const size_t zone = exclusion_zone(m, exclusion);
+    // Candidates end before the query begins: j + m <= query_start
+    if (query_start < static_cast<size_t>(m)) {
+        return {};
+    }
+    const size_t n_cand = query_start - m + 1;
+
+    if (!stats.valid(query_start)) {
+        return {};
+    }
+
+    // z-normalized query: corr_j = <q, x_j> * invn_j since q sums to zero
+    ScratchVector<double> q = scratch<double>(m);
+    const double qn = stats.invn[query_start];
+    for (int l = 0; l < m; ++l) {
+        q[l] = (stats.x[query_start + l] - stats.mu[query_start]) * qn;
+    }
+
+    ScratchVector<double> dist = scratch<double>(n_cand);
+    parallel_for((n_cand + 4095) / 4096, [&](size_t block) {
+        const size_t lo = block * 4096;
+        const size_t hi = std::min(n_cand, lo + 4096);
+        for (size_t j = lo; j < hi; ++j) {
+            const double *x = &stats.x[j];
+            double dot = 0.0;
+            for (int l = 0; l < m; ++l) {
+                dot += q[l] * x[l];
+            }
+            dist[j] = corr_to_distance(dot * stats.invn[j], m);
+        }
+    });
+
+    ScratchVector<size_t> order = scratch<size_t>(n_cand);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t x, size_t y) { return dist[x] < dist[y]; });
+
+    ScratchVector<char> blocked = scratch<char>(n_cand, 0);
+    std::vector<Neighbor> out;
+    for (size_t j : order) {
+        if (out.size() >= k) {
+            break;
+        }
+        if (blocked[j] || !stats.valid(j)) {
+            continue;
+        }
+        out.push_back({static_cast<int64_t>(j), dist[j]});
+        exclude_around(blocked, j, zone);
+    }
+    return out;
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace alphasignal {
+
+// Matrix profile over z-normalized subsequences (Euclidean distance).
+// Diagonals are traversed with the MPX/SCAMP covariance recurrence in tiles
+// of adjacent diagonals, so each row update is a contiguous SIMD sweep, and
+// tiles are spread across the shared thread pool.
+struct MatrixProfileOptions {
+    int window = 20;
+    double exclusion = 0.25;  // trivial-match zone as a fraction of the window
+    double fraction = 1.0;    // < 1 gives an anytime (SCRIMP) approximation
+    uint64_t seed = 0;        // diagonal order when fraction < 1
+};
+
+struct MatrixProfile {
+    int window = 0;
+    size_t exclusion = 0;
+    std::vector<double> distance;  // nearest neighbour anywhere in the series
+    std::vector<int64_t> index;
+    std::vector<double> left_distance;  // nearest neighbour among earlier windows
+    std::vector<int64_t> left_index;    // (causal; usable as a feature)
+};
+
+// Self-join. Windows without a neighbour get index -1 and NaN distance; so
+// does every window containing a missing value, and such windows are never
+// anyone's neighbour.
+MatrixProfile matrix_profile(const double *t, size_t n, const MatrixProfileOptions &opts);
+
+// AB-join: for every window of a its nearest window in b, and vice versa
+struct JoinProfile {
+    int window = 0;
+    std::vector<double> distance_a;
+    std::vector<int64_t> index_a;  // into b
+    std::vector<double> distance_b;
+    std::vector<int64_t> index_b;  // into a
+};
+
+JoinProfile matrix_profile_ab(const double *a, size_t na, const double *b, size_t nb,
+                              const MatrixProfileOptions &opts);
+
+struct Motif {
+    int64_t first;
+    int64_t second;
+    double distance;
+};
+
+// Top-k motif pairs (smallest profile values), each pair excluding trivial
+// matches of the ones already chosen
+std::vector<Motif> find_motifs(const MatrixProfile &mp, size_t k);
+
+struct Neighbor {
+    int64_t index;
+    double distance;
+};
+
+// Top-k discords (largest nearest-neighbour distances)
+std::vector<Neighbor> find_discords(const MatrixProfile &mp, size_t k);
+
+// Historical analogues: the k past windows closest to the query window that
+// starts at query_start (e.g. n - window for "the latest bars"). Only
+// windows ending at or before query_start are candidates, and each chosen
+// window excludes the candidates within the exclusion zone around it.
+// Windows with missing values are skipped; a query that has one finds
+// nothing.
+std::vector<Neighbor> find_analogues(const double *t, size_t n, int window, size_t query_start,
+                                     size_t k, double exclusion = 0.25);
+
+}  // namespace alphasignal
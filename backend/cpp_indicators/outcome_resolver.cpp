@@ -0,0 +1,144 @@
+#include "outcome_resolver.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "arena.h"
+#include "thread_pool.h"
+
+namespace alphasignal {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+struct Pending {
+    uint32_t row;
+    double base;  // close as of the prediction day
+};
+
+// Walks one ticker's bars forward, tracking the last valid close on or before a day
+class AsOfCursor {
+public:
+    AsOfCursor(const int32_t *day, const double *close, size_t n)
+        : day_(day), close_(close), n_(n) {}
+
+    double at(int32_t d) {
+        while (next_ < n_ && day_[next_] <= d) {
+            if (!is_missing(close_[next_])) {
+                last_ = close_[next_];
+            }
+            ++next_;
+        }
+        return last_;
+    }
+
+private:
+    const int32_t *day_;
+    const double *close_;
+    size_t n_;
+    size_t next_ = 0;
+    double last_ = kNaN;
+};
+
+}  // namespace
+
+size_t resolve_outcomes(const PriceTable &prices, const PredictionRows &rows,
+                        const OutcomeColumns &out) {
+    const size_t n_series = prices.batch.n_series;
+
+    // Group prediction rows by ticker (counting sort, stable)
+    std::vector<size_t> start(n_series + 1, 0);
+    for (size_t r = 0; r < rows.n; ++r) {
+        out.actual[r] = -1;
+        out.correct[r] = -1;
+        const int32_t t = rows.ticker[r];
+        if (t < 0) {
+            continue;
+        }
+        if (static_cast<size_t>(t) >= n_series) {
+            throw std::invalid_argument("prediction ticker " + std::to_string(t) +
+                                        " is outside the price table");
+        }
+        ++start[t + 1];
+    }
+    for (size_t s = 0; s < n_series; ++s) {
+        start[s + 1] += start[s];
+    }
+    std::vector<uint32_t> order(start[n_series]);
+    {
+        std::vector<size_t> fill(start.begin(), start.end() - 1);
+        for (size_t r = 0; r < rows.n; ++r) {
+            if (rows.ticker[r] >= 0) {
+                order[fill[rows.ticker[r]]++] = static_cast<uint32_t>(r);
+            }
+        }
+    }
+
+    std::atomic<size_t> resolved{0};
+    parallel_for(n_series, [&](size_t s) {
+        const size_t m = start[s + 1] - start[s];
+        if (m == 0) {
+            return;
+        }
+        const size_t b = prices.batch.begin(s);
+        const size_t len = prices.batch.length(s);
+        const int32_t *day = prices.day + b;
+        const double *close = prices.close + b;
+        for (size_t i = 1; i < len; ++i) {
+            if (day[i] < day[i - 1]) {
+                throw std::invalid_argument("price days must ascend within each ticker");
+            }
+        }
+        if (len == 0) {
+            return;
+        }
+        const int32_t last_day = day[len - 1];
+
+        ArenaScope scope;
+        ScratchVector<Pending> group(&scope.arena());
+        group.reserve(m);
+        for (size_t k = start[s]; k < start[s + 1]; ++k) {
+            group.push_back(Pending{order[k], kNaN});
+        }
+
+        // Pass 1: base close, in prediction-day order
+        std::sort(group.begin(), group.end(), [&rows](const Pending &x, const Pending &y) {
+            return rows.day[x.row] < rows.day[y.row];
+        });
+        AsOfCursor base_cursor(day, close, len);
+        for (Pending &p : group) {
+            p.base = base_cursor.at(rows.day[p.row]);
+        }
+
+        // Pass 2: outcome close, in target-day order
+        std::sort(group.begin(), group.end(), [&rows](const Pending &x, const Pending &y) {
+            return rows.target_day[x.row] < rows.target_day[y.row];
+        });
+        AsOfCursor target_cursor(day, close, len);
+        size_t count = 0;
+        for (const Pending &p : group) {
+            const int32_t target = rows.target_day[p.row];
+            if (target > last_day) {
+                break;  // sorted: the rest are in the future too
+            }
+            const double outcome = target_cursor.at(target);
+            if (is_missing(p.base) || is_missing(outcome)) {
+                continue;
+            }
+            const int8_t up = outcome > p.base ? 1 : 0;
+            const int8_t predicted = rows.predicted[p.row];
+            out.actual[p.row] = up;
+            out.correct[p.row] = predicted < 0 ? -1 : static_cast<int8_t>(predicted == up);
+            ++count;
+        }
+        resolved += count;
+    });
+    return resolved.load();
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "batch.h"
+
+namespace alphasignal {
+
+// Close prices of many tickers laid out by batch; days (epoch days) ascend
+// within each ticker. NaN closes are skipped.
+struct PriceTable {
+    const int32_t *day;
+    const double *close;
+    RaggedBatch batch;
+};
+
+// One entry per prediction. ticker indexes the price table's series, -1
+// when the ticker has no prices.
+struct PredictionRows {
+    const int32_t *ticker;
+    const int32_t *day;         // prediction date
+    const int32_t *target_day;  // outcome date
+    const int8_t *predicted;    // 1 = UP, 0 = DOWN, -1 = none
+    size_t n;
+};
+
+// -1 where the prediction cannot be resolved yet
+struct OutcomeColumns {
+    int8_t *actual;   // 1 = UP, 0 = DOWN
+    int8_t *correct;  // 1/0; -1 also when predicted is -1
+};
+
+// actual = close as of target_day > close as of the prediction day, "as of"
+// being the last valid close on or before that day (a flat move is DOWN,
+// as in the training label). A prediction resolves once its ticker has a
+// bar on or after target_day and a valid close on or before its day.
+// Predictions are grouped by ticker and each group is merged against its
+// price series in (day) and (target_day) order, tickers in parallel.
+// Returns the number of resolved predictions. Throws std::invalid_argument
+// on out-of-range tickers or unsorted price days.
+size_t resolve_outcomes(const PriceTable &prices, const PredictionRows &rows,
+                        const OutcomeColumns &out);
+
+}  // namespace alphasignal
@@ -0,0 +1,457 @@
+#include "pairs.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+
+#include "arena.h"
+#include "batch.h"
+#include "thread_pool.h"
+
+namespace alphasignal {
+
+namespace {
+
+// Correlation tiles cover kBlock x kBlock tickers and stream the time axis in
+// kChunk-row passes, so both ticker panels of a pass stay in L2. Inside a
+// tile, kMR x kNR register blocks accumulate outer products; the kNR loop
+// is contiguous in memory and vectorizes.
+constexpr size_t kBlock = 64;
+constexpr size_t kChunk = 256;
+constexpr size_t kMR = 4;
+constexpr size_t kNR = 16;
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// Standardized log returns, time-major (n_rows x ld), zero-padded to whole
+// tiles. Columns have unit norm, so a dot product is a correlation. Lives on
+// the calling thread's arena.
+ScratchVector<double> standardized_returns(const double *prices, size_t n_obs, size_t n_tickers,
+                                           size_t ld) {
+    const size_t n_rows = n_obs - 1;
+    ScratchVector<double> z = scratch<double>(n_rows * ld, 0.0);
+    parallel_for((n_tickers + kBlock - 1) / kBlock, [&](size_t block) {
+        const size_t lo = block * kBlock;
+        const size_t hi = std::min(n_tickers, lo + kBlock);
+        for (size_t i = lo; i < hi; ++i) {
+            double sum = 0.0;
+            size_t count = 0;
+            for (size_t t = 0; t < n_rows; ++t) {
+                const double p0 = prices[t * n_tickers + i];
+                const double p1 = prices[(t + 1) * n_tickers + i];
+                double r = 0.0;
+                if (!is_missing(p0) && !is_missing(p1) && p0 > 0.0 && p1 > 0.0) {
+                    r = std::log(p1 / p0);
+                    sum += r;
+                    ++count;
+                } else {
+                    r = kNaN;
+                }
+                z[t * ld + i] = r;
+            }
+            const double mean = count ? sum / count : 0.0;
+            double ss = 0.0;
+            for (size_t t = 0; t < n_rows; ++t) {
+                double &r = z[t * ld + i];
+                r = is_missing(r) ? 0.0 : r - mean;
+                ss += r * r;
+            }
+            const double scale = ss > 0.0 ? 1.0 / std::sqrt(ss) : 0.0;
+            for (size_t t = 0; t < n_rows; ++t) {
+                z[t * ld + i] *= scale;
+            }
+        }
+    });
+    return z;
+}
+
+// c (kBlock x kBlock, row-major) = Z[:, i0:i0+kBlock]^T Z[:, j0:j0+kBlock]
+void correlation_tile(const double *z, size_t n_rows, size_t ld, size_t i0, size_t j0,
+                      double *c) {
+    std::fill(c, c + kBlock * kBlock, 0.0);
+    for (size_t t0 = 0; t0 < n_rows; t0 += kChunk) {
+        const size_t t1 = std::min(n_rows, t0 + kChunk);
+        for (size_t ii = 0; ii < kBlock; ii += kMR) {
+            for (size_t jj = 0; jj < kBlock; jj += kNR) {
+                double acc[kMR][kNR];
+                for (size_t r = 0; r < kMR; ++r) {
+                    for (size_t q = 0; q < kNR; ++q) {
+                        acc[r][q] = c[(ii + r) * kBlock + jj + q];
+                    }
+                }
+                for (size_t t = t0; t < t1; ++t) {
+                    const double *row = z + t * ld;
+                    const double *b = row + j0 + jj;
+                    for (size_t r = 0; r < kMR; ++r) {
+                        const double a = row[i0 + ii + r];
+                        for (size_t q = 0; q < kNR; ++q) {
+                            acc[r][q] += a * b[q];
+                        }
+                    }
+                }
+                for (size_t r = 0; r < kMR; ++r) {
+                    for (size_t q = 0; q < kNR; ++q) {
+                        c[(ii + r) * kBlock + jj + q] = acc[r][q];
+                    }
+                }
+            }
+        }
+    }
+}
+
+struct Candidate {
+    double corr;
+    int64_t first;
+    int64_t second;
+};
+
+struct WeakerFirst {
+    bool operator()(const Candidate &a, const Candidate &b) const { return a.corr > b.corr; }
+};
+
+// Min-heap holding the strongest max_size pairs seen by one worker
+using CandidateHeap = std::priority_queue<Candidate, std::vector<Candidate>, WeakerFirst>;
+
+void offer(CandidateHeap &heap, size_t max_size, const Candidate &c) {
+    if (heap.size() < max_size) {
+        heap.push(c);
+    } else if (c.corr > heap.top().corr) {
+        heap.pop();
+        heap.push(c);
+    }
+}
+
+// Solves the k x k symmetric positive definite system a x = b in place
+// (Cholesky); returns false if a is singular
+bool cholesky_solve(double *a, double *b, size_t k) {
+    for (size_t j = 0; j < k; ++j) {
+        double d = a[j * k + j];
+        for (size_t p = 0; p < j; ++p) {
+            d -= a[j * k + p] * a[j * k + p];
+        }
+        if (!(d > 1e-300)) {
+            return false;
+        }
+        d = std::sqrt(d);
+        a[j * k + j] = d;
+        for (size_t i = j + 1; i < k; ++i) {
+            double s = a[i * k + j];
+            for (size_t p = 0; p < j; ++p) {
+                s -= a[i * k + p] * a[j * k + p];
+            }
+            a[i * k + j] = s / d;
+        }
+    }
+    for (size_t i = 0; i < k; ++i) {
+        double s = b[i];
+        for (size_t p = 0; p < i; ++p) {
+            s -= a[i * k + p] * b[p];
+        }
+        b[i] = s / a[i * k + i];
+    }
+    for (size_t i = k; i-- > 0;) {
+        double s = b[i];
+        for (size_t p = i + 1; p < k; ++p) {
+            s -= a[p * k + i] * b[p];
+        }
+        b[i] = s / a[i * k + i];
+    }
+    return true;
+}
+
+struct AdfFit {
+    double stat = 0.0;
+    double gamma = 0.0;
+    bool ok = false;
+};
+
+// Residual unit-root regression without constant:
+//   de_t = gamma * e_{t-1} + sum_{i=1..p} phi_i * de_{t-i} + u_t
+AdfFit adf_no_constant(const ScratchVector<double> &e, int lags) {
+    AdfFit fit;
+    const size_t n = e.size();
+    const size_t p = static_cast<size_t>(lags);
+    const size_t k = p + 1;
+    if (n < p + k + 3) {
+        return fit;
+    }
+    const size_t n_reg = n - 1 - p;
+
+    ScratchVector<double> xtx = scratch<double>(k * k, 0.0), xty = scratch<double>(k, 0.0);
+    ScratchVector<double> x = scratch<double>(k);
+    auto regressors = [&](size_t t) {
+        x[0] = e[t - 1];
+        for (size_t i = 1; i <= p; ++i) {
+            x[i] = e[t - i] - e[t - i - 1];
+        }
+    };
+    for (size_t t = p + 1; t < n; ++t) {
+        regressors(t);
+        const double y = e[t] - e[t - 1];
+        for (size_t a = 0; a < k; ++a) {
+            xty[a] += x[a] * y;
+            for (size_t b = 0; b <= a; ++b) {
+                xtx[a * k + b] += x[a] * x[b];
+            }
+        }
+    }
+    for (size_t a = 0; a < k; ++a) {
+        for (size_t b = a + 1; b < k; ++b) {
+            xtx[a * k + b] = xtx[b * k + a];
+        }
+    }
+
+    ScratchVector<double> chol(xtx, &thread_arena()), beta(xty, &thread_arena());
+    if (!cholesky_solve(chol.data(), beta.data(), k)) {
+        return fit;
+    }
+    // (X'X)^-1 [0, 0] from a second solve against the first unit vector
+    ScratchVector<double> unit = scratch<double>(k, 0.0);
+    unit[0] = 1.0;
+    chol = xtx;
+    cholesky_solve(chol.data(), unit.data(), k);
+
+    double rss = 0.0;
+    for (size_t t = p + 1; t < n; ++t) {
+        regressors(t);
+        double fitted = 0.0;
+        for (size_t a = 0; a < k; ++a) {
+            fitted += beta[a] * x[a];
+        }
+        const double u = (e[t] - e[t - 1]) - fitted;
+        rss += u * u;
+    }
+    const double sigma2 = rss / static_cast<double>(n_reg - k);
+    const double se = std::sqrt(sigma2 * unit[0]);
+    if (!(se > 0.0)) {
+        return fit;
+    }
+    fit.gamma = beta[0];
+    fit.stat = beta[0] / se;
+    fit.ok = true;
+    return fit;
+}
+
+struct Orientation {
+    double slope = 0.0;
+    double intercept = 0.0;
+    AdfFit adf;
+};
+
+Orientation regress_and_test(const ScratchVector<double> &y, const ScratchVector<double> &x,
+                             int lags, ScratchVector<double> &resid) {
+    Orientation o;
+    const size_t n = y.size();
+    double my = 0.0, mx = 0.0;
+    for (size_t t = 0; t < n; ++t) {
+        my += y[t];
+        mx += x[t];
+    }
+    my /= n;
+    mx /= n;
+    double sxy = 0.0, sxx = 0.0;
+    for (size_t t = 0; t < n; ++t) {
+        sxy += (x[t] - mx) * (y[t] - my);
+        sxx += (x[t] - mx) * (x[t] - mx);
+    }
+    if (!(sxx > 0.0)) {
+        return o;
+    }
+    o.slope = sxy / sxx;
+    o.intercept = my - o.slope * mx;
+    resid.resize(n);
+    for (size_t t = 0; t < n; ++t) {
+        resid[t] = y[t] - o.intercept - o.slope * x[t];
+    }
+    o.adf = adf_no_constant(resid, lags);
+    return o;
+}
+
+}  // namespace
+
+double mackinnon_p_value(double adf_stat) {
+    // Response-surface coefficients for "c", N = 2 (MacKinnon 1994)
+    constexpr double kTauMax = 0.92, kTauMin = -18.86, kTauStar = -2.62;
+    if (adf_stat > kTauMax) {
+        return 1.0;
+    }
+    if (adf_stat < kTauMin) {
+        return 0.0;
+    }
+    const double t = adf_stat;
+    const double z = t <= kTauStar
+                         ? 2.92 + 1.5012 * t + 3.9796e-2 * t * t
+                         : 2.1945 + 6.4695e-1 * t - 2.9198e-1 * t * t - 4.2377e-2 * t * t * t;
+    return 0.5 * std::erfc(-z / std::sqrt(2.0));
+}
+
+PairResult engle_granger(const double *log_y, const double *log_x, size_t n, int adf_lags) {
+    PairResult result{};
+    result.adf_stat = kNaN;
+    result.p_value = 1.0;
+    result.half_life = kNaN;
+    result.hedge_ratio = kNaN;
+    result.intercept = kNaN;
+
+    ArenaScope scope;
+    ScratchVector<double> y = scratch<double>(0), x = scratch<double>(0);
+    y.reserve(n);
+    x.reserve(n);
+    for (size_t t = 0; t < n; ++t) {
+        if (!is_missing(log_y[t]) && !is_missing(log_x[t])) {
+            y.push_back(log_y[t]);
+            x.push_back(log_x[t]);
+        }
+    }
+    result.n_obs = static_cast<int64_t>(y.size());
+
+    ScratchVector<double> resid = scratch<double>(0);
+    resid.reserve(y.size());
+    // The more volatile leg is the regressand. Picking the orientation with
+    // the better ADF statistic instead would inflate the test's size.
+    double vy = 0.0, vx = 0.0;
+    for (size_t t = 1; t < y.size(); ++t) {
+        vy += (y[t] - y[t - 1]) * (y[t] - y[t - 1]);
+        vx += (x[t] - x[t - 1]) * (x[t] - x[t - 1]);
+    }
+    const bool use_reverse = vx > vy;
+    const Orientation best = use_reverse ? regress_and_test(x, y, adf_lags, resid)
+                                         : regress_and_test(y, x, adf_lags, resid);
+    if (!best.adf.ok) {
+        return result;
+    }
+
+    result.first = use_reverse ? 1 : 0;
+    result.second = use_reverse ? 0 : 1;
+    result.hedge_ratio = best.slope;
+    result.intercept = best.intercept;
+    result.adf_stat = best.adf.stat;
+    result.p_value = mackinnon_p_value(best.adf.stat);
+    if (best.adf.gamma < 0.0 && best.adf.gamma > -1.0) {
+        result.half_life = -std::log(2.0) / std::log1p(best.adf.gamma);
+    }
+    return result;
+}
+
+std::vector<PairResult> screen_pairs(const double *prices, size_t n_obs, size_t n_tickers,
+                                     const PairScreenOptions &opts) {
+    if (n_obs < 3 || n_tickers < 2) {
+        throw std::invalid_argument("need at least 3 observations and 2 tickers");
+    }
+    if (opts.adf_lags < 0) {
+        throw std::invalid_argument("adf_lags must be non-negative");
+    }
+
+    // ----- Stage 1: blocked correlation with bounded candidate heaps -----
+    const size_t n_blocks = (n_tickers + kBlock - 1) / kBlock;
+    const size_t ld = n_blocks * kBlock;
+    const size_t n_rows = n_obs - 1;
+    std::vector<Candidate> candidates;
+    {
+        ArenaScope scope;
+        const ScratchVector<double> z = standardized_returns(prices, n_obs, n_tickers, ld);
+
+        // Upper-triangular tile list (bi <= bj)
+        std::vector<std::pair<uint32_t, uint32_t>> tiles;
+        for (size_t bi = 0; bi < n_blocks; ++bi) {
+            for (size_t bj = bi; bj < n_blocks; ++bj) {
+                tiles.emplace_back(static_cast<uint32_t>(bi), static_cast<uint32_t>(bj));
+            }
+        }
+
+        const size_t n_slots = std::min<size_t>(ThreadPool::shared().size(), tiles.size());
+        std::vector<CandidateHeap> heaps(n_slots);
+        std::atomic<size_t> next{0};
+        parallel_for(n_slots, [&](size_t slot) {
+            ArenaScope scope;
+            ScratchVector<double> c = scratch<double>(kBlock * kBlock);
+            CandidateHeap &heap = heaps[slot];
+            for (;;) {
+                const size_t tile = next.fetch_add(1, std::memory_order_relaxed);
+                if (tile >= tiles.size()) {
+                    break;
+                }
+                const size_t i0 = tiles[tile].first * kBlock;
+                const size_t j0 = tiles[tile].second * kBlock;
+                correlation_tile(z.data(), n_rows, ld, i0, j0, c.data());
+                const size_t i_end = std::min(kBlock, n_tickers - i0);
+                const size_t j_end = std::min(kBlock, n_tickers - j0);
+                for (size_t i = 0; i < i_end; ++i) {
+                    for (size_t j = (i0 == j0 ? i + 1 : 0); j < j_end; ++j) {
+                        const double corr = c[i * kBlock + j];
+                        if (corr >= opts.min_correlation) {
+                            offer(heap, opts.max_candidates,
+                                  {corr, static_cast<int64_t>(i0 + i), static_cast<int64_t>(j0 + j)});
+                        }
+                    }
+                }
+            }
+        });
+
+        for (CandidateHeap &heap : heaps) {
+            while (!heap.empty()) {
+                candidates.push_back(heap.top());
+                heap.pop();
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate &a, const Candidate &b) { return a.corr > b.corr; });
+    if (candidates.size() > opts.max_candidates) {
+        candidates.resize(opts.max_candidates);
+    }
+    if (candidates.empty()) {
+        return {};
+    }
+
+    // ----- Stage 2: Engle-Granger on candidates only -----
+    // Log prices of the tickers that survived, ticker-major for contiguous access
+    ArenaScope scope;
+    ScratchVector<int64_t> slot_of = scratch<int64_t>(n_tickers, -1);
+    ScratchVector<size_t> used = scratch<size_t>(0);
+    used.reserve(std::min(n_tickers, 2 * candidates.size()));
+    for (const Candidate &c : candidates) {
+        for (int64_t id : {c.first, c.second}) {
+            if (slot_of[id] < 0) {
+                slot_of[id] = static_cast<int64_t>(used.size());
+                used.push_back(static_cast<size_t>(id));
+            }
+        }
+    }
+    ScratchVector<double> log_prices = scratch<double>(used.size() * n_obs);
+    parallel_for(used.size(), [&](size_t s) {
+        const size_t id = used[s];
+        double *out = &log_prices[s * n_obs];
+        for (size_t t = 0; t < n_obs; ++t) {
+            const double p = prices[t * n_tickers + id];
+            out[t] = (!is_missing(p) && p > 0.0) ? std::log(p) : kNaN;
+        }
+    });
+
+    std::vector<PairResult> results(candidates.size());
+    parallel_for(candidates.size(), [&](size_t k) {
+        const Candidate &c = candidates[k];
+        const double *ly = &log_prices[static_cast<size_t>(slot_of[c.first]) * n_obs];
+        const double *lx = &log_prices[static_cast<size_t>(slot_of[c.second]) * n_obs];
+        PairResult r = engle_granger(ly, lx, n_obs, opts.adf_lags);
+        const bool reversed = r.first == 1;
+        r.first = reversed ? c.second : c.first;
+        r.second = reversed ? c.first : c.second;
+        r.correlation = c.corr;
+        if (r.n_obs < opts.min_overlap) {
+            r.adf_stat = kNaN;
+            r.p_value = 1.0;
+            r.half_life = kNaN;
+        }
+        results[k] = r;
+    });
+
+    std::stable_sort(results.begin(), results.end(),
+                     [](const PairResult &a, const PairResult &b) { return a.p_value < b.p_value; });
+    return results;
+}
+
+}  // namespace alphasignal
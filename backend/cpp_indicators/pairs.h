@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace alphasignal {
+
+// All-pairs screener over an aligned price panel (n_obs x n_tickers,
+// row-major, NaN where a ticker has no price). Stage 1 computes every
+// pairwise correlation of log returns as a blocked matrix product and keeps
+// only the strongest pairs in bounded per-thread heaps, so the full
+// correlation matrix is never materialised. Stage 2 runs an Engle-Granger
+// test on the surviving candidates.
+struct PairScreenOptions {
+    double min_correlation = 0.7;  // stage-1 cut on return correlation
+    size_t max_candidates = 5000;  // pairs passed on to cointegration tests
+    int adf_lags = 1;              // augmentation lags in the residual ADF
+    int min_overlap = 60;          // common observations needed for a test
+};
+
+struct PairResult {
+    int64_t first;        // ticker regressed (y)
+    int64_t second;       // ticker used as regressor (x)
+    double correlation;   // of log returns
+    double hedge_ratio;   // OLS slope of log(y) on log(x)
+    double intercept;
+    double adf_stat;      // t-statistic of the residual unit-root test
+    double p_value;       // MacKinnon approximation for two variables
+    double half_life;     // mean-reversion half-life of the spread in bars
+    int64_t n_obs;
+};
+
+// Pearson correlation of log returns; missing returns are mean-filled, so
+// they dilute but do not break a pair
+std::vector<PairResult> screen_pairs(const double *prices, size_t n_obs, size_t n_tickers,
+                                     const PairScreenOptions &opts = PairScreenOptions());
+
+// Engle-Granger on one pair of log-price series (rows with a NaN on either
+// side are dropped). The leg with the larger return variance is regressed
+// on the other; first/second are 0 (log_y) or 1 (log_x) to say which input
+// ended up as the regressand. correlation is left 0.
+PairResult engle_granger(const double *log_y, const double *log_x, size_t n, int adf_lags);
+
+// MacKinnon (1994) approximate p-value of the cointegration ADF statistic
+// with a constant and two variables
+double mackinnon_p_value(double adf_stat);
+
+}  // namespace alphasignal
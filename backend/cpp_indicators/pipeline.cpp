@@ -0,0 +1,111 @@
+#include "pipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+#include "arena.h"
+#include "tree_model.h"
+
+namespace alphasignal {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct FileJob {
+    std::string name;
+    fs::path path;
+    std::shared_ptr<const CsvTable> table;
+    std::unique_ptr<FeatureFrame> frame;
+};
+
+// Tag stage errors with the file they came from; each file's scratch
+// memory goes back to the worker's arena when its stage is done
+template <class Fn>
+Pipeline<FileJob>::StageFn per_file(Fn fn) {
+    return [fn](FileJob &job) {
+        ArenaScope scope;
+        try {
+            fn(job);
+        } catch (const std::exception &e) {
+            throw std::runtime_error(job.name + ": " + e.what());
+        }
+    };
+}
+
+}  // namespace
+
+BatchPipelineReport run_batch_pipeline(const BatchPipelineOptions &opts) {
+    const auto start = std::chrono::steady_clock::now();
+
+    std::error_code ec;
+    if (!fs::is_directory(opts.input_dir, ec)) {
+        throw std::runtime_error("not a directory: " + opts.input_dir);
+    }
+    fs::create_directories(opts.output_dir, ec);
+    if (!fs::is_directory(opts.output_dir, ec)) {
+        throw std::runtime_error("cannot create " + opts.output_dir);
+    }
+
+    std::vector<FileJob> jobs;
+    for (const fs::directory_entry &entry : fs::directory_iterator(opts.input_dir)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".csv") {
+            FileJob job;
+            job.name = entry.path().filename().string();
+            job.path = entry.path();
+            jobs.push_back(std::move(job));
+        }
+    }
+    std::sort(jobs.begin(), jobs.end(),
+              [](const FileJob &a, const FileJob &b) { return a.name < b.name; });
+
+    std::shared_ptr<const TreeEnsemble> model;
+    if (!opts.model_path.empty()) {
+        model = std::make_shared<const TreeEnsemble>(load_tree_ensemble(opts.model_path));
+    }
+    const unsigned feature_workers =
+        opts.feature_workers > 0 ? opts.feature_workers
+                                 : std::max(1u, std::thread::hardware_concurrency());
+    const fs::path output_dir(opts.output_dir);
+    const FrameOptions frame_opts = opts.frame;
+
+    Pipeline<FileJob> pipeline(opts.channel_capacity);
+    pipeline.stage("ingest", opts.read_workers, per_file([](FileJob &job) {
+        job.table = std::make_shared<const CsvTable>(CsvTable::load(job.path.string()));
+    }));
+    pipeline.stage("features", feature_workers, per_file([&frame_opts](FileJob &job) {
+        job.frame = std::make_unique<FeatureFrame>(std::move(job.table), frame_opts);
+        job.frame->add_indicators();
+        job.frame->add_features();
+    }));
+    if (model) {
+        pipeline.stage("inference", opts.score_workers, per_file([&model](FileJob &job) {
+            job.frame->add_scores(*model);
+        }));
+    }
+    pipeline.stage("write", opts.write_workers, per_file([&output_dir](FileJob &job) {
+        const fs::path out_path = output_dir / job.name;
+        std::ofstream out(out_path, std::ios::binary);
+        if (!out) {
+            throw std::runtime_error("cannot write " + out_path.string());
+        }
+        job.frame->write(out);
+        if (!out.flush()) {
+            throw std::runtime_error("write failed for " + out_path.string());
+        }
+    }));
+
+    BatchPipelineReport report;
+    report.files = jobs.size();
+    report.stages = pipeline.run(std::move(jobs));
+    report.written = report.stages.back().items_out;
+    report.wall_s =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "frame.h"
+
+namespace alphasignal {
+
+// Blocking multi-producer/multi-consumer queue with a fixed capacity.
+// A full channel blocks its producers, which is how a slow stage pushes
+// back on the stages in front of it.
+template <class T>
+class BoundedChannel {
+public:
+    explicit BoundedChannel(size_t capacity) : capacity_(capacity) {
+        if (capacity_ < 1) {
+            throw std::invalid_argument("channel capacity must be >= 1");
+        }
+    }
+
+    // Blocks while full; false (item dropped) once the channel is closed
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [&] { return closed_ || items_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        items_.push_back(std::move(item));
+        if (items_.size() > high_water_) {
+            high_water_ = items_.size();
+        }
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // Blocks while empty; false once the channel is closed and drained
+    bool pop(T &item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [&] { return closed_ || !items_.empty(); });
+        if (items_.empty()) {
+            return false;
+        }
+        item = std::move(items_.front());
+        items_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    // Wakes every waiter; queued items can still be popped
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+    size_t capacity() const { return capacity_; }
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+    size_t high_water() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return high_water_;
+    }
+
+private:
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<T> items_;
+    size_t high_water_ = 0;
+    bool closed_ = false;
+};
+
+// Per-stage counters from one Pipeline::run. Times are summed over the
+// stage's workers: starved_s waiting for input, busy_s in the stage
+// function, blocked_s waiting for room downstream.
+struct StageMetrics {
+    std::string name;
+    unsigned workers = 0;
+    uint64_t items_in = 0;
+    uint64_t items_out = 0;
+    uint64_t errors = 0;
+    double busy_s = 0.0;
+    double starved_s = 0.0;
+    double blocked_s = 0.0;
+    size_t queue_high_water = 0;  // of the stage's input channel
+    std::string first_error;
+};
+
+// Linear chain of stages joined by bounded channels. Each stage runs its
+// function on `workers` threads, so its concurrency is capped independently
+// of the others, and at most capacity + workers items wait at each stage.
+// An item whose stage function throws is counted and dropped; the rest of
+// the run continues.
+template <class T>
+class Pipeline {
+public:
+    using StageFn = std::function<void(T &)>;
+
+    explicit Pipeline(size_t channel_capacity = 4) : capacity_(channel_capacity) {
+        if (capacity_ < 1) {
+            throw std::invalid_argument("channel capacity must be >= 1");
+        }
+    }
+
+    Pipeline &stage(std::string name, unsigned workers, StageFn fn) {
+        if (workers < 1) {
+            throw std::invalid_argument("stage '" + name + "' needs at least one worker");
+        }
+        stages_.push_back(Stage{std::move(name), workers, std::move(fn)});
+        return *this;
+    }
+
+    // Feeds items through every stage in order and returns once the last
+    // stage has drained. Items leaving the last stage are discarded.
+    std::vector<StageMetrics> run(std::vector<T> items) {
+        const size_t n_stages = stages_.size();
+        std::vector<std::unique_ptr<BoundedChannel<T>>> inputs;
+        for (size_t s = 0; s < n_stages; ++s) {
+            inputs.push_back(std::make_unique<BoundedChannel<T>>(capacity_));
+        }
+        std::vector<StageMetrics> metrics(n_stages);
+        std::vector<std::mutex> metric_mutex(n_stages);
+        std::unique_ptr<std::atomic<unsigned>[]> running(new std::atomic<unsigned>[n_stages]);
+        for (size_t s = 0; s < n_stages; ++s) {
+            metrics[s].name = stages_[s].name;
+            metrics[s].workers = stages_[s].workers;
+            running[s] = stages_[s].workers;
+        }
+
+        std::vector<std::thread> threads;
+        for (size_t s = 0; s < n_stages; ++s) {
+            for (unsigned w = 0; w < stages_[s].workers; ++w) {
+                threads.emplace_back([&, s] {
+                    StageMetrics local;
+                    run_worker(stages_[s].fn, *inputs[s],
+                               s + 1 < n_stages ? inputs[s + 1].get() : nullptr, local);
+                    {
+                        std::lock_guard<std::mutex> lock(metric_mutex[s]);
+                        merge(metrics[s], local);
+                    }
+                    // The last worker out closes the next stage's input
+                    if (running[s].fetch_sub(1) == 1 && s + 1 < n_stages) {
+                        inputs[s + 1]->close();
+                    }
+                });
+            }
+        }
+
+        if (n_stages > 0) {
+            for (T &item : items) {
+                inputs[0]->push(std::move(item));
+            }
+            inputs[0]->close();
+        }
+        for (std::thread &t : threads) {
+            t.join();
+        }
+        for (size_t s = 0; s < n_stages; ++s) {
+            metrics[s].queue_high_water = inputs[s]->high_water();
+        }
+        return metrics;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stage {
+        std::string name;
+        unsigned workers;
+        StageFn fn;
+    };
+
+    static double seconds(Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<double>(b - a).count();
+    }
+
+    static void run_worker(const StageFn &fn, BoundedChannel<T> &in, BoundedChannel<T> *out,
+                           StageMetrics &m) {
+        T item;
+        for (;;) {
+            const Clock::time_point t0 = Clock::now();
+            if (!in.pop(item)) {
+                m.starved_s += seconds(t0, Clock::now());
+                return;
+            }
+            const Clock::time_point t1 = Clock::now();
+            m.starved_s += seconds(t0, t1);
+            ++m.items_in;
+            bool ok = true;
+            try {
+                fn(item);
+            } catch (const std::exception &e) {
+                ok = false;
+                if (m.errors++ == 0) {
+                    m.first_error = e.what();
+                }
+            }
+            const Clock::time_point t2 = Clock::now();
+            m.busy_s += seconds(t1, t2);
+            if (!ok) {
+                continue;
+            }
+            ++m.items_out;
+            if (out) {
+                out->push(std::move(item));
+                m.blocked_s += seconds(t2, Clock::now());
+            }
+            item = T();
+        }
+    }
+
+    static void merge(StageMetrics &into, const StageMetrics &from) {
+        into.items_in += from.items_in;
+        into.items_out += from.items_out;
+        if (into.errors == 0 && from.errors > 0) {
+            into.first_error = from.first_error;
+        }
+        into.errors += from.errors;
+        into.busy_s += from.busy_s;
+        into.starved_s += from.starved_s;
+        into.blocked_s += from.blocked_s;
+    }
+
+    size_t capacity_;
+    std::vector<Stage> stages_;
+};
+
+// ---- Directory batch pipeline ----
+
+struct BatchPipelineOptions {
+    std::string input_dir;    // every *.csv file in it is one job
+    std::string output_dir;   // <output_dir>/<file name>, created if needed
+    std::string model_path;   // .astree; no score stage when empty
+    FrameOptions frame;
+    unsigned read_workers = 2;
+    unsigned feature_workers = 0;  // 0 = hardware concurrency
+    unsigned score_workers = 1;    // predict_batch already fans out over the shared pool
+    unsigned write_workers = 2;
+    size_t channel_capacity = 4;
+};
+
+struct BatchPipelineReport {
+    size_t files = 0;
+    size_t written = 0;
+    double wall_s = 0.0;
+    std::vector<StageMetrics> stages;
+};
+
+// ingest -> features (indicators + returns/candles/calendar) -> score ->
+// write. Files that fail are skipped and counted in their stage's errors.
+// Throws std::runtime_error if the directories or the model are unusable.
+BatchPipelineReport run_batch_pipeline(const BatchPipelineOptions &opts);
+
+}  // namespace alphasignal
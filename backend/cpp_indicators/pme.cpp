@@ -0,0 +1,206 @@
+#include "pme.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "arena.h"
+#include "thread_pool.h"
+
+namespace alphasignal {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+PmeMetrics missing_pme() {
+    PmeMetrics m;
+    m.fv_contributions = m.fv_distributions = m.ks_pme = m.ln_irr = m.direct_alpha = kNaN;
+    return m;
+}
+
+// One deal's flows and where their dates sit in the shared level table
+struct DealSlots {
+    size_t begin;  // range in the flow / slot scratch
+    size_t end;
+    uint32_t valuation_slot;
+    int32_t valuation_day;
+    double nav;
+};
+
+// Compound one deal's flows to its valuation day under one benchmark's
+// levels, adding them to m's FV sums, the Long-Nickels flows (actual flows
+// plus the index replica's NAV) to ln and the compounded flows plus NAV to
+// da. False if the benchmark has no level for some date.
+bool compound(const CashFlowPoint *cf, const uint32_t *slot, const DealSlots &d,
+              const double *level, ScratchVector<CashFlowPoint> &ln,
+              ScratchVector<CashFlowPoint> &da, PmeMetrics &m) {
+    const double end = level[d.valuation_slot];
+    if (is_missing(end)) {
+        return false;
+    }
+    double fv_in = 0.0, fv_out = 0.0;
+    for (size_t k = d.begin; k < d.end; ++k) {
+        const double start = level[slot[k]];
+        if (is_missing(start) || start <= 0.0) {
+            return false;
+        }
+        const double a = cf[k].amount * (end / start);
+        if (a < 0.0) {
+            fv_in -= a;
+        } else {
+            fv_out += a;
+        }
+        ln.push_back(cf[k]);
+        da.push_back(CashFlowPoint{cf[k].day, a});
+    }
+    if (fv_in != fv_out) {
+        ln.push_back(CashFlowPoint{d.valuation_day, fv_in - fv_out});
+    }
+    if (d.nav != 0.0) {
+        da.push_back(CashFlowPoint{d.valuation_day, d.nav});
+    }
+    m.fv_contributions += fv_in;
+    m.fv_distributions += fv_out;
+    return true;
+}
+
+// KS ratio and both IRRs; seeds carry the last solution to the next benchmark
+void finish(PmeMetrics &m, double nav, const ScratchVector<CashFlowPoint> &ln,
+            const ScratchVector<CashFlowPoint> &da, double &ln_seed, double &da_seed) {
+    m.ks_pme = m.fv_contributions > 0.0 ? (m.fv_distributions + nav) / m.fv_contributions : kNaN;
+    m.ln_irr = xirr(ln.data(), ln.size(), ln_seed);
+    m.direct_alpha = xirr(da.data(), da.size(), da_seed);
+    if (!is_missing(m.ln_irr)) {
+        ln_seed = m.ln_irr;
+    }
+    if (!is_missing(m.direct_alpha)) {
+        da_seed = m.direct_alpha;
+    }
+}
+
+void sort_by_day(ScratchVector<CashFlowPoint> &v) {
+    std::stable_sort(v.begin(), v.end(),
+                     [](const CashFlowPoint &x, const CashFlowPoint &y) { return x.day < y.day; });
+}
+
+}  // namespace
+
+PmeReport compute_pme(const FlowTable &flows, const DealInputs &deals,
+                      const BenchmarkTable &benchmarks) {
+    const size_t n_deals = flows.batch.n_series;
+    const size_t n_bench = benchmarks.batch.n_series;
+    const size_t n_flows = flows.batch.total_rows();
+
+    // Distinct dates any flow or valuation can fall on
+    std::vector<int32_t> dates(flows.day, flows.day + n_flows);
+    dates.push_back(deals.as_of_day);
+    std::sort(dates.begin(), dates.end());
+    dates.erase(std::unique(dates.begin(), dates.end()), dates.end());
+    const size_t n_dates = dates.size();
+
+    // As-of level of every benchmark on every date: one merge per benchmark
+    std::vector<double> levels(n_bench * n_dates);
+    parallel_for(n_bench, [&](size_t b) {
+        const size_t begin = benchmarks.batch.begin(b);
+        const size_t len = benchmarks.batch.length(b);
+        const int32_t *day = benchmarks.day + begin;
+        const double *level = benchmarks.level + begin;
+        for (size_t i = 1; i < len; ++i) {
+            if (day[i] < day[i - 1]) {
+                throw std::invalid_argument("benchmark days must ascend within each benchmark");
+            }
+        }
+        double *out = levels.data() + b * n_dates;
+        double last = kNaN;
+        size_t next = 0;
+        for (size_t u = 0; u < n_dates; ++u) {
+            while (next < len && day[next] <= dates[u]) {
+                if (!is_missing(level[next])) {
+                    last = level[next];
+                }
+                ++next;
+            }
+            out[u] = last;
+        }
+    });
+    auto slot_of = [&dates](int32_t day) {
+        return static_cast<uint32_t>(std::lower_bound(dates.begin(), dates.end(), day) -
+                                     dates.begin());
+    };
+
+    // Gathers deal i's signed flows and date slots into cf / slot
+    auto load_deal = [&](size_t i, ScratchVector<CashFlowPoint> &cf,
+                         ScratchVector<uint32_t> &slot) {
+        PerformanceMetrics pm;
+        DealSlots d;
+        d.begin = cf.size();
+        d.valuation_day = deal_cash_flows(flows, deals, i, cf, pm);
+        d.end = cf.size();
+        d.valuation_slot = slot_of(d.valuation_day);
+        d.nav = pm.nav;
+        for (size_t k = d.begin; k < d.end; ++k) {
+            slot.push_back(slot_of(cf[k].day));
+        }
+        return d;
+    };
+
+    const FundMembers members = group_by_fund(deals, n_deals);
+    PmeReport report;
+    report.n_benchmarks = n_bench;
+    report.deals.resize(n_bench * n_deals);
+    report.funds.resize(n_bench * deals.n_funds);
+
+    parallel_for(n_deals, [&](size_t i) {
+        ArenaScope scope;
+        ScratchVector<CashFlowPoint> cf(&scope.arena()), ln(&scope.arena()), da(&scope.arena());
+        ScratchVector<uint32_t> slot(&scope.arena());
+        const DealSlots d = load_deal(i, cf, slot);
+        ln.reserve(cf.size() + 1);
+        da.reserve(cf.size() + 1);
+        double ln_seed = kNaN, da_seed = kNaN;
+        for (size_t b = 0; b < n_bench; ++b) {
+            PmeMetrics &m = report.deals[b * n_deals + i];
+            ln.clear();
+            da.clear();
+            if (!compound(cf.data(), slot.data(), d, levels.data() + b * n_dates, ln, da, m)) {
+                m = missing_pme();
+                continue;
+            }
+            finish(m, d.nav, ln, da, ln_seed, da_seed);
+        }
+    });
+
+    parallel_for(deals.n_funds, [&](size_t f) {
+        ArenaScope scope;
+        ScratchVector<CashFlowPoint> cf(&scope.arena()), ln(&scope.arena()), da(&scope.arena());
+        ScratchVector<uint32_t> slot(&scope.arena());
+        ScratchVector<DealSlots> member_slots(&scope.arena());
+        double nav = 0.0;
+        for (size_t k = members.start[f]; k < members.start[f + 1]; ++k) {
+            member_slots.push_back(load_deal(members.deals[k], cf, slot));
+            nav += member_slots.back().nav;
+        }
+        double ln_seed = kNaN, da_seed = kNaN;
+        for (size_t b = 0; b < n_bench; ++b) {
+            PmeMetrics &m = report.funds[b * deals.n_funds + f];
+            ln.clear();
+            da.clear();
+            bool ok = true;
+            for (const DealSlots &d : member_slots) {
+                ok = ok && compound(cf.data(), slot.data(), d, levels.data() + b * n_dates, ln,
+                                    da, m);
+            }
+            if (!ok) {
+                m = missing_pme();
+                continue;
+            }
+            sort_by_day(ln);
+            sort_by_day(da);
+            finish(m, nav, ln, da, ln_seed, da_seed);
+        }
+    });
+    return report;
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "batch.h"
+#include "fund_metrics.h"
+
+namespace alphasignal {
+
+// Index levels (adj_close) of several benchmarks laid out by batch, days
+// (epoch days) ascending within each. NaN levels are skipped.
+struct BenchmarkTable {
+    const int32_t *day;
+    const double *level;
+    RaggedBatch batch;
+};
+
+// Public-market equivalents of one deal or fund against one benchmark.
+// Every flow is compounded to the valuation day by I(valuation) / I(day),
+// I being the last level on or before the day. NaN when the benchmark has
+// no level for some flow.
+struct PmeMetrics {
+    double fv_contributions = 0.0;
+    double fv_distributions = 0.0;
+    double ks_pme = 0.0;        // Kaplan-Schoar: (FV distributions + NAV) / FV contributions
+    double ln_irr = 0.0;        // Long-Nickels: IRR of the actual flows with the NAV replaced
+                                // by FV contributions - FV distributions
+    double direct_alpha = 0.0;  // IRR of the compounded flows plus NAV (Gredil et al.)
+};
+
+// Row-major (n_benchmarks, n) tables
+struct PmeReport {
+    size_t n_benchmarks = 0;
+    std::vector<PmeMetrics> deals;
+    std::vector<PmeMetrics> funds;  // pooled flows of each fund's deals
+};
+
+// PMEs of every deal against every benchmark, and of every fund from its
+// deals' flows pooled. Flows and NAV follow compute_performance. The index
+// level of each distinct flow date is found in one merge pass per
+// benchmark; deals then run in parallel, each benchmark's IRRs seeded with
+// the previous benchmark's.
+PmeReport compute_pme(const FlowTable &flows, const DealInputs &deals,
+                      const BenchmarkTable &benchmarks);
+
+}  // namespace alphasignal
@@ -0,0 +1,457 @@
+#include "prediction_log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+
+namespace alphasignal {
+
+namespace {
+
+// Journal layout, little-endian: "ASPL", u32 version, then records
+//   'P' i64 id, i32 day, f64 confidence, u8 len + ticker, u8 len + model
+//   'R' i64 id, u8 correct
+constexpr char kMagic[4] = {'A', 'S', 'P', 'L'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = sizeof(kMagic) + sizeof(uint32_t);
+
+template <typename T>
+void put(std::string &buf, T v) {
+    buf.append(reinterpret_cast<const char *>(&v), sizeof(T));
+}
+
+void put_string(std::string &buf, const std::string &s) {
+    put<uint8_t>(buf, static_cast<uint8_t>(s.size()));
+    buf += s;
+}
+
+// Bounds-checked record reader; false at a torn or short record
+class RecordReader {
+public:
+    RecordReader(const std::string &bytes, size_t pos) : bytes_(bytes), pos_(pos) {}
+
+    template <typename T>
+    bool get(T &v) {
+        if (bytes_.size() - pos_ < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&v, bytes_.data() + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    bool get_string(std::string &s) {
+        uint8_t len;
+        if (!get(len) || bytes_.size() - pos_ < len) {
+            return false;
+        }
+        s.assign(bytes_, pos_, len);
+        pos_ += len;
+        return true;
+    }
+
+    size_t pos() const { return pos_; }
+    bool done() const { return pos_ == bytes_.size(); }
+
+private:
+    const std::string &bytes_;
+    size_t pos_;
+};
+
+// Throws if the journal cannot take every byte
+void write_journal(std::FILE *journal, const std::string &records) {
+    if (std::fwrite(records.data(), 1, records.size(), journal) != records.size() ||
+        std::fflush(journal) != 0) {
+        throw std::runtime_error("cannot write prediction log journal");
+    }
+}
+
+}  // namespace
+
+PredictionLog::PredictionLog(const std::string &journal_path) {
+    if (journal_path.empty()) {
+        return;
+    }
+    replay(journal_path);
+    journal_ = std::fopen(journal_path.c_str(), "ab");
+    if (!journal_) {
+        throw std::runtime_error("cannot open prediction log: " + journal_path);
+    }
+    std::fseek(journal_, 0, SEEK_END);
+    if (std::ftell(journal_) == 0) {
+        std::string header(kMagic, sizeof(kMagic));
+        put<uint32_t>(header, kVersion);
+        try {
+            write_journal(journal_, header);
+        } catch (...) {
+            std::fclose(journal_);
+            throw;
+        }
+    }
+}
+
+PredictionLog::~PredictionLog() {
+    if (journal_) {
+        std::fclose(journal_);
+    }
+}
+
+void PredictionLog::replay(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return;  // new log
+    }
+    const std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    if (bytes.empty()) {
+        return;
+    }
+    uint32_t version = 0;
+    if (bytes.size() < kHeaderSize || std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("not a prediction log: " + path);
+    }
+    std::memcpy(&version, bytes.data() + sizeof(kMagic), sizeof(version));
+    if (version != kVersion) {
+        throw std::runtime_error("unsupported prediction log version");
+    }
+
+    size_t good = kHeaderSize;
+    RecordReader r(bytes, good);
+    std::string ticker, model;
+    while (!r.done()) {
+        uint8_t type;
+        int64_t id;
+        if (!r.get(type) || !r.get(id)) {
+            break;
+        }
+        if (type == 'P') {
+            int32_t day;
+            double confidence;
+            if (!r.get(day) || !r.get(confidence) || !r.get_string(ticker) ||
+                !r.get_string(model)) {
+                break;
+            }
+            append_locked(id, ticker, model, day, confidence);
+        } else if (type == 'R') {
+            uint8_t correct;
+            if (!r.get(correct)) {
+                break;
+            }
+            resolve_locked(id, correct);
+        } else {
+            throw std::runtime_error("corrupt prediction log record at byte " +
+                                     std::to_string(r.pos()));
+        }
+        good = r.pos();
+    }
+
+    if (good != bytes.size()) {
+        // A crash mid-append left a partial record; later appends follow the last whole one
+        std::error_code ec;
+        std::filesystem::resize_file(path, good, ec);
+        if (ec) {
+            throw std::runtime_error("cannot trim torn prediction log record: " + ec.message());
+        }
+    }
+}
+
+int32_t PredictionLog::code(std::vector<std::string> &names,
+                            std::unordered_map<std::string, int32_t> &index,
+                            const std::string &name) {
+    const auto it = index.find(name);
+    if (it != index.end()) {
+        return it->second;
+    }
+    const int32_t c = static_cast<int32_t>(names.size());
+    names.push_back(name);
+    index.emplace(name, c);
+    return c;
+}
+
+int32_t PredictionLog::filter_code(const std::unordered_map<std::string, int32_t> &index,
+                                   const std::string &name) {
+    if (name.empty()) {
+        return -1;
+    }
+    const auto it = index.find(name);
+    return it == index.end() ? -2 : it->second;
+}
+
+size_t PredictionLog::append_locked(int64_t id, const std::string &ticker,
+                                    const std::string &model, int32_t day, double confidence) {
+    if (row_of_.count(id)) {
+        return 0;
+    }
+    row_of_.emplace(id, static_cast<uint32_t>(id_.size()));
+    id_.push_back(id);
+    ticker_.push_back(code(tickers_, ticker_index_, ticker));
+    model_.push_back(code(models_, model_index_, model));
+    day_.push_back(day);
+    confidence_.push_back(confidence);
+    outcome_.push_back(kUnresolved);
+    last_id_ = std::max(last_id_, id);
+    return 1;
+}
+
+bool PredictionLog::resolve_locked(int64_t id, uint8_t correct) {
+    const auto it = row_of_.find(id);
+    if (it == row_of_.end()) {
+        return false;
+    }
+    const int8_t outcome = correct ? 1 : 0;
+    if (outcome_[it->second] == outcome) {
+        return false;
+    }
+    outcome_[it->second] = outcome;
+    return true;
+}
+
+void PredictionLog::check_journal_locked() const {
+    if (journal_failed_) {
+        throw std::runtime_error("prediction log journal write failed; reopen the log");
+    }
+}
+
+void PredictionLog::write_locked(const std::string &records) {
+    try {
+        write_journal(journal_, records);
+    } catch (...) {
+        // The rows are in memory but not on disk. Refusing further writes
+        // keeps every later row out of the journal too, so reopening replays
+        // a prefix and last_id() tells the caller where to resume.
+        journal_failed_ = true;
+        throw;
+    }
+}
+
+size_t PredictionLog::append(const int64_t *ids, const std::string *tickers,
+                             const std::string *models, const int32_t *days,
+                             const double *confidence, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (tickers[i].size() > 255 || models[i].size() > 255) {
+            throw std::invalid_argument("ticker / model version longer than 255 bytes");
+        }
+    }
+    std::string records;
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    check_journal_locked();
+    size_t added = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!append_locked(ids[i], tickers[i], models[i], days[i], confidence[i])) {
+            continue;
+        }
+        ++added;
+        if (journal_) {
+            put<uint8_t>(records, 'P');
+            put<int64_t>(records, ids[i]);
+            put<int32_t>(records, days[i]);
+            put<double>(records, confidence[i]);
+            put_string(records, tickers[i]);
+            put_string(records, models[i]);
+        }
+    }
+    if (journal_ && !records.empty()) {
+        write_locked(records);
+    }
+    return added;
+}
+
+size_t PredictionLog::resolve(const int64_t *ids, const uint8_t *correct, size_t n) {
+    std::string records;
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    check_journal_locked();
+    size_t changed = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!resolve_locked(ids[i], correct[i])) {
+            continue;
+        }
+        ++changed;
+        if (journal_) {
+            put<uint8_t>(records, 'R');
+            put<int64_t>(records, ids[i]);
+            put<uint8_t>(records, correct[i] ? 1 : 0);
+        }
+    }
+    if (journal_ && !records.empty()) {
+        write_locked(records);
+    }
+    return changed;
+}
+
+size_t PredictionLog::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return id_.size();
+}
+
+bool PredictionLog::contains(int64_t id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return row_of_.count(id) != 0;
+}
+
+int64_t PredictionLog::last_id() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return last_id_;
+}
+
+std::vector<int64_t> PredictionLog::unresolved_ids() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<int64_t> ids;
+    for (size_t r = 0; r < id_.size(); ++r) {
+        if (outcome_[r] == kUnresolved) {
+            ids.push_back(id_[r]);
+        }
+    }
+    return ids;
+}
+
+int64_t PredictionLog::min_unresolved_id() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    int64_t best = 0;
+    for (size_t r = 0; r < id_.size(); ++r) {
+        if (outcome_[r] == kUnresolved && (best == 0 || id_[r] < best)) {
+            best = id_[r];
+        }
+    }
+    return best;
+}
+
+template <class Visit>
+void PredictionLog::scan(const PredictionFilter &filter, Visit visit) const {
+    const int32_t ticker = filter_code(ticker_index_, filter.ticker);
+    const int32_t model = filter_code(model_index_, filter.model_version);
+    if (ticker == -2 || model == -2) {
+        return;
+    }
+    const size_t n = id_.size();
+    const int32_t *t = ticker_.data();
+    const int32_t *m = model_.data();
+    const int32_t *d = day_.data();
+    for (size_t r = 0; r < n; ++r) {
+        if ((ticker >= 0 && t[r] != ticker) || (model >= 0 && m[r] != model) ||
+            d[r] < filter.from_day || d[r] > filter.to_day) {
+            continue;
+        }
+        visit(r);
+    }
+}
+
+namespace {
+
+void count_row(AccuracySummary &s, double confidence, int8_t outcome) {
+    ++s.predictions;
+    if (outcome < 0) {
+        return;
+    }
+    AccuracyCount &b = s.buckets[confidence_bucket(confidence)];
+    ++s.all.total;
+    ++b.total;
+    s.all.correct += static_cast<uint64_t>(outcome);
+    b.correct += static_cast<uint64_t>(outcome);
+}
+
+}  // namespace
+
+AccuracySummary PredictionLog::accuracy(const PredictionFilter &filter) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    AccuracySummary s;
+    scan(filter, [&](size_t r) { count_row(s, confidence_[r], outcome_[r]); });
+    return s;
+}
+
+std::vector<GroupAccuracy> PredictionLog::accuracy_by(GroupBy group,
+                                                      const PredictionFilter &filter) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<std::string> keys;
+    const int32_t *codes = nullptr;
+    switch (group) {
+        case GroupBy::Ticker:
+            keys = tickers_;
+            codes = ticker_.data();
+            break;
+        case GroupBy::ModelVersion:
+            keys = models_;
+            codes = model_.data();
+            break;
+        case GroupBy::Bucket:
+            keys = {"low", "medium", "high"};
+            break;
+    }
+    std::vector<AccuracySummary> sums(keys.size());
+    scan(filter, [&](size_t r) {
+        const size_t k = codes ? static_cast<size_t>(codes[r])
+                               : static_cast<size_t>(confidence_bucket(confidence_[r]));
+        count_row(sums[k], confidence_[r], outcome_[r]);
+    });
+
+    std::vector<GroupAccuracy> out;
+    for (size_t k = 0; k < keys.size(); ++k) {
+        if (sums[k].predictions > 0) {
+            out.push_back(GroupAccuracy{keys[k], sums[k]});
+        }
+    }
+    if (group != GroupBy::Bucket) {
+        std::sort(out.begin(), out.end(),
+                  [](const GroupAccuracy &a, const GroupAccuracy &b) { return a.key < b.key; });
+    }
+    return out;
+}
+
+RollingAccuracy PredictionLog::rolling_accuracy(const PredictionFilter &filter,
+                                                int32_t window_days) const {
+    if (window_days < 1) {
+        throw std::invalid_argument("window_days must be >= 1");
+    }
+    // Resolved (day, correct) pairs, then per-day totals, then a two-pointer window
+    std::vector<std::pair<int32_t, int8_t>> rows;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        scan(filter, [&](size_t r) {
+            if (outcome_[r] >= 0) {
+                rows.emplace_back(day_[r], outcome_[r]);
+            }
+        });
+    }
+    std::sort(rows.begin(), rows.end(),
+              [](const std::pair<int32_t, int8_t> &a, const std::pair<int32_t, int8_t> &b) {
+                  return a.first < b.first;
+              });
+
+    std::vector<int32_t> days;
+    std::vector<uint64_t> day_total, day_correct;
+    for (const auto &row : rows) {
+        if (days.empty() || days.back() != row.first) {
+            days.push_back(row.first);
+            day_total.push_back(0);
+            day_correct.push_back(0);
+        }
+        ++day_total.back();
+        day_correct.back() += static_cast<uint64_t>(row.second);
+    }
+
+    RollingAccuracy out;
+    out.days = days;
+    out.total.resize(days.size());
+    out.correct.resize(days.size());
+    uint64_t total = 0, correct = 0;
+    size_t lo = 0;
+    for (size_t i = 0; i < days.size(); ++i) {
+        total += day_total[i];
+        correct += day_correct[i];
+        // Window is (day - window_days, day]
+        while (days[lo] <= days[i] - window_days) {
+            total -= day_total[lo];
+            correct -= day_correct[lo];
+            ++lo;
+        }
+        out.total[i] = total;
+        out.correct[i] = correct;
+    }
+    return out;
+}
+
+}  // namespace alphasignal
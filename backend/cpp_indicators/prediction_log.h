@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace alphasignal {
+
+// Rows to aggregate; empty strings match everything
+struct PredictionFilter {
+    std::string ticker;
+    std::string model_version;
+    int32_t from_day = std::numeric_limits<int32_t>::min();  // epoch days, inclusive
+    int32_t to_day = std::numeric_limits<int32_t>::max();
+};
+
+struct AccuracyCount {
+    uint64_t total = 0;    // resolved predictions
+    uint64_t correct = 0;
+};
+
+// Confidence buckets of the accuracy endpoint
+enum ConfidenceBucket { kLowConfidence = 0, kMediumConfidence = 1, kHighConfidence = 2 };
+constexpr int kNumConfidenceBuckets = 3;
+
+// low < 0.6 <= medium <= 0.7 < high
+inline int confidence_bucket(double confidence) {
+    return confidence > 0.7 ? kHighConfidence
+                            : (confidence >= 0.6 ? kMediumConfidence : kLowConfidence);
+}
+
+struct AccuracySummary {
+    uint64_t predictions = 0;  // matching rows, resolved or not
+    AccuracyCount all;
+    AccuracyCount buckets[kNumConfidenceBuckets];
+};
+
+struct GroupAccuracy {
+    std::string key;
+    AccuracySummary summary;
+};
+
+struct RollingAccuracy {
+    std::vector<int32_t> days;        // prediction days with resolved rows, ascending
+    std::vector<uint64_t> total;      // resolved predictions in the trailing window
+    std::vector<uint64_t> correct;
+};
+
+// Append-only columnar mirror of the Predictions table: one column per
+// field the accuracy queries read, tickers and model versions dictionary
+// coded, plus an id -> row index for outcome resolution. Aggregates are
+// single passes over the columns. With a journal path every append and
+// resolution is also written to disk as a compact binary record and
+// replayed on open, so a restart only needs the rows added since
+// (see last_id()).
+// Readers share a lock; appends take it exclusively.
+class PredictionLog {
+public:
+    // Empty path = memory only. Throws std::runtime_error if the journal
+    // cannot be opened or is not a prediction log; a torn final record is
+    // dropped.
+    explicit PredictionLog(const std::string &journal_path = "");
+    ~PredictionLog();
+
+    PredictionLog(const PredictionLog &) = delete;
+    PredictionLog &operator=(const PredictionLog &) = delete;
+
+    // Rows whose id is already present are skipped. Returns rows added.
+    // append / resolve throw std::runtime_error if the journal write fails.
+    // The rows are kept in memory but not journaled, and every later
+    // append / resolve throws until the log is reopened, which replays the
+    // journaled prefix (last_id() then says where to resume).
+    size_t append(const int64_t *ids, const std::string *tickers, const std::string *models,
+                  const int32_t *days, const double *confidence, size_t n);
+    // correct: 0/1. Unknown ids and repeats of the same outcome are ignored.
+    // Returns rows whose outcome changed.
+    size_t resolve(const int64_t *ids, const uint8_t *correct, size_t n);
+
+    size_t size() const;
+    bool contains(int64_t id) const;
+    int64_t last_id() const;            // largest id seen, or 0
+    int64_t min_unresolved_id() const;  // smallest id without an outcome, or 0
+    std::vector<int64_t> unresolved_ids() const;  // ids without an outcome
+
+    AccuracySummary accuracy(const PredictionFilter &filter) const;
+    enum class GroupBy { Ticker, ModelVersion, Bucket };
+    // One entry per key with matching rows, sorted by key
+    std::vector<GroupAccuracy> accuracy_by(GroupBy group, const PredictionFilter &filter) const;
+    // Accuracy over the window_days calendar days ending at each prediction day
+    RollingAccuracy rolling_accuracy(const PredictionFilter &filter, int32_t window_days) const;
+
+private:
+    static constexpr int8_t kUnresolved = -1;
+
+    int32_t code(std::vector<std::string> &names, std::unordered_map<std::string, int32_t> &index,
+                 const std::string &name);
+    // Dictionary code of a filter string; -1 = any, -2 = matches nothing
+    static int32_t filter_code(const std::unordered_map<std::string, int32_t> &index,
+                               const std::string &name);
+    template <class Visit>
+    void scan(const PredictionFilter &filter, Visit visit) const;
+
+    size_t append_locked(int64_t id, const std::string &ticker, const std::string &model,
+                         int32_t day, double confidence);
+    bool resolve_locked(int64_t id, uint8_t correct);
+    void check_journal_locked() const;
+    void write_locked(const std::string &records);
+    void replay(const std::string &path);
+
+    mutable std::shared_mutex mutex_;
+    std::FILE *journal_ = nullptr;
+    bool journal_failed_ = false;
+
+    std::vector<int64_t> id_;
+    std::vector<int32_t> ticker_;
+    std::vector<int32_t> model_;
+    std::vector<int32_t> day_;
+    std::vector<double> confidence_;
+    std::vector<int8_t> outcome_;  // kUnresolved, 0 or 1
+    std::unordered_map<int64_t, uint32_t> row_of_;
+
+    std::vector<std::string> tickers_;
+    std::unordered_map<std::string, int32_t> ticker_index_;
+    std::vector<std::string> models_;
+    std::unordered_map<std::string, int32_t> model_index_;
+
+    int64_t last_id_ = 0;
+};
+
+}  // namespace alphasignal
@@ -0,0 +1,196 @@
+#include "protocol.h"
+
+#include <algorithm>
+
+namespace alphasignal {
+
+namespace {
+
+// Upper bound on counts read from the wire before anything is allocated
+void check_count(uint64_t count, size_t min_bytes_each, const WireReader &in) {
+    if (count * min_bytes_each > in.remaining()) {
+        throw ProtocolError("message is truncated");
+    }
+}
+
+void expect_end(const WireReader &in) {
+    if (in.remaining() != 0) {
+        throw ProtocolError("trailing bytes in message");
+    }
+}
+
+}  // namespace
+
+const std::vector<std::string> &service_feature_names() {
+    static const std::vector<std::string> names = {
+        "rsi",      "macd",     "macd_signal", "macd_hist", "bb_middle", "bb_upper",
+        "bb_lower", "bb_percent", "return_1",  "return_5",  "return_20"};
+    return names;
+}
+
+void encode_header(const FrameHeader &header, uint8_t *out) {
+    std::memcpy(out, &header.magic, 4);
+    std::memcpy(out + 4, &header.version, 2);
+    std::memcpy(out + 6, &header.op, 2);
+    std::memcpy(out + 8, &header.request_id, 4);
+    std::memcpy(out + 12, &header.length, 4);
+}
+
+FrameHeader decode_header(const uint8_t *in) {
+    FrameHeader header;
+    std::memcpy(&header.magic, in, 4);
+    std::memcpy(&header.version, in + 4, 2);
+    std::memcpy(&header.op, in + 6, 2);
+    std::memcpy(&header.request_id, in + 8, 4);
+    std::memcpy(&header.length, in + 12, 4);
+    if (header.magic != kWireMagic) {
+        throw ProtocolError("bad frame magic");
+    }
+    if (header.version != kWireVersion) {
+        throw ProtocolError("unsupported protocol version " + std::to_string(header.version));
+    }
+    return header;
+}
+
+std::vector<uint8_t> make_frame(Op op, uint32_t request_id, const std::vector<uint8_t> &payload) {
+    FrameHeader header;
+    header.op = static_cast<uint16_t>(op);
+    header.request_id = request_id;
+    header.length = static_cast<uint32_t>(payload.size());
+    std::vector<uint8_t> frame(kFrameHeaderSize + payload.size());
+    encode_header(header, frame.data());
+    if (!payload.empty()) {
+        std::memcpy(frame.data() + kFrameHeaderSize, payload.data(), payload.size());
+    }
+    return frame;
+}
+
+void encode_indicator_request(const IndicatorRequest &req, std::vector<uint8_t> &out) {
+    WireWriter w(out);
+    w.put<uint32_t>(req.feature_mask);
+    w.put<uint32_t>(req.last_only ? kIndicatorLastOnly : 0u);
+    w.put<uint32_t>(static_cast<uint32_t>(req.tickers.size()));
+    for (size_t i = 0; i < req.tickers.size(); ++i) {
+        w.put<int32_t>(req.tickers[i]);
+        w.put<uint32_t>(static_cast<uint32_t>(req.closes[i].size()));
+        w.put_array(req.closes[i].data(), req.closes[i].size());
+    }
+}
+
+IndicatorRequest decode_indicator_request(const uint8_t *data, size_t size) {
+    WireReader in(data, size);
+    IndicatorRequest req;
+    req.feature_mask = in.get<uint32_t>();
+    req.last_only = (in.get<uint32_t>() & kIndicatorLastOnly) != 0;
+    const uint32_t n_series = in.get<uint32_t>();
+    check_count(n_series, 8, in);
+    req.tickers.resize(n_series);
+    req.closes.resize(n_series);
+    for (uint32_t i = 0; i < n_series; ++i) {
+        req.tickers[i] = in.get<int32_t>();
+        const uint32_t n = in.get<uint32_t>();
+        check_count(n, sizeof(double), in);
+        req.closes[i].resize(n);
+        in.get_array(req.closes[i].data(), n);
+    }
+    expect_end(in);
+    return req;
+}
+
+void encode_indicator_response(const IndicatorResponse &resp, std::vector<uint8_t> &out) {
+    WireWriter w(out);
+    w.put<uint32_t>(static_cast<uint32_t>(Status::Ok));
+    w.put<uint32_t>(resp.n_features);
+    w.put<uint32_t>(static_cast<uint32_t>(resp.series.size()));
+    for (const IndicatorSeries &s : resp.series) {
+        w.put<int32_t>(s.ticker);
+        w.put<uint32_t>(s.rows);
+        w.put_array(s.values.data(), s.values.size());
+    }
+}
+
+IndicatorResponse decode_indicator_response(const uint8_t *data, size_t size) {
+    WireReader in(data, size);
+    check_status(in);
+    IndicatorResponse resp;
+    resp.n_features = in.get<uint32_t>();
+    const uint32_t n_series = in.get<uint32_t>();
+    check_count(n_series, 8, in);
+    resp.series.resize(n_series);
+    for (IndicatorSeries &s : resp.series) {
+        s.ticker = in.get<int32_t>();
+        s.rows = in.get<uint32_t>();
+        const uint64_t n = uint64_t{s.rows} * resp.n_features;
+        check_count(n, sizeof(double), in);
+        s.values.resize(n);
+        in.get_array(s.values.data(), n);
+    }
+    expect_end(in);
+    return resp;
+}
+
+void encode_score_request(const ScoreRequest &req, std::vector<uint8_t> &out) {
+    WireWriter w(out);
+    w.put<uint32_t>(req.n_rows);
+    w.put<uint32_t>(req.n_features);
+    w.put_array(req.tickers.data(), req.tickers.size());
+    w.put_array(req.rows.data(), req.rows.size());
+}
+
+ScoreRequest decode_score_request(const uint8_t *data, size_t size) {
+    WireReader in(data, size);
+    ScoreRequest req;
+    req.n_rows = in.get<uint32_t>();
+    req.n_features = in.get<uint32_t>();
+    const uint64_t cells = uint64_t{req.n_rows} * req.n_features;
+    check_count(req.n_rows, sizeof(int32_t), in);
+    check_count(cells, sizeof(double), in);
+    req.tickers.resize(req.n_rows);
+    in.get_array(req.tickers.data(), req.n_rows);
+    req.rows.resize(cells);
+    in.get_array(req.rows.data(), cells);
+    expect_end(in);
+    return req;
+}
+
+void encode_score_response(const ScoreResponse &resp, std::vector<uint8_t> &out) {
+    WireWriter w(out);
+    w.put<uint32_t>(static_cast<uint32_t>(Status::Ok));
+    w.put<uint32_t>(static_cast<uint32_t>(resp.scores.size()));
+    w.put_array(resp.tickers.data(), resp.tickers.size());
+    w.put_array(resp.scores.data(), resp.scores.size());
+}
+
+ScoreResponse decode_score_response(const uint8_t *data, size_t size) {
+    WireReader in(data, size);
+    check_status(in);
+    ScoreResponse resp;
+    const uint32_t n = in.get<uint32_t>();
+    check_count(n, sizeof(int32_t) + sizeof(double), in);
+    resp.tickers.resize(n);
+    resp.scores.resize(n);
+    in.get_array(resp.tickers.data(), n);
+    in.get_array(resp.scores.data(), n);
+    expect_end(in);
+    return resp;
+}
+
+void encode_error(Status status, const std::string &message, std::vector<uint8_t> &out) {
+    WireWriter w(out);
+    w.put<uint32_t>(static_cast<uint32_t>(status));
+    w.put<uint32_t>(static_cast<uint32_t>(message.size()));
+    w.put_array(message.data(), message.size());
+}
+
+void check_status(WireReader &in) {
+    const auto status = static_cast<Status>(in.get<uint32_t>());
+    if (status == Status::Ok) {
+        return;
+    }
+    const uint32_t len = in.get<uint32_t>();
+    std::string message(std::min<size_t>(len, in.remaining()), '\0');
+    in.get_array(&message[0], message.size());
+    throw ServiceError(status, message);
+}
+
+}  // namespace alphasignal
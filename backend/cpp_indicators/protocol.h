@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace alphasignal {
+
+// Binary wire format of the indicator / scoring service. Every message is a
+// 16-byte header followed by `length` payload bytes; all integers and
+// floats are little-endian (the host byte order on every supported target).
+//
+//   header:   u32 magic "ASG1", u16 version, u16 op, u32 request_id, u32 length
+//
+//   Indicators request:  u32 feature_mask, u32 flags (bit 0: last row only),
+//                        u32 n_series, then per series: i32 ticker, u32 n, f64 close[n]
+//   Indicators response: u32 status, u32 n_features, u32 n_series, then per series:
+//                        i32 ticker, u32 rows, f64 values[n_features][rows]
+//   Score request:       u32 n_rows, u32 n_features, i32 ticker[n_rows],
+//                        f64 rows[n_rows][n_features]
+//   Score response:      u32 status, u32 n_rows, i32 ticker[n_rows], f64 score[n_rows]
+//   Ping:                empty request; response u32 status
+//
+// A response with a non-zero status carries u32 message length + message
+// instead of the body. Responses echo the request's op and request_id;
+// requests on one connection may be answered out of order.
+constexpr uint32_t kWireMagic = 0x31475341;  // "ASG1"
+constexpr uint16_t kWireVersion = 1;
+constexpr size_t kFrameHeaderSize = 16;
+
+enum class Op : uint16_t {
+    Ping = 0,
+    Indicators = 1,
+    Score = 2,
+};
+
+enum class Status : uint32_t {
+    Ok = 0,
+    BadRequest = 1,
+    NoModel = 2,
+    Internal = 3,
+};
+
+// Feature bits of an indicators request, in response row order
+enum ServiceFeature : int {
+    kSvcRsi = 0,
+    kSvcMacd,
+    kSvcMacdSignal,
+    kSvcMacdHist,
+    kSvcBbMiddle,
+    kSvcBbUpper,
+    kSvcBbLower,
+    kSvcBbPercent,
+    kSvcReturn1,   // log returns
+    kSvcReturn5,
+    kSvcReturn20,
+    kNumServiceFeatures
+};
+
+constexpr uint32_t kIndicatorLastOnly = 1u;
+
+const std::vector<std::string> &service_feature_names();
+
+class ProtocolError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Raised by the client when the server answers with a non-zero status
+class ServiceError : public std::runtime_error {
+public:
+    ServiceError(Status status, const std::string &message)
+        : std::runtime_error(message), status(status) {}
+    Status status;
+};
+
+struct FrameHeader {
+    uint32_t magic = kWireMagic;
+    uint16_t version = kWireVersion;
+    uint16_t op = 0;
+    uint32_t request_id = 0;
+    uint32_t length = 0;
+};
+
+void encode_header(const FrameHeader &header, uint8_t *out);
+// Throws ProtocolError on a bad magic or version
+FrameHeader decode_header(const uint8_t *in);
+
+class WireWriter {
+public:
+    explicit WireWriter(std::vector<uint8_t> &buf) : buf_(buf) {}
+
+    template <typename T>
+    void put(T v) {
+        put_array(&v, 1);
+    }
+
+    template <typename T>
+    void put_array(const T *data, size_t n) {
+        const size_t at = buf_.size();
+        buf_.resize(at + n * sizeof(T));
+        if (n > 0) {
+            std::memcpy(buf_.data() + at, data, n * sizeof(T));
+        }
+    }
+
+private:
+    std::vector<uint8_t> &buf_;
+};
+
+// Bounds-checked reader; arrays are copied out, so payloads need no alignment
+class WireReader {
+public:
+    WireReader(const uint8_t *data, size_t size) : p_(data), end_(data + size) {}
+
+    template <typename T>
+    T get() {
+        T v;
+        get_array(&v, 1);
+        return v;
+    }
+
+    template <typename T>
+    void get_array(T *out, size_t n) {
+        if (n > remaining() / sizeof(T)) {
+            throw ProtocolError("message is truncated");
+        }
+        if (n > 0) {
+            std::memcpy(out, p_, n * sizeof(T));
+        }
+        p_ += n * sizeof(T);
+    }
+
+    size_t remaining() const { return static_cast<size_t>(end_ - p_); }
+
+private:
+    const uint8_t *p_;
+    const uint8_t *end_;
+};
+
+struct IndicatorRequest {
+    uint32_t feature_mask = 0;
+    bool last_only = false;
+    std::vector<int32_t> tickers;
+    std::vector<std::vector<double>> closes;
+};
+
+struct IndicatorSeries {
+    int32_t ticker;
+    uint32_t rows;
+    std::vector<double> values;  // n_features x rows
+};
+
+struct IndicatorResponse {
+    uint32_t n_features = 0;
+    std::vector<IndicatorSeries> series;
+};
+
+struct ScoreRequest {
+    uint32_t n_rows = 0;
+    uint32_t n_features = 0;
+    std::vector<int32_t> tickers;
+    std::vector<double> rows;  // n_rows x n_features
+};
+
+struct ScoreResponse {
+    std::vector<int32_t> tickers;
+    std::vector<double> scores;
+};
+
+// Whole frame (header + payload)
+std::vector<uint8_t> make_frame(Op op, uint32_t request_id, const std::vector<uint8_t> &payload);
+
+void encode_indicator_request(const IndicatorRequest &req, std::vector<uint8_t> &out);
+IndicatorRequest decode_indicator_request(const uint8_t *data, size_t size);
+void encode_indicator_response(const IndicatorResponse &resp, std::vector<uint8_t> &out);
+IndicatorResponse decode_indicator_response(const uint8_t *data, size_t size);
+
+void encode_score_request(const ScoreRequest &req, std::vector<uint8_t> &out);
+ScoreRequest decode_score_request(const uint8_t *data, size_t size);
+void encode_score_response(const ScoreResponse &resp, std::vector<uint8_t> &out);
+ScoreResponse decode_score_response(const uint8_t *data, size_t size);
+
+void encode_error(Status status, const std::string &message, std::vector<uint8_t> &out);
+// Reads the leading status of a response; throws ServiceError if it is not Ok
+void check_status(WireReader &in);
+
+}  // namespace alphasignal
@@ -0,0 +1,191 @@
+#include "resample.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "arena.h"
+#include "calendar.h"
+#include "thread_pool.h"
+
+namespace alphasignal {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+inline int64_t floor_div(int64_t a, int64_t b) {
+    const int64_t q = a / b;
+    return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+}
+
+// Period key of `row`; `local` is the row's index within its ticker
+inline int64_t period_key(const int64_t *keys, size_t row, size_t local,
+                          const ResampleOptions &opts) {
+    switch (opts.period) {
+        case ResamplePeriod::Weekly:
+            // 1970-01-01 was a Thursday; shifting by 3 makes weeks start Monday
+            return floor_div(keys[row] + 3, 7);
+        case ResamplePeriod::Monthly: {
+            const CivilDate date = civil_from_days(keys[row]);
+            return int64_t{date.year} * 12 + date.month - 1;
+        }
+        case ResamplePeriod::Quarterly: {
+            const CivilDate date = civil_from_days(keys[row]);
+            return int64_t{date.year} * 4 + (date.month - 1) / 3;
+        }
+        case ResamplePeriod::Yearly:
+            return civil_from_days(keys[row]).year;
+        case ResamplePeriod::Bars:
+            return static_cast<int64_t>(local / static_cast<size_t>(opts.bars));
+        default:
+            return keys[row];
+    }
+}
+
+// OHLCV accumulator that skips NaN fields
+struct Accumulator {
+    double open, high, low, close, volume;
+
+    void reset() {
+        open = high = low = close = kNaN;
+        volume = 0.0;
+    }
+
+    void add(const OHLCVColumns &in, size_t row) {
+        if (is_missing(open)) {
+            open = in.open[row];
+        }
+        const double h = in.high[row], l = in.low[row], c = in.close[row], v = in.volume[row];
+        if (!is_missing(h)) {
+            high = is_missing(high) ? h : std::max(high, h);
+        }
+        if (!is_missing(l)) {
+            low = is_missing(low) ? l : std::min(low, l);
+        }
+        if (!is_missing(c)) {
+            close = c;
+        }
+        if (!is_missing(v)) {
+            volume += v;
+        }
+    }
+};
+
+}  // namespace
+
+ResamplePeriod parse_resample_period(const std::string &name) {
+    if (name == "W" || name == "weekly") {
+        return ResamplePeriod::Weekly;
+    }
+    if (name == "M" || name == "monthly") {
+        return ResamplePeriod::Monthly;
+    }
+    if (name == "Q" || name == "quarterly") {
+        return ResamplePeriod::Quarterly;
+    }
+    if (name == "Y" || name == "yearly") {
+        return ResamplePeriod::Yearly;
+    }
+    if (name == "bars") {
+        return ResamplePeriod::Bars;
+    }
+    if (name == "custom") {
+        return ResamplePeriod::Custom;
+    }
+    throw std::invalid_argument("unknown resample period: " + name);
+}
+
+ResampleResult resample_ohlcv(const OHLCVColumns &in, const int64_t *keys,
+                              const RaggedBatch &batch, const ResampleOptions &opts) {
+    if (opts.period == ResamplePeriod::Bars && opts.bars < 1) {
+        throw std::invalid_argument("bars must be at least 1");
+    }
+    if (opts.period != ResamplePeriod::Bars && keys == nullptr) {
+        throw std::invalid_argument("period keys (epoch days) are required");
+    }
+    const size_t total = batch.total_rows();
+    ResampleResult out;
+    out.period.resize(total);
+    out.last_complete.resize(total);
+    if (opts.running) {
+        out.run_open.resize(total);
+        out.run_high.resize(total);
+        out.run_low.resize(total);
+        out.run_close.resize(total);
+        out.run_volume.resize(total);
+    }
+
+    // Pass 1: bars per ticker, so every ticker can write its own slice
+    ArenaScope scope;
+    ScratchVector<int64_t> counts = scratch<int64_t>(batch.n_series, 0);
+    parallel_for(batch.n_series, [&](size_t i) {
+        const size_t b = batch.begin(i), n = batch.length(i);
+        int64_t count = 0, prev = 0;
+        for (size_t t = 0; t < n; ++t) {
+            const int64_t key = period_key(keys, b + t, t, opts);
+            count += (t == 0 || key != prev) ? 1 : 0;
+            prev = key;
+        }
+        counts[i] = count;
+    });
+    out.bar_offsets.assign(batch.n_series + 1, 0);
+    for (size_t i = 0; i < batch.n_series; ++i) {
+        out.bar_offsets[i + 1] = out.bar_offsets[i] + counts[i];
+    }
+    const size_t n_bars = static_cast<size_t>(out.bar_offsets.back());
+    out.open.resize(n_bars);
+    out.high.resize(n_bars);
+    out.low.resize(n_bars);
+    out.close.resize(n_bars);
+    out.volume.resize(n_bars);
+    out.first_row.resize(n_bars);
+    out.last_row.resize(n_bars);
+
+    // Pass 2: aggregate
+    parallel_for(batch.n_series, [&](size_t i) {
+        const size_t b = batch.begin(i), n = batch.length(i);
+        int64_t bar = out.bar_offsets[i] - 1;
+        int64_t prev = 0;
+        Accumulator acc;
+        acc.reset();
+        auto emit = [&]() {
+            out.open[bar] = acc.open;
+            out.high[bar] = acc.high;
+            out.low[bar] = acc.low;
+            out.close[bar] = acc.close;
+            out.volume[bar] = acc.volume;
+        };
+        for (size_t t = 0; t < n; ++t) {
+            const size_t row = b + t;
+            const int64_t key = period_key(keys, row, t, opts);
+            if (t == 0 || key != prev) {
+                if (t > 0) {
+                    emit();
+                    out.last_row[bar] = static_cast<int64_t>(row) - 1;
+                }
+                ++bar;
+                out.first_row[bar] = static_cast<int64_t>(row);
+                acc.reset();
+                prev = key;
+            }
+            acc.add(in, row);
+            out.period[row] = bar;
+            out.last_complete[row] = bar > out.bar_offsets[i] ? bar - 1 : -1;
+            if (opts.running) {
+                out.run_open[row] = acc.open;
+                out.run_high[row] = acc.high;
+                out.run_low[row] = acc.low;
+                out.run_close[row] = acc.close;
+                out.run_volume[row] = acc.volume;
+            }
+        }
+        if (n > 0) {
+            emit();
+            out.last_row[bar] = static_cast<int64_t>(b + n) - 1;
+        }
+    });
+    return out;
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "batch.h"
+
+namespace alphasignal {
+
+// Daily -> higher-timeframe OHLCV aggregation in one pass per ticker.
+// Periods follow the rows actually present (the trading calendar), so a
+// holiday week is simply a shorter bar.
+enum class ResamplePeriod {
+    Weekly,     // ISO weeks, Monday to Sunday
+    Monthly,
+    Quarterly,
+    Yearly,
+    Bars,       // every `bars` rows from each ticker's first row
+    Custom,     // caller-supplied period keys (e.g. fiscal periods)
+};
+
+struct ResampleOptions {
+    ResamplePeriod period = ResamplePeriod::Weekly;
+    int bars = 5;          // Bars only
+    bool running = false;  // also emit the in-progress period bar as of every row
+};
+
+ResamplePeriod parse_resample_period(const std::string &name);
+
+// Bar and row indices are global across the batch. Ticker i owns bars
+// [bar_offsets[i], bar_offsets[i + 1]); its last bar may be incomplete.
+struct ResampleResult {
+    std::vector<double> open, high, low, close, volume;
+    std::vector<int64_t> first_row, last_row;
+    std::vector<int64_t> bar_offsets;
+
+    // Per input row: the bar containing the row, and the latest bar that was
+    // complete before the row's period began (-1 if none). Joining a
+    // higher-timeframe indicator through last_complete cannot look ahead.
+    std::vector<int64_t> period;
+    std::vector<int64_t> last_complete;
+
+    // opts.running: the current period's bar as of each row (open to date,
+    // high/low so far, close = this row's close, volume so far)
+    std::vector<double> run_open, run_high, run_low, run_close, run_volume;
+};
+
+// keys holds epoch days (1970-01-01 = 0) per row for the calendar periods,
+// or the period key per row for Custom; it is unused (may be null) for Bars.
+// NaN fields are skipped: open/close take the first/last valid value, and a
+// period without any valid value yields NaN.
+ResampleResult resample_ohlcv(const OHLCVColumns &in, const int64_t *keys,
+                              const RaggedBatch &batch, const ResampleOptions &opts);
+
+}  // namespace alphasignal
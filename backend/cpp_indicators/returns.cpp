@@ -0,0 +1,86 @@
+#include "returns.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "thread_pool.h"
+
+namespace alphasignal {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+inline bool usable(double x) { return !is_missing(x) && x > 0.0; }
+
+}  // namespace
+
+void compute_returns(const double *close, size_t n, const ReturnsOptions &opts,
+                     const ReturnsOutput &out) {
+    for (int h : opts.horizons) {
+        if (h < 1) {
+            throw std::invalid_argument("horizons must be positive");
+        }
+    }
+    for (int f : opts.forward_horizons) {
+        if (f < 1) {
+            throw std::invalid_argument("forward horizons must be positive");
+        }
+    }
+
+    for (size_t k = 0; k < opts.horizons.size(); ++k) {
+        const size_t h = std::min(static_cast<size_t>(opts.horizons[k]), n);
+        double *simple = out.simple + k * out.stride;
+        double *log_ret = opts.log && out.log ? out.log + k * out.stride : nullptr;
+        double *roc = opts.roc && out.roc ? out.roc + k * out.stride : nullptr;
+
+        std::fill(simple, simple + h, kNaN);
+        if (log_ret) {
+            std::fill(log_ret, log_ret + h, kNaN);
+        }
+        if (roc) {
+            std::fill(roc, roc + h, kNaN);
+        }
+        // One ratio per row feeds every output. The output switches are loop
+        // invariant (unswitched by the compiler) and the selects keep each
+        // variant branch-free, so it vectorizes, log included.
+        for (size_t t = h; t < n; ++t) {
+            const double cur = close[t], base = close[t - h];
+            const bool ok = usable(cur) && usable(base);
+            const double q = cur / base;
+            simple[t] = ok ? q - 1.0 : kNaN;
+            if (log_ret) {
+                log_ret[t] = ok ? std::log(q) : kNaN;
+            }
+            if (roc) {
+                roc[t] = ok ? 100.0 * (q - 1.0) : kNaN;
+            }
+        }
+    }
+
+    for (size_t k = 0; k < opts.forward_horizons.size() && out.forward; ++k) {
+        const size_t f = std::min(static_cast<size_t>(opts.forward_horizons[k]), n);
+        double *fwd = out.forward + k * out.stride;
+        for (size_t t = 0; t + f < n; ++t) {
+            const double cur = close[t], ahead = close[t + f];
+            const bool ok = usable(cur) && usable(ahead);
+            fwd[t] = ok ? ahead / cur - 1.0 : kNaN;
+        }
+        std::fill(fwd + (n - f), fwd + n, kNaN);
+    }
+}
+
+void compute_returns_batch(const double *close, const RaggedBatch &batch,
+                           const ReturnsOptions &opts, const ReturnsOutput &out) {
+    parallel_for(batch.n_series, [&](size_t i) {
+        const size_t b = batch.begin(i);
+        const ReturnsOutput slice{out.simple + b, out.log ? out.log + b : nullptr,
+                                  out.roc ? out.roc + b : nullptr,
+                                  out.forward ? out.forward + b : nullptr, out.stride};
+        compute_returns(close + b, batch.length(i), opts, slice);
+    });
+}
+
+}  // namespace alphasignal
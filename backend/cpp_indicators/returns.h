@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "batch.h"
+
+namespace alphasignal {
+
+// Price-relative features over several horizons from one close series.
+// For horizon h and ratio q = close[t] / close[t - h]:
+//   simple = q - 1 (also momentum_h),  log = ln q,  roc = 100 (q - 1)
+// and forward returns for target horizon f: close[t + f] / close[t] - 1.
+// A missing or non-positive close on either end gives NaN, as do rows
+// without h bars of history (or f bars of future).
+struct ReturnsOptions {
+    std::vector<int> horizons = {1, 5, 20};
+    std::vector<int> forward_horizons;
+    bool log = true;
+    bool roc = false;
+};
+
+// Outputs are horizon-major with `stride` between horizons:
+// simple[k * stride + t] for horizons[k]. log / roc / forward may be null
+// when not requested.
+struct ReturnsOutput {
+    double *simple;
+    double *log;
+    double *roc;
+    double *forward;
+    size_t stride;
+};
+
+void compute_returns(const double *close, size_t n, const ReturnsOptions &opts,
+                     const ReturnsOutput &out);
+
+// Horizons never cross ticker boundaries; stride = total_rows
+void compute_returns_batch(const double *close, const RaggedBatch &batch,
+                           const ReturnsOptions &opts, const ReturnsOutput &out);
+
+}  // namespace alphasignal
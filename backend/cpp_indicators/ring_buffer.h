@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace alphasignal {
+
+// Bounded lock-free queues for the real-time path. Capacity is rounded up
+// to a power of two; pushes never block or allocate and fail when full.
+constexpr size_t kCacheLine = 64;
+
+inline size_t ring_capacity(size_t requested) {
+    size_t cap = 2;
+    while (cap < requested) {
+        cap <<= 1;
+    }
+    return cap;
+}
+
+// Single producer, single consumer. Each side caches the other's index so
+// the shared cache line is only touched when the cached view runs out.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : mask_(ring_capacity(capacity) - 1), buf_(new T[mask_ + 1]) {}
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    size_t capacity() const { return mask_ + 1; }
+
+    bool try_push(const T &value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_) {
+                return false;
+            }
+        }
+        buf_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Pops up to max items into out; returns how many
+    size_t try_pop(T *out, size_t max) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (tail_cache_ == head) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (tail_cache_ == head) {
+                return 0;
+            }
+        }
+        const size_t n = tail_cache_ - head < max ? tail_cache_ - head : max;
+        for (size_t k = 0; k < n; ++k) {
+            out[k] = buf_[(head + k) & mask_];
+        }
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    size_t size_approx() const {
+        return tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_relaxed);
+    }
+
+private:
+    const size_t mask_;
+    const std::unique_ptr<T[]> buf_;
+    alignas(kCacheLine) std::atomic<size_t> head_{0};  // consumer
+    size_t tail_cache_ = 0;
+    alignas(kCacheLine) std::atomic<size_t> tail_{0};  // producer
+    size_t head_cache_ = 0;
+};
+
+// Many producers, single consumer (Vyukov's bounded queue): producers claim
+// a slot with one CAS on the tail and publish it through the slot's
+// sequence number, so the consumer never waits on a lock.
+template <typename T>
+class MpscRing {
+public:
+    explicit MpscRing(size_t capacity)
+        : mask_(ring_capacity(capacity) - 1), cells_(new Cell[mask_ + 1]) {
+        for (size_t i = 0; i <= mask_; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing &) = delete;
+    MpscRing &operator=(const MpscRing &) = delete;
+
+    size_t capacity() const { return mask_ + 1; }
+
+    bool try_push(const T &value) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            const size_t seq = cell->seq.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // full
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = value;
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t try_pop(T *out, size_t max) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t n = 0;
+        while (n < max) {
+            Cell &cell = cells_[head & mask_];
+            if (cell.seq.load(std::memory_order_acquire) != head + 1) {
+                break;  // empty, or the producer has not finished writing
+            }
+            out[n++] = cell.value;
+            cell.seq.store(head + mask_ + 1, std::memory_order_release);
+            ++head;
+        }
+        head_.store(head, std::memory_order_relaxed);
+        return n;
+    }
+
+    size_t size_approx() const {
+        return tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    const size_t mask_;
+    const std::unique_ptr<Cell[]> cells_;
+    alignas(kCacheLine) std::atomic<size_t> tail_{0};  // producers
+    alignas(kCacheLine) std::atomic<size_t> head_{0};  // written by the consumer only
+};
+
+}  // namespace alphasignal
@@ -0,0 +1,126 @@
+#include "score_batcher.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace alphasignal {
+
+ScoreBatcher::ScoreBatcher(std::shared_ptr<const TreeEnsemble> model, const BatcherOptions &opts)
+    : model_(std::move(model)), opts_(opts) {
+    if (!model_) {
+        throw std::invalid_argument("ScoreBatcher needs a model");
+    }
+    if (opts_.max_batch < 1) {
+        throw std::invalid_argument("max_batch must be >= 1");
+    }
+    if (opts_.max_delay_us < 0) {
+        throw std::invalid_argument("max_delay_us must be >= 0");
+    }
+    n_features_ = static_cast<size_t>(model_->n_features);
+    rows_.reserve(opts_.max_batch * n_features_);
+    callbacks_.reserve(opts_.max_batch);
+    dispatcher_ = std::thread([this] { dispatch_loop(); });
+}
+
+ScoreBatcher::~ScoreBatcher() {
+    close();
+    dispatcher_.join();
+}
+
+void ScoreBatcher::submit(const double *row, ScoreCallback callback) {
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            throw std::runtime_error("ScoreBatcher is closed");
+        }
+        if (callbacks_.empty()) {
+            oldest_ = Clock::now();
+        }
+        rows_.insert(rows_.end(), row, row + n_features_);
+        callbacks_.push_back(std::move(callback));
+        // The dispatcher only needs waking to start a deadline or to cut a full batch
+        wake = callbacks_.size() == 1 || callbacks_.size() >= opts_.max_batch;
+    }
+    if (wake) {
+        cv_.notify_one();
+    }
+}
+
+std::future<double> ScoreBatcher::submit(const double *row) {
+    auto promise = std::make_shared<std::promise<double>>();
+    std::future<double> result = promise->get_future();
+    submit(row, [promise](double score, std::exception_ptr error) {
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value(score);
+        }
+    });
+    return result;
+}
+
+void ScoreBatcher::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    cv_.notify_one();
+}
+
+BatcherStats ScoreBatcher::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return BatcherStats{n_rows_, n_batches_, largest_, callbacks_.size()};
+}
+
+void ScoreBatcher::dispatch_loop() {
+    const auto max_delay = std::chrono::microseconds(opts_.max_delay_us);
+    std::vector<double> rows;
+    std::vector<ScoreCallback> callbacks;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        cv_.wait(lock, [&] { return closed_ || !callbacks_.empty(); });
+        if (callbacks_.empty()) {
+            return;  // closed and drained
+        }
+        // Hold the batch open until it fills or its oldest row is due
+        const Clock::time_point deadline = oldest_ + max_delay;
+        cv_.wait_until(lock, deadline,
+                       [&] { return closed_ || callbacks_.size() >= opts_.max_batch; });
+
+        // Everything queued goes out together; a backlog that built up
+        // during the previous batch is worth scoring in one call
+        rows.swap(rows_);
+        callbacks.swap(callbacks_);
+        n_rows_ += callbacks.size();
+        n_batches_ += 1;
+        largest_ = std::max<uint64_t>(largest_, callbacks.size());
+        lock.unlock();
+
+        run_batch(rows, callbacks);
+        rows.clear();
+        callbacks.clear();
+        lock.lock();
+    }
+}
+
+void ScoreBatcher::run_batch(std::vector<double> &rows, std::vector<ScoreCallback> &callbacks) {
+    const size_t n = callbacks.size();
+    std::vector<double> scores(n);
+    std::exception_ptr error;
+    try {
+        model_->predict_batch(rows.data(), n, scores.data());
+    } catch (...) {
+        error = std::current_exception();
+    }
+    for (size_t i = 0; i < n; ++i) {
+        try {
+            callbacks[i](scores[i], error);
+        } catch (...) {
+            // A misbehaving caller must not take the dispatcher down
+        }
+    }
+}
+
+}  // namespace alphasignal
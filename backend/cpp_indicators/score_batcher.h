@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tree_model.h"
+
+namespace alphasignal {
+
+// Micro-batching front end of a TreeEnsemble. Rows submitted from many
+// callers are queued until max_batch rows are waiting or the oldest has
+// waited max_delay_us, then scored with one predict_batch call; each
+// caller's callback (or future) is completed from the dispatcher thread.
+// Under load this trades at most max_delay_us of latency for batch
+// throughput; an idle queue dispatches a lone row after the deadline.
+struct BatcherOptions {
+    size_t max_batch = 64;
+    int64_t max_delay_us = 2000;  // 0 = score whatever is queued immediately
+};
+
+struct BatcherStats {
+    uint64_t rows;
+    uint64_t batches;
+    uint64_t largest_batch;
+    uint64_t queued;  // rows waiting right now
+};
+
+// Called once per row with the probability, or with a non-null error
+using ScoreCallback = std::function<void(double score, std::exception_ptr error)>;
+
+class ScoreBatcher {
+public:
+    ScoreBatcher(std::shared_ptr<const TreeEnsemble> model,
+                 const BatcherOptions &opts = BatcherOptions());
+    // Scores everything still queued, then joins the dispatcher
+    ~ScoreBatcher();
+
+    ScoreBatcher(const ScoreBatcher &) = delete;
+    ScoreBatcher &operator=(const ScoreBatcher &) = delete;
+
+    // row holds model().n_features raw values and is copied. Callbacks run
+    // on the dispatcher thread and must not block; exceptions they throw
+    // are swallowed. Throws std::runtime_error after close().
+    void submit(const double *row, ScoreCallback callback);
+    std::future<double> submit(const double *row);
+
+    // Stop accepting rows; queued rows are still scored. Idempotent.
+    void close();
+
+    BatcherStats stats() const;
+    const TreeEnsemble &model() const { return *model_; }
+    const BatcherOptions &options() const { return opts_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void dispatch_loop();
+    void run_batch(std::vector<double> &rows, std::vector<ScoreCallback> &callbacks);
+
+    std::shared_ptr<const TreeEnsemble> model_;
+    BatcherOptions opts_;
+    size_t n_features_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<double> rows_;  // queued rows, row-major
+    std::vector<ScoreCallback> callbacks_;
+    Clock::time_point oldest_;
+    bool closed_ = false;
+
+    uint64_t n_rows_ = 0;
+    uint64_t n_batches_ = 0;
+    uint64_t largest_ = 0;
+
+    std::thread dispatcher_;
+};
+
+}  // namespace alphasignal
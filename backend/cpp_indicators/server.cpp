@@ -0,0 +1,494 @@
+#include "server.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace alphasignal {
+
+namespace {
+
+constexpr int kMaxEvents = 256;
+constexpr size_t kReadChunk = 64 * 1024;
+
+std::runtime_error sys_error(const std::string &what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+struct Job {
+    uint64_t conn_id;
+    FrameHeader header;
+    std::vector<uint8_t> payload;
+};
+
+struct Completion {
+    uint64_t conn_id;
+    std::vector<uint8_t> frame;
+};
+
+// Blocking FIFO shared by the event loop (producer) and the workers
+class JobQueue {
+public:
+    void push(Job job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push_back(std::move(job));
+        }
+        cv_.notify_one();
+    }
+
+    // False once the queue is closed and drained
+    bool pop(Job &job) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return closed_ || !jobs_.empty(); });
+        if (jobs_.empty()) {
+            return false;
+        }
+        job = std::move(jobs_.front());
+        jobs_.pop_front();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Job> jobs_;
+    bool closed_ = false;
+};
+
+struct Connection {
+    int fd;
+    uint64_t id;
+    std::vector<uint8_t> in;
+    std::vector<uint8_t> out;
+    size_t out_pos = 0;
+    uint32_t inflight = 0;  // dispatched requests whose response is not queued yet
+    uint32_t events = EPOLLIN | EPOLLRDHUP;
+    bool eof = false;       // client shut down its write side; close once answered
+};
+
+}  // namespace
+
+struct IndicatorServer::Impl {
+    ServerOptions opts;
+    const IndicatorService &service;
+    int listen_fd = -1;
+    int epoll_fd = -1;
+    int wake_fd = -1;  // eventfd: stop requests and finished jobs
+    bool listening = false;
+    bool bound = false;  // socket_path is ours to unlink
+    std::atomic<bool> stopping{false};
+
+    JobQueue jobs;
+    std::mutex done_mutex;
+    std::vector<Completion> done;
+    std::vector<std::thread> workers;
+
+    std::unordered_map<int, Connection> conns;  // by fd; event-loop thread only
+    std::unordered_map<uint64_t, int> fd_of;    // connection id -> fd
+    uint64_t next_id = 1;
+
+    std::atomic<uint64_t> n_connections{0}, n_requests{0}, n_responses{0}, n_errors{0};
+
+    Impl(const ServerOptions &o, const IndicatorService &s) : opts(o), service(s) {
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wake_fd < 0) {
+            throw sys_error("eventfd");
+        }
+    }
+
+    ~Impl() {
+        for (auto &kv : conns) {
+            ::close(kv.first);
+        }
+        for (int fd : {listen_fd, epoll_fd, wake_fd}) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+
+    void wake() {
+        const uint64_t one = 1;
+        // A full counter still leaves the eventfd readable, so the result can be ignored
+        ssize_t rc = ::write(wake_fd, &one, sizeof(one));
+        (void)rc;
+    }
+
+    void setup() {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (opts.socket_path.size() >= sizeof(addr.sun_path)) {
+            throw std::runtime_error("socket path is too long: " + opts.socket_path);
+        }
+        std::memcpy(addr.sun_path, opts.socket_path.c_str(), opts.socket_path.size() + 1);
+
+        remove_stale_socket(addr);
+        listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listen_fd < 0) {
+            throw sys_error("socket");
+        }
+        if (::bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+            throw sys_error("bind " + opts.socket_path);
+        }
+        bound = true;
+        if (::listen(listen_fd, opts.backlog) < 0) {
+            throw sys_error("listen");
+        }
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd < 0) {
+            throw sys_error("epoll_create1");
+        }
+        watch(listen_fd, EPOLLIN, EPOLL_CTL_ADD);
+        watch(wake_fd, EPOLLIN, EPOLL_CTL_ADD);
+
+        const unsigned n = opts.workers > 0 ? static_cast<unsigned>(opts.workers)
+                                            : std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < n; ++i) {
+            workers.emplace_back([this] { worker_loop(); });
+        }
+        listening = true;
+    }
+
+    // Unlinks a socket left by a previous run. Refuses if a live server still
+    // accepts on the path, or if the path cannot be probed.
+    void remove_stale_socket(const sockaddr_un &addr) {
+        const int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (probe < 0) {
+            throw sys_error("socket");
+        }
+        const int rc = ::connect(probe, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr));
+        const int err = errno;
+        ::close(probe);
+        if (rc == 0 || err == EAGAIN) {  // EAGAIN: alive, backlog full
+            throw std::runtime_error("another server is listening on " + opts.socket_path);
+        }
+        if (err == ENOENT) {
+            return;
+        }
+        if (err != ECONNREFUSED) {
+            errno = err;
+            throw sys_error("probe " + opts.socket_path);
+        }
+        if (::unlink(opts.socket_path.c_str()) < 0 && errno != ENOENT) {
+            throw sys_error("unlink " + opts.socket_path);
+        }
+    }
+
+    void watch(int fd, uint32_t events, int op) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        if (epoll_ctl(epoll_fd, op, fd, &ev) < 0) {
+            throw sys_error("epoll_ctl");
+        }
+    }
+
+    void worker_loop() {
+        Job job;
+        while (jobs.pop(job)) {
+            std::vector<uint8_t> frame =
+                service.handle(job.header, job.payload.data(), job.payload.size());
+            {
+                std::lock_guard<std::mutex> lock(done_mutex);
+                done.push_back(Completion{job.conn_id, std::move(frame)});
+            }
+            wake();
+        }
+    }
+
+    void accept_all() {
+        for (;;) {
+            const int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;  // EAGAIN, or a transient error such as EMFILE
+            }
+            Connection &c = conns[fd];
+            c.fd = fd;
+            c.id = next_id++;
+            fd_of[c.id] = fd;
+            watch(fd, EPOLLIN | EPOLLRDHUP, EPOLL_CTL_ADD);
+            n_connections.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void close_conn(Connection &c) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c.fd, nullptr);
+        ::close(c.fd);
+        fd_of.erase(c.id);
+        conns.erase(c.fd);  // responses still in flight for c.id are dropped
+    }
+
+    // Room for another request: bounded in-flight jobs and unsent bytes
+    bool has_room(const Connection &c) const {
+        return c.inflight < opts.max_inflight && c.out.size() - c.out_pos < opts.max_output_bytes;
+    }
+
+    // Hands the complete frames buffered in c.in to the workers while c has
+    // room. A header announcing more than max_frame_bytes closes the
+    // connection before its payload is buffered. Returns false if the
+    // connection was closed.
+    bool dispatch(Connection &c) {
+        size_t pos = 0;
+        while (has_room(c) && c.in.size() - pos >= kFrameHeaderSize) {
+            FrameHeader header;
+            try {
+                header = decode_header(c.in.data() + pos);
+            } catch (const ProtocolError &) {
+                n_errors.fetch_add(1, std::memory_order_relaxed);
+                close_conn(c);  // the stream cannot be resynchronised
+                return false;
+            }
+            if (header.length > opts.max_frame_bytes) {
+                n_errors.fetch_add(1, std::memory_order_relaxed);
+                close_conn(c);
+                return false;
+            }
+            if (c.in.size() - pos - kFrameHeaderSize < header.length) {
+                break;  // wait for the rest of the payload
+            }
+            const uint8_t *body = c.in.data() + pos + kFrameHeaderSize;
+            jobs.push(Job{c.id, header, std::vector<uint8_t>(body, body + header.length)});
+            ++c.inflight;
+            n_requests.fetch_add(1, std::memory_order_relaxed);
+            pos += kFrameHeaderSize + header.length;
+        }
+        c.in.erase(c.in.begin(), c.in.begin() + static_cast<std::ptrdiff_t>(pos));
+        return true;
+    }
+
+    // Reads only while c has room, so nothing is polled for a connection at
+    // its limits until responses drain
+    void update_interest(Connection &c) {
+        const uint32_t events = (!c.eof && has_room(c) ? EPOLLIN | EPOLLRDHUP : 0u) |
+                                (c.out_pos < c.out.size() ? EPOLLOUT : 0u);
+        if (events != c.events) {
+            c.events = events;
+            watch(c.fd, events, EPOLL_CTL_MOD);
+        }
+    }
+
+    // A half-closed connection is closed once every dispatched request has
+    // been answered and written; returns false if it was
+    bool close_if_done(Connection &c) {
+        if (c.eof && c.inflight == 0 && c.out_pos == c.out.size()) {
+            close_conn(c);
+            return false;
+        }
+        return true;
+    }
+
+    // Returns false if the connection was closed
+    bool on_readable(Connection &c) {
+        // One chunk at a time, dispatching after each, so the buffer never
+        // holds more than one partial frame plus a chunk
+        while (!c.eof && has_room(c)) {
+            const size_t at = c.in.size();
+            c.in.resize(at + kReadChunk);
+            const ssize_t n = ::read(c.fd, c.in.data() + at, kReadChunk);
+            c.in.resize(at + (n > 0 ? static_cast<size_t>(n) : 0));
+            if (n > 0) {
+                if (!dispatch(c)) {
+                    return false;
+                }
+                continue;
+            }
+            if (n == 0) {
+                c.eof = true;  // replies to requests already sent are still owed
+                break;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            close_conn(c);
+            return false;
+        }
+        if (!close_if_done(c)) {
+            return false;
+        }
+        update_interest(c);
+        return true;
+    }
+
+    // Writes as much as the socket takes, then dispatches frames held back
+    // while c was at its limits; returns false if the connection was closed
+    bool flush(Connection &c) {
+        while (c.out_pos < c.out.size()) {
+            const ssize_t n = ::send(c.fd, c.out.data() + c.out_pos, c.out.size() - c.out_pos,
+                                     MSG_NOSIGNAL);
+            if (n > 0) {
+                c.out_pos += static_cast<size_t>(n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            close_conn(c);
+            return false;
+        }
+        if (c.out_pos == c.out.size()) {
+            c.out.clear();
+            c.out_pos = 0;
+        }
+        if (!dispatch(c) || !close_if_done(c)) {
+            return false;
+        }
+        update_interest(c);
+        return true;
+    }
+
+    void on_wake() {
+        uint64_t count;
+        ssize_t rc = ::read(wake_fd, &count, sizeof(count));
+        (void)rc;
+        std::vector<Completion> batch;
+        {
+            std::lock_guard<std::mutex> lock(done_mutex);
+            batch.swap(done);
+        }
+        for (Completion &r : batch) {
+            auto it = fd_of.find(r.conn_id);
+            if (it == fd_of.end()) {
+                continue;  // client went away
+            }
+            Connection &c = conns[it->second];
+            --c.inflight;
+            c.out.insert(c.out.end(), r.frame.begin(), r.frame.end());
+            n_responses.fetch_add(1, std::memory_order_relaxed);
+            flush(c);
+        }
+    }
+
+    void loop() {
+        epoll_event events[kMaxEvents];
+        while (!stopping.load(std::memory_order_acquire)) {
+            const int n = epoll_wait(epoll_fd, events, kMaxEvents, -1);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw sys_error("epoll_wait");
+            }
+            for (int i = 0; i < n; ++i) {
+                const int fd = events[i].data.fd;
+                const uint32_t ev = events[i].events;
+                if (fd == listen_fd) {
+                    accept_all();
+                    continue;
+                }
+                if (fd == wake_fd) {
+                    on_wake();
+                    continue;
+                }
+                auto it = conns.find(fd);
+                if (it == conns.end()) {
+                    continue;  // closed earlier in this batch
+                }
+                Connection &c = it->second;
+                if (ev & (EPOLLERR | EPOLLHUP)) {
+                    close_conn(c);
+                    continue;
+                }
+                if ((ev & EPOLLOUT) && !flush(c)) {
+                    continue;
+                }
+                if (ev & (EPOLLIN | EPOLLRDHUP)) {
+                    on_readable(c);
+                }
+            }
+        }
+    }
+
+    // Closes the job queue, joins the workers and removes the socket;
+    // safe to call more than once
+    void shutdown() {
+        jobs.close();
+        for (auto &t : workers) {
+            t.join();
+        }
+        workers.clear();
+        if (bound) {
+            ::unlink(opts.socket_path.c_str());
+            bound = false;
+        }
+        listening = false;
+    }
+};
+
+IndicatorServer::IndicatorServer(const ServerOptions &opts, const IndicatorService &service)
+    : impl_(new Impl(opts, service)) {}
+
+IndicatorServer::~IndicatorServer() {
+    stop();
+    impl_->shutdown();  // listen() without run() still owns workers and the socket
+    delete impl_;
+}
+
+void IndicatorServer::listen() {
+    if (impl_->listening) {
+        return;
+    }
+    try {
+        impl_->setup();
+    } catch (...) {
+        impl_->shutdown();
+        throw;
+    }
+}
+
+void IndicatorServer::run() {
+    listen();
+    try {
+        impl_->loop();
+    } catch (...) {
+        impl_->shutdown();
+        throw;
+    }
+    impl_->shutdown();
+}
+
+void IndicatorServer::stop() {
+    impl_->stopping.store(true, std::memory_order_release);
+    impl_->wake();
+}
+
+ServerStats IndicatorServer::stats() const {
+    return ServerStats{impl_->n_connections.load(std::memory_order_relaxed),
+                       impl_->n_requests.load(std::memory_order_relaxed),
+                       impl_->n_responses.load(std::memory_order_relaxed),
+                       impl_->n_errors.load(std::memory_order_relaxed)};
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "service.h"
+
+namespace alphasignal {
+
+// Unix-domain-socket front end of IndicatorService (Linux: epoll + eventfd).
+// One event-loop thread owns every connection: it reads frames, hands
+// complete requests to a worker pool, and writes the responses the workers
+// post back. Requests on a connection are processed concurrently, so
+// responses may arrive out of order; clients match them by request_id.
+// A connection is not read while it has max_inflight requests awaiting a
+// response or max_output_bytes of responses its client has not taken yet,
+// so a client that sends faster than it reads is held back by the socket.
+// A client may shut down its write side after its last request; the
+// connection stays open until every response has been written.
+struct ServerOptions {
+    std::string socket_path = "/tmp/alphasignal.sock";
+    int workers = 0;                     // 0 = hardware threads
+    uint32_t max_frame_bytes = 64u << 20;  // larger requests close the connection
+    uint32_t max_inflight = 64;            // per connection
+    size_t max_output_bytes = 64u << 20;   // unsent response bytes per connection
+    int backlog = 128;
+};
+
+struct ServerStats {
+    uint64_t connections;  // accepted so far
+    uint64_t requests;     // frames dispatched to workers
+    uint64_t responses;    // responses queued for writing
+    uint64_t protocol_errors;
+};
+
+class IndicatorServer {
+public:
+    IndicatorServer(const ServerOptions &opts, const IndicatorService &service);
+    ~IndicatorServer();
+
+    IndicatorServer(const IndicatorServer &) = delete;
+    IndicatorServer &operator=(const IndicatorServer &) = delete;
+
+    // Binds the socket and starts the workers; throws std::runtime_error if
+    // the socket cannot be set up or another server is listening on it (a
+    // stale socket file is replaced). Idempotent.
+    void listen();
+    // Serves until stop(), calling listen() first if needed
+    void run();
+    // Safe from any thread and from signal handlers
+    void stop();
+
+    ServerStats stats() const;
+
+private:
+    struct Impl;
+    Impl *impl_;
+};
+
+}  // namespace alphasignal
@@ -0,0 +1,84 @@
+// alphasignal_server: serves indicators and model scores over a Unix socket.
+//
+//   alphasignal_server [--socket PATH] [--workers N] [--model FILE.astree]
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+
+#include "server.h"
+
+using namespace alphasignal;
+
+namespace {
+
+IndicatorServer *g_server = nullptr;
+
+void on_signal(int) {
+    if (g_server) {
+        g_server->stop();
+    }
+}
+
+void usage(const char *prog) {
+    std::fprintf(stderr, "usage: %s [--socket PATH] [--workers N] [--model FILE]\n", prog);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    ServerOptions opts;
+    std::string model_path;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (arg == "--socket") {
+            opts.socket_path = argv[++i];
+        } else if (arg == "--workers") {
+            opts.workers = std::atoi(argv[++i]);
+        } else if (arg == "--model") {
+            model_path = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    try {
+        std::shared_ptr<const TreeEnsemble> model;
+        if (!model_path.empty()) {
+            model = std::make_shared<const TreeEnsemble>(load_tree_ensemble(model_path));
+            std::fprintf(stderr, "loaded %zu trees over %d features from %s\n", model->n_trees(),
+                         model->n_features, model_path.c_str());
+        }
+        IndicatorService service(model);
+        IndicatorServer server(opts, service);
+
+        g_server = &server;
+        std::signal(SIGINT, on_signal);
+        std::signal(SIGTERM, on_signal);
+        std::signal(SIGPIPE, SIG_IGN);
+
+        server.listen();
+        std::fprintf(stderr, "listening on %s\n", opts.socket_path.c_str());
+        server.run();
+        g_server = nullptr;
+
+        const ServerStats s = server.stats();
+        std::fprintf(stderr, "served %llu requests on %llu connections (%llu protocol errors)\n",
+                     static_cast<unsigned long long>(s.responses),
+                     static_cast<unsigned long long>(s.connections),
+                     static_cast<unsigned long long>(s.protocol_errors));
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "alphasignal_server: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
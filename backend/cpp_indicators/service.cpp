@@ -0,0 +1,159 @@
+#include "service.h"
+
+#include <exception>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "arena.h"
+#include "returns.h"
+#include "technical.h"
+
+namespace alphasignal {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+constexpr uint32_t kAllFeatures = (1u << kNumServiceFeatures) - 1;
+constexpr uint32_t kUniverseMask = (1u << kNumUniverseFeatures) - 1;
+constexpr uint32_t kReturnsMask = kAllFeatures & ~kUniverseMask;
+
+int popcount(uint32_t x) {
+    int n = 0;
+    for (; x; x &= x - 1) {
+        ++n;
+    }
+    return n;
+}
+
+}  // namespace
+
+IndicatorService::IndicatorService(std::shared_ptr<const TreeEnsemble> model,
+                                   const UniverseOptions &indicator_opts)
+    : model_(std::move(model)), indicator_opts_(indicator_opts) {}
+
+IndicatorResponse IndicatorService::indicators(const IndicatorRequest &req) const {
+    if (req.feature_mask == 0 || (req.feature_mask & ~kAllFeatures) != 0) {
+        throw ProtocolError("feature_mask must select known features");
+    }
+    static_assert(int{kSvcRsi} == int{kUniRsi} && int{kSvcBbPercent} == int{kUniBbPercent},
+                  "service features start with the universe features");
+    IndicatorResponse resp;
+    resp.n_features = static_cast<uint32_t>(popcount(req.feature_mask));
+    resp.series.resize(req.tickers.size());
+
+    ReturnsOptions ret_opts;
+    ret_opts.horizons = {1, 5, 20};
+    ret_opts.log = true;
+
+    for (size_t s = 0; s < req.tickers.size(); ++s) {
+        const std::vector<double> &close = req.closes[s];
+        const size_t n = close.size();
+        const size_t rows = req.last_only ? (n > 0 ? 1 : 0) : n;
+        const size_t first_row = n - rows;
+        IndicatorSeries &out = resp.series[s];
+        out.ticker = req.tickers[s];
+        out.rows = static_cast<uint32_t>(rows);
+        out.values.assign(resp.n_features * rows, 0.0);
+
+        // Map each requested feature to its output row
+        int slot[kNumServiceFeatures];
+        for (int f = 0, k = 0; f < kNumServiceFeatures; ++f) {
+            slot[f] = (req.feature_mask >> f) & 1u ? k++ : -1;
+        }
+
+        // The batch kernels behind calculate_rsi / calculate_macd /
+        // calculate_bollinger_bands, so values match the Python API
+        if ((req.feature_mask & kUniverseMask) && n > 0) {
+            ArenaScope scope;
+            ScratchVector<double> cols = scratch<double>(kNumUniverseFeatures * n);
+            double *col[kNumUniverseFeatures];
+            for (int f = 0; f < kNumUniverseFeatures; ++f) {
+                col[f] = cols.data() + f * n;
+            }
+            const UniverseOptions &o = indicator_opts_;
+            rsi(close.data(), n, o.rsi_period, col[kUniRsi]);
+            macd(close.data(), n, o.macd_fast, o.macd_slow, o.macd_signal, col[kUniMacd],
+                 col[kUniMacdSignal], col[kUniMacdHist]);
+            bollinger_bands(close.data(), n, o.bb_period, o.bb_std, col[kUniBbUpper],
+                            col[kUniBbMiddle], col[kUniBbLower]);
+            for (size_t t = 0; t < n; ++t) {
+                const double width = col[kUniBbUpper][t] - col[kUniBbLower][t];
+                col[kUniBbPercent][t] =
+                    width > 0.0 ? (close[t] - col[kUniBbLower][t]) / width : kNaN;
+            }
+            for (int f = 0; f < kNumUniverseFeatures; ++f) {
+                if (slot[f] < 0) {
+                    continue;
+                }
+                for (size_t r = 0; r < rows; ++r) {
+                    out.values[slot[f] * rows + r] = col[f][first_row + r];
+                }
+            }
+        }
+        if ((req.feature_mask & kReturnsMask) && n > 0) {
+            ArenaScope scope;
+            ScratchVector<double> simple = scratch<double>(3 * n), log = scratch<double>(3 * n);
+            compute_returns(close.data(), n, ret_opts,
+                            ReturnsOutput{simple.data(), log.data(), nullptr, nullptr, n});
+            for (int h = 0; h < 3; ++h) {
+                const int f = kSvcReturn1 + h;
+                if (slot[f] < 0) {
+                    continue;
+                }
+                for (size_t r = 0; r < rows; ++r) {
+                    out.values[slot[f] * rows + r] = log[h * n + first_row + r];
+                }
+            }
+        }
+    }
+    return resp;
+}
+
+ScoreResponse IndicatorService::score(const ScoreRequest &req) const {
+    if (static_cast<int32_t>(req.n_features) != model_->n_features) {
+        throw ProtocolError("model expects " + std::to_string(model_->n_features) +
+                            " features, got " + std::to_string(req.n_features));
+    }
+    ScoreResponse resp;
+    resp.tickers = req.tickers;
+    resp.scores.resize(req.n_rows);
+    model_->predict_batch(req.rows.data(), req.n_rows, resp.scores.data());
+    return resp;
+}
+
+std::vector<uint8_t> IndicatorService::handle(const FrameHeader &header, const uint8_t *payload,
+                                              size_t size) const {
+    // Request temporaries come off this thread's arena and go back in one step
+    ArenaScope scope;
+    std::vector<uint8_t> body;
+    try {
+        switch (static_cast<Op>(header.op)) {
+            case Op::Ping:
+                WireWriter(body).put<uint32_t>(static_cast<uint32_t>(Status::Ok));
+                break;
+            case Op::Indicators:
+                encode_indicator_response(indicators(decode_indicator_request(payload, size)),
+                                          body);
+                break;
+            case Op::Score:
+                if (!model_) {
+                    encode_error(Status::NoModel, "server was started without a model", body);
+                    break;
+                }
+                encode_score_response(score(decode_score_request(payload, size)), body);
+                break;
+            default:
+                encode_error(Status::BadRequest, "unknown op " + std::to_string(header.op), body);
+        }
+    } catch (const ProtocolError &e) {
+        body.clear();
+        encode_error(Status::BadRequest, e.what(), body);
+    } catch (const std::exception &e) {
+        body.clear();
+        encode_error(Status::Internal, e.what(), body);
+    }
+    return make_frame(static_cast<Op>(header.op), header.request_id, body);
+}
+
+}  // namespace alphasignal
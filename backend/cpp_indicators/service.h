@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "protocol.h"
+#include "tree_model.h"
+#include "universe_state.h"
+
+namespace alphasignal {
+
+// Request handlers of the binary service, independent of the transport.
+// Stateless per request and safe to call from many threads at once.
+class IndicatorService {
+public:
+    // model may be null; score requests then answer Status::NoModel
+    explicit IndicatorService(std::shared_ptr<const TreeEnsemble> model = nullptr,
+                              const UniverseOptions &indicator_opts = UniverseOptions());
+
+    // Response frame for one request frame. Malformed payloads produce an
+    // error response rather than an exception.
+    std::vector<uint8_t> handle(const FrameHeader &header, const uint8_t *payload,
+                                size_t size) const;
+
+    IndicatorResponse indicators(const IndicatorRequest &req) const;
+    ScoreResponse score(const ScoreRequest &req) const;
+
+    bool has_model() const { return model_ != nullptr; }
+
+private:
+    std::shared_ptr<const TreeEnsemble> model_;
+    UniverseOptions indicator_opts_;
+};
+
+}  // namespace alphasignal
@@ -5,8 +5,37 @@ import sys
 ext_modules = [
     Pybind11Extension(
         "cpp_indicators",
-        ["indicators.cpp"],
+        [
+            "indicators.cpp",
+            "arena.cpp",
+            "thread_pool.cpp",
+            "technical.cpp",
+            "hmm.cpp",
+            "changepoint.cpp",
+            "dtw.cpp",
+            "fft.cpp",
+            "leadlag.cpp",
+            "matrix_profile.cpp",
+            "pairs.cpp",
+            "wavelet.cpp",
+            "bars.cpp",
+            "resample.cpp",
+            "corporate_actions.cpp",
+            "returns.cpp",
+            "candles.cpp",
+            "calendar.cpp",
+            "tick_engine.cpp",
+            "universe_state.cpp",
+            "tree_model.cpp",
+            "score_batcher.cpp",
+            "kernel_cache.cpp",
+            "prediction_log.cpp",
+            "outcome_resolver.cpp",
+            "fund_metrics.cpp",
+            "pme.cpp",
+        ],
         extra_compile_args=["-O3", "-march=native", "-ffast-math"] if sys.platform != "win32" else ["/O2"],
+        extra_link_args=["-pthread"] if sys.platform != "win32" else [],
         language="c++"
     ),
 ]
@@ -0,0 +1,198 @@
+#include "technical.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace alphasignal {
+
+namespace {
+
+void check_period(int period, const char *name) {
+    if (period < 1) {
+        throw std::invalid_argument(std::string(name) + " must be >= 1");
+    }
+}
+
+}  // namespace
+
+void rsi(const double *prices, size_t n, int period, double *out) {
+    RsiState state;
+    rsi(prices, n, period, out, state);
+}
+
+void rsi(const double *prices, size_t n, int period, double *out, RsiState &state) {
+    check_period(period, "period");
+    std::fill(out, out + n, 0.0);
+    const size_t p = static_cast<size_t>(period);
+    if (n <= p) {
+        return;
+    }
+
+    // Initial average (simple moving average)
+    double avg_gain = 0.0, avg_loss = 0.0;
+    for (size_t i = 1; i <= p; ++i) {
+        const double change = prices[i] - prices[i - 1];
+        if (change > 0) {
+            avg_gain += change;
+        } else {
+            avg_loss -= change;
+        }
+    }
+    state.avg_gain = avg_gain / period;
+    state.avg_loss = avg_loss / period;
+
+    rsi_extend(prices, p, n, period, state, out);
+}
+
+void rsi_extend(const double *prices, size_t from, size_t n, int period, RsiState &state,
+                double *out) {
+    check_period(period, "period");
+    if (from < static_cast<size_t>(period)) {
+        throw std::invalid_argument("rsi_extend needs from >= period");
+    }
+    // Wilder's smoothing
+    double avg_gain = state.avg_gain, avg_loss = state.avg_loss;
+    for (size_t i = from; i < n; ++i) {
+        const double change = prices[i] - prices[i - 1];
+        const double gain = change > 0 ? change : 0.0;
+        const double loss = change > 0 ? 0.0 : -change;
+        avg_gain = ((avg_gain * (period - 1)) + gain) / period;
+        avg_loss = ((avg_loss * (period - 1)) + loss) / period;
+        if (avg_loss == 0.0) {
+            out[i] = 100.0;
+        } else {
+            const double rs = avg_gain / avg_loss;
+            out[i] = 100.0 - (100.0 / (1.0 + rs));
+        }
+    }
+    state.avg_gain = avg_gain;
+    state.avg_loss = avg_loss;
+}
+
+void macd(const double *prices, size_t n, int fast_period, int slow_period, int signal_period,
+          double *macd_out, double *signal_out, double *hist_out) {
+    MacdState state;
+    macd(prices, n, fast_period, slow_period, signal_period, macd_out, signal_out, hist_out,
+         state);
+}
+
+void macd(const double *prices, size_t n, int fast_period, int slow_period, int signal_period,
+          double *macd_out, double *signal_out, double *hist_out, MacdState &state) {
+    check_period(fast_period, "fast_period");
+    check_period(slow_period, "slow_period");
+    check_period(signal_period, "signal_period");
+    std::fill(macd_out, macd_out + n, 0.0);
+    std::fill(signal_out, signal_out + n, 0.0);
+    std::fill(hist_out, hist_out + n, 0.0);
+    if (n == 0) {
+        return;
+    }
+    state = MacdState{prices[0], prices[0], 0.0};
+    macd_extend(prices, 1, n, fast_period, slow_period, signal_period, state, macd_out,
+                signal_out, hist_out);
+}
+
+void macd_extend(const double *prices, size_t from, size_t n, int fast_period, int slow_period,
+                 int signal_period, MacdState &state, double *macd_out, double *signal_out,
+                 double *hist_out) {
+    check_period(fast_period, "fast_period");
+    check_period(slow_period, "slow_period");
+    check_period(signal_period, "signal_period");
+    if (from < 1) {
+        throw std::invalid_argument("macd_extend needs from >= 1");
+    }
+    const double alpha_fast = 2.0 / (fast_period + 1);
+    const double alpha_slow = 2.0 / (slow_period + 1);
+    const double alpha_signal = 2.0 / (signal_period + 1);
+
+    // Signal line (EMA of MACD) starts at row slow_period
+    const size_t start = static_cast<size_t>(slow_period);
+    double ema_fast = state.ema_fast, ema_slow = state.ema_slow, signal = state.signal;
+    for (size_t i = from; i < n; ++i) {
+        ema_fast = alpha_fast * prices[i] + (1 - alpha_fast) * ema_fast;
+        ema_slow = alpha_slow * prices[i] + (1 - alpha_slow) * ema_slow;
+        const double m = ema_fast - ema_slow;
+        macd_out[i] = m;
+        if (i < start) {
+            signal_out[i] = 0.0;
+            hist_out[i] = 0.0;
+        } else if (i == start) {
+            signal = m;
+            signal_out[i] = signal;
+            hist_out[i] = 0.0;
+        } else {
+            signal = alpha_signal * m + (1 - alpha_signal) * signal;
+            signal_out[i] = signal;
+            hist_out[i] = m - signal;
+        }
+    }
+    state = MacdState{ema_fast, ema_slow, signal};
+}
+
+void bollinger_bands(const double *prices, size_t n, int period, double num_std, double *upper,
+                     double *middle, double *lower) {
+    check_period(period, "period");
+    std::fill(upper, upper + n, 0.0);
+    std::fill(middle, middle + n, 0.0);
+    std::fill(lower, lower + n, 0.0);
+    bollinger_bands_extend(prices, 0, n, period, num_std, upper, middle, lower);
+}
+
+void bollinger_bands_extend(const double *prices, size_t from, size_t n, int period,
+                            double num_std, double *upper, double *middle, double *lower) {
+    check_period(period, "period");
+    const size_t first = static_cast<size_t>(period) - 1;
+    for (size_t i = from; i < std::min(first, n); ++i) {
+        upper[i] = middle[i] = lower[i] = 0.0;
+    }
+    for (size_t i = std::max(from, first); i < n; ++i) {
+        double sum = 0.0;
+        for (int j = 0; j < period; ++j) {
+            sum += prices[i - j];
+        }
+        const double mean = sum / period;
+        middle[i] = mean;
+
+        double variance = 0.0;
+        for (int j = 0; j < period; ++j) {
+            const double diff = prices[i - j] - mean;
+            variance += diff * diff;
+        }
+        const double sd = std::sqrt(variance / period);
+        upper[i] = mean + num_std * sd;
+        lower[i] = mean - num_std * sd;
+    }
+}
+
+void rolling_correlation(const double *x, const double *y, size_t n, int window, double *out) {
+    check_period(window, "window");
+    std::fill(out, out + n, 0.0);
+
+    for (size_t i = static_cast<size_t>(window) - 1; i < n; ++i) {
+        double sum_x = 0.0, sum_y = 0.0;
+        double sum_xx = 0.0, sum_yy = 0.0, sum_xy = 0.0;
+        for (int j = 0; j < window; ++j) {
+            const double vx = x[i - j];
+            const double vy = y[i - j];
+            sum_x += vx;
+            sum_y += vy;
+            sum_xx += vx * vx;
+            sum_yy += vy * vy;
+            sum_xy += vx * vy;
+        }
+
+        const double mean_x = sum_x / window;
+        const double mean_y = sum_y / window;
+        const double cov = (sum_xy / window) - (mean_x * mean_y);
+        const double std_x = std::sqrt((sum_xx / window) - (mean_x * mean_x));
+        const double std_y = std::sqrt((sum_yy / window) - (mean_y * mean_y));
+        if (std_x > 0 && std_y > 0) {
+            out[i] = cov / (std_x * std_y);
+        }
+    }
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+
+namespace alphasignal {
+
+// Classic single-series indicators behind calculate_rsi / calculate_macd /
+// calculate_bollinger_bands / rolling_correlation. Each fills n output
+// values; warm-up rows (and every row of a series too short for the
+// period) are 0, as the Python API has always returned.
+
+// Wilder-smoothed RSI
+void rsi(const double *prices, size_t n, int period, double *out);
+
+// EMA(fast) - EMA(slow) seeded at the first price; the signal EMA starts at
+// row slow_period
+void macd(const double *prices, size_t n, int fast_period, int slow_period, int signal_period,
+          double *macd_out, double *signal_out, double *hist_out);
+
+// Rolling mean +/- num_std population standard deviations
+void bollinger_bands(const double *prices, size_t n, int period, double num_std, double *upper,
+                     double *middle, double *lower);
+
+// Resumable forms used by the kernel cache (kernel_cache.h). Each fills
+// rows [from, n) of outputs whose rows [0, from) came from an earlier call
+// over the same prefix; the result is the same as one call over all n rows.
+
+// Wilder averages after the last filled row
+struct RsiState {
+    double avg_gain = 0.0;
+    double avg_loss = 0.0;
+};
+// `state` is valid only when n > period
+void rsi(const double *prices, size_t n, int period, double *out, RsiState &state);
+// Needs from >= period
+void rsi_extend(const double *prices, size_t from, size_t n, int period, RsiState &state,
+                double *out);
+
+struct MacdState {
+    double ema_fast = 0.0;
+    double ema_slow = 0.0;
+    double signal = 0.0;
+};
+// `state` is valid only when n >= 1
+void macd(const double *prices, size_t n, int fast_period, int slow_period, int signal_period,
+          double *macd_out, double *signal_out, double *hist_out, MacdState &state);
+// Needs from >= 1
+void macd_extend(const double *prices, size_t from, size_t n, int fast_period, int slow_period,
+                 int signal_period, MacdState &state, double *macd_out, double *signal_out,
+                 double *hist_out);
+
+// Stateless: every row depends only on its own window
+void bollinger_bands_extend(const double *prices, size_t from, size_t n, int period,
+                            double num_std, double *upper, double *middle, double *lower);
+
+// Pearson correlation of x and y over a trailing window
+void rolling_correlation(const double *x, const double *y, size_t n, int window, double *out);
+
+}  // namespace alphasignal
@@ -0,0 +1,122 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace alphasignal {
+
+namespace {
+thread_local bool in_pool_task = false;
+}
+
+ThreadPool::ThreadPool(unsigned n_threads) {
+    if (n_threads == 0) {
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers_.reserve(n_threads - 1);
+    for (unsigned i = 1; i < n_threads; ++i) {
+        workers_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto &t : workers_) {
+        t.join();
+    }
+}
+
+ThreadPool &ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::drain(const std::function<void(size_t)> &fn, size_t n) {
+    in_pool_task = true;
+    for (;;) {
+        size_t i = next_.fetch_add(1, std::memory_order_relaxed);
+        if (i >= n) {
+            break;
+        }
+        try {
+            fn(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+            // Skip the remaining indices
+            next_.store(n, std::memory_order_relaxed);
+        }
+    }
+    in_pool_task = false;
+}
+
+void ThreadPool::worker_loop() {
+    uint64_t seen = 0;
+    for (;;) {
+        const std::function<void(size_t)> *fn;
+        size_t n;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) {
+                return;
+            }
+            seen = generation_;
+            if (job_ == nullptr) {
+                continue;  // woke after the job already finished
+            }
+            fn = job_;
+            n = job_size_;
+            ++busy_;
+        }
+        drain(*fn, n);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --busy_;
+        }
+        done_cv_.notify_one();
+    }
+}
+
+void ThreadPool::parallel_for(size_t n, const std::function<void(size_t)> &fn) {
+    if (n == 0) {
+        return;
+    }
+    if (n == 1 || workers_.empty() || in_pool_task) {
+        for (size_t i = 0; i < n; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = &fn;
+        job_size_ = n;
+        next_.store(0, std::memory_order_relaxed);
+        error_ = nullptr;
+        ++generation_;
+    }
+    start_cv_.notify_all();
+
+    drain(fn, n);
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [&] { return busy_ == 0; });
+        job_ = nullptr;
+        error = error_;
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace alphasignal {
+
+// Fixed-size worker pool used by the batched (multi-ticker) kernels.
+// parallel_for hands out indices dynamically, so uneven series lengths
+// still balance across cores. The calling thread takes part in the work.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned n_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Process-wide pool sized to the hardware concurrency
+    static ThreadPool &shared();
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    // Run fn(i) for i in [0, n). Blocks until every index is done and
+    // rethrows the first exception raised by fn. Calls made from inside a
+    // pool task run serially on the calling thread.
+    void parallel_for(size_t n, const std::function<void(size_t)> &fn);
+
+private:
+    void worker_loop();
+    void drain(const std::function<void(size_t)> &fn, size_t n);
+
+    std::vector<std::thread> workers_;
+    std::mutex run_mutex_;  // one job at a time
+
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    const std::function<void(size_t)> *job_ = nullptr;
+    size_t job_size_ = 0;
+    std::atomic<size_t> next_{0};
+    unsigned busy_ = 0;
+    uint64_t generation_ = 0;
+    bool stop_ = false;
+    std::exception_ptr error_;
+};
+
+// Convenience wrapper over the shared pool
+inline void parallel_for(size_t n, const std::function<void(size_t)> &fn) {
+    ThreadPool::shared().parallel_for(n, fn);
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,331 @@
+#include "tick_engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "batch.h"
+
+namespace alphasignal {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+constexpr size_t kPopBatch = 256;
+// Empty polls before a consumer starts sleeping between polls
+constexpr int kSpinRounds = 64;
+
+}  // namespace
+
+// Consumer-private streaming state of one ticker
+struct TickEngine::TickerState {
+    double last_price = kNaN;
+    int64_t last_ts = 0;
+    uint64_t ticks = 0;
+    double volume = 0.0;
+    double notional = 0.0;
+    double last_return = kNaN;
+    double ema_fast = 0.0;
+    double ema_slow = 0.0;
+    double signal = 0.0;
+    int changes = 0;
+    double avg_gain = 0.0;
+    double avg_loss = 0.0;
+    double variance = 0.0;
+    bool dirty = false;
+};
+
+// Seqlock: odd sequence while the consumer writes; readers retry until they
+// see the same even sequence before and after copying the values.
+struct alignas(kCacheLine) TickEngine::Published {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<double> values[kNumStreamFeatures];
+};
+
+struct TickEngine::Shard {
+    std::unique_ptr<MpscRing<Tick>> mpsc;
+    std::vector<std::unique_ptr<SpscRing<Tick>>> spsc;  // one per producer
+    std::vector<int32_t> dirty;  // tickers touched by the current batch; reserved up front
+    alignas(kCacheLine) std::atomic<uint64_t> processed{0};
+};
+
+QueueMode parse_queue_mode(const std::string &name) {
+    if (name == "mpsc") {
+        return QueueMode::Mpsc;
+    }
+    if (name == "spsc") {
+        return QueueMode::Spsc;
+    }
+    throw std::invalid_argument("unknown queue mode: " + name);
+}
+
+const std::vector<std::string> &stream_feature_names() {
+    static const std::vector<std::string> names = {
+        "last_price", "last_timestamp", "ticks",       "volume",     "vwap",       "last_return",
+        "rsi",        "macd",           "macd_signal", "macd_hist",  "volatility"};
+    return names;
+}
+
+TickEngine::TickEngine(size_t n_tickers, const TickEngineOptions &opts)
+    : n_tickers_(n_tickers),
+      opts_(opts),
+      alpha_fast_(2.0 / (opts.macd_fast + 1)),
+      alpha_slow_(2.0 / (opts.macd_slow + 1)),
+      alpha_signal_(2.0 / (opts.macd_signal + 1)),
+      alpha_vol_(1.0 - std::exp(std::log(0.5) / opts.vol_halflife)) {
+    if (n_tickers == 0 || n_tickers > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+        throw std::invalid_argument("n_tickers must be between 1 and 2^31 - 1");
+    }
+    if (opts.queue_capacity < 2) {
+        throw std::invalid_argument("queue_capacity must be at least 2");
+    }
+    if (opts.mode == QueueMode::Spsc && opts.producers < 1) {
+        throw std::invalid_argument("producers must be at least 1");
+    }
+    if (opts.rsi_period < 1 || opts.macd_fast < 1 || opts.macd_slow < 1 || opts.macd_signal < 1 ||
+        is_missing(opts.vol_halflife) || opts.vol_halflife <= 0.0) {
+        throw std::invalid_argument("indicator periods must be positive");
+    }
+
+    size_t n_shards = opts.n_shards > 0
+                          ? static_cast<size_t>(opts.n_shards)
+                          : std::max(1u, std::thread::hardware_concurrency()) - 1;
+    n_shards = std::min(std::max<size_t>(n_shards, 1), n_tickers);
+
+    states_.reset(new TickerState[n_tickers]);
+    published_.reset(new Published[n_tickers]);
+    for (size_t t = 0; t < n_tickers; ++t) {
+        for (auto &v : published_[t].values) {
+            v.store(kNaN, std::memory_order_relaxed);
+        }
+    }
+    for (size_t s = 0; s < n_shards; ++s) {
+        auto shard = std::make_unique<Shard>();
+        if (opts.mode == QueueMode::Mpsc) {
+            shard->mpsc = std::make_unique<MpscRing<Tick>>(opts.queue_capacity);
+        } else {
+            for (int p = 0; p < opts.producers; ++p) {
+                shard->spsc.push_back(std::make_unique<SpscRing<Tick>>(opts.queue_capacity));
+            }
+        }
+        shard->dirty.reserve((n_tickers + n_shards - 1) / n_shards);
+        shards_.push_back(std::move(shard));
+    }
+}
+
+TickEngine::~TickEngine() { stop(); }
+
+void TickEngine::start() {
+    if (running_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    for (auto &shard : shards_) {
+        threads_.emplace_back([this, s = shard.get()] { consume(*s); });
+    }
+}
+
+void TickEngine::stop() {
+    if (!running_.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    for (auto &thread : threads_) {
+        thread.join();
+    }
+    threads_.clear();
+}
+
+bool TickEngine::push(const Tick &tick, size_t producer, bool wait) {
+    if (tick.ticker < 0 || static_cast<size_t>(tick.ticker) >= n_tickers_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    Shard &shard = *shards_[static_cast<size_t>(tick.ticker) % shards_.size()];
+    bool ok;
+    if (shard.mpsc) {
+        ok = shard.mpsc->try_push(tick);
+        while (!ok && wait && running()) {
+            std::this_thread::yield();
+            ok = shard.mpsc->try_push(tick);
+        }
+    } else {
+        if (producer >= shard.spsc.size()) {
+            throw std::invalid_argument("producer index out of range");
+        }
+        SpscRing<Tick> &ring = *shard.spsc[producer];
+        ok = ring.try_push(tick);
+        while (!ok && wait && running()) {
+            std::this_thread::yield();
+            ok = ring.try_push(tick);
+        }
+    }
+    if (!ok) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return ok;
+}
+
+void TickEngine::apply(TickerState &st, const Tick &tick) const {
+    const double price = tick.price;
+    // is_missing, not isnan: -ffast-math folds NaN comparisons away
+    if (is_missing(price) || price <= 0.0) {
+        return;  // NaN or non-positive prices carry no information
+    }
+    const double volume = is_missing(tick.volume) ? 0.0 : tick.volume;
+    ++st.ticks;
+    st.last_ts = tick.ts;
+    st.volume += volume;
+    st.notional += price * volume;
+
+    if (st.ticks == 1) {
+        st.ema_fast = st.ema_slow = price;
+        st.signal = 0.0;
+        st.last_price = price;
+        return;
+    }
+    const double change = price - st.last_price;
+    const double ret = std::log(price / st.last_price);
+    st.last_return = ret;
+    st.variance = alpha_vol_ * ret * ret + (1.0 - alpha_vol_) * st.variance;
+
+    // Wilder RSI, seeded with the simple average of the first `period` changes
+    const double gain = change > 0.0 ? change : 0.0;
+    const double loss = change < 0.0 ? -change : 0.0;
+    const int period = opts_.rsi_period;
+    ++st.changes;
+    if (st.changes <= period) {
+        st.avg_gain += gain;
+        st.avg_loss += loss;
+        if (st.changes == period) {
+            st.avg_gain /= period;
+            st.avg_loss /= period;
+        }
+    } else {
+        st.avg_gain = (st.avg_gain * (period - 1) + gain) / period;
+        st.avg_loss = (st.avg_loss * (period - 1) + loss) / period;
+    }
+
+    st.ema_fast = alpha_fast_ * price + (1.0 - alpha_fast_) * st.ema_fast;
+    st.ema_slow = alpha_slow_ * price + (1.0 - alpha_slow_) * st.ema_slow;
+    st.signal = alpha_signal_ * (st.ema_fast - st.ema_slow) + (1.0 - alpha_signal_) * st.signal;
+    st.last_price = price;
+}
+
+void TickEngine::publish(size_t ticker, const TickerState &st) {
+    double v[kNumStreamFeatures];
+    const double macd = st.ema_fast - st.ema_slow;
+    v[kLastPrice] = st.last_price;
+    v[kLastTimestamp] = static_cast<double>(st.last_ts);
+    v[kTickCount] = static_cast<double>(st.ticks);
+    v[kCumVolume] = st.volume;
+    v[kVwap] = st.volume > 0.0 ? st.notional / st.volume : st.last_price;
+    v[kLastReturn] = st.last_return;
+    v[kRsi] = st.changes < opts_.rsi_period
+                  ? kNaN
+                  : (st.avg_loss == 0.0 ? 100.0
+                                        : 100.0 - 100.0 / (1.0 + st.avg_gain / st.avg_loss));
+    v[kMacd] = macd;
+    v[kMacdSignal] = st.signal;
+    v[kMacdHist] = macd - st.signal;
+    v[kVolatility] = st.changes > 0 ? std::sqrt(st.variance) : kNaN;
+
+    Published &p = published_[ticker];
+    const uint64_t seq = p.seq.load(std::memory_order_relaxed);
+    p.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int f = 0; f < kNumStreamFeatures; ++f) {
+        p.values[f].store(v[f], std::memory_order_relaxed);
+    }
+    p.seq.store(seq + 2, std::memory_order_release);
+}
+
+void TickEngine::consume(Shard &shard) {
+    Tick batch[kPopBatch];
+    int idle = 0;
+    auto drain = [&](auto &ring) {
+        const size_t n = ring.try_pop(batch, kPopBatch);
+        for (size_t k = 0; k < n; ++k) {
+            TickerState &st = states_[batch[k].ticker];
+            apply(st, batch[k]);
+            if (!st.dirty && st.ticks > 0) {
+                st.dirty = true;
+                shard.dirty.push_back(batch[k].ticker);
+            }
+        }
+        return n;
+    };
+
+    for (;;) {
+        // Read the flag before draining so ticks pushed before stop() are applied
+        const bool stopping = !running_.load(std::memory_order_acquire);
+        size_t got = 0;
+        if (shard.mpsc) {
+            got += drain(*shard.mpsc);
+        }
+        for (auto &ring : shard.spsc) {
+            got += drain(*ring);
+        }
+        if (got > 0) {
+            for (int32_t ticker : shard.dirty) {
+                publish(static_cast<size_t>(ticker), states_[ticker]);
+                states_[ticker].dirty = false;
+            }
+            shard.dirty.clear();
+            shard.processed.fetch_add(got, std::memory_order_relaxed);
+            idle = 0;
+            continue;
+        }
+        if (stopping) {
+            return;
+        }
+        if (++idle < kSpinRounds) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(opts_.idle_sleep_us));
+        }
+    }
+}
+
+void TickEngine::snapshot(size_t ticker, double *out) const {
+    if (ticker >= n_tickers_) {
+        throw std::out_of_range("ticker index out of range");
+    }
+    const Published &p = published_[ticker];
+    for (;;) {
+        const uint64_t before = p.seq.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (int f = 0; f < kNumStreamFeatures; ++f) {
+            out[f] = p.values[f].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (p.seq.load(std::memory_order_relaxed) == before) {
+            return;
+        }
+    }
+}
+
+void TickEngine::snapshot_all(double *out) const {
+    for (size_t t = 0; t < n_tickers_; ++t) {
+        snapshot(t, out + t * kNumStreamFeatures);
+    }
+}
+
+TickEngineStats TickEngine::stats() const {
+    TickEngineStats s{0, dropped_.load(std::memory_order_relaxed), 0};
+    for (const auto &shard : shards_) {
+        s.processed += shard->processed.load(std::memory_order_relaxed);
+        if (shard->mpsc) {
+            s.queued += shard->mpsc->size_approx();
+        }
+        for (const auto &ring : shard->spsc) {
+            s.queued += ring->size_approx();
+        }
+    }
+    return s;
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ring_buffer.h"
+
+namespace alphasignal {
+
+// Real-time tick engine. Producers push ticks into bounded lock-free rings;
+// one consumer thread per shard (ticker % n_shards) advances the streaming
+// state of its tickers and publishes their latest feature vectors through
+// per-ticker seqlocks, so readers never block the consumers. Nothing on the
+// push / consume / snapshot path allocates.
+struct Tick {
+    int64_t ts;  // ns
+    double price;
+    double volume;
+    int32_t ticker;
+};
+
+enum class QueueMode {
+    Mpsc,  // one multi-producer ring per shard; any thread may push
+    Spsc,  // one ring per (producer, shard); producer p must be a single thread
+};
+
+QueueMode parse_queue_mode(const std::string &name);
+
+struct TickEngineOptions {
+    int n_shards = 0;             // consumer threads; 0 = hardware threads - 1 (at least 1)
+    size_t queue_capacity = 1 << 16;  // ticks per ring
+    QueueMode mode = QueueMode::Mpsc;
+    int producers = 1;            // Spsc only
+    int rsi_period = 14;
+    int macd_fast = 12;
+    int macd_slow = 26;
+    int macd_signal = 9;
+    double vol_halflife = 100.0;  // ticks, EWMA variance of log returns
+    int idle_sleep_us = 50;       // consumer back-off once its rings stay empty
+};
+
+enum StreamFeature : int {
+    kLastPrice = 0,
+    kLastTimestamp,
+    kTickCount,
+    kCumVolume,
+    kVwap,
+    kLastReturn,     // log return of the last tick
+    kRsi,            // Wilder RSI over tick-to-tick changes; NaN while warming up
+    kMacd,
+    kMacdSignal,
+    kMacdHist,
+    kVolatility,     // EWMA std of tick log returns
+    kNumStreamFeatures
+};
+
+const std::vector<std::string> &stream_feature_names();
+
+struct TickEngineStats {
+    uint64_t processed;  // ticks applied by the consumers
+    uint64_t dropped;    // pushes rejected (full ring or unknown ticker)
+    uint64_t queued;     // approximate ticks waiting in the rings
+};
+
+class TickEngine {
+public:
+    TickEngine(size_t n_tickers, const TickEngineOptions &opts = TickEngineOptions());
+    ~TickEngine();
+
+    TickEngine(const TickEngine &) = delete;
+    TickEngine &operator=(const TickEngine &) = delete;
+
+    // Consumers drain whatever was queued before start; stop drains what is
+    // visible, then joins. Both are idempotent.
+    void start();
+    void stop();
+    bool running() const { return running_.load(std::memory_order_acquire); }
+
+    // Wait-free for Spsc, lock-free for Mpsc. False when the ring is full or
+    // the ticker is out of range; the tick is then dropped and counted. With
+    // `wait`, a full ring is retried for as long as the engine is running.
+    bool push(const Tick &tick, size_t producer = 0, bool wait = false);
+
+    // Latest published features of one ticker (kNumStreamFeatures values),
+    // or of every ticker, ticker-major. Consistent per ticker.
+    void snapshot(size_t ticker, double *out) const;
+    void snapshot_all(double *out) const;
+
+    TickEngineStats stats() const;
+    size_t n_tickers() const { return n_tickers_; }
+    size_t n_shards() const { return shards_.size(); }
+
+private:
+    struct TickerState;
+    struct Published;
+    struct Shard;
+
+    void consume(Shard &shard);
+    void apply(TickerState &state, const Tick &tick) const;
+    void publish(size_t ticker, const TickerState &state);
+
+    const size_t n_tickers_;
+    const TickEngineOptions opts_;
+    const double alpha_fast_, alpha_slow_, alpha_signal_, alpha_vol_;
+    std::unique_ptr<TickerState[]> states_;  // consumer-owned
+    std::unique_ptr<Published[]> published_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> running_{false};
+    alignas(kCacheLine) std::atomic<uint64_t> dropped_{0};
+};
+
+}  // namespace alphasignal
@@ -0,0 +1,192 @@
+#include "tree_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include "arena.h"
+#include "batch.h"
+#include "thread_pool.h"
+
+namespace alphasignal {
+
+namespace {
+
+// File layout, little-endian:
+//   "ASTE", u32 version, u32 n_features, u32 n_trees, u32 n_nodes, f64 base_margin,
+//   f64 mean[n_features], f64 scale[n_features], i32 roots[n_trees],
+//   i32 feature[n_nodes], f32 value[n_nodes], i32 left[n_nodes], i32 right[n_nodes],
+//   u8 default_left[n_nodes]
+constexpr char kMagic[4] = {'A', 'S', 'T', 'E'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kRowChunk = 256;
+
+class FileReader {
+public:
+    explicit FileReader(const std::string &path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("cannot open tree model: " + path);
+        }
+        bytes_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    template <typename T>
+    T get() {
+        T v;
+        read(&v, sizeof(T));
+        return v;
+    }
+
+    template <typename T>
+    void get_array(std::vector<T> &out, size_t n) {
+        out.resize(n);
+        read(out.data(), n * sizeof(T));
+    }
+
+    void read(void *out, size_t n) {
+        if (bytes_.size() - pos_ < n) {
+            throw std::runtime_error("tree model file is truncated");
+        }
+        std::memcpy(out, bytes_.data() + pos_, n);
+        pos_ += n;
+    }
+
+    bool done() const { return pos_ == bytes_.size(); }
+
+private:
+    std::vector<char> bytes_;
+    size_t pos_ = 0;
+};
+
+}  // namespace
+
+double TreeEnsemble::predict(const double *row) const {
+    double margin = base_margin;
+    for (int32_t root : roots) {
+        int32_t node = root;
+        while (feature[node] >= 0) {
+            const int32_t f = feature[node];
+            const double x = row[f];
+            if (is_missing(x)) {
+                node = default_left[node] ? left[node] : right[node];
+            } else {
+                const float z = static_cast<float>((x - mean[f]) / scale[f]);
+                node = z < value[node] ? left[node] : right[node];
+            }
+        }
+        margin += value[node];
+    }
+    return 1.0 / (1.0 + std::exp(-margin));
+}
+
+void TreeEnsemble::predict_batch(const double *rows, size_t n_rows, double *out) const {
+    const size_t nf = static_cast<size_t>(n_features);
+    parallel_for((n_rows + kRowChunk - 1) / kRowChunk, [&](size_t chunk) {
+        const size_t begin = chunk * kRowChunk;
+        const size_t m = std::min(n_rows, begin + kRowChunk) - begin;
+        // Standardise the chunk once, then walk tree by tree so each tree's
+        // nodes stay in cache across the rows. Same sums, same order as predict().
+        ArenaScope scope;
+        ScratchVector<float> z = scratch<float>(m * nf);
+        ScratchVector<uint8_t> missing = scratch<uint8_t>(m * nf);
+        for (size_t r = 0; r < m; ++r) {
+            const double *row = rows + (begin + r) * nf;
+            for (size_t f = 0; f < nf; ++f) {
+                missing[r * nf + f] = is_missing(row[f]);
+                z[r * nf + f] = static_cast<float>((row[f] - mean[f]) / scale[f]);
+            }
+        }
+        ScratchVector<double> margin = scratch<double>(m, base_margin);
+        for (int32_t root : roots) {
+            for (size_t r = 0; r < m; ++r) {
+                const float *zr = z.data() + r * nf;
+                const uint8_t *mr = missing.data() + r * nf;
+                int32_t node = root;
+                while (feature[node] >= 0) {
+                    const int32_t f = feature[node];
+                    const bool go_left = mr[f] ? default_left[node] != 0 : zr[f] < value[node];
+                    node = go_left ? left[node] : right[node];
+                }
+                margin[r] += value[node];
+            }
+        }
+        for (size_t r = 0; r < m; ++r) {
+            out[begin + r] = 1.0 / (1.0 + std::exp(-margin[r]));
+        }
+    });
+}
+
+TreeEnsemble load_tree_ensemble(const std::string &path) {
+    FileReader in(path);
+    char magic[4];
+    in.read(magic, sizeof(magic));
+    if (std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("not a tree model file: " + path);
+    }
+    if (in.get<uint32_t>() != kVersion) {
+        throw std::runtime_error("unsupported tree model version");
+    }
+    TreeEnsemble model;
+    const uint32_t n_features = in.get<uint32_t>();
+    const uint32_t n_trees = in.get<uint32_t>();
+    const uint32_t n_nodes = in.get<uint32_t>();
+    model.n_features = static_cast<int32_t>(n_features);
+    model.base_margin = in.get<double>();
+    in.get_array(model.mean, n_features);
+    in.get_array(model.scale, n_features);
+    in.get_array(model.roots, n_trees);
+    in.get_array(model.feature, n_nodes);
+    in.get_array(model.value, n_nodes);
+    in.get_array(model.left, n_nodes);
+    in.get_array(model.right, n_nodes);
+    in.get_array(model.default_left, n_nodes);
+    if (!in.done()) {
+        throw std::runtime_error("trailing bytes in tree model file");
+    }
+
+    // Validate once so prediction can index without checks
+    const int32_t nodes = static_cast<int32_t>(n_nodes);
+    for (uint32_t f = 0; f < n_features; ++f) {
+        if (!(model.scale[f] != 0.0)) {
+            model.scale[f] = 1.0;  // StandardScaler leaves constant columns unscaled
+        }
+    }
+    for (int32_t root : model.roots) {
+        if (root < 0 || root >= nodes) {
+            throw std::runtime_error("tree root out of range");
+        }
+    }
+    for (int32_t i = 0; i < nodes; ++i) {
+        if (model.feature[i] >= static_cast<int32_t>(n_features)) {
+            throw std::runtime_error("split feature out of range");
+        }
+        // Children come after their parent, so every walk terminates
+        if (model.feature[i] >= 0 && (model.left[i] <= i || model.left[i] >= nodes ||
+                                      model.right[i] <= i || model.right[i] >= nodes)) {
+            throw std::runtime_error("tree child index out of range");
+        }
+    }
+
+    std::ifstream names(path + ".features");
+    if (names) {
+        for (std::string line; std::getline(names, line);) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (!line.empty()) {
+                model.feature_names.push_back(line);
+            }
+        }
+        if (model.feature_names.size() != n_features) {
+            throw std::runtime_error("feature name sidecar does not match the model");
+        }
+    }
+    return model;
+}
+
+}  // namespace alphasignal
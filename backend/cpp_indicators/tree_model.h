@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace alphasignal {
+
+// Gradient-boosted tree ensemble exported from the XGBoost predictor
+// (XGBoostPredictor.export_native). Rows hold raw feature values; the
+// training-time standardisation (x - mean) / scale is applied before the
+// trees, and splits compare in float32 as XGBoost does. Missing (NaN)
+// values follow each node's default direction.
+struct TreeEnsemble {
+    int32_t n_features = 0;
+    double base_margin = 0.0;  // logit of XGBoost's base_score
+    std::vector<double> mean;
+    std::vector<double> scale;
+    std::vector<int32_t> roots;  // first node of each tree
+    // Flattened nodes; feature < 0 marks a leaf whose value is `value`
+    std::vector<int32_t> feature;
+    std::vector<float> value;  // split threshold (go left if x < value) or leaf weight
+    std::vector<int32_t> left;
+    std::vector<int32_t> right;
+    std::vector<uint8_t> default_left;
+    // Column names from the optional "<path>.features" sidecar, one per line
+    std::vector<std::string> feature_names;
+
+    size_t n_trees() const { return roots.size(); }
+
+    // Probability of the positive class for one row of n_features values
+    double predict(const double *row) const;
+    // Row-major (n_rows x n_features) input
+    void predict_batch(const double *rows, size_t n_rows, double *out) const;
+};
+
+// Throws std::runtime_error on a missing, truncated or inconsistent file
+// (or a sidecar whose line count is not n_features)
+TreeEnsemble load_tree_ensemble(const std::string &path);
+
+}  // namespace alphasignal
@@ -0,0 +1,208 @@
+#include "universe_state.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace alphasignal {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+// Recompute the Bollinger window sums this often to flush rounding drift
+constexpr int64_t kRebaseSteps = 4096;
+
+struct Coefficients {
+    double period;      // RSI
+    double inv_period;
+    double slow;        // MACD row at which the signal line starts
+    double alpha_fast;
+    double alpha_slow;
+    double alpha_signal;
+};
+
+constexpr uint64_t kAbsMask = 0x7fffffffffffffffULL;
+constexpr uint64_t kInfBits = 0x7ff0000000000000ULL;
+
+// The whole per-timestamp update. Once inlined, GCC no longer trusts the
+// restrict qualifiers across this many arrays, hence the ivdep as well.
+// `bits` is the raw bit pattern of `price`: the NaN test is done on integer
+// lanes because is_missing()'s per-element memcpy blocks vectorization.
+void sweep(size_t n, const Coefficients &k, const double *__restrict price,
+           const uint64_t *__restrict bits, double *__restrict last, double *__restrict n_obs,
+           double *__restrict avg_gain, double *__restrict avg_loss, double *__restrict ema_fast,
+           double *__restrict ema_slow, double *__restrict signal, double *__restrict anchor,
+           double *__restrict bb_sum, double *__restrict bb_sumsq, double *__restrict bb_count,
+           double *__restrict win_value, double *__restrict win_valid) {
+    const double period = k.period, inv_period = k.inv_period;
+    const double alpha_fast = k.alpha_fast, alpha_slow = k.alpha_slow;
+    const double alpha_signal = k.alpha_signal, k_slow = k.slow;
+#pragma GCC ivdep
+    for (size_t i = 0; i < n; ++i) {
+        const double p = price[i];
+        const bool valid = (bits[i] & kAbsMask) <= kInfBits;
+        const double seen = n_obs[i];
+        const bool first = seen == 0.0;
+
+        // RSI: `seen` is the 1-based index of this change when it counts.
+        // Like rsi(), change `period` completes the simple-average seed and
+        // is then applied once more with Wilder's smoothing.
+        const double change = p - last[i];
+        const bool counts = valid && !first;
+        const double gain = counts && change > 0.0 ? change : 0.0;
+        const double loss = counts && change < 0.0 ? -change : 0.0;
+        const double sum_gain = avg_gain[i] + gain;
+        const double sum_loss = avg_loss[i] + loss;
+        const bool warm = seen < period;
+        const bool seed = seen == period;
+        const double prev_gain = seed ? sum_gain * inv_period : avg_gain[i];
+        const double prev_loss = seed ? sum_loss * inv_period : avg_loss[i];
+        const double wilder_gain = (prev_gain * (period - 1.0) + gain) * inv_period;
+        const double wilder_loss = (prev_loss * (period - 1.0) + loss) * inv_period;
+        avg_gain[i] = counts ? (warm ? sum_gain : wilder_gain) : avg_gain[i];
+        avg_loss[i] = counts ? (warm ? sum_loss : wilder_loss) : avg_loss[i];
+
+        // MACD as in macd(): EMAs seeded with the first price, signal line
+        // seeded with the MACD value at row `slow` and 0 before it
+        const double fast = first ? p : alpha_fast * p + (1.0 - alpha_fast) * ema_fast[i];
+        const double slow = first ? p : alpha_slow * p + (1.0 - alpha_slow) * ema_slow[i];
+        const double m = fast - slow;
+        const double ema_sig = alpha_signal * m + (1.0 - alpha_signal) * signal[i];
+        const double sig = seen < k_slow ? 0.0 : (seen == k_slow ? m : ema_sig);
+        ema_fast[i] = valid ? fast : ema_fast[i];
+        ema_slow[i] = valid ? slow : ema_slow[i];
+        signal[i] = valid ? sig : signal[i];
+
+        // Bollinger window: swap this timestamp's slot
+        const double base = valid && first ? p : anchor[i];
+        const double v = valid ? p - base : 0.0;
+        const double vv = valid ? 1.0 : 0.0;
+        const double old = win_value[i];
+        bb_sum[i] += v - old;
+        bb_sumsq[i] += v * v - old * old;
+        bb_count[i] += vv - win_valid[i];
+        win_value[i] = v;
+        win_valid[i] = vv;
+        anchor[i] = base;
+
+        last[i] = valid ? p : last[i];
+        n_obs[i] = seen + vv;
+    }
+}
+
+}  // namespace
+
+const std::vector<std::string> &universe_feature_names() {
+    static const std::vector<std::string> names = {"rsi",       "macd",     "macd_signal",
+                                                   "macd_hist", "bb_middle", "bb_upper",
+                                                   "bb_lower",  "bb_percent"};
+    return names;
+}
+
+UniverseState::UniverseState(size_t n_tickers, const UniverseOptions &opts)
+    : n_(n_tickers), opts_(opts) {
+    if (opts.rsi_period < 1 || opts.macd_fast < 1 || opts.macd_slow < 1 || opts.macd_signal < 1 ||
+        opts.bb_period < 1) {
+        throw std::invalid_argument("indicator periods must be positive");
+    }
+    reset();
+}
+
+void UniverseState::reset() {
+    steps_ = 0;
+    for (auto *v : {&last_, &n_obs_, &avg_gain_, &avg_loss_, &ema_fast_, &ema_slow_, &signal_,
+                    &anchor_, &bb_sum_, &bb_sumsq_, &bb_count_}) {
+        v->assign(n_, 0.0);
+    }
+    win_value_.assign(static_cast<size_t>(opts_.bb_period) * n_, 0.0);
+    win_valid_.assign(static_cast<size_t>(opts_.bb_period) * n_, 0.0);
+    bits_.assign(n_, 0);
+}
+
+void UniverseState::update_all(const double *prices) {
+    const Coefficients k{static_cast<double>(opts_.rsi_period), 1.0 / opts_.rsi_period,
+                         static_cast<double>(opts_.macd_slow), 2.0 / (opts_.macd_fast + 1), 2.0 / (opts_.macd_slow + 1),
+                         2.0 / (opts_.macd_signal + 1)};
+    const size_t slot = static_cast<size_t>(steps_ % opts_.bb_period) * n_;
+    std::memcpy(bits_.data(), prices, n_ * sizeof(double));
+    sweep(n_, k, prices, bits_.data(), last_.data(), n_obs_.data(), avg_gain_.data(),
+          avg_loss_.data(), ema_fast_.data(), ema_slow_.data(), signal_.data(), anchor_.data(), bb_sum_.data(),
+          bb_sumsq_.data(), bb_count_.data(), win_value_.data() + slot, win_valid_.data() + slot);
+    ++steps_;
+    if (steps_ % kRebaseSteps == 0) {
+        rebase();
+    }
+}
+
+void UniverseState::rebase() {
+    double *__restrict sum = bb_sum_.data();
+    double *__restrict sumsq = bb_sumsq_.data();
+    double *__restrict count = bb_count_.data();
+    for (size_t i = 0; i < n_; ++i) {
+        sum[i] = sumsq[i] = count[i] = 0.0;
+    }
+    for (int s = 0; s < opts_.bb_period; ++s) {
+        const double *__restrict value = win_value_.data() + static_cast<size_t>(s) * n_;
+        const double *__restrict valid = win_valid_.data() + static_cast<size_t>(s) * n_;
+        for (size_t i = 0; i < n_; ++i) {
+            sum[i] += value[i];
+            sumsq[i] += value[i] * value[i];
+            count[i] += valid[i];
+        }
+    }
+}
+
+void UniverseState::features(double *out) const {
+    const double period = opts_.rsi_period;
+    const double slow = opts_.macd_slow;
+    const double bb_n = opts_.bb_period;
+    const double bb_std = opts_.bb_std;
+    double *__restrict rsi = out + kUniRsi * n_;
+    double *__restrict macd = out + kUniMacd * n_;
+    double *__restrict sig = out + kUniMacdSignal * n_;
+    double *__restrict hist = out + kUniMacdHist * n_;
+    double *__restrict mid = out + kUniBbMiddle * n_;
+    double *__restrict upper = out + kUniBbUpper * n_;
+    double *__restrict lower = out + kUniBbLower * n_;
+    double *__restrict pct = out + kUniBbPercent * n_;
+    const double *__restrict n_obs = n_obs_.data();
+    const double *__restrict avg_gain = avg_gain_.data();
+    const double *__restrict avg_loss = avg_loss_.data();
+    const double *__restrict ema_fast = ema_fast_.data();
+    const double *__restrict ema_slow = ema_slow_.data();
+    const double *__restrict signal = signal_.data();
+    const double *__restrict anchor = anchor_.data();
+    const double *__restrict bb_sum = bb_sum_.data();
+    const double *__restrict bb_sumsq = bb_sumsq_.data();
+    const double *__restrict bb_count = bb_count_.data();
+    const double *__restrict last = last_.data();
+#pragma GCC ivdep
+    for (size_t i = 0; i < n_; ++i) {
+        const double seen = n_obs[i];
+        const double gain = avg_gain[i], loss = avg_loss[i];
+        const double rs = gain / (loss == 0.0 ? 1.0 : loss);
+        const double value = loss == 0.0 ? 100.0 : 100.0 - 100.0 / (1.0 + rs);
+        rsi[i] = seen - 1.0 >= period ? value : 0.0;
+
+        // Before the signal line starts it is 0, and so is the histogram
+        const double m = ema_fast[i] - ema_slow[i];
+        macd[i] = m;
+        sig[i] = signal[i];
+        hist[i] = seen - 1.0 > slow ? m - signal[i] : 0.0;
+
+        const double mean = bb_sum[i] / bb_n;
+        const double var = bb_sumsq[i] / bb_n - mean * mean;
+        const double sd = std::sqrt(var > 0.0 ? var : 0.0);
+        const double centre = anchor[i] + mean;
+        const double width = 2.0 * bb_std * sd;
+        const bool full = bb_count[i] == bb_n;
+        mid[i] = full ? centre : 0.0;
+        upper[i] = full ? centre + bb_std * sd : 0.0;
+        lower[i] = full ? centre - bb_std * sd : 0.0;
+        const double pos = (last[i] - (centre - bb_std * sd)) / (width > 0.0 ? width : 1.0);
+        pct[i] = full && width > 0.0 ? pos : kNaN;
+    }
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace alphasignal {
+
+// Streaming RSI / MACD / Bollinger state for a whole universe, stored as
+// struct-of-arrays: every state variable is one contiguous array indexed by
+// ticker, so update_all() advances all tickers for one timestamp in a single
+// branch-free sweep the compiler turns into SIMD.
+//
+// On a ticker without missing prices the features equal the last row of
+// rsi(), macd() and bollinger_bands() over its history, up to rounding
+// (Bollinger moments come from running sums), warm-up zeros included:
+// RSI is 0 until `rsi_period` changes are in, the MACD signal line and
+// histogram are 0 until row `macd_slow`, bands are 0 until the window fills.
+// A missing (NaN) price leaves that ticker's RSI / MACD state untouched, so
+// they follow the kernels run on its non-missing prices; Bollinger bands
+// cover the last `bb_period` timestamps and stay 0 unless every one of them
+// had a price. bb_percent is NaN while the bands are 0 or flat.
+struct UniverseOptions {
+    int rsi_period = 14;
+    int macd_fast = 12;
+    int macd_slow = 26;
+    int macd_signal = 9;
+    int bb_period = 20;
+    double bb_std = 2.0;
+};
+
+enum UniverseFeature : int {
+    kUniRsi = 0,
+    kUniMacd,
+    kUniMacdSignal,
+    kUniMacdHist,
+    kUniBbMiddle,
+    kUniBbUpper,
+    kUniBbLower,
+    kUniBbPercent,  // (price - lower) / (upper - lower)
+    kNumUniverseFeatures
+};
+
+const std::vector<std::string> &universe_feature_names();
+
+class UniverseState {
+public:
+    UniverseState(size_t n_tickers, const UniverseOptions &opts = UniverseOptions());
+
+    // Advance every ticker by one timestamp; prices has n_tickers entries
+    void update_all(const double *prices);
+
+    // Feature-major (kNumUniverseFeatures x n_tickers) view of the current state
+    void features(double *out) const;
+
+    void reset();
+
+    size_t n_tickers() const { return n_; }
+    int64_t steps() const { return steps_; }
+    const UniverseOptions &options() const { return opts_; }
+
+private:
+    void rebase();
+
+    size_t n_;
+    UniverseOptions opts_;
+    int64_t steps_ = 0;
+
+    // One entry per ticker. Counts are doubles so every lane has the same width.
+    std::vector<double> last_;
+    std::vector<double> n_obs_;
+    std::vector<double> avg_gain_;
+    std::vector<double> avg_loss_;
+    std::vector<double> ema_fast_;
+    std::vector<double> ema_slow_;
+    std::vector<double> signal_;
+    // Bollinger window sums of (price - anchor); the anchor (first price)
+    // keeps the variance from cancelling catastrophically on high prices
+    std::vector<double> anchor_;
+    std::vector<double> bb_sum_;
+    std::vector<double> bb_sumsq_;
+    std::vector<double> bb_count_;
+    // Window rings, time-major ([slot][ticker]) so the row being replaced is contiguous
+    std::vector<double> win_value_;
+    std::vector<double> win_valid_;
+    std::vector<uint64_t> bits_;  // scratch: bit patterns of the current prices
+};
+
+}  // namespace alphasignal
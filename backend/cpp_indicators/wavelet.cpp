@@ -0,0 +1,184 @@
+#include "wavelet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "arena.h"
+#include "thread_pool.h"
+
+namespace alphasignal {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+constexpr double kInvSqrt2 = 0.70710678118654752440084436210485;
+
+// Orthonormal Daubechies scaling filters (sum = sqrt 2), Percival & Walden order
+const std::vector<double> &scaling_filter(WaveletFilter filter) {
+    static const std::vector<double> haar = {kInvSqrt2, kInvSqrt2};
+    static const std::vector<double> d4 = {0.48296291314469025, 0.83651630373746899,
+                                           0.22414386804185735, -0.12940952255092145};
+    static const std::vector<double> d6 = {0.33267055295095688, 0.80689150931333875,
+                                           0.45987750211933132, -0.13501102001039084,
+                                           -0.08544127388224149, 0.03522629188210562};
+    static const std::vector<double> d8 = {0.23037781330885523, 0.71484657055254153,
+                                           0.63088076792959036, -0.02798376941698385,
+                                           -0.18703481171888114, 0.03084138183598697,
+                                           0.03288301166698295, -0.01059740178499728};
+    switch (filter) {
+        case WaveletFilter::D4: return d4;
+        case WaveletFilter::D6: return d6;
+        case WaveletFilter::D8: return d8;
+        default: return haar;
+    }
+}
+
+// On the calling thread's arena
+struct FilterBank {
+    ScratchVector<double> g;  // MODWT scaling filter, sums to 1
+    ScratchVector<double> h;  // MODWT wavelet filter, sums to 0
+};
+
+FilterBank modwt_filters(WaveletFilter filter) {
+    const std::vector<double> &base = scaling_filter(filter);
+    const size_t taps = base.size();
+    FilterBank bank{scratch<double>(taps), scratch<double>(taps)};
+    for (size_t l = 0; l < taps; ++l) {
+        bank.g[l] = base[l] * kInvSqrt2;
+        // Quadrature mirror: h_l = (-1)^l g_{L-1-l}
+        bank.h[l] = ((l & 1) ? -1.0 : 1.0) * base[taps - 1 - l] * kInvSqrt2;
+    }
+    return bank;
+}
+
+// One pyramid level: out[t] = sum_l f[l] in[t - spacing * l], with the
+// boundary either clamped to in[0] (causal) or wrapped (periodic)
+void filter_level(const double *in, size_t n, const ScratchVector<double> &f, size_t spacing,
+                  bool causal, double *out) {
+    const size_t taps = f.size();
+    const size_t reach = spacing * (taps - 1);
+    const size_t head = std::min(n, reach);
+    for (size_t t = 0; t < head; ++t) {
+        double acc = 0.0;
+        for (size_t l = 0; l < taps; ++l) {
+            const size_t back = spacing * l;
+            size_t idx;
+            if (back <= t) {
+                idx = t - back;
+            } else {
+                idx = causal ? 0 : (n - (back - t) % n) % n;
+            }
+            acc += f[l] * in[idx];
+        }
+        out[t] = acc;
+    }
+    if (head == n) {
+        return;
+    }
+    // Interior: no boundary checks, the t loop vectorizes per tap
+    std::fill(out + head, out + n, 0.0);
+    for (size_t l = 0; l < taps; ++l) {
+        const double c = f[l];
+        const double *src = in + head - spacing * l;
+        for (size_t t = 0; t + head < n; ++t) {
+            out[head + t] += c * src[t];
+        }
+    }
+}
+
+}  // namespace
+
+WaveletFilter parse_wavelet_filter(const std::string &name) {
+    if (name == "haar" || name == "db1") {
+        return WaveletFilter::Haar;
+    }
+    if (name == "d4" || name == "db2") {
+        return WaveletFilter::D4;
+    }
+    if (name == "d6" || name == "db3") {
+        return WaveletFilter::D6;
+    }
+    if (name == "d8" || name == "db4") {
+        return WaveletFilter::D8;
+    }
+    throw std::invalid_argument("unknown wavelet filter: " + name);
+}
+
+void wavelet_decompose(const double *x, size_t n, const WaveletOptions &opts,
+                       double *detail, double *smooth, double *energy, size_t stride) {
+    if (opts.levels < 1) {
+        throw std::invalid_argument("levels must be at least 1");
+    }
+    const size_t levels = static_cast<size_t>(opts.levels);
+
+    size_t first = 0;
+    while (first < n && is_missing(x[first])) {
+        ++first;
+    }
+    for (size_t j = 0; j < levels; ++j) {
+        std::fill(detail + j * stride, detail + j * stride + first, kNaN);
+        std::fill(smooth + j * stride, smooth + j * stride + first, kNaN);
+        if (energy) {
+            std::fill(energy + j * stride, energy + j * stride + first, kNaN);
+        }
+    }
+    const size_t m = n - first;
+    if (m == 0) {
+        return;
+    }
+
+    // Gaps are filled forward so a missing bar never looks ahead
+    ArenaScope scope;
+    ScratchVector<double> prev = scratch<double>(m), next = scratch<double>(m);
+    prev[0] = x[first];
+    for (size_t t = 1; t < m; ++t) {
+        const double v = x[first + t];
+        prev[t] = is_missing(v) ? prev[t - 1] : v;
+    }
+
+    const FilterBank bank = modwt_filters(opts.filter);
+    const bool modwt = opts.transform == WaveletTransform::Modwt;
+    for (size_t j = 0; j < levels; ++j) {
+        const size_t spacing = size_t{1} << j;
+        filter_level(prev.data(), m, bank.g, spacing, opts.causal, next.data());
+        double *d = detail + j * stride + first;
+        if (modwt) {
+            filter_level(prev.data(), m, bank.h, spacing, opts.causal, d);
+        } else {
+            for (size_t t = 0; t < m; ++t) {
+                d[t] = prev[t] - next[t];
+            }
+        }
+        std::copy(next.begin(), next.end(), smooth + j * stride + first);
+
+        if (energy && opts.energy_window > 0) {
+            // Trailing mean of detail^2; NaN until a full window is available
+            const size_t w = static_cast<size_t>(opts.energy_window);
+            double *e = energy + j * stride + first;
+            double sum = 0.0;
+            for (size_t t = 0; t < m; ++t) {
+                sum += d[t] * d[t];
+                if (t >= w) {
+                    sum -= d[t - w] * d[t - w];
+                }
+                e[t] = t + 1 >= w ? std::max(sum, 0.0) / static_cast<double>(w) : kNaN;
+            }
+        }
+        prev.swap(next);
+    }
+}
+
+void wavelet_decompose_batch(const double *x, const RaggedBatch &batch,
+                             const WaveletOptions &opts, double *detail, double *smooth,
+                             double *energy) {
+    const size_t stride = batch.total_rows();
+    parallel_for(batch.n_series, [&](size_t i) {
+        const size_t b = batch.begin(i);
+        wavelet_decompose(x + b, batch.length(i), opts, detail + b, smooth + b,
+                          energy ? energy + b : nullptr, stride);
+    });
+}
+
+}  // namespace alphasignal
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "batch.h"
+
+namespace alphasignal {
+
+// Undecimated (MODWT / a-trous) wavelet decomposition.
+// Level j filters the level j-1 smooth with the filter taps spread 2^(j-1)
+// bars apart, so the cost is O(n * levels * taps) and every level keeps the
+// input length:
+//   smooth_j[t] = sum_l g_l smooth_{j-1}[t - 2^(j-1) l]
+//   Modwt:  detail_j[t] = sum_l h_l smooth_{j-1}[t - 2^(j-1) l]
+//   ATrous: detail_j[t] = smooth_{j-1}[t] - smooth_j[t]
+// (g, h are the MODWT filters, i.e. the orthonormal ones divided by sqrt 2).
+// ATrous details are additive: x = smooth_J + sum_j detail_j. For Haar the
+// two transforms coincide.
+enum class WaveletFilter { Haar, D4, D6, D8 };
+
+enum class WaveletTransform { Modwt, ATrous };
+
+struct WaveletOptions {
+    WaveletFilter filter = WaveletFilter::Haar;
+    WaveletTransform transform = WaveletTransform::ATrous;
+    int levels = 4;
+    // Causal: taps before the first bar repeat the first value, so no output
+    // depends on later bars (safe for features). Otherwise the series is
+    // treated as periodic, the textbook MODWT, for offline analysis.
+    bool causal = true;
+    int energy_window = 0;  // > 0: also emit the rolling mean of detail^2
+};
+
+// Parses "haar", "d4"/"db2", "d6"/"db3", "d8"/"db4"
+WaveletFilter parse_wavelet_filter(const std::string &name);
+
+// Outputs are level-major with `stride` between levels: detail[j * stride + t]
+// for level j + 1. NaNs are carried forward from the last valid value;
+// rows before the first valid value are NaN. energy may be null and is
+// only written when opts.energy_window > 0.
+void wavelet_decompose(const double *x, size_t n, const WaveletOptions &opts,
+                       double *detail, double *smooth, double *energy, size_t stride);
+
+// One series per ticker; outputs are (levels x total_rows), so every level
+// is a contiguous column over all tickers
+void wavelet_decompose_batch(const double *x, const RaggedBatch &batch,
+                             const WaveletOptions &opts, double *detail, double *smooth,
+                             double *energy);
+
+}  // namespace alphasignal
@@ -0,0 +1,119 @@
+"""
+Corporate-Action Adjustment
+Backward-adjusted OHLCV and total-return indices from raw prices plus
+split and dividend events, recomputed without refetching history
+"""
+
+import pandas as pd
+import numpy as np
+import logging
+
+try:
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+except ImportError:
+    import sys
+    import os
+    sys.path.insert(0, os.path.join(os.path.dirname(__file__), '../..'))
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+
+logger = logging.getLogger(__name__)
+
+PRICE_COLUMNS = ['open', 'high', 'low', 'close', 'volume']
+
+
+class CorporateActionAdjuster:
+    """
+    Split and dividend adjustment for many tickers in one pass
+    - adj_open/high/low/close: CRSP / Yahoo convention, last row unadjusted
+    - adj_volume: scaled by subsequent splits
+    - total_return: dividends reinvested at the ex-date close, 1.0 at the first close
+    - adj_factor: adjusted price / raw price
+    Falls back to numpy if C++ not available
+    """
+
+    def __init__(self, use_cpp: bool = True):
+        self.use_cpp = use_cpp and CPP_AVAILABLE
+
+    def adjust(self, prices: pd.DataFrame, actions: pd.DataFrame) -> pd.DataFrame:
+        """
+        Args:
+            prices: ticker, date and raw open/high/low/close/volume
+            actions: ticker, date (ex-date), split (new shares per old) and/or
+                dividend (cash per share); several rows per day are combined
+
+        Returns:
+            prices sorted by ticker and date, with the adjusted columns added
+        """
+        df = prices.copy()
+        df['date'] = pd.to_datetime(df['date'])
+        df = df.sort_values(['ticker', 'date']).reset_index(drop=True)
+
+        events = actions.copy()
+        events['date'] = pd.to_datetime(events['date'])
+        if 'split' not in events:
+            events['split'] = np.nan
+        if 'dividend' not in events:
+            events['dividend'] = np.nan
+        events = events.groupby(['ticker', 'date']).agg(
+            split=('split', lambda s: s[s > 0].prod() if (s > 0).any() else np.nan),
+            dividend=('dividend', lambda s: s[s > 0].sum()),
+        ).reset_index()
+        merged = df[['ticker', 'date']].merge(events, on=['ticker', 'date'], how='left')
+
+        cols = [np.ascontiguousarray(df[c].to_numpy(dtype=np.float64)) for c in PRICE_COLUMNS]
+        split = np.ascontiguousarray(merged['split'].to_numpy(dtype=np.float64))
+        dividend = np.ascontiguousarray(merged['dividend'].to_numpy(dtype=np.float64))
+        counts = df.groupby('ticker', sort=False).size().to_numpy()
+        offsets = np.concatenate([[0], np.cumsum(counts)]).astype(np.int64)
+
+        if self.use_cpp:
+            res = cpp.adjust_corporate_actions(*cols, split, dividend, offsets)
+            out = [res.open, res.high, res.low, res.close, res.volume, res.total_return, res.factor]
+        else:
+            out = self._adjust_python(cols, split, dividend, offsets)
+
+        for name, values in zip(['adj_open', 'adj_high', 'adj_low', 'adj_close', 'adj_volume',
+                                 'total_return', 'adj_factor'], out):
+            df[name] = values
+        return df
+
+    @staticmethod
+    def _adjust_python(cols, split, dividend, offsets):
+        open_, high, low, close, volume = cols
+        n = len(close)
+        factor = np.ones(n)
+        volume_factor = np.ones(n)
+        total_return = np.full(n, np.nan)
+        split = np.where(np.nan_to_num(split) > 0, split, 1.0)
+        dividend = np.where(np.nan_to_num(dividend) > 0, dividend, 0.0)
+        for b, e in zip(offsets[:-1], offsets[1:]):
+            valid = np.flatnonzero(~np.isnan(close[b:e])) + b
+            if len(valid) == 0:
+                continue
+            # Per-event factors for the rows strictly before each ex-date,
+            # using the previous valid close
+            step = np.ones(e - b)
+            vstep = np.ones(e - b)
+            for t in range(b + 1, e):
+                if split[t] == 1.0 and dividend[t] == 0.0:
+                    continue
+                prev = valid[valid < t]
+                prev_close = close[prev[-1]] if len(prev) else np.nan
+                f = 1.0 - dividend[t] * split[t] / prev_close if len(prev) else 1.0
+                step[t - b] = (f if f > 0 else 1.0) / split[t]
+                vstep[t - b] = split[t]
+            # Reverse cumulative products: row t gets every event after it
+            factor[b:e] = np.concatenate([np.cumprod(step[::-1])[::-1][1:], [1.0]])
+            volume_factor[b:e] = np.concatenate([np.cumprod(vstep[::-1])[::-1][1:], [1.0]])
+            # Total return between consecutive valid closes p < t: dividends
+            # on a missing-close row are reinvested at close p, in the share
+            # basis after the splits up to that row
+            seg, div = close[b:e], dividend[b:e]
+            scale = np.cumprod(split[b:e])
+            missed = np.cumsum(np.where(np.isnan(seg), div, 0.0) * scale)
+            p, t = valid[:-1] - b, valid[1:] - b
+            growth = (seg[t] + div[t]) / seg[p] * scale[t] / scale[p] \
+                * (1.0 + (missed[t] - missed[p]) / (scale[p] * seg[p]))
+            total_return[valid] = np.concatenate([[1.0], np.cumprod(growth)])
+        return [open_ * factor, high * factor, low * factor, close * factor,
+                volume * volume_factor, total_return, factor]
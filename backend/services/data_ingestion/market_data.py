@@ -10,6 +10,14 @@ from datetime import datetime, timedelta
 from typing import Optional
 import logging
 
+try:
+    from services.technical_indicators.cpp_wrapper import ReturnsCalculator
+except ImportError:
+    import sys
+    import os
+    sys.path.insert(0, os.path.join(os.path.dirname(__file__), '../..'))
+    from services.technical_indicators.cpp_wrapper import ReturnsCalculator
+
 logger = logging.getLogger(__name__)
 
 
@@ -59,11 +67,45 @@ class MarketDataService:
             logger.error(f"Error fetching data for {ticker}: {e}")
             return pd.DataFrame()
 
+    def fetch_actions(
+        self,
+        ticker: str,
+        start_date: Optional[str] = None,
+        end_date: Optional[str] = None
+    ) -> pd.DataFrame:
+        """
+        Fetch split and dividend events (ticker, date, split, dividend) for
+        CorporateActionAdjuster
+        """
+        try:
+            actions = yf.Ticker(ticker).actions
+            if actions is None or actions.empty:
+                return pd.DataFrame(columns=['ticker', 'date', 'split', 'dividend'])
+
+            actions = actions.reset_index()
+            actions.columns = [str(col).lower() for col in actions.columns]
+            events = pd.DataFrame({
+                'ticker': ticker,
+                'date': pd.to_datetime(actions['date']).dt.tz_localize(None).dt.normalize(),
+                'split': actions.get('stock splits', 0.0),
+                'dividend': actions.get('dividends', 0.0),
+            })
+            if start_date is not None:
+                events = events[events['date'] >= pd.Timestamp(start_date)]
+            if end_date is not None:
+                events = events[events['date'] <= pd.Timestamp(end_date)]
+            return events.reset_index(drop=True)
+
+        except Exception as e:
+            logger.error(f"Error fetching corporate actions for {ticker}: {e}")
+            return pd.DataFrame(columns=['ticker', 'date', 'split', 'dividend'])
+
     def calculate_returns(self, df: pd.DataFrame) -> pd.DataFrame:
         """Add return columns"""
-        df = df.copy()
-        df['returns_1d'] = df['close'].pct_change(1)
-        df['returns_5d'] = df['close'].pct_change(5)
-        df['returns_20d'] = df['close'].pct_change(20)
-        df['log_returns'] = np.log(df['close'] / df['close'].shift(1))
-        return df
+        returns = ReturnsCalculator(horizons=(1, 5, 20)).compute(df['close'].to_numpy())
+        return df.assign(
+            returns_1d=returns['simple_1'],
+            returns_5d=returns['simple_5'],
+            returns_20d=returns['simple_20'],
+            log_returns=returns['log_1'],
+        )
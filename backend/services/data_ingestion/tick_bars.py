@@ -0,0 +1,187 @@
+"""
+Tick-to-Bar Builder
+Aggregate (timestamp, price, size) ticks into time, tick, volume, dollar
+and tick-imbalance bars with OHLCV + VWAP
+"""
+
+import pandas as pd
+import numpy as np
+from typing import Iterator, Optional
+import logging
+
+try:
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+except ImportError:
+    import sys
+    import os
+    sys.path.insert(0, os.path.join(os.path.dirname(__file__), '../..'))
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+
+logger = logging.getLogger(__name__)
+
+BAR_COLUMNS = ['start', 'end', 'open', 'high', 'low', 'close', 'volume',
+               'dollar_volume', 'vwap', 'buy_volume', 'ticks']
+BAR_TYPES = ('time', 'tick', 'volume', 'dollar', 'tick_imbalance')
+
+
+class TickBarBuilder:
+    """
+    Streaming bar builder; state is constant, so tick files of any size can
+    be fed chunk by chunk and each chunk returns the bars it closed.
+    - time: clock bars aligned to `interval` (empty intervals emit no bar)
+    - tick / volume / dollar: close once ticks / size / notional reach `threshold`
+    - tick_imbalance: close once the signed tick count exceeds its EWMA expectation
+    buy_volume is the size traded on upticks by the tick rule.
+    Falls back to Python if C++ not available
+    """
+
+    def __init__(self, bar_type: str = 'time', interval: str = '1min', threshold: float = 0.0,
+                 expected_ticks: float = 1000.0, expected_imbalance: float = 0.1,
+                 ewma_span: float = 20.0, use_cpp: bool = True):
+        if bar_type not in BAR_TYPES:
+            raise ValueError(f"bar_type must be one of {BAR_TYPES}")
+        self.bar_type = bar_type
+        self.interval_ns = int(pd.Timedelta(interval).value)
+        self.threshold = threshold
+        self.expected_ticks = expected_ticks
+        self.expected_imbalance = expected_imbalance
+        self.ewma_span = ewma_span
+        self.use_cpp = use_cpp and CPP_AVAILABLE
+        if self.use_cpp:
+            self._builder = cpp.BarBuilder(bar_type, self.interval_ns, threshold, expected_ticks,
+                                           expected_imbalance, ewma_span)
+        else:
+            self._builder = _PythonBarBuilder(self)
+
+    def update(self, ticks: pd.DataFrame) -> pd.DataFrame:
+        """
+        Args:
+            ticks: timestamp, price, size columns in time order
+
+        Returns:
+            Bars closed by this chunk
+        """
+        ts = pd.to_datetime(ticks['timestamp']).to_numpy(dtype='datetime64[ns]').view(np.int64)
+        price = ticks['price'].to_numpy(dtype=np.float64)
+        size = ticks['size'].to_numpy(dtype=np.float64)
+        return self._frame(self._builder.update(ts, price, size))
+
+    def flush(self) -> pd.DataFrame:
+        """Close the partial bar, e.g. at the end of a session"""
+        return self._frame(self._builder.flush())
+
+    def build_from_file(self, path: str, chunksize: int = 1_000_000) -> Iterator[pd.DataFrame]:
+        """Stream a CSV tick file, yielding bars as they close"""
+        for chunk in pd.read_csv(path, chunksize=chunksize):
+            bars = self.update(chunk)
+            if len(bars):
+                yield bars
+        last = self.flush()
+        if len(last):
+            yield last
+
+    @staticmethod
+    def _frame(cols) -> pd.DataFrame:
+        return pd.DataFrame({
+            'start': pd.to_datetime(np.asarray(cols.start_ns), unit='ns'),
+            'end': pd.to_datetime(np.asarray(cols.end_ns), unit='ns'),
+            'open': cols.open,
+            'high': cols.high,
+            'low': cols.low,
+            'close': cols.close,
+            'volume': cols.volume,
+            'dollar_volume': cols.dollar_volume,
+            'vwap': cols.vwap,
+            'buy_volume': cols.buy_volume,
+            'ticks': cols.ticks,
+        }, columns=BAR_COLUMNS)
+
+
+class _BarColumns:
+    """Column container matching the C++ BarColumns"""
+
+    def __init__(self, bars: list):
+        rows = np.array(bars, dtype=np.float64).reshape(-1, len(BAR_COLUMNS))
+        self.start_ns = np.array([b[0] for b in bars], dtype=np.int64)
+        self.end_ns = np.array([b[1] for b in bars], dtype=np.int64)
+        self.open, self.high, self.low, self.close = rows[:, 2], rows[:, 3], rows[:, 4], rows[:, 5]
+        self.volume, self.dollar_volume, self.vwap = rows[:, 6], rows[:, 7], rows[:, 8]
+        self.buy_volume = rows[:, 9]
+        self.ticks = np.array([b[10] for b in bars], dtype=np.int64)
+
+
+class _PythonBarBuilder:
+    """Tick loop mirroring the C++ BarBuilder"""
+
+    def __init__(self, opts: TickBarBuilder):
+        self.opts = opts
+        self.bar: Optional[list] = None
+        self.bar_end = 0
+        self.last_price = None
+        self.last_sign = 1.0
+        self.theta = 0.0
+        self.ewma_ticks = opts.expected_ticks
+        self.ewma_imbalance = min(opts.expected_imbalance, 1.0)
+
+    def _threshold(self) -> float:
+        return max(self.ewma_ticks * self.ewma_imbalance, 1.0)
+
+    def _close(self) -> list:
+        bar = self.bar
+        bar[8] = bar[7] / bar[6] if bar[6] > 0 else bar[5]
+        if self.opts.bar_type == 'tick_imbalance':
+            alpha = 2.0 / (self.opts.ewma_span + 1.0)
+            self.ewma_ticks += alpha * (bar[10] - self.ewma_ticks)
+            self.ewma_ticks = min(max(self.ewma_ticks, 0.1 * self.opts.expected_ticks),
+                                  10.0 * self.opts.expected_ticks)
+            self.ewma_imbalance += alpha * (abs(self.theta) / bar[10] - self.ewma_imbalance)
+            self.theta = 0.0
+        self.bar = None
+        return bar
+
+    def update(self, ts: np.ndarray, price: np.ndarray, size: np.ndarray) -> _BarColumns:
+        kind = self.opts.bar_type
+        interval = self.opts.interval_ns
+        out = []
+        for t, p, q in zip(ts.tolist(), price.tolist(), size.tolist()):
+            if np.isnan(p):
+                continue
+            q = 0.0 if np.isnan(q) else q
+            sign = 0.0
+            if self.last_price is not None:
+                sign = 1.0 if p > self.last_price else (-1.0 if p < self.last_price else self.last_sign)
+                self.last_sign = sign
+            self.last_price = p
+
+            if kind == 'time' and self.bar is not None and t >= self.bar_end:
+                out.append(self._close())
+            if self.bar is None:
+                self.bar = [t, t, p, p, p, p, 0.0, 0.0, 0.0, 0.0, 0]
+                self.bar_end = (t // interval + 1) * interval
+            bar = self.bar
+            bar[1] = t
+            bar[3] = max(bar[3], p)
+            bar[4] = min(bar[4], p)
+            bar[5] = p
+            bar[6] += q
+            bar[7] += p * q
+            bar[9] += q if sign > 0 else 0.0
+            bar[10] += 1
+
+            if kind == 'tick':
+                done = bar[10] >= self.opts.threshold
+            elif kind == 'volume':
+                done = bar[6] >= self.opts.threshold
+            elif kind == 'dollar':
+                done = bar[7] >= self.opts.threshold
+            elif kind == 'tick_imbalance':
+                self.theta += sign
+                done = abs(self.theta) >= self._threshold()
+            else:
+                done = False
+            if done:
+                out.append(self._close())
+        return _BarColumns(out)
+
+    def flush(self) -> _BarColumns:
+        return _BarColumns([self._close()] if self.bar is not None else [])
@@ -1,8 +1,10 @@
 """
 Factor Analysis for AlphaSignal
-Fama-French 3-factor model and risk decomposition
+Fama-French 3-factor model, risk decomposition, pairs and lead-lag screening
 """
 
 from .fama_french import FamaFrenchAnalysis
+from .pairs_screener import PairsScreener
+from .lead_lag import LeadLagScanner
 
-__all__ = ['FamaFrenchAnalysis']
+__all__ = ['FamaFrenchAnalysis', 'PairsScreener', 'LeadLagScanner']
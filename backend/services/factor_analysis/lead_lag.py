@@ -0,0 +1,102 @@
+"""
+Lead-Lag Scanner
+Cross-correlation over a range of lags to find which series lead which
+"""
+
+import pandas as pd
+import numpy as np
+from typing import List, Tuple
+import logging
+
+try:
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+except ImportError:
+    import sys
+    import os
+    sys.path.insert(0, os.path.join(os.path.dirname(__file__), '../..'))
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+
+logger = logging.getLogger(__name__)
+
+
+class LeadLagScanner:
+    """
+    Peak lagged correlation for (x, y) pairs of aligned series, e.g. sentiment
+    vs returns or a sector ETF vs its constituents.
+    Lag k > 0 means x leads y by k bars: corr(x_t, y_{t+k}) is the peak.
+    NaNs are read as 0, so pass returns or signals rather than prices.
+    Falls back to numpy if C++ not available
+    """
+
+    def __init__(self, max_lag: int = 10, window: int = 0, step: int = 0,
+                 sliding: bool = False, use_cpp: bool = True):
+        self.max_lag = max_lag
+        self.window = window      # 0: one window over the full history
+        self.step = step          # 0: non-overlapping windows
+        self.sliding = sliding    # sliding-DFT updates; worthwhile for small steps
+        self.use_cpp = use_cpp and CPP_AVAILABLE
+
+    def scan(self, data: pd.DataFrame, pairs: List[Tuple[str, str]]) -> pd.DataFrame:
+        """
+        Args:
+            data: one column per series, aligned on the index
+            pairs: (x, y) column names
+
+        Returns:
+            Long frame: x, y, window_end (index label), lag, corr
+        """
+        columns = {c: i for i, c in enumerate(data.columns)}
+        index = np.array([[columns[x], columns[y]] for x, y in pairs], dtype=np.int64).reshape(-1, 2)
+        panel = np.ascontiguousarray(data.to_numpy(dtype=np.float64))
+
+        if self.use_cpp:
+            ends, lags, corrs = cpp.lead_lag_scan(panel, index, self.max_lag, self.window,
+                                                  self.step, self.sliding)
+        else:
+            ends, lags, corrs = self._scan_python(panel, index)
+
+        n_windows = len(ends)
+        return pd.DataFrame({
+            'x': np.repeat([x for x, _ in pairs], n_windows),
+            'y': np.repeat([y for _, y in pairs], n_windows),
+            'window_end': np.tile(data.index[ends], len(pairs)),
+            'lag': lags.ravel(),
+            'corr': corrs.ravel(),
+        })
+
+    def profile(self, x: np.ndarray, y: np.ndarray) -> pd.Series:
+        """Full cross-correlation curve indexed by lag"""
+        x = np.ascontiguousarray(x, dtype=np.float64)
+        y = np.ascontiguousarray(y, dtype=np.float64)
+        if self.use_cpp:
+            r = cpp.cross_correlation(x, y, self.max_lag)
+        else:
+            r = self._cross_correlation_python(x, y)
+        return pd.Series(r, index=np.arange(-self.max_lag, self.max_lag + 1), name='corr')
+
+    def _cross_correlation_python(self, x: np.ndarray, y: np.ndarray) -> np.ndarray:
+        x = np.nan_to_num(x) - np.nan_to_num(x).mean()
+        y = np.nan_to_num(y) - np.nan_to_num(y).mean()
+        denom = np.sqrt((x ** 2).sum() * (y ** 2).sum())
+        full = np.correlate(y, x, mode='full')  # full[n - 1 + k] = sum_t x_t y_{t+k}
+        mid = len(x) - 1
+        r = full[mid - self.max_lag:mid + self.max_lag + 1]
+        return r / denom if denom > 0 else np.zeros_like(r)
+
+    def _scan_python(self, panel: np.ndarray, index: np.ndarray):
+        n_obs = len(panel)
+        window = self.window or n_obs
+        step = self.step or window
+        ends = np.arange(window - 1, n_obs, step)
+        lags = np.zeros((len(index), len(ends)), dtype=np.int64)
+        corrs = np.zeros((len(index), len(ends)))
+        # Lags ordered by |k| so ties go to the shorter lag, as in the C++ kernel
+        order = np.argsort(np.abs(np.arange(-self.max_lag, self.max_lag + 1)), kind='stable')
+        for p, (a, b) in enumerate(index):
+            for w, end in enumerate(ends):
+                rows = slice(end - window + 1, end + 1)
+                r = self._cross_correlation_python(panel[rows, a], panel[rows, b])
+                best = order[np.argmax(np.abs(r[order]))]
+                lags[p, w] = best - self.max_lag
+                corrs[p, w] = r[best]
+        return ends, lags, corrs
@@ -0,0 +1,107 @@
+"""
+Pairs Screener
+All-pairs return correlation followed by Engle-Granger cointegration tests
+"""
+
+import pandas as pd
+import numpy as np
+from typing import Optional
+import logging
+
+try:
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+except ImportError:
+    import sys
+    import os
+    sys.path.insert(0, os.path.join(os.path.dirname(__file__), '../..'))
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+
+logger = logging.getLogger(__name__)
+
+RESULT_COLUMNS = ['first', 'second', 'correlation', 'hedge_ratio', 'intercept',
+                  'adf_stat', 'p_value', 'half_life', 'n_obs']
+
+
+class PairsScreener:
+    """
+    Screen a price panel (dates x tickers) for tradeable pairs
+    - Stage 1: correlation of log returns for every pair, keep the strongest
+    - Stage 2: Engle-Granger (OLS hedge ratio + ADF on the spread) on those only
+    Falls back to numpy/statsmodels if C++ not available
+    """
+
+    def __init__(self, min_correlation: float = 0.7, max_candidates: int = 5000,
+                 adf_lags: int = 1, min_overlap: int = 60, use_cpp: bool = True):
+        self.min_correlation = min_correlation
+        self.max_candidates = max_candidates
+        self.adf_lags = adf_lags
+        self.min_overlap = min_overlap
+        self.use_cpp = use_cpp and CPP_AVAILABLE
+
+    def screen(self, prices: pd.DataFrame, max_pvalue: Optional[float] = None) -> pd.DataFrame:
+        """
+        Args:
+            prices: close prices, one column per ticker, aligned on dates (NaN for gaps)
+            max_pvalue: optionally keep only pairs below this cointegration p-value
+
+        Returns:
+            One row per candidate pair, most significant first
+        """
+        tickers = list(prices.columns)
+        values = np.ascontiguousarray(prices.to_numpy(dtype=np.float64))
+        logger.info(f"Screening {len(tickers) * (len(tickers) - 1) // 2} pairs over {len(values)} dates")
+
+        if self.use_cpp:
+            res = cpp.screen_pairs(values, self.min_correlation, self.max_candidates,
+                                   self.adf_lags, self.min_overlap)
+            result = pd.DataFrame({col: getattr(res, col) for col in RESULT_COLUMNS})
+        else:
+            result = self._screen_python(values)
+
+        result['first'] = [tickers[i] for i in result['first']]
+        result['second'] = [tickers[i] for i in result['second']]
+        if max_pvalue is not None:
+            result = result[result['p_value'] < max_pvalue]
+        return result.reset_index(drop=True)
+
+    def _screen_python(self, values: np.ndarray) -> pd.DataFrame:
+        from statsmodels.tsa.stattools import adfuller
+        from statsmodels.tsa.adfvalues import mackinnonp
+
+        with np.errstate(divide='ignore', invalid='ignore'):
+            log_prices = np.log(np.where(values > 0, values, np.nan))
+        returns = np.diff(log_prices, axis=0)
+        returns = returns - np.nanmean(returns, axis=0)
+        returns = np.nan_to_num(returns)
+        norms = np.linalg.norm(returns, axis=0)
+        z = np.divide(returns, norms, out=np.zeros_like(returns), where=norms > 0)
+        corr = z.T @ z
+
+        first, second = np.triu_indices(corr.shape[0], k=1)
+        strength = corr[first, second]
+        keep = np.flatnonzero(strength >= self.min_correlation)
+        keep = keep[np.argsort(-strength[keep], kind='stable')][:self.max_candidates]
+
+        rows = []
+        for a, b in zip(first[keep], second[keep]):
+            y, x = log_prices[:, a], log_prices[:, b]
+            mask = ~(np.isnan(y) | np.isnan(x))
+            y, x = y[mask], x[mask]
+            if np.sum(np.diff(x) ** 2) > np.sum(np.diff(y) ** 2):
+                a, b, y, x = b, a, x, y
+            row = dict(first=a, second=b, correlation=corr[a, b], hedge_ratio=np.nan,
+                       intercept=np.nan, adf_stat=np.nan, p_value=1.0, half_life=np.nan,
+                       n_obs=len(y))
+            if len(y) >= max(self.min_overlap, 2 * self.adf_lags + 4) and np.var(x) > 0:
+                slope, intercept = np.polyfit(x, y, 1)
+                spread = y - intercept - slope * x
+                stat, _, _, store = adfuller(spread, maxlag=self.adf_lags, autolag=None,
+                                             regression='n', regresults=True)
+                gamma = store.resols.params[0]
+                row.update(hedge_ratio=slope, intercept=intercept, adf_stat=stat,
+                           p_value=mackinnonp(stat, regression='c', N=2),
+                           half_life=-np.log(2) / np.log1p(gamma) if -1 < gamma < 0 else np.nan)
+            rows.append(row)
+
+        result = pd.DataFrame(rows, columns=RESULT_COLUMNS)
+        return result.sort_values('p_value', kind='stable')
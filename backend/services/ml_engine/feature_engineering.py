@@ -10,12 +10,12 @@ import logging
 
 # Import technical indicators
 try:
-    from services.technical_indicators.cpp_wrapper import TechnicalIndicators
+    from services.technical_indicators.cpp_wrapper import TechnicalIndicators, RegimeDetector, ChangePointDetector, WaveletDecomposer, TimeframeResampler, ReturnsCalculator, CandlestickPatterns, CalendarFeatures
 except ImportError:
     import sys
     import os
     sys.path.insert(0, os.path.join(os.path.dirname(__file__), '../..'))
-    from services.technical_indicators.cpp_wrapper import TechnicalIndicators
+    from services.technical_indicators.cpp_wrapper import TechnicalIndicators, RegimeDetector, ChangePointDetector, WaveletDecomposer, TimeframeResampler, ReturnsCalculator, CandlestickPatterns, CalendarFeatures
 
 logger = logging.getLogger(__name__)
 
@@ -23,10 +23,21 @@ logger = logging.getLogger(__name__)
 class FeatureEngineer:
     """
     Create ML features from price data, sentiment, and social signals
+    use_cpp selects the backend of every helper, so training and serving build
+    the same columns; technical indicators always use the Python path
     """
 
-    def __init__(self):
+    def __init__(self, use_cpp: bool = True):
         self.indicators = TechnicalIndicators(use_cpp=False)  # Use Python fallback for training
+        self.regimes = RegimeDetector(n_states=4, use_cpp=use_cpp)
+        self.change_points = ChangePointDetector(use_cpp=use_cpp)
+        self.wavelets = WaveletDecomposer(levels=4, energy_window=20, use_cpp=use_cpp)
+        self.weekly = TimeframeResampler('W', use_cpp=use_cpp)
+        self.monthly = TimeframeResampler('M', use_cpp=use_cpp)
+        self.candles = CandlestickPatterns(use_cpp=use_cpp)
+        self.calendar = CalendarFeatures(use_cpp=use_cpp)
+        self.returns = ReturnsCalculator(horizons=(5, 10, 20), forward_horizons=(1, 3, 5),
+                                         log=False, roc=True, use_cpp=use_cpp)
 
     def create_features(
         self,
@@ -52,18 +63,20 @@ class FeatureEngineer:
         logger.info("Calculating technical indicators...")
         df = self.indicators.calculate_all(df)
 
-        # 2. Price Patterns
+        # 2. Price Patterns (shape features and candlestick patterns in one pass)
         logger.info("Creating price pattern features...")
-        df['candle_size'] = (df['high'] - df['low']) / df['close']
-        df['upper_shadow'] = (df['high'] - df[['open', 'close']].max(axis=1)) / df['close']
-        df['lower_shadow'] = (df[['open', 'close']].min(axis=1) - df['low']) / df['close']
-        df['body_size'] = abs(df['close'] - df['open']) / df['close']
+        patterns, shapes = self.candles.compute(df)
+        for name, values in shapes.items():
+            df[name] = values
+        # Flat bars (high == low) have no body ratio or close location
+        df['body_ratio'] = df['body_ratio'].fillna(0.0)
+        df['close_location'] = df['close_location'].fillna(0.5)
 
         # 3. Price Action
-        df['higher_high'] = (df['high'] > df['high'].shift(1)).astype(int)
-        df['lower_low'] = (df['low'] < df['low'].shift(1)).astype(int)
-        df['gap_up'] = ((df['open'] - df['close'].shift(1)) / df['close'].shift(1) > 0.02).astype(int)
-        df['gap_down'] = ((df['open'] - df['close'].shift(1)) / df['close'].shift(1) < -0.02).astype(int)
+        for name in ['higher_high', 'lower_low', 'gap_up', 'gap_down',
+                     'doji', 'hammer', 'shooting_star', 'bullish_engulfing', 'bearish_engulfing',
+                     'morning_star', 'evening_star', 'three_white_soldiers', 'three_black_crows']:
+            df[name] = self.candles.flag(patterns, name)
 
         # 4. Advanced Momentum Features
         df['rsi_slope'] = df['rsi_14'].diff()
@@ -78,17 +91,50 @@ class FeatureEngineer:
         df['macd_strength'] = abs(df['macd'] - df['macd_signal']) / df['close']
 
         # 5. Advanced Volatility Features
-        df['volatility_regime'] = pd.cut(
-            df['volatility_10d'],
-            bins=[0, 0.01, 0.02, 0.05, np.inf],
-            labels=['low', 'medium', 'high', 'extreme']
-        )
-        df = pd.get_dummies(df, columns=['volatility_regime'], prefix='vol')
+        # Fixed volatility buckets, still read by models trained before the regime features
+        volatility_bucket = pd.cut(df['volatility_10d'], bins=[0, 0.01, 0.02, 0.05, np.inf],
+                                   labels=['low', 'medium', 'high', 'extreme'])
+        for label in volatility_bucket.cat.categories:
+            df[f'vol_{label}'] = volatility_bucket == label
+
+        # Regime probabilities from a Gaussian HMM (state 0 = calmest regime)
+        regime_probs = self.regimes.probabilities(df)
+        for k, col in enumerate(self.regimes.column_names()):
+            df[col] = regime_probs[:, k]
+        df[self.regimes.state_column()] = regime_probs.argmax(axis=1)
 
         # Volatility expansion/contraction
         df['volatility_trend'] = df['volatility_10d'].diff()
         df['volatility_ratio'] = df['volatility_10d'] / df['volatility_10d'].rolling(20).mean()
 
+        # Structural breaks: CUSUM events scaled by recent volatility and
+        # Bayesian online change-point probability on daily returns
+        returns = df['close'].pct_change().to_numpy()
+        df['cusum_event'] = self.change_points.cusum_events(returns, df['volatility_10d'].to_numpy() * 2)
+        df['changepoint_prob'], df['changepoint_run_length'] = self.change_points.change_probabilities(returns)
+
+        # Multi-resolution view (causal wavelets): distance from the denoised
+        # close and the share of recent return energy at each scale
+        _, close_smooth, _ = self.wavelets.decompose(df['close'].to_numpy())
+        df['wavelet_dev_2'] = df['close'] / close_smooth[1] - 1
+        df['wavelet_dev_4'] = df['close'] / close_smooth[3] - 1
+        _, _, return_energy = self.wavelets.decompose(returns)
+        total_energy = return_energy.sum(axis=0)
+        for j in range(return_energy.shape[0]):
+            df[f'wavelet_energy_{j + 1}'] = np.divide(return_energy[j], total_energy,
+                                                      out=np.full_like(total_energy, np.nan),
+                                                      where=total_energy > 0)
+
+        # Higher-timeframe context, joined through the last completed
+        # week / month so the bar in progress never leaks into the features
+        weekly, last_week = self.weekly.resample(df)
+        weekly_rsi = self.indicators._calculate_rsi_python(weekly['close']).to_numpy()
+        df['rsi_14_weekly'] = np.where(last_week >= 0, weekly_rsi[np.maximum(last_week, 0)], np.nan)
+        monthly, last_month = self.monthly.resample(df)
+        monthly_momentum = monthly['close'].pct_change(3).to_numpy()
+        df['momentum_3m_monthly'] = np.where(last_month >= 0,
+                                             monthly_momentum[np.maximum(last_month, 0)], np.nan)
+
         # Bollinger Band squeeze
         df['bb_width'] = (df['bb_upper'] - df['bb_lower']) / df['bb_middle']
         df['bb_position'] = (df['close'] - df['bb_lower']) / (df['bb_upper'] - df['bb_lower'])
@@ -147,14 +193,13 @@ class FeatureEngineer:
         df['price_above_sma50'] = (df['close'] > df['sma_50']).astype(int)
         df['sma20_above_sma50'] = (df['sma_20'] > df['sma_50']).astype(int)
 
-        # Momentum indicators
-        df['momentum_5'] = df['close'] / df['close'].shift(5) - 1
-        df['momentum_10'] = df['close'] / df['close'].shift(10) - 1
-        df['momentum_20'] = df['close'] / df['close'].shift(20) - 1
-
-        # Rate of change
-        df['roc_5'] = (df['close'] - df['close'].shift(5)) / df['close'].shift(5) * 100
-        df['roc_10'] = (df['close'] - df['close'].shift(10)) / df['close'].shift(10) * 100
+        # Momentum, rate of change and forward returns (for the targets) in one pass
+        horizon_returns = self.returns.compute(df['close'].to_numpy())
+        df['momentum_5'] = horizon_returns['simple_5']
+        df['momentum_10'] = horizon_returns['simple_10']
+        df['momentum_20'] = horizon_returns['simple_20']
+        df['roc_5'] = horizon_returns['roc_5']
+        df['roc_10'] = horizon_returns['roc_10']
 
         # Volume momentum (if volume exists)
         if 'volume_ratio' in df.columns:
@@ -184,19 +229,21 @@ class FeatureEngineer:
 
         # 10. Time Features
         logger.info("Creating time features...")
-        df['day_of_week'] = pd.to_datetime(df['date']).dt.dayofweek
-        df['month'] = pd.to_datetime(df['date']).dt.month
-        df['quarter'] = pd.to_datetime(df['date']).dt.quarter
-        df['is_month_start'] = pd.to_datetime(df['date']).dt.is_month_start.astype(int)
-        df['is_month_end'] = pd.to_datetime(df['date']).dt.is_month_end.astype(int)
+        cal = self.calendar.compute(df['date'])
+        for name in ('day_of_week', 'month', 'quarter', 'is_month_start', 'is_month_end',
+                     'first_trading_day_of_month', 'last_trading_day_of_month',
+                     'trading_days_to_month_end', 'is_pre_holiday', 'is_post_holiday'):
+            df[name] = cal[name].astype(int)
+        # No holiday in reach only happens at the edges of a custom list
+        df['days_to_holiday'] = np.nan_to_num(cal['days_to_holiday'], nan=30.0).clip(max=30)
 
         # 11. Target Variable (5-day direction for better predictability)
         # 5-day horizon is more predictable than next-day
-        df['target'] = (df['close'].shift(-5) > df['close']).astype(int)
+        df['target'] = (horizon_returns['forward_5'] > 0).astype(int)
 
         # Also create intermediate targets for feature engineering
-        df['target_1d'] = (df['close'].shift(-1) > df['close']).astype(int)
-        df['target_3d'] = (df['close'].shift(-3) > df['close']).astype(int)
+        df['target_1d'] = (horizon_returns['forward_1'] > 0).astype(int)
+        df['target_3d'] = (horizon_returns['forward_3'] > 0).astype(int)
 
         # 12. Drop rows with NaN and infinite values
         initial_len = len(df)
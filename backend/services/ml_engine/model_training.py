@@ -12,8 +12,10 @@ from sklearn.feature_selection import SelectKBest, f_classif, mutual_info_classi
 from sklearn.preprocessing import StandardScaler
 from typing import Dict, Tuple, List
 import joblib
+import json
 import logging
 import os
+import struct
 
 logger = logging.getLogger(__name__)
 
@@ -171,6 +173,7 @@ class XGBoostPredictor:
             self._load_model()
 
         # Ensure features match training (selected features only)
+        self.check_features(X.columns)
         X = X[self.feature_names]
 
         # Scale features
@@ -191,6 +194,15 @@ class XGBoostPredictor:
             'confidence': float(max(probabilities))
         }
 
+    def check_features(self, columns):
+        """Raise if the feature pipeline no longer builds a column the model was trained on"""
+        available = set(columns)
+        missing = [name for name in self.feature_names if name not in available]
+        if missing:
+            shown = ', '.join(missing[:5]) + (', ...' if len(missing) > 5 else '')
+            raise ValueError(f"Model at {self.model_path} was trained on features this pipeline "
+                             f"does not build ({shown}); retrain required")
+
     def get_feature_importance(self) -> pd.DataFrame:
         """Get feature importance scores"""
 
@@ -214,6 +226,61 @@ class XGBoostPredictor:
         }, self.model_path)
         logger.info(f"💾 Model saved to {self.model_path}")
 
+        # Native copy for the C++ scoring server; the pickle stays authoritative
+        try:
+            self.export_native(os.path.splitext(self.model_path)[0] + '.astree')
+        except Exception as e:
+            logger.warning(f"Native model export failed: {e}")
+
+    def export_native(self, path: str):
+        """
+        Export the booster and scaler in the C++ tree-ensemble format (.astree)
+        - Rows are scored on raw feature values in self.feature_names order
+        - Standardisation, splits, default directions and base score are preserved
+        - Read by alphasignal_server --model
+        - Column names go to a "<path>.features" sidecar (used by alphasignal_cli)
+        """
+        if self.model is None:
+            raise ValueError("Model not trained")
+
+        booster = self.model.get_booster()
+        trees = booster.trees_to_dataframe()
+        feature_index = {name: i for i, name in enumerate(self.feature_names)}
+        feature_index.update({f"f{i}": i for i in range(len(self.feature_names))})
+
+        # Nodes are renumbered in (tree, node) order, which keeps children after parents
+        trees = trees.sort_values(['Tree', 'Node']).reset_index(drop=True)
+        node_of = {node_id: i for i, node_id in enumerate(trees['ID'])}
+        is_leaf = (trees['Feature'] == 'Leaf').to_numpy()
+
+        feature = np.array([-1 if leaf else feature_index[f]
+                            for f, leaf in zip(trees['Feature'], is_leaf)], dtype='<i4')
+        value = np.where(is_leaf, trees['Gain'], trees['Split']).astype('<f4')
+        left = np.array([-1 if leaf else node_of[y] for y, leaf in zip(trees['Yes'], is_leaf)], dtype='<i4')
+        right = np.array([-1 if leaf else node_of[n] for n, leaf in zip(trees['No'], is_leaf)], dtype='<i4')
+        default_left = np.array([0 if leaf else int(m == y)
+                                 for m, y, leaf in zip(trees['Missing'], trees['Yes'], is_leaf)], dtype='u1')
+        roots = trees.groupby('Tree').head(1).index.to_numpy().astype('<i4')
+
+        config = json.loads(booster.save_config())
+        base_score = float(str(config['learner']['learner_model_param']['base_score']).strip('[]'))
+        base_margin = float(np.log(base_score / (1.0 - base_score)))
+
+        n_features = len(self.feature_names)
+        mean = np.asarray(getattr(self.scaler, 'mean_', np.zeros(n_features)), dtype='<f8')
+        scale = np.asarray(getattr(self.scaler, 'scale_', np.ones(n_features)), dtype='<f8')
+
+        os.makedirs(os.path.dirname(path) or '.', exist_ok=True)
+        with open(path, 'wb') as f:
+            f.write(b'ASTE')
+            f.write(struct.pack('<IIII', 1, n_features, len(roots), len(trees)))
+            f.write(struct.pack('<d', base_margin))
+            for arr in (mean, scale, roots, feature, value, left, right, default_left):
+                f.write(arr.tobytes())
+        with open(path + '.features', 'w') as f:
+            f.write(''.join(f"{name}\n" for name in self.feature_names))
+        logger.info(f"💾 Native model exported to {path} ({len(roots)} trees, {len(trees)} nodes)")
+
     def _load_model(self):
         """Load saved model"""
         if not os.path.exists(self.model_path):
@@ -0,0 +1,136 @@
+"""
+Prediction Outcome Resolver
+Fills Predictions.actual_direction / correct in bulk from stored closes:
+every open prediction is merged against its ticker's price series in one
+pass and the updates are written back in a single transaction
+"""
+
+import os
+from datetime import date
+from typing import Dict, Optional
+import numpy as np
+import pandas as pd
+import logging
+from sqlalchemy import func, select, update
+from sqlalchemy.orm import aliased
+
+try:
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+    from services.ml_engine.prediction_log import get_prediction_log
+    from models import Predictions, AlphaMarketData
+except ImportError:
+    import sys
+    sys.path.insert(0, os.path.join(os.path.dirname(__file__), '../..'))
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+    from services.ml_engine.prediction_log import get_prediction_log
+    from models import Predictions, AlphaMarketData
+
+logger = logging.getLogger(__name__)
+
+_EPOCH = np.datetime64('1970-01-01', 'D')
+
+
+def _epoch_days(values: pd.Series) -> np.ndarray:
+    return (pd.to_datetime(values).to_numpy().astype('datetime64[D]') - _EPOCH).astype(np.int32)
+
+
+class OutcomeResolver:
+    """
+    Resolve open predictions against AlphaMarketData closes
+    - actual_direction: 'UP' if the close as of target_date is above the close
+      as of prediction_date, else 'DOWN' (same rule as the training label)
+    - "as of" = last close on or before the day, so weekend target dates work
+    - A prediction resolves once its ticker has a bar on or after target_date
+    - correct: predicted_direction == actual_direction (NULL without a prediction)
+    Falls back to pandas merge_asof if C++ not available
+    """
+
+    def __init__(self, use_cpp: bool = True):
+        self.use_cpp = use_cpp and CPP_AVAILABLE
+
+    def resolve(self, db, as_of: Optional[date] = None) -> Dict[str, int]:
+        """Resolve every open prediction whose target_date is on or before as_of (today)"""
+        as_of = as_of or date.today()
+        open_query = db.query(Predictions.id, Predictions.ticker, Predictions.prediction_date,
+                              Predictions.target_date, Predictions.predicted_direction)\
+            .filter(Predictions.actual_direction.is_(None), Predictions.target_date <= as_of)
+        preds = pd.read_sql(open_query.statement, db.bind)
+        if preds.empty:
+            return {'open': 0, 'resolved': 0}
+
+        tickers = preds['ticker'].unique().tolist()
+        first_day = pd.to_datetime(preds['prediction_date']).min().date()
+        # Each ticker's bars from its last one on or before first_day, however
+        # long ago that was, so every prediction has its as-of base close
+        earlier = aliased(AlphaMarketData)
+        base_day = select(func.max(earlier.date))\
+            .where(earlier.ticker == AlphaMarketData.ticker, earlier.date <= first_day)\
+            .scalar_subquery()
+        price_query = db.query(AlphaMarketData.ticker, AlphaMarketData.date, AlphaMarketData.close)\
+            .filter(AlphaMarketData.ticker.in_(tickers),
+                    AlphaMarketData.date >= func.coalesce(base_day, first_day))\
+            .order_by(AlphaMarketData.ticker, AlphaMarketData.date)
+        prices = pd.read_sql(price_query.statement, db.bind)
+
+        actual, correct = self._compute(preds, prices)
+        done = actual >= 0
+        updates = [
+            {'id': int(i), 'actual_direction': 'UP' if a else 'DOWN',
+             'correct': None if c < 0 else bool(c)}
+            for i, a, c in zip(preds['id'].to_numpy()[done], actual[done], correct[done])
+        ]
+        if updates:
+            try:
+                db.execute(update(Predictions), updates)
+                db.commit()
+            except Exception:
+                db.rollback()
+                raise
+
+            scored = [(u['id'], u['correct']) for u in updates if u['correct'] is not None]
+            get_prediction_log().resolve([i for i, _ in scored], [c for _, c in scored])
+
+        logger.info(f"Resolved {len(updates)} of {len(preds)} open predictions")
+        return {'open': len(preds), 'resolved': len(updates)}
+
+    def _compute(self, preds: pd.DataFrame, prices: pd.DataFrame):
+        """(actual, correct) int8 arrays, -1 where unresolved"""
+        predicted = preds['predicted_direction'].map({'UP': 1, 'DOWN': 0})\
+            .fillna(-1).to_numpy(dtype=np.int8)
+
+        if self.use_cpp:
+            series, price_ticker = np.unique(prices['ticker'].to_numpy(dtype=object),
+                                             return_inverse=True)
+            # Group by code; stable, so dates stay ascending within each ticker
+            order = np.argsort(price_ticker, kind='stable')
+            prices, price_ticker = prices.iloc[order], price_ticker[order]
+            offsets = np.searchsorted(price_ticker, np.arange(len(series) + 1)).astype(np.int64)
+            code = pd.Series(np.arange(len(series), dtype=np.int32), index=series)
+            ticker = preds['ticker'].map(code).fillna(-1).to_numpy(dtype=np.int32)
+            actual, correct, _ = cpp.resolve_outcomes(
+                ticker, _epoch_days(preds['prediction_date']), _epoch_days(preds['target_date']),
+                predicted, offsets, _epoch_days(prices['date']),
+                prices['close'].to_numpy(dtype=np.float64))
+            return actual, correct
+
+        prices = prices.assign(date=pd.to_datetime(prices['date']))
+        # Any bar, even one without a close, counts as data through that day
+        last_bar = prices.groupby('ticker')['date'].max()
+        # merge_asof needs the right frame sorted on the key globally, not per ticker
+        prices = prices.dropna(subset=['close']).sort_values('date', kind='stable')
+        rows = preds.assign(prediction_date=pd.to_datetime(preds['prediction_date']),
+                            target_date=pd.to_datetime(preds['target_date']),
+                            row=np.arange(len(preds)))
+        base = pd.merge_asof(rows.sort_values('prediction_date'),
+                             prices.rename(columns={'date': 'prediction_date', 'close': 'base'}),
+                             on='prediction_date', by='ticker')
+        outcome = pd.merge_asof(base.sort_values('target_date'),
+                                prices.rename(columns={'date': 'target_date', 'close': 'outcome'}),
+                                on='target_date', by='ticker').set_index('row').sort_index()
+        ready = (outcome['target_date'] <= outcome['ticker'].map(last_bar)).to_numpy() \
+            & outcome['base'].notna().to_numpy() & outcome['outcome'].notna().to_numpy()
+
+        up = (outcome['outcome'] > outcome['base']).to_numpy()
+        actual = np.where(ready, up, -1).astype(np.int8)
+        correct = np.where(ready & (predicted >= 0), predicted == up, -1).astype(np.int8)
+        return actual, correct
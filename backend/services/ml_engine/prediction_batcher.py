@@ -0,0 +1,240 @@
+"""
+Prediction Scoring Coalescer
+Concurrent /predict requests are queued for up to max_delay_ms (or until
+max_batch rows are waiting) and scored with one batched tree-ensemble call;
+each caller awaits its own future
+"""
+
+import asyncio
+import os
+import threading
+import numpy as np
+import pandas as pd
+from typing import Dict, Optional
+import logging
+
+try:
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+    from services.ml_engine.model_training import XGBoostPredictor
+except ImportError:
+    import sys
+    sys.path.insert(0, os.path.join(os.path.dirname(__file__), '../..'))
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+    from services.ml_engine.model_training import XGBoostPredictor
+
+logger = logging.getLogger(__name__)
+
+
+class PredictionCoalescer:
+    """
+    Micro-batched scoring for a trained XGBoostPredictor
+    - predict(features): awaitable; same result dict as XGBoostPredictor.predict
+    - Rows arriving within max_delay_ms share one model call of up to max_batch rows
+    - stats(): rows, batches, largest_batch, queued
+    - retire(successor): after a reload, requests already inside predict()
+      finish here and the batcher closes once they have; later ones go to
+      the successor
+    The native path scores the exported .astree ensemble on a dispatcher thread.
+    Falls back to an asyncio batcher over predict_proba if C++ not available
+    """
+
+    def __init__(self, model_path: str = 'models/xgboost_model.pkl', max_batch: int = 64,
+                 max_delay_ms: float = 2.0, use_cpp: bool = True):
+        self.predictor = XGBoostPredictor(model_path=model_path)
+        self.predictor._load_model()
+        self.feature_names = list(self.predictor.feature_names)
+        self.max_batch = max_batch
+        self.max_delay_ms = max_delay_ms
+        self._state_lock = threading.Lock()
+        self._inflight = 0
+        self._retired = False
+        self._closed = False
+        self._successor: Optional['PredictionCoalescer'] = None
+
+        self._native = None
+        if use_cpp and CPP_AVAILABLE:
+            try:
+                self._native = cpp.ScoreBatcher(self._native_model_path(), max_batch,
+                                                int(max_delay_ms * 1000))
+            except Exception as e:
+                logger.warning(f"Native scoring unavailable, using Python batcher: {e}")
+        self.use_cpp = self._native is not None
+        if not self.use_cpp:
+            self._fallback = _PythonScoreBatcher(self.predictor, self.feature_names,
+                                                 max_batch, max_delay_ms)
+
+    def _native_model_path(self) -> str:
+        """Exported ensemble next to the pickle, re-exported if older than it"""
+        pickle_path = self.predictor.model_path
+        path = os.path.splitext(pickle_path)[0] + '.astree'
+        if not os.path.exists(path) or os.path.getmtime(path) < os.path.getmtime(pickle_path):
+            self.predictor.export_native(path)
+        return path
+
+    async def predict(self, features: pd.DataFrame) -> Dict[str, any]:
+        """Score the last row of features (raw, unscaled values)"""
+        if not self._enter():
+            # Retired by a reload and already drained since the caller looked it up
+            return await self._successor.predict(features)
+        try:
+            self.predictor.check_features(features.columns)
+            row = np.ascontiguousarray(
+                features[self.feature_names].iloc[-1].to_numpy(dtype=np.float64))
+
+            if self.use_cpp:
+                loop = asyncio.get_running_loop()
+                future = loop.create_future()
+
+                def done(probability, error):
+                    # Runs on the dispatcher thread
+                    loop.call_soon_threadsafe(_resolve, future, probability, error)
+
+                self._native.submit(row, done)
+                probability_up = await future
+            else:
+                probability_up = await self._fallback.score(row)
+        finally:
+            self._exit()
+
+        return _prediction_result(probability_up)
+
+    def stats(self) -> Dict[str, int]:
+        if self.use_cpp:
+            return self._native.stats()
+        return self._fallback.stats()
+
+    def retire(self, successor: 'PredictionCoalescer'):
+        """Route new requests to successor; close once in-flight ones finish"""
+        with self._state_lock:
+            self._successor = successor
+            self._retired = True
+            drained = self._inflight == 0 and not self._closed
+            self._closed = self._closed or drained
+        if drained:
+            self._close_native()
+
+    def close(self):
+        with self._state_lock:
+            was_closed, self._closed = self._closed, True
+        if not was_closed:
+            self._close_native()
+
+    def _enter(self) -> bool:
+        with self._state_lock:
+            if self._closed:
+                return False
+            self._inflight += 1
+            return True
+
+    def _exit(self):
+        with self._state_lock:
+            self._inflight -= 1
+            drained = self._retired and self._inflight == 0 and not self._closed
+            self._closed = self._closed or drained
+        if drained:
+            self._close_native()
+
+    def _close_native(self):
+        if self.use_cpp:
+            self._native.close()
+
+
+def _resolve(future: asyncio.Future, probability: Optional[float], error: Optional[str]):
+    if future.done():  # caller went away
+        return
+    if error is not None:
+        future.set_exception(RuntimeError(error))
+    else:
+        future.set_result(float(probability))
+
+
+def _prediction_result(probability_up: float) -> Dict[str, any]:
+    # XGBClassifier.predict thresholds the positive-class probability at 0.5
+    return {
+        'prediction': 'UP' if probability_up > 0.5 else 'DOWN',
+        'probability_up': probability_up,
+        'probability_down': 1.0 - probability_up,
+        'confidence': max(probability_up, 1.0 - probability_up)
+    }
+
+
+class _PythonScoreBatcher:
+    """Same coalescing on the event loop; one predict_proba call per batch"""
+
+    def __init__(self, predictor: XGBoostPredictor, feature_names, max_batch: int,
+                 max_delay_ms: float):
+        self.predictor = predictor
+        self.feature_names = feature_names
+        self.max_batch = max_batch
+        self.max_delay = max_delay_ms / 1000.0
+        self._pending = []
+        self._timer = None
+        self._rows = 0
+        self._batches = 0
+        self._largest = 0
+
+    async def score(self, row: np.ndarray) -> float:
+        loop = asyncio.get_running_loop()
+        future = loop.create_future()
+        self._pending.append((row, future))
+        if len(self._pending) >= self.max_batch:
+            self._flush()
+        elif self._timer is None:
+            self._timer = loop.call_later(self.max_delay, self._flush)
+        return await future
+
+    def _flush(self):
+        if self._timer is not None:
+            self._timer.cancel()
+            self._timer = None
+        batch, self._pending = self._pending, []
+        if not batch:
+            return
+        self._rows += len(batch)
+        self._batches += 1
+        self._largest = max(self._largest, len(batch))
+
+        try:
+            X = pd.DataFrame(np.vstack([row for row, _ in batch]), columns=self.feature_names)
+            X_scaled = pd.DataFrame(self.predictor.scaler.transform(X), columns=self.feature_names)
+            probabilities = self.predictor.model.predict_proba(X_scaled)[:, 1]
+        except Exception as e:
+            for _, future in batch:
+                if not future.done():
+                    future.set_exception(e)
+            return
+
+        for (_, future), p in zip(batch, probabilities):
+            if not future.done():
+                future.set_result(float(p))
+
+    def stats(self) -> Dict[str, int]:
+        return {'rows': self._rows, 'batches': self._batches,
+                'largest_batch': self._largest, 'queued': len(self._pending)}
+
+
+_coalescers: Dict[str, tuple] = {}
+_coalescers_lock = threading.Lock()
+
+
+def get_prediction_coalescer(model_path: str = 'models/xgboost_model.pkl',
+                             **kwargs) -> PredictionCoalescer:
+    """
+    Process-wide coalescer per model file, rebuilt when the pickle is retrained;
+    the replaced one drains its in-flight requests before closing
+    Loads (and on first use exports) the model: call it off the event loop
+    Raises FileNotFoundError if the model has not been trained
+    """
+    if not os.path.exists(model_path):
+        raise FileNotFoundError(f"Model not found at {model_path}")
+    mtime = os.path.getmtime(model_path)
+    with _coalescers_lock:
+        cached = _coalescers.get(model_path)
+        if cached is not None and cached[0] == mtime:
+            return cached[1]
+        coalescer = PredictionCoalescer(model_path, **kwargs)
+        _coalescers[model_path] = (mtime, coalescer)
+    if cached is not None:
+        cached[1].retire(coalescer)
+        logger.info(f"Reloaded scoring model from {model_path}")
+    return coalescer
@@ -0,0 +1,283 @@
+"""
+Prediction Accuracy Log
+Append-only columnar mirror of the Predictions table for dashboard accuracy
+queries; sync() pulls only rows added or resolved since the last call
+"""
+
+import os
+import threading
+from datetime import date
+from typing import Dict, List, Optional
+import numpy as np
+import pandas as pd
+import logging
+from sqlalchemy import or_
+
+try:
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+    from models import Predictions
+except ImportError:
+    import sys
+    sys.path.insert(0, os.path.join(os.path.dirname(__file__), '../..'))
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+    from models import Predictions
+
+logger = logging.getLogger(__name__)
+
+_EPOCH = date(1970, 1, 1)
+_BUCKETS = ('low', 'medium', 'high')
+# Ids below last_id re-checked on every sync; autoincrement ids are handed
+# out before commit, so a slow transaction can land below rows already seen
+_RESCAN_IDS = 1000
+# Open prediction ids per outcome query
+_OPEN_CHUNK = 1000
+
+
+def _epoch_day(d: Optional[date]) -> Optional[int]:
+    return None if d is None else (d - _EPOCH).days
+
+
+class PredictionAccuracyLog:
+    """
+    Accuracy aggregates over every stored prediction
+    - sync(db): append Predictions rows not yet mirrored (id > last_id, plus
+      late commits among the last _RESCAN_IDS ids) and record outcomes of the
+      open predictions, looked up by id
+    - A failed journal write reopens the log from its journal and retries;
+      rows missing from the journal are pulled from the DB again
+    - accuracy(): predictions, total, correct and low/medium/high {count, correct}
+      filtered by ticker, model_version and prediction_date range
+    - accuracy_by(group): the same per 'ticker', 'model_version' or 'bucket'
+    - rolling_accuracy(window_days): trailing accuracy at each prediction day
+    Buckets follow the accuracy endpoint: low < 0.6 <= medium <= 0.7 < high.
+    The native log journals to path and replays it on restart.
+    Falls back to pandas over the same columns if C++ not available
+    """
+
+    def __init__(self, path: str = '', use_cpp: bool = True):
+        self._lock = threading.Lock()
+        self._path = path
+        self._native = None
+        if use_cpp and CPP_AVAILABLE:
+            self._native = self._open_native()
+        self.use_cpp = self._native is not None
+        if not self.use_cpp:
+            self._frame = pd.DataFrame({
+                'ticker': pd.Series(dtype=object), 'model_version': pd.Series(dtype=object),
+                'day': pd.Series(dtype=np.int32), 'confidence': pd.Series(dtype=np.float64),
+                'outcome': pd.Series(dtype=np.float64),
+            }, index=pd.Index([], dtype=np.int64, name='id'))
+
+    def _open_native(self):
+        try:
+            return cpp.PredictionLog(self._path)
+        except Exception as e:
+            logger.warning(f"Prediction log journal unusable ({e}), rebuilding in memory")
+            return cpp.PredictionLog('')
+
+    def _reopen(self, error: Exception):
+        logger.error(f"Prediction log journal write failed ({error}), reopening")
+        self._native = self._open_native()
+
+    @property
+    def last_id(self) -> int:
+        if self.use_cpp:
+            return self._native.last_id
+        return int(self._frame.index.max()) if len(self._frame) else 0
+
+    @property
+    def min_unresolved_id(self) -> int:
+        if self.use_cpp:
+            return self._native.min_unresolved_id
+        open_rows = self._frame.index[self._frame['outcome'].isna()]
+        return int(open_rows.min()) if len(open_rows) else 0
+
+    def __len__(self) -> int:
+        return len(self._native) if self.use_cpp else len(self._frame)
+
+    def __contains__(self, prediction_id: int) -> bool:
+        if self.use_cpp:
+            return prediction_id in self._native
+        return prediction_id in self._frame.index
+
+    def sync(self, db) -> Dict[str, int]:
+        """Mirror rows added and outcomes resolved since the last sync"""
+        with self._lock:
+            try:
+                return self._sync(db)
+            except RuntimeError as e:
+                if not self.use_cpp:
+                    raise
+                self._reopen(e)
+                return self._sync(db)
+
+    def _sync(self, db) -> Dict[str, int]:
+        last_id = self.last_id
+        late = [r[0] for r in db.query(Predictions.id)
+                .filter(Predictions.id > max(last_id - _RESCAN_IDS, 0),
+                        Predictions.id <= last_id)
+                .all() if r[0] not in self]
+        query = db.query(Predictions.id, Predictions.ticker, Predictions.model_version,
+                         Predictions.prediction_date, Predictions.confidence,
+                         Predictions.correct)
+        wanted = Predictions.id > last_id
+        if late:
+            wanted = or_(wanted, Predictions.id.in_(late))
+        rows = query.filter(wanted).order_by(Predictions.id).all()
+        added = self._append(rows)
+
+        # Only open rows can change, so they are looked up by primary key
+        # rather than by scanning every id after the oldest open one
+        resolved = 0
+        open_ids = self._unresolved_ids()
+        for start in range(0, len(open_ids), _OPEN_CHUNK):
+            outcomes = db.query(Predictions.id, Predictions.correct)\
+                .filter(Predictions.id.in_(open_ids[start:start + _OPEN_CHUNK]),
+                        Predictions.correct.isnot(None))\
+                .all()
+            resolved += self._resolve([r[0] for r in outcomes], [r[1] for r in outcomes])
+        return {'added': added, 'resolved': resolved}
+
+    def resolve(self, ids, correct) -> int:
+        """Record outcomes written to the DB outside sync(); unknown ids are left to sync()"""
+        with self._lock:
+            try:
+                return self._resolve(list(ids), list(correct))
+            except RuntimeError as e:
+                if not self.use_cpp:
+                    raise
+                self._reopen(e)  # the next sync() picks the outcomes up from the DB
+                return 0
+
+    def _unresolved_ids(self) -> List[int]:
+        if self.use_cpp:
+            return self._native.unresolved_ids().tolist()
+        return self._frame.index[self._frame['outcome'].isna()].tolist()
+
+    def _append(self, rows) -> int:
+        if not rows:
+            return 0
+        ids = np.fromiter((r.id for r in rows), dtype=np.int64, count=len(rows))
+        tickers = [r.ticker for r in rows]
+        versions = [r.model_version or '' for r in rows]
+        days = np.fromiter((_epoch_day(r.prediction_date) for r in rows), dtype=np.int64,
+                           count=len(rows))
+        confidence = np.fromiter((np.nan if r.confidence is None else r.confidence for r in rows),
+                                 dtype=np.float64, count=len(rows))
+        resolved = [(r.id, r.correct) for r in rows if r.correct is not None]
+
+        if self.use_cpp:
+            added = self._native.append(ids, tickers, versions, days, confidence)
+        else:
+            new = pd.DataFrame({'ticker': tickers, 'model_version': versions,
+                                'day': days.astype(np.int32), 'confidence': confidence,
+                                'outcome': np.nan}, index=pd.Index(ids, name='id'))
+            new = new[~new.index.isin(self._frame.index)]
+            self._frame = pd.concat([self._frame, new])
+            added = len(new)
+        if resolved:
+            self._resolve([i for i, _ in resolved], [c for _, c in resolved])
+        return added
+
+    def _resolve(self, ids: List[int], correct: List[bool]) -> int:
+        if not ids:
+            return 0
+        if self.use_cpp:
+            return self._native.resolve(np.asarray(ids, dtype=np.int64),
+                                        np.asarray(correct, dtype=np.uint8))
+        outcome = pd.Series(np.asarray(correct, dtype=np.float64), index=ids)
+        outcome = outcome[outcome.index.isin(self._frame.index)]
+        changed = self._frame.loc[outcome.index, 'outcome'].ne(outcome)
+        self._frame.loc[outcome.index, 'outcome'] = outcome
+        return int(changed.sum())
+
+    def accuracy(self, ticker: str = '', model_version: str = '',
+                 start: Optional[date] = None, end: Optional[date] = None) -> Dict:
+        if self.use_cpp:
+            return self._native.accuracy(ticker, model_version, _epoch_day(start), _epoch_day(end))
+        return _summarise(self._filtered(ticker, model_version, start, end))
+
+    def accuracy_by(self, group: str, ticker: str = '', model_version: str = '',
+                    start: Optional[date] = None, end: Optional[date] = None) -> List[Dict]:
+        if group not in ('ticker', 'model_version', 'bucket'):
+            raise ValueError("group must be 'ticker', 'model_version' or 'bucket'")
+        if self.use_cpp:
+            return self._native.accuracy_by(group, ticker, model_version,
+                                            _epoch_day(start), _epoch_day(end))
+        frame = self._filtered(ticker, model_version, start, end)
+        if group == 'bucket':
+            buckets = _bucket_of(frame['confidence'])
+            groups = [(name, frame[buckets == b]) for b, name in enumerate(_BUCKETS)]
+            groups = [(name, part) for name, part in groups if len(part)]
+        else:
+            groups = sorted(frame.groupby(group), key=lambda kv: kv[0])
+        return [dict(_summarise(part), key=key) for key, part in groups]
+
+    def rolling_accuracy(self, window_days: int = 30, ticker: str = '', model_version: str = '',
+                         start: Optional[date] = None, end: Optional[date] = None) -> pd.DataFrame:
+        """date, total, correct, accuracy_pct over the window_days days ending at each day"""
+        if window_days < 1:
+            raise ValueError("window_days must be positive")
+        if self.use_cpp:
+            series = self._native.rolling_accuracy(window_days, ticker, model_version,
+                                                   _epoch_day(start), _epoch_day(end))
+            out = pd.DataFrame({'day': series['day'], 'total': series['total'],
+                                'correct': series['correct']})
+        else:
+            frame = self._filtered(ticker, model_version, start, end)
+            frame = frame[frame['outcome'].notna()]
+            daily = frame.groupby('day')['outcome'].agg(['count', 'sum']).sort_index()
+            daily.index = pd.to_datetime(daily.index, unit='D')
+            window = daily.rolling(f'{window_days}D').sum()
+            out = pd.DataFrame({'day': (window.index - pd.Timestamp(0)).days,
+                                'total': window['count'].astype(np.uint64).to_numpy(),
+                                'correct': window['sum'].astype(np.uint64).to_numpy()})
+        out['date'] = pd.to_datetime(out.pop('day'), unit='D').dt.date
+        out['accuracy_pct'] = (out['correct'] / out['total'] * 100).round(2)
+        return out[['date', 'total', 'correct', 'accuracy_pct']]
+
+    def _filtered(self, ticker, model_version, start, end) -> pd.DataFrame:
+        frame = self._frame
+        mask = np.ones(len(frame), dtype=bool)
+        if ticker:
+            mask &= (frame['ticker'] == ticker).to_numpy()
+        if model_version:
+            mask &= (frame['model_version'] == model_version).to_numpy()
+        if start is not None:
+            mask &= (frame['day'] >= _epoch_day(start)).to_numpy()
+        if end is not None:
+            mask &= (frame['day'] <= _epoch_day(end)).to_numpy()
+        return frame[mask]
+
+
+def _bucket_of(confidence: pd.Series) -> np.ndarray:
+    c = confidence.to_numpy()
+    return np.where(c > 0.7, 2, np.where(c >= 0.6, 1, 0))
+
+
+def _summarise(frame: pd.DataFrame) -> Dict:
+    resolved = frame[frame['outcome'].notna()]
+    buckets = _bucket_of(resolved['confidence'])
+    out = {'predictions': len(frame), 'total': len(resolved),
+           'correct': int(resolved['outcome'].sum())}
+    for b, name in enumerate(_BUCKETS):
+        part = resolved['outcome'].to_numpy()[buckets == b]
+        out[name] = {'count': len(part), 'correct': int(part.sum())}
+    return out
+
+
+_log: Optional[PredictionAccuracyLog] = None
+_log_lock = threading.Lock()
+
+
+def get_prediction_log() -> PredictionAccuracyLog:
+    """Process-wide log journaled at settings.PREDICTION_LOG_PATH"""
+    global _log
+    with _log_lock:
+        if _log is None:
+            from config import settings
+            path = settings.PREDICTION_LOG_PATH
+            if path:
+                os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+            _log = PredictionAccuracyLog(path, use_cpp=settings.USE_CPP_INDICATORS)
+        return _log
@@ -0,0 +1,11 @@
+"""
+PE Dashboard Analytics
+Deal and fund performance and public-market equivalents over the
+Deal / CashFlow / Fund tables
+"""
+
+from .fund_performance import FundPerformanceEngine, get_performance_engine, load_cash_flows
+from .pme import PMEEngine, load_benchmarks
+
+__all__ = ['FundPerformanceEngine', 'get_performance_engine', 'load_cash_flows',
+           'PMEEngine', 'load_benchmarks']
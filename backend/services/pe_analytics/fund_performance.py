@@ -0,0 +1,204 @@
+"""
+Fund Performance Engine
+Paid-in, distributions, NAV, TVPI/DPI/RVPI and XIRR for every deal and fund
+in one batched call
+"""
+
+import os
+import threading
+from datetime import date
+from typing import Dict, Optional
+import numpy as np
+import pandas as pd
+import logging
+
+try:
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+    from models import Deal, CashFlow, Fund
+except ImportError:
+    import sys
+    sys.path.insert(0, os.path.join(os.path.dirname(__file__), '../..'))
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+    from models import Deal, CashFlow, Fund
+
+logger = logging.getLogger(__name__)
+
+_EPOCH = np.datetime64('1970-01-01', 'D')
+# CashFlow.flow_type -> native flow kind
+FLOW_KINDS = {'contribution': 0, 'distribution': 1, 'nav': 2}
+METRIC_COLUMNS = ['paid_in', 'distributed', 'nav', 'tvpi', 'dpi', 'rvpi', 'irr']
+
+
+def epoch_days(values) -> np.ndarray:
+    return (pd.to_datetime(values).to_numpy().astype('datetime64[D]') - _EPOCH).astype(np.int32)
+
+
+def residual_nav(nav_latest: float, marks: np.ndarray, as_of_day: int, today_day: int) -> float:
+    """nav_latest is today's NAV: it only values a residual as of today or later;
+    otherwise (or when missing) the last NAV mark on or before as_of does"""
+    if as_of_day >= today_day and not np.isnan(nav_latest):
+        return nav_latest
+    return marks[-1] if len(marks) else 0.0
+
+
+def load_cash_flows(db, fund_ids=None) -> Dict[str, object]:
+    """
+    Deals, funds and cash flows laid out for the native kernels
+    - deals: id, fund_id, nav_latest, fund (index into funds, -1 = none)
+    - funds: id, name
+    - flows: deal_id, date, amount, kind, sorted by deal then date
+    - offsets: rows of deal i are flows[offsets[i]:offsets[i + 1]]
+    """
+    deal_query = db.query(Deal.id, Deal.fund_id, Deal.nav_latest).order_by(Deal.id)
+    if fund_ids is not None:
+        deal_query = deal_query.filter(Deal.fund_id.in_(list(fund_ids)))
+    deals = pd.read_sql(deal_query.statement, db.bind)
+
+    fund_query = db.query(Fund.id, Fund.name).order_by(Fund.id)
+    if fund_ids is not None:
+        fund_query = fund_query.filter(Fund.id.in_(list(fund_ids)))
+    funds = pd.read_sql(fund_query.statement, db.bind)
+
+    flow_query = db.query(CashFlow.deal_id, CashFlow.date, CashFlow.amount, CashFlow.flow_type)\
+        .filter(CashFlow.deal_id.in_(deals['id'].tolist()))\
+        .order_by(CashFlow.deal_id, CashFlow.date, CashFlow.id)
+    flows = pd.read_sql(flow_query.statement, db.bind)
+    # The Enum column stores member names; accept values too
+    flows['kind'] = flows['flow_type'].astype(str).str.lower().str.split('.').str[-1]\
+        .map(FLOW_KINDS)
+    unknown = flows['kind'].isna()
+    if unknown.any():
+        logger.warning(f"Skipping {int(unknown.sum())} cash flows with unknown flow_type")
+        flows = flows[~unknown]
+    flows = flows.assign(kind=flows['kind'].astype(np.int8)).reset_index(drop=True)
+
+    fund_index = pd.Series(np.arange(len(funds), dtype=np.int32), index=funds['id'])
+    deals['fund'] = deals['fund_id'].map(fund_index).fillna(-1).astype(np.int32)
+    offsets = np.searchsorted(flows['deal_id'].to_numpy(),
+                              np.append(deals['id'].to_numpy(), np.iinfo(np.int64).max))
+    offsets[-1] = len(flows)
+    return {'deals': deals, 'funds': funds, 'flows': flows, 'offsets': offsets.astype(np.int64)}
+
+
+class FundPerformanceEngine:
+    """
+    Batched deal and fund performance
+    - Per deal: paid_in (contributions), distributed, nav (nav_latest when
+      as_of is today or later, else the last NAV mark on or before as_of),
+      TVPI/DPI/RVPI and XIRR with the NAV as a final inflow on as_of
+    - Per fund: the same over the pooled flows of its deals
+    - XIRR is a safeguarded Newton solve seeded with each deal's IRR from the
+      previous compute(), so refreshes converge in a couple of steps
+    Falls back to scipy brentq per deal if C++ not available
+    """
+
+    def __init__(self, use_cpp: bool = True):
+        self.use_cpp = use_cpp and CPP_AVAILABLE
+        self._seeds: Dict[int, float] = {}
+        self._lock = threading.Lock()
+
+    def compute(self, db, as_of: Optional[date] = None, fund_ids=None) -> Dict[str, pd.DataFrame]:
+        """{'deals': one row per deal, 'funds': one row per fund}"""
+        data = load_cash_flows(db, fund_ids)
+        return self.compute_loaded(data, as_of)
+
+    def compute_loaded(self, data: Dict[str, object],
+                       as_of: Optional[date] = None) -> Dict[str, pd.DataFrame]:
+        deals, funds, flows = data['deals'], data['funds'], data['flows']
+        today_day = int(epoch_days([date.today()])[0])
+        as_of_day = int(epoch_days([as_of])[0]) if as_of else today_day
+        nav_latest = deals['nav_latest'].to_numpy(dtype=np.float64, na_value=np.nan)
+
+        with self._lock:
+            guess = deals['id'].map(self._seeds).to_numpy(dtype=np.float64, na_value=np.nan)
+        if self.use_cpp:
+            res = cpp.fund_performance(
+                data['offsets'], epoch_days(flows['date']),
+                flows['amount'].to_numpy(dtype=np.float64), flows['kind'].to_numpy(dtype=np.int8),
+                nav_latest, deals['fund'].to_numpy(dtype=np.int32), len(funds), as_of_day,
+                today_day, guess)
+            deal_metrics = pd.DataFrame({c: res['deals'][c] for c in METRIC_COLUMNS})
+            fund_metrics = pd.DataFrame({c: res['funds'][c] for c in METRIC_COLUMNS})
+        else:
+            deal_metrics, fund_metrics = self._compute_python(data, nav_latest, as_of_day,
+                                                              today_day)
+
+        with self._lock:
+            solved = deal_metrics['irr'].notna().to_numpy()
+            self._seeds.update(zip(deals['id'].to_numpy()[solved].tolist(),
+                                   deal_metrics['irr'].to_numpy()[solved].tolist()))
+
+        deal_out = pd.concat([deals[['id', 'fund_id']].rename(columns={'id': 'deal_id'}),
+                              deal_metrics], axis=1)
+        fund_out = pd.concat([funds.rename(columns={'id': 'fund_id'}), fund_metrics], axis=1)
+        return {'deals': deal_out, 'funds': fund_out}
+
+    def _compute_python(self, data, nav_latest: np.ndarray, as_of_day: int, today_day: int):
+        deals, funds, flows = data['deals'], data['funds'], data['flows']
+        offsets = data['offsets']
+        days = epoch_days(flows['date'])
+        amounts = np.abs(flows['amount'].to_numpy(dtype=np.float64))
+        kinds = flows['kind'].to_numpy()
+
+        deal_rows, deal_flows = [], []
+        for i in range(len(deals)):
+            s = slice(offsets[i], offsets[i + 1])
+            past = days[s] <= as_of_day
+            d, a, k = days[s][past], amounts[s][past], kinds[s][past]
+            nav = residual_nav(nav_latest[i], a[k == 2], as_of_day, today_day)
+            cash_days = d[k != 2]
+            cash = np.where(k[k != 2] == 0, -a[k != 2], a[k != 2])
+            if nav != 0.0:
+                cash_days, cash = np.append(cash_days, as_of_day), np.append(cash, nav)
+            deal_flows.append((cash_days, cash))
+            deal_rows.append(_metrics(a[k == 0].sum(), a[k == 1].sum(), nav, cash_days, cash))
+
+        fund_rows = []
+        fund_of = deals['fund'].to_numpy()
+        for f in range(len(funds)):
+            members = np.flatnonzero(fund_of == f)
+            pooled_days = np.concatenate([deal_flows[i][0] for i in members]) if len(members) else np.array([])
+            pooled = np.concatenate([deal_flows[i][1] for i in members]) if len(members) else np.array([])
+            fund_rows.append(_metrics(sum(deal_rows[i]['paid_in'] for i in members),
+                                      sum(deal_rows[i]['distributed'] for i in members),
+                                      sum(deal_rows[i]['nav'] for i in members),
+                                      pooled_days, pooled))
+        return (pd.DataFrame(deal_rows, columns=METRIC_COLUMNS),
+                pd.DataFrame(fund_rows, columns=METRIC_COLUMNS))
+
+
+def _metrics(paid_in, distributed, nav, days, cash) -> Dict[str, float]:
+    multiples = {'dpi': distributed / paid_in, 'rvpi': nav / paid_in} if paid_in > 0 \
+        else {'dpi': np.nan, 'rvpi': np.nan}
+    return {'paid_in': float(paid_in), 'distributed': float(distributed), 'nav': float(nav),
+            'tvpi': multiples['dpi'] + multiples['rvpi'], **multiples,
+            'irr': xirr_python(days, cash)}
+
+
+def xirr_python(days: np.ndarray, cash: np.ndarray) -> float:
+    from scipy.optimize import brentq
+
+    if not (cash > 0).any() or not (cash < 0).any():
+        return np.nan
+    t = (days - days.min()) / 365.0
+
+    def npv(x):
+        return float(np.sum(cash * np.exp(-x * t)))
+
+    try:
+        return float(np.expm1(brentq(npv, -10.0, 10.0, xtol=1e-12)))
+    except ValueError:
+        return np.nan
+
+
+_engine: Optional[FundPerformanceEngine] = None
+_engine_lock = threading.Lock()
+
+
+def get_performance_engine() -> FundPerformanceEngine:
+    """Process-wide engine, so IRR seeds carry over between requests"""
+    global _engine
+    with _engine_lock:
+        if _engine is None:
+            _engine = FundPerformanceEngine()
+        return _engine
@@ -0,0 +1,160 @@
+"""
+Public Market Equivalent Engine
+Kaplan-Schoar PME, Long-Nickels PME and Direct Alpha of every deal and fund
+against one or more benchmark indices (MarketData.adj_close)
+"""
+
+import os
+from datetime import date
+from typing import Dict, List, Optional
+import numpy as np
+import pandas as pd
+import logging
+
+try:
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+    from services.pe_analytics.fund_performance import (
+        load_cash_flows, epoch_days, residual_nav, xirr_python)
+    from models import MarketData
+except ImportError:
+    import sys
+    sys.path.insert(0, os.path.join(os.path.dirname(__file__), '../..'))
+    from services.technical_indicators.cpp_wrapper import cpp, CPP_AVAILABLE
+    from services.pe_analytics.fund_performance import (
+        load_cash_flows, epoch_days, residual_nav, xirr_python)
+    from models import MarketData
+
+logger = logging.getLogger(__name__)
+
+PME_COLUMNS = ['fv_contributions', 'fv_distributions', 'ks_pme', 'ln_irr', 'direct_alpha']
+
+
+def load_benchmarks(db, tickers: List[str]) -> Dict[str, object]:
+    """adj_close of each ticker laid out by offsets, in the order given"""
+    query = db.query(MarketData.ticker, MarketData.date, MarketData.adj_close)\
+        .filter(MarketData.ticker.in_(tickers))\
+        .order_by(MarketData.ticker, MarketData.date)
+    prices = pd.read_sql(query.statement, db.bind)
+    groups = {t: g for t, g in prices.groupby('ticker', sort=False)}
+    missing = [t for t in tickers if t not in groups]
+    if missing:
+        logger.warning(f"No MarketData rows for benchmarks {missing}")
+    parts = [groups.get(t, prices.iloc[0:0]) for t in tickers]
+    levels = pd.concat(parts, ignore_index=True) if parts else prices
+    offsets = np.concatenate([[0], np.cumsum([len(p) for p in parts])]).astype(np.int64)
+    return {'tickers': list(tickers), 'levels': levels, 'offsets': offsets}
+
+
+class PMEEngine:
+    """
+    Benchmark-relative performance, each flow compounded to the valuation date
+    by the index: FV = amount * I(valuation) / I(flow date), I = last adj_close
+    on or before the date
+    - ks_pme: (FV distributions + NAV) / FV contributions; > 1 beat the index
+    - ln_irr: Long-Nickels IRR, the deal's flows with NAV replaced by the index
+      replica (FV contributions - FV distributions); compare with the deal IRR
+    - direct_alpha: annual IRR of the compounded flows plus NAV
+    NaN where a benchmark has no level on or before a flow date.
+    Falls back to numpy per deal if C++ not available
+    """
+
+    def __init__(self, use_cpp: bool = True):
+        self.use_cpp = use_cpp and CPP_AVAILABLE
+
+    def compute(self, db, benchmarks: List[str], as_of: Optional[date] = None,
+                fund_ids=None) -> Dict[str, pd.DataFrame]:
+        """{'deals': one row per (benchmark, deal), 'funds': one row per (benchmark, fund)}"""
+        data = load_cash_flows(db, fund_ids)
+        bench = load_benchmarks(db, [t.upper() for t in benchmarks])
+        return self.compute_loaded(data, bench, as_of)
+
+    def compute_loaded(self, data: Dict[str, object], bench: Dict[str, object],
+                       as_of: Optional[date] = None) -> Dict[str, pd.DataFrame]:
+        if not bench['tickers']:
+            raise ValueError("at least one benchmark is required")
+        deals, funds, flows = data['deals'], data['funds'], data['flows']
+        today_day = int(epoch_days([date.today()])[0])
+        as_of_day = int(epoch_days([as_of])[0]) if as_of else today_day
+        nav_latest = deals['nav_latest'].to_numpy(dtype=np.float64, na_value=np.nan)
+        levels = bench['levels']
+
+        if self.use_cpp:
+            res = cpp.public_market_equivalents(
+                data['offsets'], epoch_days(flows['date']),
+                flows['amount'].to_numpy(dtype=np.float64), flows['kind'].to_numpy(dtype=np.int8),
+                nav_latest, deals['fund'].to_numpy(dtype=np.int32), len(funds), as_of_day,
+                today_day, bench['offsets'], epoch_days(levels['date']),
+                levels['adj_close'].to_numpy(dtype=np.float64))
+        else:
+            res = self._compute_python(data, bench, nav_latest, as_of_day, today_day)
+
+        keys = {'deals': deals[['id', 'fund_id']].rename(columns={'id': 'deal_id'}),
+                'funds': funds.rename(columns={'id': 'fund_id'})}
+        out = {}
+        for level, key in keys.items():
+            n = len(key)
+            frame = pd.DataFrame({c: np.asarray(res[level][c]).reshape(-1) for c in PME_COLUMNS})
+            frame.insert(0, 'benchmark', np.repeat(bench['tickers'], n))
+            out[level] = pd.concat([pd.concat([key] * len(bench['tickers']), ignore_index=True),
+                                    frame], axis=1)
+        return out
+
+    def _compute_python(self, data, bench, nav_latest: np.ndarray, as_of_day: int,
+                        today_day: int):
+        deals, funds, flows = data['deals'], data['funds'], data['flows']
+        offsets = data['offsets']
+        days = epoch_days(flows['date'])
+        amounts = np.abs(flows['amount'].to_numpy(dtype=np.float64))
+        kinds = flows['kind'].to_numpy()
+        level_days = epoch_days(bench['levels']['date'])
+        level_values = bench['levels']['adj_close'].to_numpy(dtype=np.float64)
+
+        per_deal = []
+        for i in range(len(deals)):
+            s = slice(offsets[i], offsets[i + 1])
+            past = days[s] <= as_of_day
+            d, a, k = days[s][past], amounts[s][past], kinds[s][past]
+            nav = residual_nav(nav_latest[i], a[k == 2], as_of_day, today_day)
+            cash = k != 2
+            per_deal.append((d[cash], np.where(k[cash] == 0, -a[cash], a[cash]), nav, as_of_day))
+
+        fund_of = deals['fund'].to_numpy()
+        members = [np.flatnonzero(fund_of == f) for f in range(len(funds))]
+        deal_rows, fund_rows = [], []
+        for b in range(len(bench['tickers'])):
+            lo, hi = bench['offsets'][b], bench['offsets'][b + 1]
+            valid = ~np.isnan(level_values[lo:hi])
+            bd, bl = level_days[lo:hi][valid], level_values[lo:hi][valid]
+
+            def level_at(day):
+                pos = np.searchsorted(bd, day, side='right') - 1
+                return np.where(pos >= 0, bl[np.maximum(pos, 0)], np.nan)
+
+            def compound(group):
+                ln_days, ln_cash, da_days, da_cash = [], [], [], []
+                fv_in = fv_out = nav_sum = 0.0
+                for d, cash, nav, valuation in group:
+                    fv = cash * level_at(valuation) / level_at(d)
+                    if np.isnan(fv).any() or np.isnan(level_at(valuation)):
+                        return None
+                    deal_in, deal_out = -fv[fv < 0].sum(), fv[fv > 0].sum()
+                    fv_in, fv_out, nav_sum = fv_in + deal_in, fv_out + deal_out, nav_sum + nav
+                    ln_days += [d, [valuation]]
+                    ln_cash += [cash, [deal_in - deal_out]]
+                    da_days += [d, [valuation]]
+                    da_cash += [fv, [nav]]
+                return {'fv_contributions': fv_in, 'fv_distributions': fv_out,
+                        'ks_pme': (fv_out + nav_sum) / fv_in if fv_in > 0 else np.nan,
+                        'ln_irr': xirr_python(np.concatenate(ln_days), np.concatenate(ln_cash))
+                        if ln_days else np.nan,
+                        'direct_alpha': xirr_python(np.concatenate(da_days), np.concatenate(da_cash))
+                        if da_days else np.nan}
+
+            empty = dict.fromkeys(PME_COLUMNS, np.nan)
+            deal_rows += [compound([row]) or empty for row in per_deal]
+            fund_rows += [compound([per_deal[i] for i in m]) or empty for m in members]
+
+        shape = (len(bench['tickers']), -1)
+        return {level: {c: np.array([r[c] for r in rows], dtype=np.float64).reshape(shape)
+                        for c in PME_COLUMNS}
+                for level, rows in (('deals', deal_rows), ('funds', fund_rows))}
@@ -5,7 +5,7 @@ Automatic fallback to Python if C++ module not available
 
 import numpy as np
 import pandas as pd
-from typing import Dict, Tuple
+from typing import Dict, List, Tuple
 import logging
 import sys
 import os
@@ -25,6 +25,23 @@ except ImportError:
     logger.warning("⚠️  C++ indicators not available, using Python fallback")
 
 
+def enable_kernel_cache(budget_mb: float = 64) -> bool:
+    """
+    Opt in to the native memo cache behind calculate_rsi / calculate_macd /
+    calculate_bollinger_bands
+    - Keyed on a fingerprint of the price buffer plus the kernel parameters
+    - LRU-evicted under budget_mb; a series that only grew at the end reuses
+      the cached rows and computes just the new ones
+    - Results are identical to uncached calls; stats via cpp.kernel_cache_stats()
+    Returns False (no-op) if C++ not available
+    """
+    if not CPP_AVAILABLE:
+        return False
+    cpp.enable_kernel_cache(int(budget_mb * 1024 * 1024))
+    logger.info(f"Kernel memo cache enabled ({budget_mb} MB)")
+    return True
+
+
 class TechnicalIndicators:
     """
     Technical indicator calculator with C++ acceleration
@@ -139,6 +156,866 @@ class TechnicalIndicators:
         }
 
 
+class RegimeDetector:
+    """
+    Market regime probabilities from a Gaussian HMM on (returns, volatility)
+    States are ordered calm -> volatile, so regime_prob_0 is the quietest regime
+    - Walk-forward: every refit_every bars the model is refit on the bars
+      before and frozen for the next block, so no row sees later data
+    - The first min_train bars get flat probabilities
+    Falls back to one-hot expanding volatility quantile buckets if C++ not
+    available; that is a different feature, so its columns are named
+    vol_bucket_k / vol_bucket_state instead of regime_prob_k / regime_state
+    """
+
+    def __init__(self, n_states: int = 4, min_train: int = 120, refit_every: int = 21,
+                 use_cpp: bool = True):
+        self.n_states = n_states
+        self.min_train = min_train
+        self.refit_every = refit_every
+        self.use_cpp = use_cpp and CPP_AVAILABLE
+
+    def column_names(self) -> List[str]:
+        prefix = 'regime_prob' if self.use_cpp else 'vol_bucket'
+        return [f'{prefix}_{k}' for k in range(self.n_states)]
+
+    def state_column(self) -> str:
+        return 'regime_state' if self.use_cpp else 'vol_bucket_state'
+
+    def probabilities(self, df: pd.DataFrame) -> np.ndarray:
+        """
+        Out-of-sample regime probabilities per bar
+        Input: DataFrame with 'close' and 'volatility_10d' columns
+        Output: array of shape (len(df), n_states)
+        """
+        obs = self._observations(df)
+        if self.use_cpp:
+            return cpp.hmm_walk_forward(obs, self.n_states, self.min_train, self.refit_every)
+        return self._bucket_probabilities(obs[:, 1])
+
+    def probabilities_batch(self, frames: List[pd.DataFrame]) -> List[np.ndarray]:
+        """Walk-forward HMM per ticker on the native thread pool"""
+        if not self.use_cpp:
+            return [self.probabilities(df) for df in frames]
+
+        obs = np.concatenate([self._observations(df) for df in frames])
+        offsets = np.concatenate([[0], np.cumsum([len(df) for df in frames])]).astype(np.int64)
+        _, probs = cpp.fit_hmm_batch(obs, offsets, self.n_states, self.min_train,
+                                     self.refit_every)
+        return np.split(probs, offsets[1:-1])
+
+    @staticmethod
+    def _observations(df: pd.DataFrame) -> np.ndarray:
+        # NaNs (warm-up rows) are treated as missing by the native HMM
+        returns = df['returns_1d'] if 'returns_1d' in df.columns else df['close'].pct_change()
+        return np.column_stack([
+            returns.to_numpy(dtype=np.float64),
+            df['volatility_10d'].to_numpy(dtype=np.float64)
+        ])
+
+    def _bucket_probabilities(self, volatility: np.ndarray) -> np.ndarray:
+        """Python fallback: one-hot buckets on expanding volatility quantiles (bars 0..t)"""
+        probs = np.full((len(volatility), self.n_states), 1.0 / self.n_states)
+        if self.n_states < 2:
+            return probs
+        expanding = pd.Series(volatility).expanding(min_periods=self.min_train)
+        edges = np.column_stack([expanding.quantile(q).to_numpy()
+                                 for q in np.linspace(0, 1, self.n_states + 1)[1:-1]])
+        valid = ~np.isnan(volatility) & ~np.isnan(edges).any(axis=1)
+        states = (volatility[valid, None] >= edges[valid]).sum(axis=1)
+        probs[valid] = np.eye(self.n_states)[states]
+        return probs
+
+
+class ChangePointDetector:
+    """
+    Structural-break features on a return series
+    - CUSUM events (+1/-1/0), also usable as an event sampler for labeling
+    - Bayesian online change-point probability and expected run length
+    Falls back to Python implementations if C++ not available
+    """
+
+    def __init__(self, expected_run_length: float = 250.0, alert_window: int = 5,
+                 max_run_length: int = 256, prune_threshold: float = 1e-5,
+                 use_cpp: bool = True):
+        self.expected_run_length = expected_run_length
+        self.alert_window = alert_window
+        self.max_run_length = max_run_length
+        self.prune_threshold = prune_threshold
+        self.use_cpp = use_cpp and CPP_AVAILABLE
+
+    def cusum_events(self, returns: np.ndarray, threshold) -> np.ndarray:
+        """CUSUM events; threshold is a scalar or one value per bar (e.g. rolling vol)"""
+        returns = np.asarray(returns, dtype=np.float64)
+        threshold = np.asarray(threshold, dtype=np.float64)
+        if self.use_cpp:
+            return cpp.cusum_filter(returns, threshold)
+
+        thresholds = np.broadcast_to(threshold, returns.shape)
+        events = np.zeros(len(returns), dtype=np.int8)
+        pos = neg = 0.0
+        for t, (x, h) in enumerate(zip(returns, thresholds)):
+            if np.isnan(x) or np.isnan(h):
+                continue
+            pos = max(0.0, pos + x)
+            neg = min(0.0, neg + x)
+            if pos > h:
+                pos = 0.0
+                events[t] = 1
+            elif neg < -h:
+                neg = 0.0
+                events[t] = -1
+        return events
+
+    def change_probabilities(self, returns: np.ndarray) -> Tuple[np.ndarray, np.ndarray]:
+        """
+        BOCPD on returns
+        Output: (P(run length < alert_window), expected run length) per bar
+        """
+        returns = np.asarray(returns, dtype=np.float64)
+        beta0 = self._prior_scale(returns)
+        if self.use_cpp:
+            result = cpp.bocpd(returns, self.expected_run_length, beta0=beta0,
+                               prune_threshold=self.prune_threshold,
+                               max_hypotheses=self.max_run_length,
+                               alert_window=self.alert_window)
+            return result.change_prob, result.expected_run_length
+        return self._bocpd_python(returns, beta0)
+
+    @staticmethod
+    def _prior_scale(returns: np.ndarray) -> float:
+        # Prior variance from the warm-up window only (no look-ahead)
+        head = returns[~np.isnan(returns)][:60]
+        var = float(np.var(head)) if len(head) > 1 else 0.0
+        return var if var > 0 else 1e-4
+
+    def _bocpd_python(self, returns: np.ndarray, beta0: float) -> Tuple[np.ndarray, np.ndarray]:
+        """Python fallback: same recursion and pruning as the native BOCPD"""
+        from scipy.special import gammaln
+
+        hazard = 1.0 / self.expected_run_length
+
+        def prior():
+            return (np.array([0]), np.array([1.0]), np.array([0.0]), np.array([1.0]),
+                    np.array([beta0]))
+
+        run, probs, mu, kappa, beta = prior()
+        change_prob = np.zeros(len(returns))
+        expected = np.zeros(len(returns))
+        last = (0.0, 0.0)
+
+        for t, x in enumerate(returns):
+            if np.isnan(x):
+                change_prob[t], expected[t] = last
+                continue
+            alpha = 1.0 + 0.5 * run
+            nu = 2 * alpha
+            scale2 = beta * (kappa + 1) / (alpha * kappa)
+            log_pred = (gammaln(alpha + 0.5) - gammaln(alpha) - 0.5 * np.log(nu * np.pi * scale2)
+                        - (alpha + 0.5) * np.log1p((x - mu) ** 2 / (nu * scale2)))
+            w = probs * np.exp(log_pred - log_pred.max())
+            total = w.sum()
+            if not total > 0:
+                # Every hypothesis underflowed: x starts a new run
+                run, probs, mu, kappa, beta = prior()
+                last = (1.0, 0.0)
+                change_prob[t], expected[t] = last
+                continue
+            probs = np.concatenate([[w.sum() * hazard], w * (1 - hazard)]) / total
+            beta = np.concatenate([[beta0], beta + kappa * (x - mu) ** 2 / (2 * (kappa + 1))])
+            mu = np.concatenate([[0.0], (kappa * mu + x) / (kappa + 1)])
+            kappa = np.concatenate([[1.0], kappa + 1])
+            run = np.concatenate([[0], run + 1])
+
+            # Drop negligible hypotheses, cap at max_run_length by probability;
+            # the most probable one always survives
+            cutoff = self.prune_threshold
+            if len(probs) > self.max_run_length:
+                cutoff = max(cutoff, np.sort(probs)[::-1][self.max_run_length - 1])
+            keep = probs >= cutoff
+            keep[np.argmax(probs)] = True
+            keep &= np.cumsum(keep) <= self.max_run_length
+            run, probs, mu, kappa, beta = (a[keep] for a in (run, probs, mu, kappa, beta))
+            probs = probs / probs.sum()
+
+            last = (probs[run < self.alert_window].sum(), (probs * run).sum())
+            change_prob[t], expected[t] = last
+
+        return change_prob, expected
+
+
+class AnalogueSearch:
+    """
+    Pattern search on a price series via the matrix profile
+    - analogues: past windows most similar (z-normalized) to the latest one,
+      ending before it starts (no overlap with the query)
+    - left_profile: distance of every window to its nearest earlier window,
+      a causal "has this shape happened before" feature
+    Falls back to a brute-force numpy search if C++ not available
+    """
+
+    def __init__(self, window: int = 20, exclusion: float = 0.25, use_cpp: bool = True):
+        self.window = window
+        self.exclusion = exclusion
+        self.use_cpp = use_cpp and CPP_AVAILABLE
+
+    def analogues(self, prices: np.ndarray, k: int = 5) -> List[Tuple[int, float]]:
+        """(start index, distance) of the k closest past windows"""
+        prices = np.ascontiguousarray(prices, dtype=np.float64)
+        if len(prices) < 2 * self.window:
+            return []
+        if self.use_cpp:
+            return [(n.index, n.distance)
+                    for n in cpp.find_analogues(prices, self.window, k, -1, self.exclusion)]
+
+        m = self.window
+        windows = np.lib.stride_tricks.sliding_window_view(prices, m)
+        mu = windows.mean(axis=1, keepdims=True)
+        sd = windows.std(axis=1, keepdims=True)
+        z = np.divide(windows - mu, sd, out=np.zeros_like(windows), where=sd > 0)
+        query = len(windows) - 1
+        dist = np.sqrt(np.maximum(((z - z[query]) ** 2).sum(axis=1), 0.0))
+        zone = max(1, int(np.ceil(m * self.exclusion)))
+        dist[query - m + 1:] = np.inf
+
+        result = []
+        for j in np.argsort(dist, kind='stable'):
+            if len(result) == k or not np.isfinite(dist[j]):
+                break
+            # Same inclusive zone as the C++ search: |j - i| <= zone is blocked
+            if all(abs(j - i) > zone for i, _ in result):
+                result.append((int(j), float(dist[j])))
+        return result
+
+    def left_profile(self, prices: np.ndarray) -> np.ndarray:
+        """Per-bar nearest-earlier-window distance, aligned to the window's last bar"""
+        prices = np.ascontiguousarray(prices, dtype=np.float64)
+        out = np.full(len(prices), np.nan)
+        if not self.use_cpp or len(prices) < 2 * self.window:
+            return out
+        mp = cpp.matrix_profile(prices, self.window, self.exclusion)
+        out[self.window - 1:] = mp.left_distance
+        return out
+
+
+class PatternSearch:
+    """
+    "Which tickers' last N bars look like this pattern" across a universe.
+    Close prices are packed once into a columnar layout (one contiguous
+    values array plus per-ticker offsets) so repeated queries hit native
+    z-normalized DTW search without re-copying.
+    Falls back to LB_Keogh-pruned Python DTW if C++ not available
+    """
+
+    def __init__(self, prices: Dict[str, np.ndarray], band: float = 0.1, use_cpp: bool = True):
+        self.tickers = list(prices)
+        series = [np.asarray(prices[t], dtype=np.float64) for t in self.tickers]
+        self.values = np.ascontiguousarray(np.concatenate(series) if series else np.zeros(0))
+        self.offsets = np.zeros(len(series) + 1, dtype=np.int64)
+        self.offsets[1:] = np.cumsum([len(s) for s in series])
+        self.band = band
+        self.use_cpp = use_cpp and CPP_AVAILABLE
+
+    def window(self, ticker: str, length: int) -> np.ndarray:
+        """The latest `length` bars of a ticker, e.g. as a query"""
+        i = self.tickers.index(ticker)
+        return self.values[self.offsets[i + 1] - length:self.offsets[i + 1]]
+
+    def search(self, query: np.ndarray, k: int = 10, exclude_ticker: str = None,
+               exclude_start: int = -1) -> List[Tuple[str, int, float]]:
+        """(ticker, start bar, distance) of the k closest windows, best first"""
+        query = np.ascontiguousarray(query, dtype=np.float64)
+        exclude_series = self.tickers.index(exclude_ticker) if exclude_ticker is not None else -1
+        if exclude_series >= 0 and exclude_start < 0:
+            exclude_start = self.offsets[exclude_series + 1] - self.offsets[exclude_series] - len(query)
+
+        if self.use_cpp:
+            series, start, dist = cpp.dtw_search(self.values, self.offsets, query, k, self.band,
+                                                 exclude_series, exclude_start)
+        else:
+            series, start, dist = self._search_python(query, k, exclude_series, exclude_start)
+        return [(self.tickers[s], int(b), float(d)) for s, b, d in zip(series, start, dist)]
+
+    @staticmethod
+    def _znorm(x: np.ndarray) -> np.ndarray:
+        mu = x.mean(axis=-1, keepdims=True)
+        sd = x.std(axis=-1, keepdims=True)
+        return np.divide(x - mu, sd, out=np.zeros_like(x), where=sd > 0)
+
+    @staticmethod
+    def _dtw(a: np.ndarray, b: np.ndarray, r: int) -> float:
+        m = len(a)
+        cost = np.full((m + 1, m + 1), np.inf)
+        cost[0, 0] = 0.0
+        for i in range(1, m + 1):
+            for j in range(max(1, i - r), min(m, i + r) + 1):
+                cost[i, j] = (a[i - 1] - b[j - 1]) ** 2 + min(cost[i - 1, j], cost[i, j - 1], cost[i - 1, j - 1])
+        return float(np.sqrt(cost[m, m]))
+
+    def _search_python(self, query: np.ndarray, k: int, exclude_series: int, exclude_start: int):
+        m = len(query)
+        r = min(m - 1, int(self.band * m))
+        q = self._znorm(query)
+        upper = np.array([q[max(0, i - r):i + r + 1].max() for i in range(m)])
+        lower = np.array([q[max(0, i - r):i + r + 1].min() for i in range(m)])
+
+        candidates = []
+        for s in range(len(self.tickers)):
+            x = self.values[self.offsets[s]:self.offsets[s + 1]]
+            if len(x) < m:
+                continue
+            z = self._znorm(np.lib.stride_tricks.sliding_window_view(x, m))
+            lb = np.sqrt((np.maximum(z - upper, 0) ** 2 + np.maximum(lower - z, 0) ** 2).sum(axis=1))
+            for b in np.flatnonzero(np.isfinite(lb)):
+                if s == exclude_series and b + m > exclude_start and b < exclude_start + m:
+                    continue
+                candidates.append((lb[b], s, b, z[b]))
+        candidates.sort(key=lambda c: c[0])
+
+        # Exact DTW in lower-bound order until the bound rules the rest out.
+        # The bound is the k-th of matches kept 2m - 1 apart: no window
+        # overlaps two of them, so the greedy pick below has k at or under it.
+        scored, spread = [], []
+        for lb, s, b, z in candidates:
+            bound = spread[k - 1][2] if len(spread) >= k else np.inf
+            if lb >= bound:
+                break
+            d = self._dtw(z, q, r)
+            if d >= bound:
+                continue
+            scored.append((d, s, b))
+            if any(bs == s and abs(bb - b) < 2 * m - 1 and bd <= d for bs, bb, bd in spread):
+                continue
+            spread = [c for c in spread if not (c[0] == s and abs(c[1] - b) < 2 * m - 1)]
+            spread = sorted(spread + [(s, b, d)], key=lambda c: c[2])[:k]
+
+        best = []
+        for d, s, b in sorted(scored):
+            if len(best) == k:
+                break
+            if not any(bs == s and abs(bb - b) < m for bs, bb, _ in best):
+                best.append((s, b, d))
+
+        series, start, dist = zip(*best) if best else ((), (), ())
+        return np.array(series, dtype=np.int64), np.array(start, dtype=np.int64), np.array(dist)
+
+
+class WaveletDecomposer:
+    """
+    Causal multi-resolution decomposition (a-trous / MODWT pyramid)
+    - smooth(level j): denoised series keeping scales above 2^j bars
+    - detail(level j): the band between 2^(j-1) and 2^j bars
+    - energy: trailing mean of detail^2 per level (scale-specific activity)
+    Falls back to numpy if C++ not available
+    """
+
+    FILTERS = {
+        'haar': [0.70710678118654752, 0.70710678118654752],
+        'd4': [0.48296291314469025, 0.83651630373746899, 0.22414386804185735, -0.12940952255092145],
+        'd6': [0.33267055295095688, 0.80689150931333875, 0.45987750211933132, -0.13501102001039084,
+               -0.08544127388224149, 0.03522629188210562],
+        'd8': [0.23037781330885523, 0.71484657055254153, 0.63088076792959036, -0.02798376941698385,
+               -0.18703481171888114, 0.03084138183598697, 0.03288301166698295, -0.01059740178499728],
+    }
+
+    def __init__(self, levels: int = 4, filter: str = 'haar', energy_window: int = 20,
+                 use_cpp: bool = True):
+        self.levels = levels
+        self.filter = filter
+        self.energy_window = energy_window
+        self.use_cpp = use_cpp and CPP_AVAILABLE
+
+    def decompose(self, x: np.ndarray) -> Tuple[np.ndarray, np.ndarray, np.ndarray]:
+        """(detail, smooth, energy), each (levels, n); x = smooth[-1] + detail.sum(axis=0)"""
+        x = np.ascontiguousarray(x, dtype=np.float64)
+        if self.use_cpp:
+            res = cpp.wavelet_decompose(x, self.levels, self.filter, 'atrous', True, self.energy_window)
+            return res.detail, res.smooth, res.energy
+        return self._decompose_python(x)
+
+    def _decompose_python(self, x: np.ndarray):
+        g = np.array(self.FILTERS[self.filter]) / np.sqrt(2)
+        valid = pd.Series(x).ffill().to_numpy()
+        first = np.argmax(~np.isnan(valid)) if (~np.isnan(valid)).any() else len(x)
+
+        n = len(x)
+        detail = np.full((self.levels, n), np.nan)
+        smooth = np.full((self.levels, n), np.nan)
+        prev = valid[first:]
+        for j in range(self.levels):
+            spacing = 2 ** j
+            nxt = np.zeros_like(prev)
+            for l, c in enumerate(g):
+                # Shift back by spacing * l, repeating the first value (causal)
+                idx = np.maximum(np.arange(len(prev)) - spacing * l, 0)
+                nxt += c * prev[idx]
+            detail[j, first:] = prev - nxt
+            smooth[j, first:] = nxt
+            prev = nxt
+
+        energy = None
+        if self.energy_window > 0:
+            energy = pd.DataFrame(detail.T ** 2).rolling(self.energy_window).mean().to_numpy().T
+        return detail, smooth, energy
+
+
+class TimeframeResampler:
+    """
+    Daily OHLCV -> weekly / monthly / quarterly / yearly bars on the trading
+    calendar actually present in the data
+    - resample(df): higher-timeframe bars plus, per daily row, the index of
+      the latest completed bar (-1 if none)
+    - join through that index so higher-timeframe features never see the
+      period still in progress
+    Falls back to pandas if C++ not available
+    """
+
+    PERIODS = ('W', 'M', 'Q', 'Y')
+
+    def __init__(self, period: str = 'W', use_cpp: bool = True):
+        if period not in self.PERIODS:
+            raise ValueError(f"period must be one of {self.PERIODS}")
+        self.period = period
+        self.use_cpp = use_cpp and CPP_AVAILABLE
+
+    def resample(self, df: pd.DataFrame) -> Tuple[pd.DataFrame, np.ndarray]:
+        """
+        Args:
+            df: one ticker's daily rows with date, open, high, low, close, volume
+
+        Returns:
+            (bars with date = last daily date of each period, last_complete per daily row)
+        """
+        dates = pd.to_datetime(df['date']) if 'date' in df.columns else pd.to_datetime(df.index)
+        days = dates.to_numpy(dtype='datetime64[D]').astype(np.int64)
+        cols = [np.ascontiguousarray(df[c].to_numpy(dtype=np.float64))
+                for c in ('open', 'high', 'low', 'close', 'volume')]
+
+        if self.use_cpp:
+            res = cpp.resample_ohlcv(*cols, days, np.array([0, len(df)], dtype=np.int64), self.period)
+            bars = pd.DataFrame({'open': res.open, 'high': res.high, 'low': res.low,
+                                 'close': res.close, 'volume': res.volume})
+            bars['date'] = np.asarray(dates)[res.last_row]
+            return bars, np.asarray(res.last_complete)
+        return self._resample_python(dates, days, cols)
+
+    def _resample_python(self, dates: pd.Series, days: np.ndarray, cols: List[np.ndarray]):
+        frame = pd.DataFrame(dict(zip(('open', 'high', 'low', 'close', 'volume'), cols)))
+        if self.period == 'W':
+            key = (days + 3) // 7  # weeks start on Monday
+        else:
+            civil = pd.DatetimeIndex(np.asarray(dates))
+            key = {'M': civil.year * 12 + civil.month - 1,
+                   'Q': civil.year * 4 + (civil.month - 1) // 3,
+                   'Y': civil.year}[self.period]
+            key = np.asarray(key, dtype=np.int64)
+        period = np.concatenate([[0], np.cumsum(key[1:] != key[:-1])]) if len(key) else key
+        grouped = frame.groupby(period)
+        bars = pd.DataFrame({'open': grouped['open'].first(), 'high': grouped['high'].max(),
+                             'low': grouped['low'].min(), 'close': grouped['close'].last(),
+                             'volume': grouped['volume'].sum()}).reset_index(drop=True)
+        bars['date'] = pd.Series(np.asarray(dates)).groupby(period).last().to_numpy()
+        return bars, period - 1
+
+
+class ReturnsCalculator:
+    """
+    Price-relative features from one close series in a single native call
+    - simple_h: close / close.shift(h) - 1 (the same as momentum_h)
+    - log_h: log(close / close.shift(h))
+    - roc_h: 100 * simple_h
+    - forward_f: close.shift(-f) / close - 1, for targets
+    Falls back to numpy if C++ not available
+    """
+
+    def __init__(self, horizons=(1, 5, 20), forward_horizons=(), log: bool = True,
+                 roc: bool = False, use_cpp: bool = True):
+        self.horizons = list(horizons)
+        self.forward_horizons = list(forward_horizons)
+        self.log = log
+        self.roc = roc
+        self.use_cpp = use_cpp and CPP_AVAILABLE
+
+    def compute(self, close: np.ndarray) -> Dict[str, np.ndarray]:
+        close = np.ascontiguousarray(close, dtype=np.float64)
+        if self.use_cpp:
+            res = cpp.compute_returns(close, self.horizons, self.forward_horizons, self.log, self.roc)
+            simple, log, roc, forward = res.simple, res.log, res.roc, res.forward
+        else:
+            simple, log, roc, forward = self._compute_python(close)
+
+        out = {}
+        for k, h in enumerate(self.horizons):
+            out[f'simple_{h}'] = simple[k]
+            if self.log:
+                out[f'log_{h}'] = log[k]
+            if self.roc:
+                out[f'roc_{h}'] = roc[k]
+        for k, f in enumerate(self.forward_horizons):
+            out[f'forward_{f}'] = forward[k]
+        return out
+
+    def _compute_python(self, close: np.ndarray):
+        n = len(close)
+        usable = np.where(close > 0, close, np.nan)
+
+        def lagged(h):
+            # close.shift(h); negative h looks ahead
+            shifted = np.full(n, np.nan)
+            if 0 < h < n:
+                shifted[h:] = usable[:-h]
+            elif -n < h < 0:
+                shifted[:h] = usable[-h:]
+            return shifted
+
+        ratios = np.array([usable / lagged(h) for h in self.horizons]).reshape(-1, n)
+        simple = ratios - 1
+        with np.errstate(invalid='ignore', divide='ignore'):
+            log = np.log(ratios) if self.log else None
+        roc = 100 * simple if self.roc else None
+        forward = (np.array([lagged(-f) / usable for f in self.forward_horizons]).reshape(-1, n) - 1
+                   if self.forward_horizons else None)
+        return simple, log, roc, forward
+
+
+class CandlestickPatterns:
+    """
+    Candle shape features and classic 1-3 bar patterns in one pass over OHLC
+    - features: candle_size, upper/lower shadow, body_size (all / close),
+      body_ratio (body / range), close_location ((close - low) / range)
+    - patterns: uint64 bitmask per bar, bit k = PATTERNS[k]
+    Falls back to numpy if C++ not available
+    """
+
+    PATTERNS = ['bullish', 'doji', 'dragonfly_doji', 'gravestone_doji', 'marubozu', 'hammer',
+                'hanging_man', 'inverted_hammer', 'shooting_star', 'bullish_engulfing',
+                'bearish_engulfing', 'bullish_harami', 'bearish_harami', 'piercing_line',
+                'dark_cloud_cover', 'morning_star', 'evening_star', 'three_white_soldiers',
+                'three_black_crows', 'inside_bar', 'outside_bar', 'higher_high', 'lower_low',
+                'gap_up', 'gap_down']
+    FEATURES = ['candle_size', 'upper_shadow', 'lower_shadow', 'body_size', 'body_ratio',
+                'close_location']
+
+    def __init__(self, doji_body: float = 0.1, small_body: float = 0.3, long_body: float = 0.6,
+                 shadow_ratio: float = 2.0, gap_threshold: float = 0.02, trend_lookback: int = 5,
+                 use_cpp: bool = True):
+        self.doji_body = doji_body
+        self.small_body = small_body
+        self.long_body = long_body
+        self.shadow_ratio = shadow_ratio
+        self.gap_threshold = gap_threshold
+        self.trend_lookback = trend_lookback
+        self.use_cpp = use_cpp and CPP_AVAILABLE
+
+    def compute(self, df: pd.DataFrame) -> Tuple[np.ndarray, Dict[str, np.ndarray]]:
+        """(patterns bitmask, {feature name: values}) for one ticker's OHLC"""
+        o, h, l, c = [np.ascontiguousarray(df[col].to_numpy(dtype=np.float64))
+                      for col in ('open', 'high', 'low', 'close')]
+        if self.use_cpp:
+            res = cpp.candle_patterns(o, h, l, c, None, self.doji_body, self.small_body,
+                                      self.long_body, self.shadow_ratio, self.gap_threshold,
+                                      self.trend_lookback)
+            patterns, features = np.asarray(res.patterns), res.features
+        else:
+            patterns, features = self._compute_python(o, h, l, c)
+        return patterns, dict(zip(self.FEATURES, features))
+
+    def flag(self, patterns: np.ndarray, name: str) -> np.ndarray:
+        """0/1 column for one pattern"""
+        return ((patterns >> np.uint64(self.PATTERNS.index(name))) & np.uint64(1)).astype(int)
+
+    def _compute_python(self, o, h, l, c):
+        n = len(c)
+        valid = ~(np.isnan(o) | np.isnan(h) | np.isnan(l) | np.isnan(c)) & (c > 0) & (h >= l)
+        rng = h - l
+        body = np.abs(c - o)
+        top, bottom = np.maximum(o, c), np.minimum(o, c)
+        upper, lower = h - top, bottom - l
+        bull, bear = c > o, c < o
+        mid = 0.5 * (o + c)
+        with np.errstate(invalid='ignore', divide='ignore'):
+            features = np.array([rng / c, upper / c, lower / c, body / c,
+                                 np.where(rng > 0, body / rng, np.nan),
+                                 np.where(rng > 0, (c - l) / rng, np.nan)])
+        features[:, ~valid] = np.nan
+
+        def prev(x, k=1):
+            out = np.zeros(n, dtype=x.dtype) if x.dtype == bool else np.full(n, np.nan)
+            if k < n:
+                out[k:] = x[:-k]
+            return out
+
+        doji = (rng > 0) & (body <= self.doji_body * rng)
+        real = (rng > 0) & ~doji
+        hammer_shape = real & (lower >= self.shadow_ratio * body) & (upper <= 0.1 * rng)
+        inverted_shape = real & (upper >= self.shadow_ratio * body) & (lower <= 0.1 * rng)
+        k = self.trend_lookback
+        c1, ck = prev(c), prev(c, k + 1)
+        down, up = c1 < ck, c1 > ck
+        long_body = (rng > 0) & (body >= self.long_body * rng)
+        small = (rng > 0) & (body <= self.small_body * rng)
+
+        v1 = valid & prev(valid)
+        v2 = v1 & prev(valid, 2)
+        o1, h1, l1, b1 = prev(o), prev(h), prev(l), prev(body)
+        bull1, bear1, long1, mid1 = prev(bull), prev(bear), prev(long_body), prev(mid)
+        o2, c2, b2 = prev(o, 2), prev(c, 2), prev(body, 2)
+        bull2, bear2, long2, mid2 = prev(bull, 2), prev(bear, 2), prev(long_body, 2), prev(mid, 2)
+        top1, bottom1, small1 = prev(top), prev(bottom), prev(small)
+        upper1, lower1 = prev(upper), prev(lower)
+        with np.errstate(invalid='ignore', divide='ignore'):
+            gap = o / c1 - 1
+
+        flags = [
+            bull, doji,
+            doji & (upper <= 0.1 * rng) & (lower >= 0.6 * rng),
+            doji & (lower <= 0.1 * rng) & (upper >= 0.6 * rng),
+            (rng > 0) & (upper <= 0.05 * rng) & (lower <= 0.05 * rng),
+            hammer_shape & down, hammer_shape & up, inverted_shape & down, inverted_shape & up,
+            v1 & bear1 & bull & (o <= c1) & (c >= o1) & (body > b1),
+            v1 & bull1 & bear & (o >= c1) & (c <= o1) & (body > b1),
+            v1 & bear1 & long1 & bull & (top <= o1) & (bottom >= c1) & (body < b1),
+            v1 & bull1 & long1 & bear & (top <= c1) & (bottom >= o1) & (body < b1),
+            v1 & bear1 & long1 & bull & (o < c1) & (c > mid1) & (c < o1),
+            v1 & bull1 & long1 & bear & (o > c1) & (c < mid1) & (c > o1),
+            v2 & bear2 & long2 & small1 & (top1 <= c2) & bull & (c >= mid2),
+            v2 & bull2 & long2 & small1 & (bottom1 >= c2) & bear & (c <= mid2),
+            v2 & bull2 & bull1 & bull & (c1 > c2) & (c > c1) & (o1 >= o2) & (o1 <= c2)
+            & (o >= o1) & (o <= c1) & (upper <= body) & (upper1 <= b1),
+            v2 & bear2 & bear1 & bear & (c1 < c2) & (c < c1) & (o1 <= o2) & (o1 >= c2)
+            & (o <= o1) & (o >= c1) & (lower <= body) & (lower1 <= b1),
+            v1 & (h < h1) & (l > l1), v1 & (h > h1) & (l < l1),
+            v1 & (h > h1), v1 & (l < l1),
+            v1 & (gap > self.gap_threshold), v1 & (gap < -self.gap_threshold),
+        ]
+        patterns = np.zeros(n, dtype=np.uint64)
+        for bit, f in enumerate(flags):
+            patterns |= (np.nan_to_num(f).astype(bool) & valid).astype(np.uint64) << np.uint64(bit)
+        return patterns, features
+
+
+class CalendarFeatures:
+    """
+    Calendar and trading-calendar features from dates in one pass
+    - year, month, day, day_of_week (Mon=0), day_of_year, quarter, iso_week
+    - month / quarter boundary flags and days to month end
+    - first / last trading day of month, trading days left in the month
+    - days to / since the nearest exchange holiday, pre / post holiday flags
+    Falls back to pandas if C++ not available
+    """
+
+    NAMES = ['year', 'month', 'day', 'day_of_week', 'day_of_year', 'quarter', 'iso_week',
+             'is_month_start', 'is_month_end', 'is_quarter_end', 'is_trading_day',
+             'first_trading_day_of_month', 'last_trading_day_of_month',
+             'trading_days_to_month_end', 'days_to_month_end', 'days_to_holiday',
+             'days_since_holiday', 'is_pre_holiday', 'is_post_holiday']
+
+    def __init__(self, holidays=None, use_cpp: bool = True):
+        """holidays: exchange holiday dates; None uses the NYSE rules"""
+        self.holidays = holidays
+        self.use_cpp = use_cpp and CPP_AVAILABLE
+
+    @staticmethod
+    def nyse_holidays(start, end) -> pd.DatetimeIndex:
+        """NYSE full-day closures between start and end (rule based, no one-offs)"""
+        from pandas.tseries.holiday import (AbstractHolidayCalendar, Holiday, GoodFriday,
+                                            USMartinLutherKingJr, USPresidentsDay, USMemorialDay,
+                                            USLaborDay, USThanksgivingDay, nearest_workday)
+
+        class NYSECalendar(AbstractHolidayCalendar):
+            rules = [
+                Holiday('NewYearsDay', month=1, day=1, observance=nearest_workday),
+                USMartinLutherKingJr, USPresidentsDay, GoodFriday, USMemorialDay,
+                Holiday('Juneteenth', month=6, day=19, start_date='2022-01-01',
+                        observance=nearest_workday),
+                Holiday('IndependenceDay', month=7, day=4, observance=nearest_workday),
+                USLaborDay, USThanksgivingDay,
+                Holiday('Christmas', month=12, day=25, observance=nearest_workday),
+            ]
+
+        # Pad so the first / last rows still see their neighbouring holidays
+        pad = pd.Timedelta(days=400)
+        holidays = NYSECalendar().holidays(pd.Timestamp(start) - pad, pd.Timestamp(end) + pad)
+        # A Saturday New Year's Day is not observed on the prior Friday
+        return holidays[~((holidays.month == 12) & (holidays.day == 31))]
+
+    def compute(self, dates) -> Dict[str, np.ndarray]:
+        """{feature name: values} for a sequence of dates"""
+        days = np.ascontiguousarray(
+            pd.DatetimeIndex(pd.to_datetime(dates)).to_numpy(dtype='datetime64[D]').astype(np.int64))
+        if len(days) == 0:
+            return {name: np.empty(0) for name in self.NAMES}
+        holidays = self.holidays
+        if holidays is None:
+            holidays = self.nyse_holidays(pd.Timestamp(days.min(), unit='D'),
+                                          pd.Timestamp(days.max(), unit='D'))
+        hdays = np.ascontiguousarray(
+            pd.DatetimeIndex(pd.to_datetime(holidays)).to_numpy(dtype='datetime64[D]').astype(np.int64))
+        if self.use_cpp:
+            features = np.asarray(cpp.calendar_features(days, 'D', hdays))
+        else:
+            features = self._compute_python(days, hdays)
+        return dict(zip(self.NAMES, features))
+
+    def _compute_python(self, days: np.ndarray, hdays: np.ndarray) -> np.ndarray:
+        idx = pd.DatetimeIndex(days.astype('datetime64[D]'))
+        dow = idx.dayofweek.to_numpy()
+        dim = idx.days_in_month.to_numpy()
+        day = idx.day.to_numpy()
+        month_start = days - (day - 1)
+        month_end = month_start + dim - 1
+
+        # Day-indexed tables over the rows plus a margin, as in the C++ kernel
+        first = days.min() - 400
+        span = np.arange(first, days.max() + 401)
+        hmask = np.isin(span, hdays) & ((span + 3) % 7 < 5)
+        trading = ((span + 3) % 7 < 5) & ~hmask
+        before = np.concatenate([[0], np.cumsum(trading)])
+        pos = days - first
+        t = trading[pos]
+        before_in_month = before[pos] - before[month_start - first]
+        after_in_month = before[month_end - first + 1] - before[pos + 1]
+
+        hidx = np.flatnonzero(hmask)
+        nxt = np.searchsorted(hidx, pos, side='left')
+        prv = np.searchsorted(hidx, pos, side='right') - 1
+        with np.errstate(invalid='ignore'):
+            to_h = np.where(nxt < len(hidx), hidx[np.minimum(nxt, len(hidx) - 1)] - pos, np.nan) \
+                if len(hidx) else np.full(len(days), np.nan)
+            since_h = np.where(prv >= 0, pos - hidx[np.maximum(prv, 0)], np.nan) \
+                if len(hidx) else np.full(len(days), np.nan)
+        next_wd = pos + np.select([dow == 4, dow == 5], [3, 2], 1)
+        prev_wd = pos - np.select([dow == 0, dow == 6], [3, 2], 1)
+
+        return np.array([
+            idx.year, idx.month, day, dow, idx.dayofyear, idx.quarter,
+            idx.isocalendar().week.to_numpy(),
+            day == 1, day == dim, (day == dim) & (idx.month % 3 == 0), t,
+            t & (before_in_month == 0), t & (after_in_month == 0), after_in_month,
+            dim - day, to_h, since_h, hmask[next_wd], hmask[prev_wd],
+        ], dtype=np.float64)
+
+
+class UniverseStreamingState:
+    """
+    Streaming RSI / MACD / Bollinger state for a whole universe
+    - state is struct-of-arrays: one contiguous array per variable, indexed by ticker
+    - update(prices) advances every ticker by one timestamp in a single SIMD sweep
+    - Without gaps, each ticker's features equal the last row of
+      calculate_rsi / calculate_macd / calculate_bollinger_bands over its
+      history, warm-up zeros included
+    - NaN prices leave a ticker's RSI / MACD untouched; Bollinger bands need
+      a price at each of the last bb_period timestamps (0 until then)
+    Falls back to numpy if C++ not available
+    """
+
+    FEATURES = ['rsi', 'macd', 'macd_signal', 'macd_hist', 'bb_middle', 'bb_upper', 'bb_lower',
+                'bb_percent']
+
+    def __init__(self, tickers: List[str], rsi_period: int = 14, macd_fast: int = 12,
+                 macd_slow: int = 26, macd_signal: int = 9, bb_period: int = 20,
+                 bb_std: float = 2.0, use_cpp: bool = True):
+        self.tickers = list(tickers)
+        self.use_cpp = use_cpp and CPP_AVAILABLE
+        args = (len(self.tickers), rsi_period, macd_fast, macd_slow, macd_signal, bb_period, bb_std)
+        self._state = cpp.UniverseState(*args) if self.use_cpp else _NumpyUniverseState(*args)
+
+    def update(self, prices) -> pd.DataFrame:
+        """
+        Args:
+            prices: one price per ticker (array in ticker order, or Series indexed by ticker)
+
+        Returns:
+            Features after this timestamp, one row per ticker
+        """
+        if isinstance(prices, pd.Series):
+            prices = prices.reindex(self.tickers)
+        values = np.ascontiguousarray(np.asarray(prices, dtype=np.float64))
+        return self._frame(self._state.update_all(values))
+
+    def update_many(self, panel: pd.DataFrame) -> pd.DataFrame:
+        """Feed a (timestamps x tickers) price panel; returns the final features"""
+        values = np.ascontiguousarray(panel.reindex(columns=self.tickers).to_numpy(dtype=np.float64))
+        return self._frame(self._state.update_many(values))
+
+    def features(self) -> pd.DataFrame:
+        return self._frame(self._state.features())
+
+    def reset(self):
+        self._state.reset()
+
+    def _frame(self, features) -> pd.DataFrame:
+        return pd.DataFrame(np.asarray(features).T, index=self.tickers, columns=self.FEATURES)
+
+
+class _NumpyUniverseState:
+    """Same update rules as the C++ UniverseState, one numpy op per state array"""
+
+    def __init__(self, n, rsi_period, macd_fast, macd_slow, macd_signal, bb_period, bb_std):
+        self.n_tickers = n
+        self.period = rsi_period
+        self.macd_slow = macd_slow
+        self.a_fast = 2.0 / (macd_fast + 1)
+        self.a_slow = 2.0 / (macd_slow + 1)
+        self.a_signal = 2.0 / (macd_signal + 1)
+        self.bb_period = bb_period
+        self.bb_std = bb_std
+        self.reset()
+
+    def reset(self):
+        n = self.n_tickers
+        self.steps = 0
+        self.last, self.n_obs = np.zeros(n), np.zeros(n)
+        self.gain, self.loss = np.zeros(n), np.zeros(n)
+        self.fast, self.slow, self.signal = np.zeros(n), np.zeros(n), np.zeros(n)
+        self.window = np.full((self.bb_period, n), np.nan)
+
+    def update_all(self, p: np.ndarray) -> np.ndarray:
+        valid = ~np.isnan(p)
+        first = self.n_obs == 0
+        counts = valid & ~first
+        change = np.where(counts, p - self.last, 0.0)
+        gain, loss = np.maximum(change, 0.0), np.maximum(-change, 0.0)
+        seen, k = self.n_obs, self.period
+        for avg, x in ((self.gain, gain), (self.loss, loss)):
+            total = avg + x
+            prev = np.where(seen == k, total / k, avg)
+            nxt = np.where(seen < k, total, (prev * (k - 1) + x) / k)
+            avg[:] = np.where(counts, nxt, avg)
+        fast = np.where(first, p, self.a_fast * p + (1 - self.a_fast) * self.fast)
+        slow = np.where(first, p, self.a_slow * p + (1 - self.a_slow) * self.slow)
+        m = fast - slow
+        sig = np.where(seen < self.macd_slow, 0.0,
+                       np.where(seen == self.macd_slow, m,
+                                self.a_signal * m + (1 - self.a_signal) * self.signal))
+        self.fast = np.where(valid, fast, self.fast)
+        self.slow = np.where(valid, slow, self.slow)
+        self.signal = np.where(valid, sig, self.signal)
+        self.window[self.steps % self.bb_period] = p
+        self.last = np.where(valid, p, self.last)
+        self.n_obs = seen + valid
+        self.steps += 1
+        return self.features()
+
+    def update_many(self, panel: np.ndarray) -> np.ndarray:
+        for row in panel:
+            self.update_all(row)
+        return self.features()
+
+    def features(self) -> np.ndarray:
+        with np.errstate(invalid='ignore', divide='ignore'):
+            rsi = np.where(self.loss == 0, 100.0, 100.0 - 100.0 / (1.0 + self.gain / self.loss))
+            rsi = np.where(self.n_obs - 1 >= self.period, rsi, 0.0)
+            macd = self.fast - self.slow
+            hist = np.where(self.n_obs - 1 > self.macd_slow, macd - self.signal, 0.0)
+            full = ~np.isnan(self.window).any(axis=0)
+            mid = np.where(full, self.window.mean(axis=0), 0.0)
+            sd = np.where(full, self.window.std(axis=0), 0.0)
+            upper, lower = mid + self.bb_std * sd, mid - self.bb_std * sd
+            pct = np.where(upper > lower, (self.last - lower) / (upper - lower), np.nan)
+        return np.array([rsi, macd, self.signal, hist, mid, upper, lower, pct])
+
+
 # Performance benchmarking
 def benchmark_indicators(iterations: int = 100):
     """Benchmark C++ vs Python performance"""
@@ -12,6 +12,7 @@ import pandas as pd
 from datetime import datetime, timedelta
 import logging
 
+from config import settings
 from services.data_ingestion.market_data import MarketDataService
 from services.ml_engine.feature_engineering import FeatureEngineer
 from services.ml_engine.model_training import XGBoostPredictor
@@ -54,7 +55,7 @@ def train_alpha_model(ticker: str = 'AAPL', days: int = 1095):
 
     # ===== 2. Feature Engineering =====
     logger.info("\n🔧 Step 2: Creating features...")
-    feature_engineer = FeatureEngineer()
+    feature_engineer = FeatureEngineer(use_cpp=settings.USE_CPP_INDICATORS)
 
     # Note: For demo, we're not using sentiment/social data
     # In production, you would merge real sentiment and social signal data here
@@ -12,6 +12,7 @@ import pandas as pd
 from datetime import datetime, timedelta
 import logging
 
+from config import settings
 from services.data_ingestion.market_data import MarketDataService
 from services.ml_engine.feature_engineering import FeatureEngineer
 from services.ml_engine.model_training import XGBoostPredictor
@@ -38,7 +39,7 @@ def train_multi_stock_model(days: int = 730):  # 2 years per stock
 
     all_features = []
     market_service = MarketDataService()
-    feature_engineer = FeatureEngineer()
+    feature_engineer = FeatureEngineer(use_cpp=settings.USE_CPP_INDICATORS)
 
     # Fetch and engineer features for each stock
     for ticker in TRAINING_STOCKS: